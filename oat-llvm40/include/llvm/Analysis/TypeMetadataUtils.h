@@ -40,6 +40,10 @@ void findDevirtualizableCallsForTypeCheckedLoad(
     SmallVectorImpl<DevirtCallSite> &DevirtCalls,
     SmallVectorImpl<Instruction *> &LoadedPtrs,
     SmallVectorImpl<Instruction *> &Preds, bool &HasNonCallUses, CallInst *CI);
+
+/// Return the pointer stored at byte offset \p Offset of the virtual table
+/// initializer \p I, or null if there is none.
+Constant *getPointerAtOffset(Constant *I, uint64_t Offset, Module &M);
 }
 
 #endif
@@ -0,0 +1,155 @@
+//===- OATCommon.h - Definitions shared by the OAT passes -------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains definitions shared by the OAT instrumentation passes
+// (Nova, CFVHints) that insert calls to the oat-trampoline-lib runtime.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_OAT_OATCOMMON_H
+#define LLVM_TRANSFORMS_OAT_OATCOMMON_H
+
+#include "llvm/IR/CallingConv.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/Module.h"
+
+namespace llvm {
+namespace oat {
+
+/// Calling convention of the runtime hooks (__record_defevt, __check_useevt,
+/// __collect_*_hints). The hooks are entry stubs in trampoline.S that save
+/// x9-x15 themselves, so a hook call only clobbers x0-x8, x16-x18 and lr in
+/// the instrumented function instead of every caller-saved register.
+const CallingConv::ID HookCallingConv = CallingConv::PreserveMost;
+
+/// Def/use events of sensitive globals carry a dense compile-time ID instead
+/// of the runtime address. The ID is tagged with SensitiveIDFlag, which never
+/// appears in a user space address, so the TA can tell both keys apart.
+const uint64_t SensitiveIDFlag = 1ULL << 63;
+
+/// Section holding the sensitive globals that have an ID.
+const char *const SensitiveSectionName = ".oat_sensitive";
+
+/// Global holding the number of sensitive IDs, read by cfv_init.
+const char *const SensitiveCountName = "__oat_sensitive_count";
+
+/// Metadata on an alloca whose llvm.var.annotation was removed by
+/// -oat-preserve-annotations, so that optimized builds can promote it.
+const char *const SensitiveMDName = "oat.sensitive";
+
+/// Function attribute set by -oat-scope on the functions that may run
+/// between cfv_init() and cfv_quote().
+const char *const InScopeAttrName = "oat-in-scope";
+
+/// Module flag set by -oat-scope once the operation scope is known.
+const char *const ScopeFlagName = "oat.scoped";
+
+/// Return true if \p F has to be instrumented: -oat-scope did not run on
+/// the module, or found \p F to be part of the attested operation.
+inline bool isInScope(const Function &F) {
+  return !F.getParent()->getModuleFlag(ScopeFlagName) ||
+         F.hasFnAttribute(InScopeAttrName);
+}
+
+/// Metadata set by -wholeprogramdevirt on the virtual calls it could not
+/// turn into direct calls: !{type ID, i64 byte offset of the vtable slot}.
+const char *const VCallMDName = "oat.vcall";
+
+/// Metadata set by -collect-cfv-hints-pass on the switches that report their
+/// case index, and by -collect-path-hints-pass on the switches of its paths.
+/// The AArch64 backend leaves their jump tables alone.
+const char *const SwitchHintMDName = "oat.switch_hint";
+
+/// Kinds of the hint sites listed in .oat_sites.
+enum SiteKind {
+  SiteCondBr = 1,
+  SiteICall = 2,
+  SiteIBranch = 3,
+  SiteLoop = 4,
+  SiteSwitch = 5,
+  SitePathBr = 6, // a branch or switch of a function with path hints
+};
+
+/// Site numbers of the SitePathBr sites are the .oat_paths block index with
+/// PathSiteFlag set, out of the range of the sites -collect-cfv-hints-pass
+/// numbers in the same function.
+const uint32_t PathSiteFlag = 1U << 31;
+
+/// Section mapping each hint site to its machine address, emitted by the
+/// AArch64 AsmPrinter from the site markers.
+const char *const SitesSectionName = ".oat_sites";
+
+/// Section holding the control-flow graph of every instrumented function,
+/// emitted by the AArch64 AsmPrinter.
+const char *const CFGSectionName = ".oat_cfg";
+
+/// Terminator kinds of the blocks listed in .oat_cfg.
+enum CFGTermKind {
+  CFGFallThrough = 0, // no branch, continues in the next block
+  CFGJump = 1,        // b <target>
+  CFGCond = 2,        // b.cc/cbz/tbz <taken>, then <not taken>
+  CFGIndirect = 3,    // br, targets are the successors, e.g. a jump table
+  CFGRet = 4,
+  CFGTailCall = 5,
+  CFGNoSucc = 6,      // the block does not return, e.g. a call to abort()
+};
+
+/// How a conditional branch follows the hint bit of its site in .oat_cfg.
+enum CFGPolarity {
+  CFGPolUnknown = 0,
+  CFGPolTakenIfSet = 1,   // taken if the IR condition is true
+  CFGPolTakenIfClear = 2, // taken if the IR condition is false
+};
+
+/// Stackmap IDs of site markers carry SiteIDFlag, the site kind in bits
+/// 56-62, the function ID in bits 32-55 and the site number in bits 0-31.
+const uint64_t SiteIDFlag = 1ULL << 63;
+
+inline uint64_t getSiteID(SiteKind Kind, uint32_t FID, uint32_t Site) {
+  return SiteIDFlag | ((uint64_t)Kind << 56) |
+         ((uint64_t)(FID & 0xffffff) << 32) | Site;
+}
+
+/// Insert a site marker at the insertion point of \p B. It is a stackmap
+/// without shadow bytes, so it emits no code, only a label. A non-zero \p Arg
+/// is passed as a constant live value and listed with the site.
+inline CallInst *createSiteMarker(IRBuilder<> &B, uint64_t ID,
+                                  unsigned Arg = 0) {
+  Module *M = B.GetInsertBlock()->getModule();
+  Function *SM = Intrinsic::getDeclaration(M, Intrinsic::experimental_stackmap);
+  if (Arg)
+    return B.CreateCall(SM, {B.getInt64(ID), B.getInt32(0), B.getInt32(Arg)});
+  return B.CreateCall(SM, {B.getInt64(ID), B.getInt32(0)});
+}
+
+/// Return the declaration of the runtime hook \p Name, inserting it with
+/// type \p FTy and the hook calling convention if it does not exist yet.
+inline Function *getOrInsertHook(Module &M, StringRef Name,
+                                 FunctionType *FTy) {
+  Function *F = cast<Function>(M.getOrInsertFunction(Name, FTy));
+  F->setCallingConv(HookCallingConv);
+  return F;
+}
+
+/// Create a call to \p Hook at the insertion point of \p B. The call site
+/// must use the same convention as the declaration.
+inline CallInst *createHookCall(IRBuilder<> &B, Function *Hook,
+                                ArrayRef<Value *> Args) {
+  CallInst *CI = B.CreateCall(Hook, Args);
+  CI->setCallingConv(Hook->getCallingConv());
+  return CI;
+}
+
+} // end namespace oat
+} // end namespace llvm
+
+#endif // LLVM_TRANSFORMS_OAT_OATCOMMON_H
@@ -20,11 +20,14 @@
 #include "AArch64Subtarget.h"
 #include "InstPrinter/AArch64InstPrinter.h"
 #include "MCTargetDesc/AArch64MCExpr.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/CodeGen/AsmPrinter.h"
 #include "llvm/CodeGen/MachineInstr.h"
+#include "llvm/CodeGen/MachineJumpTableInfo.h"
 #include "llvm/CodeGen/MachineModuleInfoImpls.h"
 #include "llvm/CodeGen/StackMaps.h"
 #include "llvm/CodeGen/TargetLoweringObjectFileImpl.h"
@@ -40,13 +43,20 @@
 #include "llvm/MC/MCSymbolELF.h"
 #include "llvm/MC/MCSectionELF.h"
 #include "llvm/MC/MCSectionMachO.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/OAT/OATCommon.h"
 using namespace llvm;
 
 #define DEBUG_TYPE "asm-printer"
 
+static cl::opt<bool>
+    EmitOATCFG("aarch64-oat-cfg", cl::Hidden, cl::init(true),
+               cl::desc("Emit the .oat_cfg control-flow graph of the "
+                        "functions verified by OAT"));
+
 namespace {
 
 class AArch64AsmPrinter : public AsmPrinter {
@@ -57,7 +67,7 @@ class AArch64AsmPrinter : public AsmPrinter {
 public:
   AArch64AsmPrinter(TargetMachine &TM, std::unique_ptr<MCStreamer> Streamer)
       : AsmPrinter(TM, std::move(Streamer)), MCInstLowering(OutContext, *this),
-        SM(*this), AArch64FI(nullptr) {}
+        SM(*this), AArch64FI(nullptr), CFVControlFlowMap(false) {}
 
   StringRef getPassName() const override { return "AArch64 Assembly Printer"; }
 
@@ -93,6 +103,8 @@ public:
   bool runOnMachineFunction(MachineFunction &F) override {
     AArch64FI = F.getInfo<AArch64FunctionInfo>();
     STI = static_cast<const AArch64Subtarget*>(&F.getSubtarget());
+    CFVControlFlowMap = EmitOATCFG && TM.getTargetTriple().isOSBinFormatELF() &&
+                        oat::isInScope(*F.getFunction());
     bool Result = AsmPrinter::runOnMachineFunction(F);
     emitXRayTable();
     return Result;
@@ -115,6 +127,7 @@ private:
   void PrintDebugValueComment(const MachineInstr *MI, raw_ostream &OS);
 
   void EmitFunctionBodyEnd() override;
+  void EmitBasicBlockStart(const MachineBasicBlock &MBB) const override;
 
   MCSymbol *GetCPISymbol(unsigned CPID) const override;
   void EmitEndOfAsmFile(Module &M) override;
@@ -123,11 +136,43 @@ private:
   /// \brief Emit the LOHs contained in AArch64FI.
   void EmitLOHs();
 
+  /// \brief Emit the .oat_jt records for the jump table dispatches reported
+  /// by the control flow verification pass.
+  void EmitCFVJumpTables();
+
+  /// \brief Emit the .oat_implicit_ret entries for the rets left
+  /// uninstrumented by the control flow verification pass.
+  void EmitCFVImplicitRets();
+
+  /// \brief Emit the .oat_sites entries for the hint site markers.
+  void EmitCFVSites();
+
+  /// \brief Emit the .oat_cfg record of the function.
+  void EmitCFVControlFlowMap();
+
   /// Emit instruction to set float register to zero.
   void EmitFMov0(const MachineInstr &MI);
 
   typedef std::map<const MachineInstr *, MCSymbol *> MInstToMCSymbol;
   MInstToMCSymbol LOHInstToLabel;
+  MInstToMCSymbol CFVJumpTableToLabel;
+  SmallVector<MCSymbol *, 8> CFVImplicitRetLabels;
+
+  struct CFVSite {
+    MCSymbol *Label;
+    uint64_t ID;
+    unsigned Line;
+    unsigned Col;
+    unsigned Arg;
+    const MachineBasicBlock *MBB;
+  };
+  SmallVector<CFVSite, 16> CFVSites;
+
+  // labels of the .oat_cfg record, see EmitCFVControlFlowMap
+  bool CFVControlFlowMap;
+  mutable DenseMap<const MachineBasicBlock *, MCSymbol *> CFVBlockLabels;
+  MInstToMCSymbol CFVTerminatorToLabel;
+  SmallVector<std::pair<MCSymbol *, unsigned>, 2> CFVOperationCalls;
 };
 
 } // end of anonymous namespace
@@ -217,9 +262,316 @@ void AArch64AsmPrinter::EmitLOHs() {
   }
 }
 
+// Each .oat_jt record describes one instrumented jump table dispatch:
+//   .xword <address of br>
+//   .word  <jump table index>, <number of entries>
+//   .xword <target block address> * number of entries
+void AArch64AsmPrinter::EmitCFVJumpTables() {
+  const std::vector<MachineJumpTableEntry> &JT =
+      MF->getJumpTableInfo()->getJumpTables();
+  MCSection *Section =
+      OutContext.getELFSection(".oat_jt", ELF::SHT_PROGBITS, 0);
+
+  OutStreamer->PushSection();
+  OutStreamer->SwitchSection(Section);
+  for (const auto &D : AArch64FI->getCFVJumpTables()) {
+    MInstToMCSymbol::iterator LabelIt = CFVJumpTableToLabel.find(D.first);
+    assert(LabelIt != CFVJumpTableToLabel.end() &&
+           "Label hasn't been inserted for jump table dispatch");
+    const std::vector<MachineBasicBlock *> &MBBs = JT[D.second].MBBs;
+
+    OutStreamer->EmitSymbolValue(LabelIt->second, 8);
+    OutStreamer->EmitIntValue(D.second, 4);
+    OutStreamer->EmitIntValue(MBBs.size(), 4);
+    for (const MachineBasicBlock *MBB : MBBs)
+      OutStreamer->EmitSymbolValue(MBB->getSymbol(), 8);
+  }
+  OutStreamer->PopSection();
+  CFVJumpTableToLabel.clear();
+}
+
+// .oat_implicit_ret holds the address (.xword) of every ret whose target is
+// statically known and therefore not reported at runtime.
+void AArch64AsmPrinter::EmitCFVImplicitRets() {
+  MCSection *Section =
+      OutContext.getELFSection(".oat_implicit_ret", ELF::SHT_PROGBITS, 0);
+
+  OutStreamer->PushSection();
+  OutStreamer->SwitchSection(Section);
+  for (MCSymbol *Label : CFVImplicitRetLabels)
+    OutStreamer->EmitSymbolValue(Label, 8);
+  OutStreamer->PopSection();
+  CFVImplicitRetLabels.clear();
+}
+
+// Each .oat_sites entry maps a hint site to the code:
+//   .xword <address after the hook call>
+//   .xword <site ID: kind, function ID and site number>
+//   .word  <source line>
+//   .hword <source column>, <marker argument, e.g. the switch hint width>
+void AArch64AsmPrinter::EmitCFVSites() {
+  MCSection *Section =
+      OutContext.getELFSection(oat::SitesSectionName, ELF::SHT_PROGBITS, 0);
+
+  OutStreamer->PushSection();
+  OutStreamer->SwitchSection(Section);
+  for (const CFVSite &S : CFVSites) {
+    OutStreamer->EmitSymbolValue(S.Label, 8);
+    OutStreamer->EmitIntValue(S.ID, 8);
+    OutStreamer->EmitIntValue(S.Line, 4);
+    OutStreamer->EmitIntValue(S.Col, 2);
+    OutStreamer->EmitIntValue(S.Arg, 2);
+  }
+  OutStreamer->PopSection();
+  CFVSites.clear();
+}
+
 void AArch64AsmPrinter::EmitFunctionBodyEnd() {
   if (!AArch64FI->getLOHRelated().empty())
     EmitLOHs();
+  if (!AArch64FI->getCFVJumpTables().empty() &&
+      TM.getTargetTriple().isOSBinFormatELF())
+    EmitCFVJumpTables();
+  if (!AArch64FI->getCFVImplicitRets().empty() &&
+      TM.getTargetTriple().isOSBinFormatELF())
+    EmitCFVImplicitRets();
+  // before .oat_sites, the hint sites are mapped to their branches
+  if (CFVControlFlowMap)
+    EmitCFVControlFlowMap();
+  if (!CFVSites.empty() && TM.getTargetTriple().isOSBinFormatELF())
+    EmitCFVSites();
+}
+
+void AArch64AsmPrinter::EmitBasicBlockStart(const MachineBasicBlock &MBB) const {
+  AsmPrinter::EmitBasicBlockStart(MBB);
+
+  // blocks only reached by fallthrough have no label of their own
+  if (CFVControlFlowMap) {
+    MCSymbol *Label = createTempSymbol("oat_bb");
+    OutStreamer->EmitLabel(Label);
+    CFVBlockLabels[&MBB] = Label;
+  }
+}
+
+// The IR block a machine block branches to, skipping the blocks created in
+// codegen to split critical edges.
+static const BasicBlock *getIRTarget(const MachineBasicBlock *MBB) {
+  for (unsigned i = 0; MBB && i < 4; i++) {
+    if (MBB->getBasicBlock())
+      return MBB->getBasicBlock();
+    if (MBB->succ_size() != 1)
+      return nullptr;
+    MBB = *MBB->succ_begin();
+  }
+  return nullptr;
+}
+
+// Return the polarity of the conditional branch BrMI with respect to the IR
+// branch of its block.
+static unsigned getBranchPolarity(const MachineInstr &BrMI) {
+  const MachineBasicBlock *MBB = BrMI.getParent();
+  const BasicBlock *BB = MBB->getBasicBlock();
+  const MachineBasicBlock *Taken = nullptr, *NotTaken = nullptr;
+
+  auto *BI = BB ? dyn_cast<BranchInst>(BB->getTerminator()) : nullptr;
+  if (BI == nullptr || !BI->isConditional() ||
+      BI->getSuccessor(0) == BI->getSuccessor(1))
+    return oat::CFGPolUnknown;
+
+  for (const MachineOperand &MO : BrMI.operands())
+    if (MO.isMBB())
+      Taken = MO.getMBB();
+  for (const MachineBasicBlock *Succ : MBB->successors())
+    if (Succ != Taken)
+      NotTaken = Succ;
+
+  // a condition split over several machine branches maps to none of them
+  if (getIRTarget(Taken) == BI->getSuccessor(0) ||
+      getIRTarget(NotTaken) == BI->getSuccessor(1))
+    return oat::CFGPolTakenIfSet;
+  if (getIRTarget(Taken) == BI->getSuccessor(1) ||
+      getIRTarget(NotTaken) == BI->getSuccessor(0))
+    return oat::CFGPolTakenIfClear;
+  return oat::CFGPolUnknown;
+}
+
+// The machine blocks the switch ending the IR block of MBB dispatches to,
+// indexed like its case index hint: the default destination, then the cases.
+// The dispatch goes through the blocks codegen created for the switch, which
+// keep its IR block. A destination codegen folded away is left null.
+static void getSwitchDests(const MachineBasicBlock *MBB,
+                           SmallVectorImpl<const MachineBasicBlock *> &Dests) {
+  const BasicBlock *BB = MBB->getBasicBlock();
+  auto *SI = BB ? dyn_cast<SwitchInst>(BB->getTerminator()) : nullptr;
+  DenseMap<const BasicBlock *, const MachineBasicBlock *> Reached;
+  SmallPtrSet<const MachineBasicBlock *, 16> Visited;
+  SmallVector<const MachineBasicBlock *, 16> Stack(1, MBB);
+
+  if (SI == nullptr)
+    return;
+
+  while (!Stack.empty()) {
+    const MachineBasicBlock *Cur = Stack.pop_back_val();
+    if (!Visited.insert(Cur).second)
+      continue;
+    for (const MachineBasicBlock *Succ : Cur->successors()) {
+      if (Succ != MBB && Succ->getBasicBlock() == BB)
+        Stack.push_back(Succ);
+      else if (const BasicBlock *Target = getIRTarget(Succ))
+        Reached.insert(std::make_pair(Target, Succ));
+    }
+  }
+
+  Dests.push_back(Reached.lookup(SI->getDefaultDest()));
+  for (auto Case : SI->cases())
+    Dests.push_back(Reached.lookup(Case.getCaseSuccessor()));
+}
+
+// Each .oat_cfg record holds the control-flow graph of one function:
+//   .xword <function start>, <function end>
+//   .word  <number of blocks>, <number of hint sites>
+//   .word  <number of operation calls>, 0
+//   for each block, in layout order:
+//     .xword <block start>, <address of the first terminator, 0 if none>
+//     .word  <terminator kind>, <number of targets>
+//     .xword <target block start> * number of targets
+//   for each conditional branch, switch and path branch site:
+//     .xword <site ID>, <address of the branch, 0 if not found>
+//     .word  <polarity>, <index of the block of the branch>
+//     .word  <number of destinations>, 0
+//     .xword <destination block start, 0 if not found> * number of destinations
+//   where only a switch has destinations, one per case index, which is the
+//   successor number of its IR switch
+//   for each call to cfv_init or cfv_quote:
+//     .xword <address of the bl>
+//     .word  <1 for cfv_init, 2 for cfv_quote>, 0
+void AArch64AsmPrinter::EmitCFVControlFlowMap() {
+  const TargetInstrInfo *TII = STI->getInstrInfo();
+  MCSection *Section =
+      OutContext.getELFSection(oat::CFGSectionName, ELF::SHT_PROGBITS, 0);
+  DenseMap<const MachineBasicBlock *, unsigned> BlockIndex;
+  SmallVector<const CFVSite *, 16> BranchSites;
+
+  MCSymbol *FnEnd = createTempSymbol("oat_fn_end");
+  OutStreamer->EmitLabel(FnEnd);
+
+  unsigned NumBlocks = 0;
+  for (const MachineBasicBlock &MBB : *MF)
+    BlockIndex[&MBB] = NumBlocks++;
+  for (const CFVSite &S : CFVSites) {
+    unsigned Kind = (S.ID >> 56) & 0x7f;
+    if (Kind == oat::SiteCondBr || Kind == oat::SiteSwitch ||
+        Kind == oat::SitePathBr)
+      BranchSites.push_back(&S);
+  }
+
+  auto getTermLabel = [&](const MachineInstr *MI) -> MCSymbol * {
+    MInstToMCSymbol::iterator LabelIt = CFVTerminatorToLabel.find(MI);
+    return LabelIt == CFVTerminatorToLabel.end() ? nullptr : LabelIt->second;
+  };
+  auto emitAddress = [&](MCSymbol *Label) {
+    if (Label)
+      OutStreamer->EmitSymbolValue(Label, 8);
+    else
+      OutStreamer->EmitIntValue(0, 8);
+  };
+
+  OutStreamer->PushSection();
+  OutStreamer->SwitchSection(Section);
+  OutStreamer->EmitSymbolValue(CurrentFnSym, 8);
+  OutStreamer->EmitSymbolValue(FnEnd, 8);
+  OutStreamer->EmitIntValue(NumBlocks, 4);
+  OutStreamer->EmitIntValue(BranchSites.size(), 4);
+  OutStreamer->EmitIntValue(CFVOperationCalls.size(), 4);
+  OutStreamer->EmitIntValue(0, 4);
+
+  for (const MachineBasicBlock &MBB : *MF) {
+    MachineBasicBlock *TBB = nullptr, *FBB = nullptr;
+    SmallVector<MachineOperand, 4> Cond;
+    SmallVector<const MachineBasicBlock *, 4> Targets;
+    auto Next = std::next(MBB.getIterator());
+    const MachineBasicBlock *Layout = Next == MF->end() ? nullptr : &*Next;
+    MachineBasicBlock::const_iterator Term = MBB.getFirstTerminator();
+    unsigned Kind;
+
+    // analyzeBranch leaves the block alone without AllowModify
+    if (!TII->analyzeBranch(const_cast<MachineBasicBlock &>(MBB), TBB, FBB,
+                            Cond, false)) {
+      if (TBB == nullptr) {
+        Kind = MBB.succ_empty() || !Layout ? oat::CFGNoSucc : oat::CFGFallThrough;
+        if (Kind == oat::CFGFallThrough)
+          Targets.push_back(Layout);
+      } else if (Cond.empty()) {
+        Kind = oat::CFGJump;
+        Targets.push_back(TBB);
+      } else {
+        Kind = oat::CFGCond;
+        Targets.push_back(TBB);
+        Targets.push_back(FBB ? FBB : Layout);
+      }
+    } else {
+      const MachineInstr &Last = MBB.back();
+      if (Last.isReturn() && Last.isCall())
+        Kind = oat::CFGTailCall;
+      else if (Last.isReturn())
+        Kind = oat::CFGRet;
+      else if (Last.isIndirectBranch()) {
+        Kind = oat::CFGIndirect;
+        Targets.append(MBB.succ_begin(), MBB.succ_end());
+      } else
+        Kind = oat::CFGNoSucc;
+    }
+
+    emitAddress(CFVBlockLabels.lookup(&MBB));
+    emitAddress(Term == MBB.end() ? nullptr : getTermLabel(&*Term));
+    OutStreamer->EmitIntValue(Kind, 4);
+    OutStreamer->EmitIntValue(Targets.size(), 4);
+    for (const MachineBasicBlock *Target : Targets)
+      emitAddress(Target ? CFVBlockLabels.lookup(Target) : nullptr);
+  }
+
+  for (const CFVSite *S : BranchSites) {
+    const MachineInstr *BrMI = nullptr;
+    unsigned Polarity = oat::CFGPolUnknown;
+    SmallVector<const MachineBasicBlock *, 8> Dests;
+    const BasicBlock *BB = S->MBB->getBasicBlock();
+    bool Switch = ((S->ID >> 56) & 0x7f) == oat::SiteSwitch ||
+                  (((S->ID >> 56) & 0x7f) == oat::SitePathBr && BB &&
+                   isa<SwitchInst>(BB->getTerminator()));
+
+    // the branch of a switch is its first dispatch, the one of a
+    // conditional branch the first conditional branch of its block
+    for (const MachineInstr &MI : S->MBB->terminators()) {
+      if (Switch || MI.isConditionalBranch()) {
+        BrMI = &MI;
+        break;
+      }
+    }
+    if (BrMI && BrMI->isConditionalBranch() && !Switch)
+      Polarity = getBranchPolarity(*BrMI);
+    if (Switch)
+      getSwitchDests(S->MBB, Dests);
+
+    OutStreamer->EmitIntValue(S->ID, 8);
+    emitAddress(getTermLabel(BrMI));
+    OutStreamer->EmitIntValue(Polarity, 4);
+    OutStreamer->EmitIntValue(BlockIndex.lookup(S->MBB), 4);
+    OutStreamer->EmitIntValue(Dests.size(), 4);
+    OutStreamer->EmitIntValue(0, 4);
+    for (const MachineBasicBlock *Dest : Dests)
+      emitAddress(Dest ? CFVBlockLabels.lookup(Dest) : nullptr);
+  }
+
+  for (auto &Call : CFVOperationCalls) {
+    OutStreamer->EmitSymbolValue(Call.first, 8);
+    OutStreamer->EmitIntValue(Call.second, 4);
+    OutStreamer->EmitIntValue(0, 4);
+  }
+  OutStreamer->PopSection();
+
+  CFVBlockLabels.clear();
+  CFVTerminatorToLabel.clear();
+  CFVOperationCalls.clear();
 }
 
 /// GetCPISymbol - Return the symbol for the specified constant pool entry.
@@ -420,6 +772,23 @@ void AArch64AsmPrinter::PrintDebugValueComment(const MachineInstr *MI,
 void AArch64AsmPrinter::LowerSTACKMAP(MCStreamer &OutStreamer, StackMaps &SM,
                                       const MachineInstr &MI) {
   unsigned NumNOPBytes = StackMapOpers(&MI).getNumPatchBytes();
+  uint64_t ID = StackMapOpers(&MI).getID();
+
+  // OAT hint site markers only need a label, listed in .oat_sites
+  if (ID & oat::SiteIDFlag) {
+    const DebugLoc &DL = MI.getDebugLoc();
+    unsigned VarIdx = StackMapOpers(&MI).getVarIdx();
+    unsigned Arg = 0;
+    MCSymbol *SiteLabel = createTempSymbol("oat_site");
+    OutStreamer.EmitLabel(SiteLabel);
+    // the optional argument is a constant live value, <ConstantOp>, <imm>
+    if (VarIdx + 1 < MI.getNumOperands() && MI.getOperand(VarIdx).isImm() &&
+        MI.getOperand(VarIdx).getImm() == StackMaps::ConstantOp)
+      Arg = MI.getOperand(VarIdx + 1).getImm();
+    CFVSites.push_back({SiteLabel, ID, DL ? DL.getLine() : 0,
+                        DL ? DL.getCol() : 0, Arg, MI.getParent()});
+    return;
+  }
 
   SM.recordStackMap(MI);
   assert(NumNOPBytes % 4 == 0 && "Invalid number of NOP bytes requested!");
@@ -524,6 +893,42 @@ void AArch64AsmPrinter::EmitFMov0(const MachineInstr &MI) {
 #include "AArch64GenMCPseudoLowering.inc"
 
 void AArch64AsmPrinter::EmitInstruction(const MachineInstr *MI) {
+  // Labels referenced from the .oat_* sections come first, pseudo
+  // instructions like RET_ReallyLR need them as well.
+  if (AArch64FI->getCFVJumpTables().count(MI)) {
+    // Generate a label for the jump table dispatch, referenced from .oat_jt
+    MCSymbol *JTLabel = createTempSymbol("oat_jt");
+    CFVJumpTableToLabel[MI] = JTLabel;
+    OutStreamer->EmitLabel(JTLabel);
+  }
+
+  if (AArch64FI->getCFVImplicitRets().count(MI)) {
+    // Generate a label for the uninstrumented ret, referenced from
+    // .oat_implicit_ret
+    MCSymbol *RetLabel = createTempSymbol("oat_ret");
+    CFVImplicitRetLabels.push_back(RetLabel);
+    OutStreamer->EmitLabel(RetLabel);
+  }
+
+  if (CFVControlFlowMap && MI->isTerminator()) {
+    // Generate a label for the branch, referenced from .oat_cfg
+    MCSymbol *TermLabel = createTempSymbol("oat_br");
+    CFVTerminatorToLabel[MI] = TermLabel;
+    OutStreamer->EmitLabel(TermLabel);
+  }
+
+  if (CFVControlFlowMap && MI->getOpcode() == AArch64::BL &&
+      MI->getOperand(0).isGlobal()) {
+    // the attested operation runs between these calls
+    StringRef Callee = MI->getOperand(0).getGlobal()->getName();
+    unsigned Kind = Callee == "cfv_init" ? 1 : Callee == "cfv_quote" ? 2 : 0;
+    if (Kind) {
+      MCSymbol *CallLabel = createTempSymbol("oat_op");
+      CFVOperationCalls.push_back(std::make_pair(CallLabel, Kind));
+      OutStreamer->EmitLabel(CallLabel);
+    }
+  }
+
   // Do any auto-generated pseudo lowerings.
   if (emitPseudoExpansionLowering(*OutStreamer, MI))
     return;
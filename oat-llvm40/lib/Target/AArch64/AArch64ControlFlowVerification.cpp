@@ -17,6 +17,25 @@
 //          pop x0 
 //      L1: br xA
 //
+// =*= jump table jmp =*=
+// before insert check
+//          ldr xA, [xT, xI, lsl #3]  /* xT: jump table base, xI: case index */
+//      L1: br xA
+// after insert check
+//          push x0
+//          mov x0, xI
+//          movk x0, #JTI, lsl #32
+//          bl __cfv_ijmp_jt /* param0:(JTI << 32) | index */
+//          pop x0
+//          ldr xA, [xT, xI, lsl #3]
+//      L1: br xA
+// L1 and the jump table targets are recorded in the .oat_jt section, so the
+// verifier resolves the target from the index alone.
+//
+// The switches tagged with oat::SwitchHintMDName (see CollectCFVHints) already
+// report their case index, their jump table jmp is neither instrumented nor
+// recorded in .oat_jt.
+//
 // =*= indirect call =*=
 // before insert check
 //      L1: blr xA
@@ -27,6 +46,11 @@
 //          pop x0 
 //      L1: blr xA
 //
+// In functions marked "oat-icall-hints" (see CollectCFVHints) the indirect
+// calls of the hint sites already report the index of their target in
+// .oat_icall. The blr directly following the site marker of such a call is not
+// instrumented, any other blr is.
+//
 // =*= ret =*=
 // before insert check
 //      L1: ret [xA]
@@ -37,19 +61,30 @@
 //          pop x0 
 //      L1: ret [xA]
 //
+// =*= implicit ret =*=
+// Functions marked "oat-implicit-ret" (see MarkImplicitReturns) have a single
+// call site. If they never save LR to the stack, their ret is not instrumented
+// but listed in .oat_implicit_ret.
+//
 //===----------------------------------------------------------------------===//
 
 #include "AArch64.h"
 #include "AArch64InstrInfo.h"
+#include "AArch64MachineFunctionInfo.h"
 #include "AArch64Subtarget.h"
 #include "AArch64TargetMachine.h"
 #include "llvm/CodeGen/MachineInstr.h"
 #include "llvm/CodeGen/MachineBasicBlock.h"
 #include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineFrameInfo.h"
+#include "llvm/CodeGen/MachineJumpTableInfo.h"
 #include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/CodeGen/PseudoSourceValue.h"
+#include "llvm/CodeGen/StackMaps.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/OAT/OATCommon.h"
 
 #include "AArch64ControlFlowVerification.h"
 
@@ -162,6 +197,194 @@ bool AArch64ControlFlowVerification::instrumentIndirectJump (MachineBasicBlock &
     return handleControlTransfer(MBB, MI, DL, TII, sym, targetReg);
 }
 
+// Return true if the blr MI directly follows the site marker of an indirect
+// call hint, without another call in between.
+static bool followsICallSite(const MachineInstr &MI) {
+    bool Site = false;
+
+    for (const MachineInstr &I : *MI.getParent()) {
+        if (&I == &MI)
+            return Site;
+        if (I.getOpcode() == TargetOpcode::STACKMAP) {
+            uint64_t ID = StackMapOpers(&I).getID();
+            Site = (ID & oat::SiteIDFlag) && ((ID >> 56) & 0x7f) == oat::SiteICall;
+        } else if (I.isCall())
+            Site = false;
+    }
+    return false;
+}
+
+// Return true if the prologue may spill LR. The ret then loads its target
+// from the stack, where it can be overwritten, and is reported even for a
+// single call site.
+static bool mayHaveSavedLR(const MachineFunction &MF) {
+    const MachineFrameInfo &MFI = MF.getFrameInfo();
+
+    if (MFI.hasCalls())
+        return true;
+    for (const CalleeSavedInfo &CS : MFI.getCalleeSavedInfo()) {
+        if (CS.getReg() == AArch64::LR)
+            return true;
+    }
+    return false;
+}
+
+// Return true if MBB dispatches a switch with a case index hint. The blocks
+// codegen creates to lower a switch keep the IR block of the switch.
+static bool hasSwitchHint(const MachineBasicBlock &MBB) {
+    const BasicBlock *BB = MBB.getBasicBlock();
+    return BB && BB->getTerminator() &&
+           BB->getTerminator()->getMetadata(oat::SwitchHintMDName);
+}
+
+// verifiy jump table dispatch, br xR where xR is loaded from a jump table
+bool AArch64ControlFlowVerification::instrumentJumpTableJump (MachineBasicBlock &MBB,
+                         MachineInstr &MI,
+                         const DebugLoc &DL,
+                         const TargetInstrInfo *TII,
+                         const char *sym) {
+    MachineFunction &MF = *MBB.getParent();
+    const MachineJumpTableInfo *MJTI = MF.getJumpTableInfo();
+    MachineInstr *LoadMI = nullptr;
+    int JTI = -1;
+    unsigned indexReg;
+
+    DEBUG(dbgs() << __func__ << "\n");
+    DEBUG(MI.print(dbgs()));
+
+    if (MJTI == nullptr || MJTI->isEmpty())
+        return false;
+
+    // find the jump table load and the jump table it addresses (adrp/add with
+    // a jump table operand) in front of the br
+    for (MachineBasicBlock::iterator I = MBB.begin(); &*I != &MI; ++I) {
+        for (const MachineOperand &MO : I->operands())
+            if (MO.isJTI())
+                JTI = MO.getIndex();
+
+        for (const MachineMemOperand *MMO : I->memoperands()) {
+            const PseudoSourceValue *PSV = MMO->getPseudoValue();
+            if (PSV && PSV->kind() == PseudoSourceValue::JumpTable)
+                LoadMI = &*I;
+        }
+    }
+
+    if (LoadMI == nullptr)
+        return false;
+
+    // the table base may have been hoisted out of the block, then pick the
+    // table whose targets are all successors of this block
+    const std::vector<MachineJumpTableEntry> &JT = MJTI->getJumpTables();
+    for (unsigned i = 0; JTI < 0 && i < JT.size(); i++) {
+        bool match = !JT[i].MBBs.empty();
+        for (MachineBasicBlock *Target : JT[i].MBBs)
+            match &= MBB.isSuccessor(Target);
+        if (match)
+            JTI = i;
+    }
+
+    if (JTI < 0 || JT[JTI].MBBs.size() > CFV_JT_MAX_ENTRIES)
+        return false;
+
+    // only the register offset forms keep the case index in a register,
+    // ldr xA, [xT, xI, lsl #3] (static) or ldrsw xA, [xT, xI, lsl #2] (pic)
+    switch (LoadMI->getOpcode()) {
+      case AArch64::LDRXroX:
+      case AArch64::LDRSWroX:
+      case AArch64::LDRXroW:
+      case AArch64::LDRSWroW:
+        indexReg = LoadMI->getOperand(2).getReg();
+        break;
+      default:
+        return false;
+    }
+
+    MF.getInfo<AArch64FunctionInfo>()->addCFVJumpTable(&MI, JTI);
+
+    return handleJumpTableTransfer(MBB, *LoadMI, DL, TII, sym, indexReg, JTI);
+}
+
+bool AArch64ControlFlowVerification::handleJumpTableTransfer(MachineBasicBlock &MBB,
+                         MachineInstr &LoadMI,
+                         const DebugLoc &DL,
+                         const TargetInstrInfo *TII,
+                         const char *sym,
+                         unsigned indexReg,
+                         unsigned JTI) {
+
+    MachineInstr *BMI;
+
+    DEBUG(dbgs() << __func__ << "\n");
+
+    // sub sp, sp, 16
+    BMI = BuildMI(MBB, LoadMI, DL, TII->get(AArch64::SUBXri))
+        .addReg(AArch64::SP)
+        .addReg(AArch64::SP)
+        .addImm(16)
+        .addImm(0); /*shift imm*/
+
+    DEBUG(BMI->print(dbgs()));
+
+    // stp r0,lr, [sp]
+    BMI = BuildMI(MBB, LoadMI, DL, TII->get(AArch64::STPXi))
+        .addReg(AArch64::X0) //src reg
+        .addReg(AArch64::LR) //src reg
+        .addReg(AArch64::SP)
+        .addImm(0); /*offset imm*/
+
+    DEBUG(BMI->print(dbgs()));
+
+    // mov x0, xI, a 32-bit index register is zero extended by orr wI
+    if (AArch64::GPR32RegClass.contains(indexReg))
+        BMI = BuildMI(MBB, LoadMI, DL, TII->get(AArch64::ORRWrs))
+            .addReg(AArch64::W0, RegState::Define)
+            .addReg(AArch64::WZR)
+            .addReg(indexReg)
+            .addImm(0); /* shift imm */
+    else
+        BMI = BuildMI(MBB, LoadMI, DL, TII->get(AArch64::ORRXrs))
+            .addReg(AArch64::X0, RegState::Define)
+            .addReg(AArch64::XZR)
+            .addReg(indexReg)
+            .addImm(0); /* shift imm */
+
+    DEBUG(BMI->print(dbgs()));
+
+    // movk x0, #JTI, lsl #32
+    BMI = BuildMI(MBB, LoadMI, DL, TII->get(AArch64::MOVKXi))
+        .addReg(AArch64::X0, RegState::Define)
+        .addReg(AArch64::X0)
+        .addImm(JTI & 0xffff)
+        .addImm(32); /* shift imm */
+
+    DEBUG(BMI->print(dbgs()));
+
+    // bl sym
+    BMI = BuildMI(MBB, LoadMI, DL, TII->get(AArch64::BL)).addExternalSymbol(sym);
+
+    DEBUG(BMI->print(dbgs()));
+
+    // ldp x0,lr [sp]
+    BMI = BuildMI(MBB, LoadMI, DL, TII->get(AArch64::LDPXi))
+        .addReg(AArch64::X0, RegState::Define) //src1 reg
+        .addReg(AArch64::LR, RegState::Define) //src2 reg
+        .addReg(AArch64::SP)
+        .addImm(0); /* offset imm */
+
+    DEBUG(BMI->print(dbgs()));
+
+    // add sp, sp, 16
+    BMI = BuildMI(MBB, LoadMI, DL, TII->get(AArch64::ADDXri))
+        .addReg(AArch64::SP)
+        .addReg(AArch64::SP)
+        .addImm(16)
+        .addImm(0); /* shift imm */
+
+    DEBUG(BMI->print(dbgs()));
+
+    return true;
+}
+
 // verifiy ret inst, ret [xR], xR default is lr
 bool AArch64ControlFlowVerification::instrumentRet (MachineBasicBlock &MBB,
                          MachineInstr &MI,
@@ -201,10 +424,23 @@ bool AArch64ControlFlowVerification::runOnMachineFunction(MachineFunction &MF) {
   const TargetInstrInfo *TII = MF.getSubtarget().getInstrInfo();
   const char* symICall = "__cfv_icall";
   const char* symIJmp = "__cfv_ijmp";
+  const char* symIJmpJT = "__cfv_ijmp_jt";
   const char* symRet = "__cfv_ret";
 
   DEBUG(dbgs() << "***** AArch64ControlFlowVerification *****\n");
 
+  // not run by the attested operation, see -oat-scope
+  if (!oat::isInScope(*MF.getFunction()))
+    return false;
+
+  // the ret target of single caller functions is statically known, as long
+  // as it stays in LR
+  bool implicitRet = MF.getFunction()->hasFnAttribute("oat-implicit-ret") &&
+                     !mayHaveSavedLR(MF);
+  // the indirect calls of the hint sites report their target themselves
+  bool icallHints = MF.getFunction()->hasFnAttribute("oat-icall-hints");
+  AArch64FunctionInfo *AFI = MF.getInfo<AArch64FunctionInfo>();
+
   for (MachineFunction::iterator FI = MF.begin(); FI != MF.end(); ++FI) {
     MachineBasicBlock& MBB = *FI;
 
@@ -216,16 +452,29 @@ bool AArch64ControlFlowVerification::runOnMachineFunction(MachineFunction &MF) {
           MI.getDesc().isReturn()) {
         switch(MI.getOpcode()) {
           case AArch64::BLR:
-            MadeChange |= instrumentIndirectCall(MBB,MI,MI.getDebugLoc(),TII,symICall);
+            if (!icallHints || !followsICallSite(MI))
+              MadeChange |= instrumentIndirectCall(MBB,MI,MI.getDebugLoc(),TII,symICall);
             break;
           case AArch64::BR:
-            MadeChange |= instrumentIndirectJump(MBB,MI,MI.getDebugLoc(),TII,symIJmp);
+            // the switch reports its case index itself
+            if (hasSwitchHint(MBB))
+              break;
+            if (instrumentJumpTableJump(MBB,MI,MI.getDebugLoc(),TII,symIJmpJT))
+              MadeChange = true;
+            else
+              MadeChange |= instrumentIndirectJump(MBB,MI,MI.getDebugLoc(),TII,symIJmp);
             break;
           case AArch64::RET:
-            MadeChange |= instrumentRet(MBB,MI,MI.getDebugLoc(),TII,symRet);
+            if (implicitRet)
+              AFI->addCFVImplicitRet(&MI);
+            else
+              MadeChange |= instrumentRet(MBB,MI,MI.getDebugLoc(),TII,symRet);
             break;
           case AArch64::RET_ReallyLR:
-            MadeChange |= instrumentRetLR(MBB,MI,MI.getDebugLoc(),TII,symRet);
+            if (implicitRet)
+              AFI->addCFVImplicitRet(&MI);
+            else
+              MadeChange |= instrumentRetLR(MBB,MI,MI.getDebugLoc(),TII,symRet);
             break;
           default:
 	    /* Skip direct call(BL) instructions! */
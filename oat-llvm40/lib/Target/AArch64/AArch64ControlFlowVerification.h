@@ -17,6 +17,21 @@
 //          pop x0 
 //      L1: br xA
 //
+// =*= jump table jmp =*=
+// before insert check
+//          ldr xA, [xT, xI, lsl #3]  /* xT: jump table base, xI: case index */
+//      L1: br xA
+// after insert check
+//          push x0
+//          mov x0, xI
+//          movk x0, #JTI, lsl #32
+//          bl __cfv_ijmp_jt /* param0:(JTI << 32) | index */
+//          pop x0
+//          ldr xA, [xT, xI, lsl #3]
+//      L1: br xA
+// L1 and the jump table targets are recorded in the .oat_jt section, so the
+// verifier resolves the target from the index alone.
+//
 // =*= indirect call =*=
 // before insert check
 //      L1: blr xA
@@ -27,6 +42,10 @@
 //          pop x0 
 //      L1: blr xA
 //
+// In functions marked "oat-icall-hints" (see CollectCFVHints) every indirect
+// call already reports the index of its target in .oat_icall, the blr is not
+// instrumented.
+//
 // =*= ret =*=
 // before insert check
 //      L1: ret [xA]
@@ -37,6 +56,11 @@
 //          pop x0 
 //      L1: ret [xA]
 //
+// =*= implicit ret =*=
+// Functions marked "oat-implicit-ret" (see MarkImplicitReturns) have a single
+// call site. If they never save LR to the stack, their ret is not instrumented
+// but listed in .oat_implicit_ret.
+//
 //===----------------------------------------------------------------------===//
 
 #ifndef LLVM_LIB_TARGET_AARCH64_AARCH64ControlFlowVerification_H
@@ -46,6 +70,10 @@
 
 #define AARCH64_CONTROL_FLOW_VERIFICATION_NAME "AArch64 Control Flow Verification pass"
 
+// jump table case indices are logged in one byte, larger tables fall back to
+// the generic indirect jmp event.
+#define CFV_JT_MAX_ENTRIES 256
+
 namespace llvm {
 class AArch64ControlFlowVerification : public MachineFunctionPass {
   
@@ -63,6 +91,14 @@ class AArch64ControlFlowVerification : public MachineFunctionPass {
                            const TargetInstrInfo *TII,
                            const char *sym);
 
+  // verifiy jump table dispatch, br xR where xR is loaded from a jump table.
+  // Returns false if MI is not a jump table dispatch we can report compactly.
+  bool instrumentJumpTableJump (MachineBasicBlock &MBB,
+                           MachineInstr &MI,
+                           const DebugLoc &DL,
+                           const TargetInstrInfo *TII,
+                           const char *sym);
+
   // verifiy ret inst, ret [xR], xR default is lr
   bool instrumentRet (MachineBasicBlock &MBB,
                            MachineInstr &MI,
@@ -85,6 +121,15 @@ class AArch64ControlFlowVerification : public MachineFunctionPass {
                            const char *sym,
                            unsigned targetReg);
 
+  // report (JTI << 32) | index right before the jump table load LoadMI
+  bool handleJumpTableTransfer(MachineBasicBlock &MBB,
+                           MachineInstr &LoadMI,
+                           const DebugLoc &DL,
+                           const TargetInstrInfo *TII,
+                           const char *sym,
+                           unsigned indexReg,
+                           unsigned JTI);
+
 public:
   static char ID;
   AArch64ControlFlowVerification() : MachineFunctionPass(ID) { }
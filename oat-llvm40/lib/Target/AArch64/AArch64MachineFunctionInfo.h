@@ -15,6 +15,7 @@
 #define LLVM_LIB_TARGET_AARCH64_AARCH64MACHINEFUNCTIONINFO_H
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/CodeGen/MachineFunction.h"
@@ -179,10 +180,34 @@ public:
     LOHRelated.insert(Args.begin(), Args.end());
   }
 
+  /// Map from a jump table dispatch (BR) reported as a compact (jump table,
+  /// index) event to the index of the jump table it dispatches through.
+  typedef MapVector<const MachineInstr *, unsigned> CFVJumpTableMap;
+
+  const CFVJumpTableMap &getCFVJumpTables() const { return CFVJumpTables; }
+
+  /// Record that the jump table dispatch @p MI goes through table @p JTI.
+  void addCFVJumpTable(const MachineInstr *MI, unsigned JTI) {
+    CFVJumpTables[MI] = JTI;
+  }
+
+  const SetOfInstructions &getCFVImplicitRets() const {
+    return CFVImplicitRets;
+  }
+
+  /// Record a ret left uninstrumented because its target is statically known.
+  void addCFVImplicitRet(const MachineInstr *MI) { CFVImplicitRets.insert(MI); }
+
 private:
   // Hold the lists of LOHs.
   MILOHContainer LOHContainerSet;
   SetOfInstructions LOHRelated;
+
+  // Hold the jump table dispatches instrumented by the CFV pass.
+  CFVJumpTableMap CFVJumpTables;
+
+  // Hold the rets of functions marked "oat-implicit-ret".
+  SetOfInstructions CFVImplicitRets;
 };
 
 } // end namespace llvm
@@ -0,0 +1,1016 @@
+//===- CollectCFVHints.cpp - Collect Control-Flow Verification Hints ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+// This pass is in cooperation with the Control-Flow Verification pass for
+// AArch64 backend. In order to provide hints info for Verifier to quickly
+// verify the control-flow HASH value, we need to collect hints info for
+// those control-flow events that might cause path explosion or whose target
+// is unknown statically. -cfv-hints selects which ones (default: all):
+//
+//   cond:    every conditional branch reports its condition, using 1 bit to
+//            record basically the taken or not taken info, and every switch
+//            its case index (0 for the default, i for the i-th case) in the
+//            fewest bits that hold all of them. Both go to one bitstream.
+//   icall:   every indirect call reports the index of its target in the
+//            target table of its site, or the target itself if it is not
+//            listed there.
+//   ibranch: every indirect branch reports <function-id, site, target>.
+//   loop:    every loop counts the executions of its header, each exit of
+//            the loop reports <function-id, site, depth, iterations>.
+//
+// Functions and hint sites share one numbering. Defined functions get an ID
+// from 1 in module order, and the sites of a function are numbered in
+// instruction order whatever their kind. A site marker after each hook call
+// carries (kind, function-id, site) and, for switches, the hint width. The
+// AArch64 AsmPrinter lists it in the .oat_sites section with its machine
+// address and source location, so the verifier maps hints to addresses
+// without reparsing the binary.
+//
+// Loop counters live in the frame of the function. A counter is cleared in the
+// preheader of its loop, so a loop reports once per entry when it is left
+// instead of once per iteration, and an inner loop once per iteration of the
+// outer one. Loops are put in simplified form first to have a preheader and
+// dedicated exits. A recursive call in the loop body reports the entries of
+// the callee first, so the reports carry the depth of the activation, the
+// number of activations of the function below it, kept in a global counter
+// of the function. The entries of one loop at one depth report in order.
+//
+// The single exiting branch of a counted loop, executed once per iteration,
+// is not instrumented either: it is listed as SBR_COUNT in .oat_static_br and
+// the verifier stays in the loop until the header executions of the entry
+// reach its count.
+//
+// The backend turns switches into compare chains or jump tables, out of reach
+// of this pass. So the case index is computed in front of the switch, with a
+// lookup table for dense cases and a chain of selects otherwise, and reported
+// as a single hint. Hinted switches are tagged with oat::SwitchHintMDName so
+// that the AArch64 control-flow verification pass does not report their jump
+// tables again. Sparse switches with more cases than MaxSwitchSelects would
+// need too long a chain, they get no hint and their jump tables report
+// __cfv_ijmp_jt as before. Selects are marked unpredictable so that
+// CodeGenPrepare keeps them as csel instead of turning them into branches.
+// If -pgo-instr-use annotated the module with a profile, a switch run more
+// often than its function is entered uses a table whenever its case values
+// fit in one, dense or not, so that it runs one load instead of its chain and
+// reports one hint instead of a jump table event. A switch the profile never
+// runs keeps the chain if it is short enough, without a table in .rodata.
+//
+// The target table of an indirect call lists the functions it may call: the
+// functions its called value is built from (selects, phis and loads from
+// constant tables of functions) when they are all known, otherwise the
+// address-taken functions of its type. The tables go to the .oat_icall
+// section and the index is computed in front of the call with a chain of
+// selects, so the trace holds one byte per call instead of an address.
+// Virtual calls that -wholeprogramdevirt could not make direct are tagged with
+// their type ID and vtable slot. Their table has one entry per vtable of the
+// type, the function in that slot, and the index is the class of the object,
+// found by comparing its vtable pointer with the address points.
+// Functions with icall hints are marked "oat-icall-hints" so that the AArch64
+// control-flow verification pass does not report their blr again.
+//
+// Branches whose outcome the verifier can derive by itself are not
+// instrumented: constant conditions, conditions decided by LazyValueInfo or
+// implied by a dominating branch, and the single exiting branch of a loop with
+// a constant trip count. They keep their site and marker, and are listed in
+// the .oat_static_br section with their derivation, so the verifier replays
+// them without trace bits.
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Pass.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/Analysis/CFG.h"
+#include "llvm/Analysis/LazyValueInfo.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/TypeMetadataUtils.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/OAT/OATCommon.h"
+#include "llvm/Transforms/Scalar.h"
+#include "llvm/Transforms/Utils/ModuleUtils.h"
+
+#define DEBUG_TYPE "collect-cfv-hints"
+
+STATISTIC(NumOfCondBranches, "Number of conditional branch inst");
+STATISTIC(NumOfSwitches, "Number of switch inst");
+STATISTIC(NumOfStaticBranches, "Number of conditional branches left to the verifier");
+STATISTIC(NumOfICalls, "Number of indirect calls");
+STATISTIC(NumOfVCalls, "Number of virtual calls reported by class");
+STATISTIC(NumOfIBranches, "Number of indirect branches");
+STATISTIC(NumOfAffectedLoops, "Number of loops counted");
+
+using namespace llvm;
+
+namespace {
+enum HintKind { HintCond, HintICall, HintIBranch, HintLoop };
+}
+
+static cl::bits<HintKind> CFVHintKinds("cfv-hints", cl::CommaSeparated,
+                                  cl::desc("Hints to collect (default: all)"),
+                                  cl::values(clEnumValN(HintCond, "cond", "Conditional branches"),
+                                             clEnumValN(HintICall, "icall", "Indirect calls"),
+                                             clEnumValN(HintIBranch, "ibranch", "Indirect branches"),
+                                             clEnumValN(HintLoop, "loop", "Loop iteration counts")));
+
+static cl::opt<bool> CFVSiteMarkers("cfv-hints-site-markers", cl::Hidden,
+                                  cl::desc("Mark hint sites for the .oat_sites section"),
+                                  cl::init(true));
+
+static cl::opt<bool> EliminateStaticBranches("collect-cond-branch-hints-static", cl::Hidden,
+                                  cl::desc("Do not instrument branches the verifier can decide statically"),
+                                  cl::init(true));
+
+static cl::opt<bool> CFVHintsProfile("collect-cfv-hints-profile", cl::Hidden,
+                                  cl::desc("Pick the case index lookup of switches by the profile"),
+                                  cl::init(true));
+
+// dominating branches visited when looking for an implying condition
+static const unsigned MaxImplyingDepth = 8;
+
+// switches with more than MinSwitchTableCases cases use a lookup table for
+// the case index if their case values are dense enough, a chain of selects
+// otherwise, up to MaxSwitchSelects cases
+static const unsigned MinSwitchTableCases = 4;
+static const unsigned MaxSwitchSelects = 32;
+static const unsigned MaxSwitchTableSize = 4096;
+static const unsigned SwitchTableDensity = 4;
+
+// indirect calls with more possible targets report the target address, the
+// index has to fit in one byte and is computed with one select per target
+static const unsigned MaxICallTargets = 64;
+
+static bool collectHint(HintKind K) {
+  return CFVHintKinds.getBits() == 0 || CFVHintKinds.isSet(K);
+}
+
+namespace {
+// derivation of a .oat_static_br site
+enum StaticBranchKind {
+  SBR_CONST = 1,   // constant condition
+  SBR_LVI = 2,     // condition decided by the value ranges of its operands
+  SBR_IMPLIED = 3, // implied by the dominating branch site in Arg
+  SBR_TRIP = 4,    // loop exit taken after Arg executions, not taken before
+  SBR_COUNT = 5,   // exit of the counted loop of site Arg, taken at its count
+};
+
+// how often the profile runs a switch, against the entries of its function
+enum SwitchHeat {
+  SwitchUnknown, // no profile or as often, the density decides
+  SwitchCold,    // never run
+  SwitchHot,     // run more often, in a loop
+};
+
+struct StaticBranch {
+  unsigned Site;
+  unsigned Kind;
+  unsigned Succ;
+  unsigned Arg;
+};
+
+struct HintSite {
+  oat::SiteKind Kind;
+  Instruction *I; // the branch or call, or the first insertion point of a loop header
+  unsigned Site;
+};
+
+struct  CollectCFVHints : public FunctionPass {
+  static char ID;
+
+  DenseMap<const Function *, unsigned> FuncIDs;
+  DenseMap<FunctionType *, std::vector<Function *>> AddressTaken;
+  // vtables of each type ID with the offset of their address point
+  DenseMap<Metadata *, std::vector<std::pair<GlobalVariable *, uint64_t>>> TypeMembers;
+
+  CollectCFVHints() : FunctionPass(ID) {}
+
+  bool doInitialization(Module &M) override;
+  bool runOnFunction(Function &F) override;
+  bool doFinalization(Module &M) override;
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    // loop-simplify first, it does not preserve LazyValueInfo
+    if (collectHint(HintLoop)) {
+      AU.addRequiredID(LoopSimplifyID);
+      AU.addRequired<DominatorTreeWrapperPass>();
+    }
+    if (collectHint(HintCond) && EliminateStaticBranches) {
+      AU.addRequired<DominatorTreeWrapperPass>();
+      AU.addRequired<LazyValueInfoWrapperPass>();
+      AU.addRequired<ScalarEvolutionWrapperPass>();
+    }
+    AU.addRequired<LoopInfoWrapperPass>();
+  }
+
+  bool decideCondBranch(BranchInst *bi, DenseMap<BranchInst *, unsigned> &Sites,
+                        StaticBranch &SB);
+  Loop *getCountedExitLoop(BranchInst *bi);
+  void emitStaticBranches(Function &F, ArrayRef<StaticBranch> Static);
+  void markSite(IRBuilder<> &B, oat::SiteKind Kind, unsigned fid, unsigned site,
+                unsigned arg = 0);
+  bool instrumentCondBranch(Instruction *I, Value *cond, unsigned fid, unsigned site);
+  bool instrumentSwitch(SwitchInst *SI, unsigned fid, unsigned site, SwitchHeat Heat);
+  void getICallTargets(CallSite CS, SmallSetVector<Function *, 8> &Targets);
+  Value *getVCallTargets(CallSite CS, std::vector<Constant *> &Classes,
+                         std::vector<Constant *> &Targets, unsigned &Slot);
+  bool instrumentICall(Instruction *I, unsigned fid, unsigned site);
+  bool instrumentIBranch(Instruction *I, unsigned fid, unsigned site);
+  Value *countActivations(Function &F);
+  bool instrumentLoopNest(Loop *Outer, unsigned fid, DenseMap<Loop *, unsigned> &LoopSites,
+                          Value *Depth);
+};
+} // end of namespace
+
+// same filter as IndirectCallSiteVisitor
+static bool isIndirectCall(Instruction &I) {
+  CallSite CS(&I);
+  if (!CS || CS.getCalledFunction() || !CS.getCalledValue())
+    return false;
+  if (auto *CI = dyn_cast<CallInst>(&I))
+    if (CI->isInlineAsm())
+      return false;
+  return !isa<Constant>(CS.getCalledValue());
+}
+
+bool CollectCFVHints::doInitialization(Module &M) {
+  unsigned FID = 0;
+
+  for (Function &F : M) {
+    if (!F.isDeclaration())
+      FuncIDs[&F] = ++FID;
+    // before this pass takes the address of any function
+    if (!F.isIntrinsic() && F.hasAddressTaken())
+      AddressTaken[F.getFunctionType()].push_back(&F);
+  }
+
+  SmallVector<MDNode *, 2> Types;
+  for (GlobalVariable &GV : M.globals()) {
+    Types.clear();
+    GV.getMetadata(LLVMContext::MD_type, Types);
+    for (MDNode *Type : Types) {
+      uint64_t Offset = mdconst::extract<ConstantInt>(Type->getOperand(0))->getZExtValue();
+      TypeMembers[Type->getOperand(1).get()].push_back(std::make_pair(&GV, Offset));
+    }
+  }
+
+  return false;
+}
+
+// Return the heat of SI in the profile BFI holds the counts of, if any.
+static SwitchHeat getSwitchHeat(SwitchInst *SI, BlockFrequencyInfo *BFI) {
+    if (BFI == nullptr)
+        return SwitchUnknown;
+
+    uint64_t Entry = SI->getFunction()->getEntryCount().getValue();
+    uint64_t Count = BFI->getBlockProfileCount(SI->getParent()).getValueOr(0);
+    if (Count == 0)
+        return SwitchCold;
+    return Count > Entry ? SwitchHot : SwitchUnknown;
+}
+
+// Return true if the case index of SI is looked up in a table indexed by the
+// case value minus Min, which spans Span values above Min.
+static bool useSwitchTable(SwitchInst *SI, SwitchHeat Heat, APInt &Min, APInt &Span) {
+    unsigned NumCases = SI->getNumCases();
+
+    Min = SI->case_begin().getCaseValue()->getValue();
+    APInt Max = Min;
+    for (auto Case : SI->cases()) {
+        const APInt &V = Case.getCaseValue()->getValue();
+        if (V.slt(Min))
+            Min = V;
+        if (V.sgt(Max))
+            Max = V;
+    }
+    Span = Max - Min;
+
+    if (NumCases <= MinSwitchTableCases ||
+        cast<IntegerType>(SI->getCondition()->getType())->getBitWidth() > 64 ||
+        !Span.ult(MaxSwitchTableSize))
+        return false;
+    if (Heat == SwitchCold && NumCases <= MaxSwitchSelects)
+        return false;
+    return Heat == SwitchHot || Span.ult((uint64_t)SwitchTableDensity * NumCases);
+}
+
+// Return true if SI reports its case index, it needs a case besides the
+// default and a table or a short enough chain of selects.
+static bool isSwitchHinted(SwitchInst *SI, SwitchHeat Heat) {
+    APInt Min, Span;
+
+    if (SI->getNumCases() == 0)
+        return false;
+    return SI->getNumCases() <= MaxSwitchSelects || useSwitchTable(SI, Heat, Min, Span);
+}
+
+// Return true if the header executions of L can be counted per entry, it
+// needs a preheader to clear the counter and exits to report it.
+static bool canCountLoop(Loop *L) {
+    SmallVector<BasicBlock *, 8> Exits;
+
+    // loop-simplify leaves loops with indirectbr edges alone
+    if (L->getLoopPreheader() == nullptr || !L->hasDedicatedExits())
+        return false;
+
+    L->getUniqueExitBlocks(Exits);
+    return none_of(Exits, [](BasicBlock *Exit) {
+        return Exit->getFirstInsertionPt() == Exit->end();
+    });
+}
+
+bool CollectCFVHints::runOnFunction(Function &F) {
+    unsigned fid = FuncIDs.lookup(&F);
+    LoopInfo &LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+    bool Modified = false;
+
+    // not run by the attested operation, see -oat-scope
+    if (!oat::isInScope(F))
+        return false;
+
+    // the branches of this function are reported by -collect-path-hints-pass
+    bool CondHints = collectHint(HintCond) && !F.hasFnAttribute("oat-path-hints");
+    bool ICallHints = collectHint(HintICall) &&
+                      !F.hasFnAttribute(Attribute::OptimizeNone); /* TODO:need further check */
+    bool IBranchHints = collectHint(HintIBranch);
+    bool LoopHints = collectHint(HintLoop);
+    // the exits of counted loops replay from the counts, unless paths do
+    bool CountedExits = LoopHints && !F.hasFnAttribute("oat-path-hints");
+
+    // the profile of -pgo-instr-use picks the case index lookup of switches
+    std::unique_ptr<BranchProbabilityInfo> BPI;
+    std::unique_ptr<BlockFrequencyInfo> BFI;
+    if (CondHints && CFVHintsProfile && F.getEntryCount().hasValue()) {
+        BPI.reset(new BranchProbabilityInfo(F, LI));
+        BFI.reset(new BlockFrequencyInfo(F, *BPI, LI));
+    }
+
+    // one traversal numbers the sites of every kind in instruction order
+    std::vector<HintSite> Sites;
+    DenseMap<BranchInst *, unsigned> CondSites;
+    DenseMap<Loop *, unsigned> LoopSites;
+    DenseMap<SwitchInst *, SwitchHeat> SwitchHeats;
+
+    for (BasicBlock &BB : F) {
+        if (LoopHints && LI.isLoopHeader(&BB)) {
+            LoopSites[LI.getLoopFor(&BB)] = Sites.size();
+            Sites.push_back({oat::SiteLoop, &*BB.getFirstInsertionPt(), (unsigned)Sites.size()});
+        }
+
+        for  (Instruction &I : BB) {
+            switch (I.getOpcode()) {
+                case Instruction::Br: {
+                    // without cond hints only the exits the loop counts decide
+                    BranchInst *bi = cast<BranchInst>(&I);
+                    if (bi->isConditional() &&
+                        (CondHints || (CountedExits && getCountedExitLoop(bi)))) {
+                        CondSites[bi] = Sites.size();
+                        Sites.push_back({oat::SiteCondBr, bi, (unsigned)Sites.size()});
+                    }
+                    break;
+                }
+
+                case Instruction::Switch: {
+                    // a switch with only a default destination is a jump
+                    SwitchInst *SI = cast<SwitchInst>(&I);
+                    SwitchHeat Heat = getSwitchHeat(SI, BFI.get());
+                    if (CondHints && isSwitchHinted(SI, Heat)) {
+                        SwitchHeats[SI] = Heat;
+                        Sites.push_back({oat::SiteSwitch, &I, (unsigned)Sites.size()});
+                    }
+                    break;
+                }
+
+                case Instruction::IndirectBr: {
+                    if (IBranchHints)
+                        Sites.push_back({oat::SiteIBranch, &I, (unsigned)Sites.size()});
+                    break;
+                }
+
+                case Instruction::Call:
+                case Instruction::Invoke: {
+                    if (ICallHints && isIndirectCall(I)) {
+                        Sites.push_back({oat::SiteICall, &I, (unsigned)Sites.size()});
+                        F.addFnAttr("oat-icall-hints");
+                        Modified = true;
+                    }
+                    break;
+                }
+
+                case Instruction::Select: {
+                    if (CondHints && !I.getMetadata(LLVMContext::MD_unpredictable)) {
+                        I.setMetadata(LLVMContext::MD_unpredictable,
+                                      MDNode::get(F.getContext(), None));
+                        Modified = true;
+                    }
+                    break;
+                }
+
+                default:
+                   break;
+            }
+        }
+    }
+
+    // decide the static branches before any hook is inserted
+    std::vector<StaticBranch> Static;
+    SmallPtrSet<Instruction *, 16> StaticSites;
+    for (HintSite &S : Sites) {
+        if (S.Kind != oat::SiteCondBr)
+            continue;
+        BranchInst *bi = cast<BranchInst>(S.I);
+        StaticBranch SB = {S.Site, 0, 0, 0};
+        bool Decided = CondHints && EliminateStaticBranches &&
+                       decideCondBranch(bi, CondSites, SB);
+        // the exit of a counted loop leaves at its count
+        if (!Decided && (!CondHints || EliminateStaticBranches)) {
+            if (Loop *L = CountedExits ? getCountedExitLoop(bi) : nullptr) {
+                SB.Kind = SBR_COUNT;
+                SB.Succ = L->contains(bi->getSuccessor(0)) ? 1 : 0;
+                SB.Arg = LoopSites.lookup(L);
+                Decided = true;
+            }
+        }
+        if (Decided) {
+            DEBUG(dbgs() << "static branch " << SB.Site << " kind " << SB.Kind
+                         << " succ " << SB.Succ << ": " << *S.I << "\n");
+            Static.push_back(SB);
+            StaticSites.insert(S.I);
+        }
+    }
+
+    for (HintSite &S : Sites) {
+        switch (S.Kind) {
+            case oat::SiteCondBr: {
+                if (StaticSites.count(S.I)) {
+                    // argument 1: no hint bit, see .oat_static_br
+                    IRBuilder<> B(S.I);
+                    markSite(B, S.Kind, fid, S.Site, 1);
+                    NumOfStaticBranches++;
+                    break;
+                }
+                Modified |= instrumentCondBranch(S.I, cast<BranchInst>(S.I)->getCondition(),
+                                                 fid, S.Site);
+                NumOfCondBranches++;
+                break;
+            }
+
+            case oat::SiteSwitch:
+                Modified |= instrumentSwitch(cast<SwitchInst>(S.I), fid, S.Site,
+                                             SwitchHeats.lookup(cast<SwitchInst>(S.I)));
+                NumOfSwitches++;
+                break;
+
+            case oat::SiteICall:
+                Modified |= instrumentICall(S.I, fid, S.Site);
+                NumOfICalls++;
+                break;
+
+            case oat::SiteIBranch:
+                Modified |= instrumentIBranch(S.I, fid, S.Site);
+                NumOfIBranches++;
+                break;
+
+            case oat::SiteLoop:
+                break;
+        }
+    }
+
+    if (any_of(LoopSites, [](const std::pair<Loop *, unsigned> &LS) {
+            return canCountLoop(LS.first);
+        })) {
+        Value *Depth = countActivations(F);
+        for (Loop *L : LI)
+            Modified |= instrumentLoopNest(L, fid, LoopSites, Depth);
+    }
+
+    if (!Static.empty()) {
+        emitStaticBranches(F, Static);
+        Modified = true;
+    }
+
+    return Modified;
+}
+
+// Return true if the outcome of bi can be derived without a trace bit, and
+// fill in how in SB.
+bool CollectCFVHints::decideCondBranch(BranchInst *bi,
+                        DenseMap<BranchInst *, unsigned> &Sites, StaticBranch &SB) {
+    BasicBlock *BB = bi->getParent();
+    Function *F = BB->getParent();
+    Value *cond = bi->getCondition();
+
+    if (auto *CI = dyn_cast<ConstantInt>(cond)) {
+        SB.Kind = SBR_CONST;
+        SB.Succ = CI->isZero() ? 1 : 0;
+        return true;
+    }
+
+    LazyValueInfo &LVI = getAnalysis<LazyValueInfoWrapperPass>().getLVI();
+    if (auto *Cmp = dyn_cast<ICmpInst>(cond)) {
+        if (auto *C = dyn_cast<Constant>(Cmp->getOperand(1))) {
+            LazyValueInfo::Tristate T =
+                LVI.getPredicateAt(Cmp->getPredicate(), Cmp->getOperand(0), C, bi);
+            if (T != LazyValueInfo::Unknown) {
+                SB.Kind = SBR_LVI;
+                SB.Succ = T == LazyValueInfo::True ? 0 : 1;
+                return true;
+            }
+        }
+    }
+
+    // a dominating branch whose outgoing edge into BB implies the condition
+    DominatorTree &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+    const DataLayout &DL = F->getParent()->getDataLayout();
+    DomTreeNode *N = DT.getNode(BB);
+    for (unsigned depth = 0; N && depth < MaxImplyingDepth; depth++) {
+        N = N->getIDom();
+        if (N == nullptr)
+            break;
+
+        auto *DomBI = dyn_cast<BranchInst>(N->getBlock()->getTerminator());
+        if (DomBI == nullptr || !Sites.count(DomBI) ||
+            DomBI->getSuccessor(0) == DomBI->getSuccessor(1))
+            continue;
+
+        for (unsigned s = 0; s < 2; s++) {
+            if (!DT.dominates(BasicBlockEdge(N->getBlock(), DomBI->getSuccessor(s)), BB))
+                continue;
+            Optional<bool> Implied =
+                isImpliedCondition(DomBI->getCondition(), cond, DL, s == 1);
+            if (Implied.hasValue()) {
+                SB.Kind = SBR_IMPLIED;
+                SB.Succ = Implied.getValue() ? 0 : 1;
+                SB.Arg = Sites[DomBI];
+                return true;
+            }
+        }
+    }
+
+    // the only exit of a loop with a constant trip count, executed once per
+    // iteration: it stays in the loop TripCount-1 times, then leaves.
+    LoopInfo &LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+    Loop *L = LI.getLoopFor(BB);
+    if (L && L->getExitingBlock() == BB && L->getLoopLatch() &&
+        DT.dominates(BB, L->getLoopLatch())) {
+        ScalarEvolution &SE = getAnalysis<ScalarEvolutionWrapperPass>().getSE();
+        unsigned TripCount = SE.getSmallConstantTripCount(L, BB);
+        if (TripCount != 0) {
+            SB.Kind = SBR_TRIP;
+            SB.Succ = L->contains(bi->getSuccessor(0)) ? 1 : 0;
+            SB.Arg = TripCount;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Return the loop bi is the only exit of if that loop is counted and bi runs
+// once per header execution, so that the count decides it, null otherwise.
+Loop *CollectCFVHints::getCountedExitLoop(BranchInst *bi) {
+    BasicBlock *BB = bi->getParent();
+    LoopInfo &LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+    DominatorTree &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+    Loop *L = LI.getLoopFor(BB);
+
+    if (L == nullptr || L->getExitingBlock() != BB || L->getLoopLatch() == nullptr ||
+        !DT.dominates(BB, L->getLoopLatch()) || !canCountLoop(L))
+        return nullptr;
+    return L;
+}
+
+// Each .oat_static_br record lists the static branches of one function:
+//   .word  <function ID>, <length of the name>, <number of sites>, 0
+//   .ascii <function name>, zero padded to 8 bytes
+//   .word  <site>, <kind>, <successor>, <argument>   * number of sites
+// The record is emitted with the function, doFinalization() runs after opt
+// has written the module.
+void CollectCFVHints::emitStaticBranches(Function &F, ArrayRef<StaticBranch> Static) {
+    Module *M = F.getParent();
+    LLVMContext &Ctx = M->getContext();
+    Type *I32Ty = Type::getInt32Ty(Ctx);
+    StructType *SiteTy = StructType::get(I32Ty, I32Ty, I32Ty, I32Ty, nullptr);
+
+    std::vector<Constant *> Sites;
+    for (const StaticBranch &SB : Static) {
+        Constant *Fields[] = {
+            ConstantInt::get(I32Ty, SB.Site),
+            ConstantInt::get(I32Ty, SB.Kind),
+            ConstantInt::get(I32Ty, SB.Succ),
+            ConstantInt::get(I32Ty, SB.Arg),
+        };
+        Sites.push_back(ConstantStruct::get(SiteTy, Fields));
+    }
+
+    std::string Name = F.getName().str();
+    Name.resize(alignTo(Name.size(), 8), '\0');
+
+    Constant *Record = ConstantStruct::getAnon({
+        ConstantInt::get(I32Ty, FuncIDs.lookup(&F)),
+        ConstantInt::get(I32Ty, F.getName().size()),
+        ConstantInt::get(I32Ty, Sites.size()),
+        ConstantInt::get(I32Ty, 0),
+        ConstantDataArray::getString(Ctx, Name, false),
+        ConstantArray::get(ArrayType::get(SiteTy, Sites.size()), Sites),
+    });
+
+    auto *GV = new GlobalVariable(*M, Record->getType(), true,
+                                  GlobalValue::PrivateLinkage, Record,
+                                  "oat.static_br." + F.getName());
+    GV->setSection(".oat_static_br");
+    GV->setAlignment(8);
+    appendToUsed(*M, {GV});
+}
+
+bool CollectCFVHints::doFinalization(Module &M) {
+    AddressTaken.clear();
+    TypeMembers.clear();
+    return false;
+}
+
+void CollectCFVHints::markSite(IRBuilder<> &B, oat::SiteKind Kind,
+                               unsigned fid, unsigned site, unsigned arg) {
+    if (CFVSiteMarkers)
+        oat::createSiteMarker(B, oat::getSiteID(Kind, fid, site), arg);
+}
+
+bool CollectCFVHints::instrumentCondBranch(Instruction *I, Value *cond,
+                                           unsigned fid, unsigned site) {
+    IRBuilder<> B(I);
+    Module *M = B.GetInsertBlock()->getModule();
+    Type *VoidTy = B.getVoidTy();
+    Type *I1Ty = B.getInt1Ty();
+
+    Function *FuncCollectCondBranchHints= oat::getOrInsertHook(*M, "__collect_cond_branch_hints",
+                                        FunctionType::get(VoidTy, {I1Ty}, false));
+
+    oat::createHookCall(B, FuncCollectCondBranchHints, {cond});
+    markSite(B, oat::SiteCondBr, fid, site);
+
+    return true;
+}
+
+// selects inserted by this pass have to stay csel as well
+static Value *createUnpredictableSelect(IRBuilder<> &B, Value *C, Value *T, Value *F) {
+    Value *V = B.CreateSelect(C, T, F);
+    if (auto *SI = dyn_cast<SelectInst>(V))
+        SI->setMetadata(LLVMContext::MD_unpredictable, MDNode::get(B.getContext(), None));
+    return V;
+}
+
+bool CollectCFVHints::instrumentSwitch(SwitchInst *SI, unsigned fid, unsigned site,
+                                       SwitchHeat Heat) {
+    IRBuilder<> B(SI);
+    Module *M = B.GetInsertBlock()->getModule();
+    Type *VoidTy = B.getVoidTy();
+    Type *I32Ty = B.getInt32Ty();
+    Value *cond = SI->getCondition();
+    auto *CondTy = cast<IntegerType>(cond->getType());
+    unsigned NumCases = SI->getNumCases();
+    unsigned width = Log2_32_Ceil(NumCases + 1);
+    APInt Min, Span;
+    Value *index;
+
+    DEBUG(dbgs() << __func__ << " fid : "<< fid << " site: " << site << " cases: " << NumCases
+                 << " width: " << width << " : " << *SI << "\n");
+
+    if (useSwitchTable(SI, Heat, Min, Span)) {
+        // index = cond - Min <= Span ? table[cond - Min] : 0
+        uint64_t Range = Span.getZExtValue() + 1;
+        IntegerType *EltTy = B.getIntNTy(width <= 8 ? 8 : width <= 16 ? 16 : 32);
+        ArrayType *TableTy = ArrayType::get(EltTy, Range);
+        std::vector<Constant *> Table(Range, ConstantInt::get(EltTy, 0));
+        for (auto Case : SI->cases())
+            Table[(Case.getCaseValue()->getValue() - Min).getZExtValue()] =
+                ConstantInt::get(EltTy, Case.getCaseIndex() + 1);
+
+        auto *GV = new GlobalVariable(*M, TableTy, true, GlobalValue::PrivateLinkage,
+                                      ConstantArray::get(TableTy, Table), "oat.switch_idx");
+        GV->setUnnamedAddr(GlobalValue::UnnamedAddr::Global);
+
+        Value *off = B.CreateSub(cond, B.getInt(Min));
+        Value *inRange = B.CreateICmpULE(off, B.getInt(Span));
+        off = createUnpredictableSelect(B, inRange, off, ConstantInt::get(CondTy, 0));
+        Value *entry = B.CreateLoad(B.CreateInBoundsGEP(TableTy, GV,
+                                    {B.getInt64(0), B.CreateZExt(off, B.getInt64Ty())}));
+        index = createUnpredictableSelect(B, inRange, B.CreateZExt(entry, I32Ty), B.getInt32(0));
+    } else {
+        index = B.getInt32(0);
+        for (auto Case : SI->cases())
+            index = createUnpredictableSelect(B, B.CreateICmpEQ(cond, Case.getCaseValue()),
+                                              B.getInt32(Case.getCaseIndex() + 1), index);
+    }
+
+    Function *FuncCollectSwitchHints= oat::getOrInsertHook(*M, "__collect_switch_hints",
+                                        FunctionType::get(VoidTy, {I32Ty, I32Ty}, false));
+
+    oat::createHookCall(B, FuncCollectSwitchHints, {index, B.getInt32(width)});
+    // the verifier reads that many bits for the hint of this site
+    markSite(B, oat::SiteSwitch, fid, site, width);
+    SI->setMetadata(oat::SwitchHintMDName, MDNode::get(SI->getContext(), None));
+
+    return true;
+}
+
+// Add the functions the constant C holds to Targets.
+static void collectConstantFunctions(Constant *C, SmallSetVector<Function *, 8> &Targets) {
+    if (auto *F = dyn_cast<Function>(C->stripPointerCasts())) {
+        Targets.insert(F);
+        return;
+    }
+    if (isa<ConstantAggregate>(C) || isa<ConstantExpr>(C))
+        for (Use &Op : C->operands())
+            collectConstantFunctions(cast<Constant>(Op), Targets);
+}
+
+// Fill Targets with the functions the indirect call CS may call. They are the
+// functions its called value is built from if all of them are known, else the
+// address-taken functions of the call type. A target missing from the list is
+// still reported by address, so the list only has to be short, not complete.
+void CollectCFVHints::getICallTargets(CallSite CS, SmallSetVector<Function *, 8> &Targets) {
+    const DataLayout &DL = CS.getInstruction()->getModule()->getDataLayout();
+    SmallVector<Value *, 8> Worklist;
+    SmallPtrSet<Value *, 8> Visited;
+
+    bool Known = true;
+
+    Worklist.push_back(CS.getCalledValue());
+    while (Known && !Worklist.empty()) {
+        Value *V = Worklist.pop_back_val()->stripPointerCasts();
+        if (!Visited.insert(V).second)
+            continue;
+
+        if (auto *F = dyn_cast<Function>(V)) {
+            Targets.insert(F);
+        } else if (auto *SI = dyn_cast<SelectInst>(V)) {
+            Worklist.push_back(SI->getTrueValue());
+            Worklist.push_back(SI->getFalseValue());
+        } else if (auto *PN = dyn_cast<PHINode>(V)) {
+            Worklist.append(PN->op_begin(), PN->op_end());
+        } else if (auto *LI = dyn_cast<LoadInst>(V)) {
+            // an entry of a constant table of functions
+            auto *GV = dyn_cast<GlobalVariable>(GetUnderlyingObject(LI->getPointerOperand(), DL));
+            if (GV && GV->isConstant() && GV->hasDefinitiveInitializer())
+                collectConstantFunctions(GV->getInitializer(), Targets);
+            else
+                Known = false;
+        } else if (!isa<ConstantPointerNull>(V) && !isa<UndefValue>(V)) {
+            Known = false;
+        }
+    }
+
+    if (Known && !Targets.empty())
+        return;
+
+    Targets.clear();
+    for (Function *F : AddressTaken.lookup(CS.getFunctionType()))
+        Targets.insert(F);
+}
+
+// If CS is a virtual call tagged by -wholeprogramdevirt, fill Classes with the
+// address points of the vtables of its type, Targets with the function in its
+// slot of each vtable and Slot with the slot number, and return the vtable
+// pointer of the object. Return null otherwise.
+Value *CollectCFVHints::getVCallTargets(CallSite CS, std::vector<Constant *> &Classes,
+                                        std::vector<Constant *> &Targets, unsigned &Slot) {
+    MDNode *MD = CS.getInstruction()->getMetadata(oat::VCallMDName);
+    auto *FPtr = dyn_cast<LoadInst>(CS.getCalledValue()->stripPointerCasts());
+    if (MD == nullptr || FPtr == nullptr)
+        return nullptr;
+
+    Module &M = *CS.getInstruction()->getModule();
+    const DataLayout &DL = M.getDataLayout();
+    Type *I64Ty = Type::getInt64Ty(M.getContext());
+    uint64_t SlotOffset = mdconst::extract<ConstantInt>(MD->getOperand(1))->getZExtValue();
+    int64_t Offset = 0;
+
+    // the slot is loaded from the vtable pointer at a constant offset
+    Value *VTable = GetPointerBaseWithConstantOffset(FPtr->getPointerOperand(), Offset, DL);
+    if ((uint64_t)Offset != SlotOffset)
+        return nullptr;
+
+    for (auto &Member : TypeMembers.lookup(MD->getOperand(0).get())) {
+        GlobalVariable *GV = Member.first;
+        Constant *Entry = nullptr;
+        if (GV->isConstant() && GV->hasDefinitiveInitializer())
+            Entry = getPointerAtOffset(GV->getInitializer(), Member.second + SlotOffset, M);
+        auto *Fn = Entry ? dyn_cast<Function>(Entry->stripPointerCasts()) : nullptr;
+        if (Fn == nullptr) {
+            Classes.clear();
+            Targets.clear();
+            return nullptr;
+        }
+
+        Constant *AddrPoint = ConstantExpr::getGetElementPtr(
+            Type::getInt8Ty(M.getContext()),
+            ConstantExpr::getBitCast(GV, Type::getInt8PtrTy(M.getContext())),
+            ConstantInt::get(I64Ty, Member.second));
+        Classes.push_back(ConstantExpr::getPtrToInt(AddrPoint, I64Ty));
+        Targets.push_back(ConstantExpr::getPtrToInt(Fn, I64Ty));
+    }
+
+    if (Classes.empty())
+        return nullptr;
+    Slot = SlotOffset / DL.getPointerSize();
+    return VTable;
+}
+
+// Each .oat_icall record lists the possible targets of one indirect call:
+//   .word  <function-id>, <site>, <number of targets>, <vtable slot + 1 or 0>
+//   .xword <target address> * number of targets
+// The targets of a virtual call are the functions in its slot of every vtable
+// of its type, in the order of the class IDs.
+bool CollectCFVHints::instrumentICall(Instruction *I, unsigned fid, unsigned site) {
+    IRBuilder<> B(I);
+    Module *M = B.GetInsertBlock()->getModule();
+    Type *VoidTy = B.getVoidTy();
+    Type *I32Ty = B.getInt32Ty();
+    Type *I64Ty = B.getInt64Ty();
+    CallSite CS(I);
+    Value *castVal = B.CreatePtrToInt(CS.getCalledValue(), I64Ty, "ptrtoint");
+    // the index is the position of Key in Keys, Entries are the targets
+    Value *Key = castVal;
+    std::vector<Constant *> Keys, Entries;
+    unsigned Slot = 0;
+
+    if (Value *VTable = getVCallTargets(CS, Keys, Entries, Slot)) {
+        Key = B.CreatePtrToInt(VTable, I64Ty);
+        Slot++;
+        NumOfVCalls++;
+    } else {
+        SmallSetVector<Function *, 8> Targets;
+        getICallTargets(CS, Targets);
+        for (Function *F : Targets)
+            Keys.push_back(ConstantExpr::getPtrToInt(F, I64Ty));
+        Entries = Keys;
+    }
+    if (Keys.size() > MaxICallTargets) {
+        Keys.clear();
+        Entries.clear();
+    }
+
+    DEBUG(dbgs() << __func__ << " fid : "<< fid << " site: " << site << " slot: " << Slot
+                 << " targets: " << Entries.size() << " : " << *I << "\n");
+
+    Value *index = B.getInt32(0);
+    for (unsigned i = 0; i < Keys.size(); i++)
+        index = createUnpredictableSelect(B, B.CreateICmpEQ(Key, Keys[i]),
+                                          B.getInt32(i + 1), index);
+
+    if (!Entries.empty()) {
+        Constant *Record = ConstantStruct::getAnon({
+            ConstantInt::get(I32Ty, fid),
+            ConstantInt::get(I32Ty, site),
+            ConstantInt::get(I32Ty, Entries.size()),
+            ConstantInt::get(I32Ty, Slot),
+            ConstantArray::get(ArrayType::get(I64Ty, Entries.size()), Entries),
+        });
+
+        auto *GV = new GlobalVariable(*M, Record->getType(), true,
+                                      GlobalValue::PrivateLinkage, Record, "oat.icall");
+        GV->setSection(".oat_icall");
+        GV->setAlignment(8);
+        appendToUsed(*M, {GV});
+    }
+
+    Function *FuncCollectICallHints= oat::getOrInsertHook(*M, "__collect_icall_hints",
+                                        FunctionType::get(VoidTy, {I32Ty, I64Ty}, false));
+
+    oat::createHookCall(B, FuncCollectICallHints, {index, castVal});
+    markSite(B, oat::SiteICall, fid, site);
+
+    return true;
+}
+
+bool CollectCFVHints::instrumentIBranch(Instruction *I, unsigned fid, unsigned site) {
+    IRBuilder<> B(I);
+    Module *M = B.GetInsertBlock()->getModule();
+    Type *VoidTy = B.getVoidTy();
+    Type *I64Ty = B.getInt64Ty();
+    Value *target = cast<IndirectBrInst>(I)->getAddress();
+
+    DEBUG(dbgs() << __func__ << " fid : "<< fid << " site: " << site << " : " << *I << "\n");
+
+    Function *FuncCollectIBranchHints= oat::getOrInsertHook(*M, "__collect_ibranch_hints",
+                                        FunctionType::get(VoidTy, {I64Ty, I64Ty, I64Ty}, false));
+    Value *castVal = B.CreatePtrToInt(target, I64Ty, "ptrtoint");
+
+    oat::createHookCall(B, FuncCollectIBranchHints, {B.getInt64(fid), B.getInt64(site), castVal});
+    markSite(B, oat::SiteIBranch, fid, site);
+
+    return true;
+}
+
+// Count the activations of F in the global oat.activations.<name>: it is
+// incremented on entry and restored on return. Return the depth of the
+// activation, its value on entry.
+Value *CollectCFVHints::countActivations(Function &F) {
+    Module *M = F.getParent();
+    IRBuilder<> B(&*F.getEntryBlock().getFirstInsertionPt());
+    Type *I64Ty = B.getInt64Ty();
+
+    auto *Activations = new GlobalVariable(*M, I64Ty, false, GlobalValue::InternalLinkage,
+                                           B.getInt64(0), "oat.activations." + F.getName());
+    Value *Depth = B.CreateLoad(Activations, "oat.depth");
+    B.CreateStore(B.CreateAdd(Depth, B.getInt64(1)), Activations);
+
+    for (BasicBlock &BB : F) {
+        Instruction *Term = BB.getTerminator();
+        if (!isa<ReturnInst>(Term) && !isa<ResumeInst>(Term))
+            continue;
+        // nothing may come between a musttail call and its ret
+        if (CallInst *MustTail = BB.getTerminatingMustTailCall())
+            Term = MustTail;
+        B.SetInsertPoint(Term);
+        B.CreateStore(Depth, Activations);
+    }
+
+    return Depth;
+}
+
+// Count the header executions of every loop in the nest of Outer per entry of
+// the loop: its counter is cleared in its preheader and reported with Depth at
+// each of its exits.
+bool CollectCFVHints::instrumentLoopNest(Loop *Outer, unsigned fid,
+                                         DenseMap<Loop *, unsigned> &LoopSites,
+                                         Value *Depth) {
+    Function *F = Outer->getHeader()->getParent();
+    Module *M = F->getParent();
+    IRBuilder<> B(&*F->getEntryBlock().getFirstInsertionPt());
+    Type *VoidTy = B.getVoidTy();
+    Type *I32Ty = B.getInt32Ty();
+    Type *I64Ty = B.getInt64Ty();
+    SmallVector<Loop *, 8> Nest;
+    bool Modified = false;
+
+    // outer loops first
+    Nest.push_back(Outer);
+    for (unsigned i = 0; i < Nest.size(); i++)
+        Nest.append(Nest[i]->begin(), Nest[i]->end());
+
+    for (Loop *L : Nest) {
+        BasicBlock *Preheader = L->getLoopPreheader();
+        SmallVector<BasicBlock *, 8> Exits;
+        auto It = LoopSites.find(L);
+        if (It == LoopSites.end())
+            continue;
+
+        if (!canCountLoop(L)) {
+            DEBUG(dbgs() << __func__ << " cannot count: " << *L);
+            continue;
+        }
+        L->getUniqueExitBlocks(Exits);
+
+        DEBUG(dbgs() << __func__ << " fid: " << fid << " site: " << It->second
+                     << " header: " << L->getHeader()->getName() << "\n");
+
+        B.SetInsertPoint(&*F->getEntryBlock().getFirstInsertionPt());
+        AllocaInst *Counter = B.CreateAlloca(I64Ty, nullptr, "oat.loop.cnt");
+
+        B.SetInsertPoint(Preheader->getTerminator());
+        B.CreateStore(B.getInt64(0), Counter);
+
+        B.SetInsertPoint(&*L->getHeader()->getFirstInsertionPt());
+        B.CreateStore(B.CreateAdd(B.CreateLoad(Counter), B.getInt64(1)), Counter);
+        markSite(B, oat::SiteLoop, fid, It->second);
+
+        Function *FuncCollectLoopHints= oat::getOrInsertHook(*M, "__collect_loop_hints",
+                                            FunctionType::get(VoidTy, {I32Ty, I32Ty, I32Ty, I64Ty}, false));
+        for (BasicBlock *Exit : Exits) {
+            B.SetInsertPoint(&*Exit->getFirstInsertionPt());
+            oat::createHookCall(B, FuncCollectLoopHints,
+                                {B.getInt32(fid), B.getInt32(It->second),
+                                 B.CreateTrunc(Depth, I32Ty), B.CreateLoad(Counter)});
+        }
+
+        NumOfAffectedLoops++;
+        Modified = true;
+    }
+
+    return Modified;
+}
+
+char CollectCFVHints::ID = 0;
+static RegisterPass<CollectCFVHints> X("collect-cfv-hints-pass", "Collect Control-Flow Verification Hints Info", false, false);
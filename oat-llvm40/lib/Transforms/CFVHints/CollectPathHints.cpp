@@ -0,0 +1,526 @@
+//===- CollectPathHints.cpp - Collect Ball-Larus Path Hints for CFV -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+// This pass is an alternative to the cond hints of -collect-cfv-hints-pass.
+// Instead of one hint per conditional branch, every function reports one
+// Ball-Larus path ID per acyclic path it executes: when the path leaves
+// through a loop back edge, a call or a return.
+//
+// Each back edge v->w is replaced by the dummy edges ENTRY->w and v->EXIT,
+// which leaves a DAG. Every back edge gets its own v->EXIT edge, numbered with
+// the successor of v it stands for. Blocks are split after every call that
+// may run instrumented code, and the edge from the call to the rest of its
+// block is replaced the same way, so no path spans a call. Edge values are
+// assigned so that the sum of the values along any ENTRY->EXIT path is a
+// unique number in [0, NumPaths(ENTRY)). The function keeps a path register,
+// initialised to 0 in the entry block and incremented by a constant on the
+// edges with a non-zero value. A back edge reports the register plus the
+// value of v->EXIT and then resets it to the value of ENTRY->w, a call does
+// the same right before it, and a return reports the register plus the value
+// of its edge to EXIT. The hook gets the function ID of
+// -collect-cfv-hints-pass along with the path ID.
+//
+// The DAG of every instrumented function is emitted in the .oat_paths section,
+// which lets the verifier decode a path ID back into the branches taken. Each
+// conditional branch and switch gets a SitePathBr marker numbered with its
+// block, which the AArch64 backend maps to its machine branch in .oat_cfg.
+// Instrumented functions get the "oat-path-hints" attribute and get no cond
+// hints from -collect-cfv-hints-pass, functions with too many paths are left
+// to it. So are functions without a branch, which have nothing to report.
+//
+// As a path ends before every call, path IDs arrive in the order the paths
+// run, and the next path ID in the trace that has a branch is always the one
+// of the path the replay is on. verify_engine decodes it when it reaches the
+// first branch of the path and takes the outcome of each branch from it.
+//
+// If -pgo-instr-use annotated the module with a profile, a function also stays
+// on cond hints when they are expected to report fewer events: one per
+// conditional branch or switch executed, against one path ID per return, call
+// or back edge taken. Path hints pay off in functions with many branches per
+// path, cond hints in loops whose body is a single branch.
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Pass.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/DepthFirstIterator.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/Analysis/CFG.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/OAT/OATCommon.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/ModuleUtils.h"
+
+#define DEBUG_TYPE "collect-path-hints"
+
+STATISTIC(NumPathFuncs, "Number of functions instrumented with path hints");
+STATISTIC(NumPathIncrements, "Number of path register increments");
+STATISTIC(NumPathCalls, "Number of calls ending a path");
+STATISTIC(NumPathSkipped, "Number of functions left to conditional branch hints");
+
+using namespace llvm;
+
+// Path IDs must fit in the hint, and the verifier has to enumerate the
+// candidate paths of a function, keep the number of paths bounded.
+static cl::opt<unsigned> PathHintsMaxBits("collect-path-hints-max-bits", cl::Hidden,
+                                  cl::desc("Maximum number of bits of a function's path IDs"),
+                                  cl::init(32));
+
+static cl::opt<bool> PathHintsProfile("collect-path-hints-profile", cl::Hidden,
+                                  cl::desc("Leave functions to cond hints where the profile expects fewer events"),
+                                  cl::init(true));
+
+namespace {
+// flags of a .oat_paths edge record
+enum PathEdgeFlags {
+  PATH_BRANCH = 1, // the source ends in a conditional branch or a switch
+  PATH_RESET = 2,  // dummy ENTRY->w edge of the back edge v->w
+  PATH_EXIT = 4,   // edge to EXIT, from a return or the source of a back edge
+                   // or a call
+};
+
+// index of EXIT in the .oat_paths edge records
+const uint32_t PathExitIndex = ~0U;
+
+struct PathEdge {
+  BasicBlock *Src;
+  BasicBlock *Dst; // nullptr for EXIT
+  unsigned SuccNum;
+  unsigned Flags;
+  uint64_t Val;
+};
+
+typedef SmallVector<PathEdge, 4> PathEdgeList;
+
+struct CollectPathHints : public ModulePass {
+  static char ID;
+
+  CollectPathHints() : ModulePass(ID) {}
+  bool runOnModule(Module &M) override;
+
+  bool instrumentFunction(Function &F, unsigned FID, Function *Hook);
+  bool splitAtCalls(Function &F, DenseMap<BasicBlock *, CallInst *> &Calls);
+  bool computeEdgeValues(BasicBlock *Entry,
+                         DenseMap<BasicBlock *, PathEdgeList> &Out,
+                         uint64_t &Paths);
+  Instruction *getEdgeInsertPoint(BasicBlock *Src, BasicBlock *Dst,
+                                  unsigned SuccNum);
+  void emitPathRecord(Function &F, unsigned FID, ArrayRef<BasicBlock *> Blocks,
+                      DenseMap<BasicBlock *, PathEdgeList> &Out);
+};
+} // end of namespace
+
+// Return true if a path has to end before the call I, because the callee may
+// report paths of its own. The runtime hooks never do.
+static bool endsPath(Instruction &I) {
+  auto *CI = dyn_cast<CallInst>(&I);
+  if (CI == nullptr || CI->isInlineAsm() || isa<IntrinsicInst>(CI))
+    return false;
+
+  Function *Callee = CI->getCalledFunction();
+  return Callee == nullptr || Callee->getCallingConv() != oat::HookCallingConv;
+}
+
+// Return true if the profile of F expects fewer cond hints than path IDs.
+static bool preferCondHints(Function &F) {
+  if (!PathHintsProfile || !F.getEntryCount().hasValue())
+    return false;
+
+  DominatorTree DT(F);
+  LoopInfo LI(DT);
+  BranchProbabilityInfo BPI(F, LI);
+  BlockFrequencyInfo BFI(F, BPI, LI);
+  SmallVector<std::pair<const BasicBlock *, const BasicBlock *>, 8> BackEdges;
+  uint64_t CondEvents = 0, PathEvents = 0;
+
+  FindFunctionBackedges(F, BackEdges);
+  for (auto &E : BackEdges) {
+    uint64_t Count = BFI.getBlockProfileCount(E.first).getValueOr(0);
+    PathEvents += BPI.getEdgeProbability(E.first, E.second).scale(Count);
+  }
+
+  for (BasicBlock &BB : F) {
+    uint64_t Count = BFI.getBlockProfileCount(&BB).getValueOr(0);
+    TerminatorInst *TI = BB.getTerminator();
+    for (Instruction &I : BB)
+      if (endsPath(I))
+        PathEvents += Count;
+    if (isa<ReturnInst>(TI))
+      PathEvents += Count;
+    else if (auto *BI = dyn_cast<BranchInst>(TI))
+      CondEvents += BI->isConditional() ? Count : 0;
+    else if (auto *SI = dyn_cast<SwitchInst>(TI))
+      CondEvents += SI->getNumCases() > 0 ? Count : 0;
+  }
+
+  DEBUG(dbgs() << F.getName() << ": expected cond hints " << CondEvents
+               << ", path hints " << PathEvents << "\n");
+  return CondEvents <= PathEvents;
+}
+
+// Assign the Ball-Larus edge values, walking the DAG in post order so that
+// NumPaths of every successor is known. Return false if the number of paths
+// does not fit in PathHintsMaxBits, else set Paths to NumPaths(ENTRY).
+bool CollectPathHints::computeEdgeValues(BasicBlock *Entry,
+                              DenseMap<BasicBlock *, PathEdgeList> &Out,
+                              uint64_t &Paths) {
+  uint64_t Limit = PathHintsMaxBits >= 64 ? UINT64_MAX
+                                          : (1ULL << PathHintsMaxBits);
+  DenseMap<BasicBlock *, uint64_t> NumPaths;
+  SmallVector<std::pair<BasicBlock *, unsigned>, 32> Stack;
+  SmallPtrSet<BasicBlock *, 32> Visited;
+
+  Visited.insert(Entry);
+  Stack.push_back(std::make_pair(Entry, 0));
+  while (!Stack.empty()) {
+    BasicBlock *BB = Stack.back().first;
+    PathEdgeList &Edges = Out[BB];
+    unsigned &Next = Stack.back().second;
+
+    if (Next < Edges.size()) {
+      BasicBlock *Dst = Edges[Next++].Dst;
+      if (Dst != nullptr && Visited.insert(Dst).second)
+        Stack.push_back(std::make_pair(Dst, 0));
+      continue;
+    }
+
+    // all successors done
+    uint64_t Sum = 0;
+    for (PathEdge &E : Edges) {
+      uint64_t N = E.Dst ? NumPaths[E.Dst] : 1;
+      E.Val = Sum;
+      if (N > Limit - Sum)
+        return false;
+      Sum += N;
+    }
+    NumPaths[BB] = Edges.empty() ? 1 : Sum;
+    Stack.pop_back();
+  }
+
+  DEBUG(dbgs() << Entry->getParent()->getName() << ": " << NumPaths[Entry]
+               << " paths\n");
+  Paths = NumPaths[Entry];
+  return true;
+}
+
+// Return the point where code for the edge Src->Dst runs exactly when the
+// edge is taken, splitting the edge if it is critical.
+Instruction *CollectPathHints::getEdgeInsertPoint(BasicBlock *Src,
+                                        BasicBlock *Dst, unsigned SuccNum) {
+  if (Src->getUniqueSuccessor() == Dst)
+    return Src->getTerminator();
+  if (Dst->getUniquePredecessor() == Src)
+    return &*Dst->getFirstInsertionPt();
+
+  BasicBlock *Split = SplitCriticalEdge(Src->getTerminator(), SuccNum,
+                          CriticalEdgeSplittingOptions().setMergeIdenticalEdges());
+  assert(Split && "edge could not be split");
+  return Split->getTerminator();
+}
+
+// Each .oat_paths record describes the DAG of one function:
+//   .word  <function ID>, <length of the name>, <number of edges>, 0
+//   .ascii <function name>, zero padded to 8 bytes
+//   .word  <src>, <dst>, <successor number>, <flags>
+//   .xword <value>                            * number of edges
+// Blocks are numbered in function order, the entry block is 0 and EXIT is
+// 0xffffffff. The edges of a block are listed by increasing value. The
+// successor number of an EXIT edge is the one of its back edge, 0 for a
+// return.
+void CollectPathHints::emitPathRecord(Function &F, unsigned FID,
+                                ArrayRef<BasicBlock *> Blocks,
+                                DenseMap<BasicBlock *, PathEdgeList> &Out) {
+  Module *M = F.getParent();
+  LLVMContext &Ctx = M->getContext();
+  Type *I32Ty = Type::getInt32Ty(Ctx);
+  Type *I64Ty = Type::getInt64Ty(Ctx);
+  StructType *EdgeTy = StructType::get(I32Ty, I32Ty, I32Ty, I32Ty, I64Ty, nullptr);
+  DenseMap<BasicBlock *, uint32_t> Index;
+  std::vector<Constant *> Edges;
+
+  for (unsigned i = 0, e = Blocks.size(); i != e; ++i)
+    Index[Blocks[i]] = i;
+
+  for (BasicBlock *BB : Blocks) {
+    for (PathEdge &E : Out[BB]) {
+      Constant *Fields[] = {
+        ConstantInt::get(I32Ty, Index[E.Src]),
+        ConstantInt::get(I32Ty, E.Dst ? Index[E.Dst] : PathExitIndex),
+        ConstantInt::get(I32Ty, E.SuccNum),
+        ConstantInt::get(I32Ty, E.Flags),
+        ConstantInt::get(I64Ty, E.Val),
+      };
+      Edges.push_back(ConstantStruct::get(EdgeTy, Fields));
+    }
+  }
+
+  std::string Name = F.getName().str();
+  Name.resize(alignTo(Name.size(), 8), '\0');
+
+  Constant *Record = ConstantStruct::getAnon({
+    ConstantInt::get(I32Ty, FID),
+    ConstantInt::get(I32Ty, F.getName().size()),
+    ConstantInt::get(I32Ty, Edges.size()),
+    ConstantInt::get(I32Ty, 0),
+    ConstantDataArray::getString(Ctx, Name, false),
+    ConstantArray::get(ArrayType::get(EdgeTy, Edges.size()), Edges),
+  });
+
+  auto *GV = new GlobalVariable(*M, Record->getType(), true,
+                                GlobalValue::PrivateLinkage, Record,
+                                "oat.paths." + F.getName());
+  GV->setSection(".oat_paths");
+  GV->setAlignment(8);
+  appendToUsed(*M, {GV});
+}
+
+// Split the block of every call that ends a path right after the call, and
+// map the block now ending with the call to it.
+bool CollectPathHints::splitAtCalls(Function &F,
+                                    DenseMap<BasicBlock *, CallInst *> &Calls) {
+  SmallVector<CallInst *, 16> Worklist;
+
+  for (Instruction &I : instructions(F))
+    if (endsPath(I))
+      Worklist.push_back(cast<CallInst>(&I));
+
+  for (CallInst *CI : Worklist) {
+    SplitBlock(CI->getParent(), CI->getNextNode());
+    Calls[CI->getParent()] = CI;
+  }
+
+  return !Worklist.empty();
+}
+
+bool CollectPathHints::instrumentFunction(Function &F, unsigned FID,
+                                         Function *Hook) {
+  BasicBlock *Entry = &F.getEntryBlock();
+  SmallVector<std::pair<const BasicBlock *, const BasicBlock *>, 8> BackEdgeList;
+  DenseSet<std::pair<const BasicBlock *, const BasicBlock *>> BackEdges;
+  DenseMap<BasicBlock *, PathEdgeList> Out;
+  SmallVector<BasicBlock *, 32> Blocks;
+  SmallPtrSet<BasicBlock *, 32> Reachable;
+  DenseMap<BasicBlock *, CallInst *> Calls;
+  uint64_t Paths;
+  bool Branches = false;
+
+  // the path register is reset in the entry block, which must not be part
+  // of a loop, and edges into EH pads and indirectbr targets cannot be split.
+  // Nothing may come between a musttail call and its ret.
+  if (!pred_empty(Entry))
+    return false;
+  for (BasicBlock &BB : F) {
+    if (BB.isEHPad() || isa<IndirectBrInst>(BB.getTerminator()))
+      return false;
+    if (CallInst *CI = BB.getTerminatingMustTailCall())
+      if (endsPath(*CI))
+        return false;
+  }
+
+  for (BasicBlock *BB : depth_first(Entry)) {
+    Reachable.insert(BB);
+    Branches |= BB->getUniqueSuccessor() == nullptr &&
+                BB->getTerminator()->getNumSuccessors() > 1;
+  }
+  if (!Branches) {
+    DEBUG(dbgs() << F.getName() << ": no branch, skipped\n");
+    NumPathSkipped++;
+    return false;
+  }
+
+  // split blocks keep their reachability
+  bool Modified = splitAtCalls(F, Calls);
+  Reachable.clear();
+  for (BasicBlock *BB : depth_first(Entry))
+    Reachable.insert(BB);
+  for (BasicBlock &BB : F)
+    if (Reachable.count(&BB))
+      Blocks.push_back(&BB);
+
+  FindFunctionBackedges(F, BackEdgeList);
+  BackEdges.insert(BackEdgeList.begin(), BackEdgeList.end());
+
+  // build the DAG, with back edges and the edges after calls replaced by the
+  // dummy edges
+  for (BasicBlock *BB : Blocks) {
+    TerminatorInst *TI = BB->getTerminator();
+    SmallPtrSet<BasicBlock *, 4> Seen;
+    unsigned Flags = BB->getUniqueSuccessor() ? 0 : PATH_BRANCH;
+
+    if (isa<ReturnInst>(TI))
+      Out[BB].push_back({BB, nullptr, 0, PATH_EXIT, 0});
+
+    for (unsigned i = 0, e = TI->getNumSuccessors(); i != e; ++i) {
+      BasicBlock *Succ = TI->getSuccessor(i);
+      if (!Seen.insert(Succ).second)
+        continue;
+
+      if (!BackEdges.count(std::make_pair(BB, Succ)) && !Calls.count(BB)) {
+        Out[BB].push_back({BB, Succ, i, Flags, 0});
+        continue;
+      }
+
+      bool HasReset = false;
+      for (PathEdge &E : Out[Entry])
+        HasReset |= (E.Flags & PATH_RESET) && E.Dst == Succ;
+      if (!HasReset)
+        Out[Entry].push_back({Entry, Succ, 0, PATH_RESET, 0});
+
+      // leaving through the back edge is a branch outcome of BB as well,
+      // a block ending with a call has a single successor
+      Out[BB].push_back({BB, nullptr, i, PATH_EXIT | Flags, 0});
+    }
+  }
+
+  if (!computeEdgeValues(Entry, Out, Paths)) {
+    DEBUG(dbgs() << F.getName() << ": too many paths, skipped\n");
+    NumPathSkipped++;
+    return Modified;
+  }
+
+  emitPathRecord(F, FID, Blocks, Out);
+
+  // collect the instrumentation points before splitting any edge
+  SmallVector<PathEdge, 16> Increments;
+  SmallVector<std::pair<PathEdge, PathEdge>, 8> Latches; // (v->EXIT, ENTRY->w)
+  SmallVector<std::pair<ReturnInst *, uint64_t>, 4> Rets;
+
+  for (BasicBlock *BB : Blocks) {
+    TerminatorInst *TI = BB->getTerminator();
+
+    for (PathEdge &E : Out[BB]) {
+      if (!(E.Flags & PATH_EXIT)) {
+        if (!(E.Flags & PATH_RESET) && E.Val != 0)
+          Increments.push_back(E);
+        continue;
+      }
+
+      if (auto *RI = dyn_cast<ReturnInst>(TI)) {
+        Rets.push_back(std::make_pair(RI, E.Val));
+        continue;
+      }
+
+      // the back edge or call this EXIT edge stands for
+      BasicBlock *Succ = TI->getSuccessor(E.SuccNum);
+      for (PathEdge &R : Out[Entry]) {
+        if ((R.Flags & PATH_RESET) && R.Dst == Succ) {
+          PathEdge Latch = E;
+          Latch.Dst = Succ;
+          Latches.push_back(std::make_pair(Latch, R));
+        }
+      }
+    }
+  }
+
+  IRBuilder<> B(&*Entry->getFirstInsertionPt());
+  Type *I64Ty = B.getInt64Ty();
+  AllocaInst *PathReg = B.CreateAlloca(I64Ty, nullptr, "oat.path");
+  B.CreateStore(ConstantInt::get(I64Ty, 0), PathReg);
+
+  for (PathEdge &E : Increments) {
+    B.SetInsertPoint(getEdgeInsertPoint(E.Src, E.Dst, E.SuccNum));
+    Value *R = B.CreateLoad(PathReg);
+    B.CreateStore(B.CreateAdd(R, ConstantInt::get(I64Ty, E.Val)), PathReg);
+    NumPathIncrements++;
+  }
+
+  for (auto &L : Latches) {
+    // before the call, the callee reports its own paths
+    if (CallInst *CI = Calls.lookup(L.first.Src)) {
+      B.SetInsertPoint(CI);
+      NumPathCalls++;
+    } else {
+      B.SetInsertPoint(getEdgeInsertPoint(L.first.Src, L.first.Dst, L.first.SuccNum));
+    }
+    Value *R = B.CreateLoad(PathReg);
+    oat::createHookCall(B, Hook, {B.getInt32(FID),
+                                  B.CreateAdd(R, ConstantInt::get(I64Ty, L.first.Val))});
+    B.CreateStore(ConstantInt::get(I64Ty, L.second.Val), PathReg);
+  }
+
+  for (auto &R : Rets) {
+    B.SetInsertPoint(R.first);
+    Value *V = B.CreateLoad(PathReg);
+    oat::createHookCall(B, Hook, {B.getInt32(FID),
+                                  B.CreateAdd(V, ConstantInt::get(I64Ty, R.second))});
+  }
+
+  // The branches and switches, by their block. Switches are dispatched by
+  // the verifier as a whole, the backend leaves their jump tables alone.
+  // Selects stay csel as in the functions with cond hints.
+  for (unsigned i = 0, e = Blocks.size(); i != e; ++i) {
+    TerminatorInst *TI = Blocks[i]->getTerminator();
+    if (Blocks[i]->getUniqueSuccessor() || TI->getNumSuccessors() < 2)
+      continue;
+    if (isa<SwitchInst>(TI))
+      TI->setMetadata(oat::SwitchHintMDName, MDNode::get(F.getContext(), None));
+    B.SetInsertPoint(TI);
+    oat::createSiteMarker(B, oat::getSiteID(oat::SitePathBr, FID, oat::PathSiteFlag | i));
+  }
+  for (Instruction &I : instructions(F))
+    if (isa<SelectInst>(&I))
+      I.setMetadata(LLVMContext::MD_unpredictable, MDNode::get(F.getContext(), None));
+
+  F.addFnAttr("oat-path-hints");
+  NumPathFuncs++;
+  return true;
+}
+
+bool CollectPathHints::runOnModule(Module &M) {
+  Type *VoidTy = Type::getVoidTy(M.getContext());
+  Type *I32Ty = Type::getInt32Ty(M.getContext());
+  Type *I64Ty = Type::getInt64Ty(M.getContext());
+  std::vector<std::pair<Function *, unsigned>> Funcs;
+  unsigned FID = 0;
+  bool modified = false;
+
+  // function IDs count the defined functions from 1, as in
+  // -collect-cfv-hints-pass
+  for (Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    ++FID;
+    if (oat::isInScope(F))
+      Funcs.push_back(std::make_pair(&F, FID));
+  }
+
+  if (Funcs.empty())
+    return false;
+
+  Function *Hook = oat::getOrInsertHook(M, "__collect_path_hints",
+                                        FunctionType::get(VoidTy, {I32Ty, I64Ty}, false));
+
+  for (auto &F : Funcs) {
+    if (preferCondHints(*F.first)) {
+      NumPathSkipped++;
+      continue;
+    }
+    modified |= instrumentFunction(*F.first, F.second, Hook);
+  }
+
+  return modified;
+}
+
+char CollectPathHints::ID = 0;
+static RegisterPass<CollectPathHints> X("collect-path-hints-pass", "Collect Ball-Larus Path Hints Info", false, false);
@@ -0,0 +1,111 @@
+//===- MarkImplicitReturns.cpp - Mark returns with a statically known target ===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+// This pass is in cooperation with the Control-Flow Verification pass for
+// AArch64 backend. Every ret is reported to the measurement engine and hashed
+// into the control-flow digest. When a function has exactly one call site in
+// the whole program and its address is never taken, the ret can only go back
+// to that call site, so hashing it adds nothing to the digest.
+//
+// The pass must run on the llvm-link'ed module of the whole program. Such
+// functions get the "oat-implicit-ret" attribute. It only makes them
+// candidates: the target is known while it is in LR, not once the prologue
+// spilled LR to the stack. The AArch64 backend does not instrument the ret of
+// candidates that never save LR and lists them in the .oat_implicit_ret
+// section so the verifier treats them as implicit.
+//
+// The single call site is marked notail: a tail call would return to the
+// caller's caller and the target would no longer be unique.
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Pass.h"
+
+#include "llvm/ADT/Statistic.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+
+#define DEBUG_TYPE "oat-implicit-ret"
+
+STATISTIC(NumImplicitRets, "Number of functions with implicit returns");
+
+using namespace llvm;
+
+// Functions with external linkage may still be called from objects outside of
+// the linked module (e.g. the runtime library), only local ones by default.
+static cl::opt<bool> ImplicitRetLocalOnly("oat-implicit-ret-local-only", cl::Hidden,
+                                  cl::desc("Only mark functions with local linkage"),
+                                  cl::init(true));
+
+namespace {
+struct  MarkImplicitReturns : public ModulePass {
+  static char ID;
+
+  MarkImplicitReturns() : ModulePass(ID) {}
+  bool runOnModule(Module &M) override;
+  Instruction *getSingleCallSite(Function &F);
+};
+} // end of namespace
+
+// return the only direct call site of F, or nullptr if there are zero or
+// more call sites, or F is used in any other way.
+Instruction *MarkImplicitReturns::getSingleCallSite(Function &F) {
+  if (!F.hasOneUse())
+    return nullptr;
+
+  User *U = *F.user_begin();
+  CallSite CS(U);
+  if (!CS || !CS.isCallee(&*F.use_begin()))
+    return nullptr;
+
+  // recursion, the ret may go back into F itself
+  if (CS.getInstruction()->getFunction() == &F)
+    return nullptr;
+
+  return CS.getInstruction();
+}
+
+bool MarkImplicitReturns::runOnModule(Module &M) {
+  bool modified = false;
+
+  for (auto &F : M) {
+    if (F.isDeclaration())
+      continue;
+    if (F.getName() == "main")
+      continue;
+    if (ImplicitRetLocalOnly && !F.hasLocalLinkage())
+      continue;
+    if (F.hasAddressTaken())
+      continue;
+
+    Instruction *I = getSingleCallSite(F);
+    if (I == nullptr)
+      continue;
+
+    if (auto *CI = dyn_cast<CallInst>(I)) {
+      if (CI->isMustTailCall())
+        continue;
+      CI->setTailCallKind(CallInst::TCK_NoTail);
+    }
+
+    DEBUG(dbgs() << "implicit ret: " << F.getName() << " called by "
+                 << I->getFunction()->getName() << "\n");
+
+    F.addFnAttr("oat-implicit-ret");
+    NumImplicitRets++;
+    modified = true;
+  }
+
+  return modified;
+}
+
+char MarkImplicitReturns::ID = 0;
+static RegisterPass<MarkImplicitReturns> X("oat-implicit-ret-pass", "Mark Single Caller Functions With Implicit Returns", false, false);
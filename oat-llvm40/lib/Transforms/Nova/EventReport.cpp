@@ -0,0 +1,200 @@
+//===- EventReport.cpp - Expected OAT events per attested operation -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+// Run this pass last, on the instrumented module of a program that was
+// annotated with a profile by -pgo-instr-use before Nova. It weights every
+// runtime hook call with the profile count of its block and reports the calls
+// and events expected per attested operation, i.e. per executed cfv_init()
+// call, for each hook. Only the functions of the operation count (see
+// oat::isInScope), hooks run outside the operation are not attested. The
+// events the AArch64 control-flow verification pass adds later are estimated
+// from the IR:
+//   - __cfv_icall for the indirect calls of functions without icall hints,
+//   - __cfv_ret for the returns of functions without implicit returns,
+//   - __cfv_ijmp_jt for the switches without a case index hint that have
+//     enough cases for a jump table.
+// Comparing the reports of two pipelines, e.g. with and without
+// -nova-profile-placement, shows what a placement change saves on the device.
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Pass.h"
+
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/OAT/OATCommon.h"
+
+#include <map>
+
+#define DEBUG_TYPE "oat-event-report"
+
+using namespace llvm;
+
+// the fewest cases the AArch64 backend lowers to a jump table, see
+// -min-jump-table-entries
+static const unsigned MinJumpTableCases = 4;
+
+static cl::opt<std::string> EventReportFile("oat-event-report-file",
+                                  cl::desc("File to write the event report to, stderr if empty"),
+                                  cl::init(""));
+
+namespace {
+// calls and events of a hook, summed over the profile
+struct HookCount {
+  uint64_t Calls = 0;
+  uint64_t Events = 0;
+};
+
+struct EventReport : public ModulePass {
+  static char ID;
+
+  std::map<std::string, HookCount> Hooks;
+  uint64_t Operations = 0;
+
+  EventReport() : ModulePass(ID) {}
+  bool runOnModule(Module &M) override;
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+
+  void countFunction(Function &F);
+  void print(raw_ostream &OS, Module &M);
+};
+} // end of namespace
+
+void EventReport::countFunction(Function &F) {
+  DominatorTree DT(F);
+  LoopInfo LI(DT);
+  BranchProbabilityInfo BPI(F, LI);
+  BlockFrequencyInfo BFI(F, BPI, LI);
+  bool Scoped = oat::isInScope(F);
+  bool ICallHints = F.hasFnAttribute("oat-icall-hints");
+  bool ImplicitRet = F.hasFnAttribute("oat-implicit-ret");
+
+  for (BasicBlock &BB : F) {
+    uint64_t Count = BFI.getBlockProfileCount(&BB).getValueOr(0);
+    if (Count == 0)
+      continue;
+
+    for (Instruction &I : BB) {
+      if (isa<ReturnInst>(I) && Scoped && !ImplicitRet) {
+        HookCount &H = Hooks["__cfv_ret"];
+        H.Calls += Count;
+        H.Events += Count;
+        continue;
+      }
+
+      if (auto *SI = dyn_cast<SwitchInst>(&I)) {
+        if (Scoped && !SI->getMetadata(oat::SwitchHintMDName) &&
+            SI->getNumCases() >= MinJumpTableCases) {
+          HookCount &H = Hooks["__cfv_ijmp_jt"];
+          H.Calls += Count;
+          H.Events += Count;
+        }
+        continue;
+      }
+
+      CallSite CS(&I);
+      if (!CS || CS.isInlineAsm())
+        continue;
+
+      auto *Callee = dyn_cast<Function>(CS.getCalledValue()->stripPointerCasts());
+      if (Callee == nullptr) {
+        if (Scoped && !ICallHints) {
+          HookCount &H = Hooks["__cfv_icall"];
+          H.Calls += Count;
+          H.Events += Count;
+        }
+        continue;
+      }
+
+      if (Callee->getName() == "cfv_init") {
+        Operations += Count;
+        continue;
+      }
+      if (!Scoped || Callee->getCallingConv() != oat::HookCallingConv ||
+          !Callee->getName().startswith("__"))
+        continue;
+
+      // a batched check reports its n uses with one world switch
+      uint64_t Events = 1;
+      if (Callee->getName() == "__check_useevt_multi")
+        if (auto *N = dyn_cast<ConstantInt>(CS.getArgument(0)))
+          Events = N->getZExtValue();
+
+      HookCount &H = Hooks[Callee->getName()];
+      H.Calls += Count;
+      H.Events += Count * Events;
+    }
+  }
+}
+
+void EventReport::print(raw_ostream &OS, Module &M) {
+  double PerOp = Operations ? Operations : 1;
+  HookCount Total;
+
+  OS << "# " << M.getModuleIdentifier() << ": " << Operations
+     << " operations in the profile\n";
+  OS << left_justify("hook", 32) << right_justify("calls/op", 15)
+     << right_justify("events/op", 15) << "\n";
+  for (auto &H : Hooks) {
+    OS << left_justify(H.first, 32)
+       << format(" %14.1f %14.1f\n", H.second.Calls / PerOp,
+                 H.second.Events / PerOp);
+    Total.Calls += H.second.Calls;
+    Total.Events += H.second.Events;
+  }
+  OS << left_justify("total", 32)
+     << format(" %14.1f %14.1f\n", Total.Calls / PerOp, Total.Events / PerOp);
+}
+
+bool EventReport::runOnModule(Module &M) {
+  bool HasProfile = false;
+
+  for (Function &F : M) {
+    if (F.isDeclaration() || !F.getEntryCount().hasValue())
+      continue;
+    HasProfile = true;
+    countFunction(F);
+  }
+
+  // opt writes the module to stdout
+  std::error_code EC;
+  std::unique_ptr<raw_fd_ostream> File;
+  if (!EventReportFile.empty()) {
+    File.reset(new raw_fd_ostream(EventReportFile, EC, sys::fs::F_Text));
+    if (EC) {
+      errs() << "oat-event-report: " << EventReportFile << ": "
+             << EC.message() << "\n";
+      return false;
+    }
+  }
+  raw_ostream &OS = File ? *File : errs();
+
+  if (HasProfile)
+    print(OS, M);
+  else
+    OS << "# " << M.getModuleIdentifier()
+       << ": no profile, run -pgo-instr-use first\n";
+
+  Hooks.clear();
+  Operations = 0;
+  return false;
+}
+
+char EventReport::ID = 0;
+static RegisterPass<EventReport> X("oat-event-report", "Report The Expected OAT Events Per Operation", false, true);
@@ -1,5 +1,7 @@
+#include <deque>
 #include <queue>
 #include <set>
+#include <tuple>
 #include <cstdlib>
 #include <string>
 #include <sstream>
@@ -8,6 +10,16 @@
 #include <iostream>
 #include <type_traits>
 #include "llvm/ADT/SCCIterator.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/AssumptionCache.h"
+#include "llvm/Analysis/BasicAliasAnalysis.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Analysis/Loads.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/Pass.h"
 #include "llvm/IR/Mangler.h" 
 #include "llvm/IR/Module.h"
@@ -17,10 +29,24 @@
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/CallSite.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/ModuleSlotTracker.h"
+#include "llvm/Support/CachePruning.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/LineIterator.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/Transforms/OAT/OATCommon.h"
+#include "llvm/Transforms/Utils/MemorySSA.h"
 #include "Nova.h"
 
+#define DEBUG_TYPE "nova"
+
 using namespace llvm;
 using std::stringstream;
 
@@ -30,9 +56,39 @@ using std::stringstream;
 //#define INSTRUMENT_ALL
 //#define INSTRUMENT_HALF
 
+static cl::opt<bool> EliminateRedundant("nova-eliminate-redundant-events",
+                                        cl::desc("Drop def/use events that cannot observe a new value"),
+                                        cl::init(true));
+
+static cl::opt<std::string> NovaCacheDir("nova-cache-dir",
+                                  cl::desc("Directory caching the sensitive variables of analyzed modules"),
+                                  cl::init(""));
+
+static cl::opt<unsigned> NovaCacheExpiration("nova-cache-expiration",
+                                  cl::desc("Days after which an unused cache entry is removed"),
+                                  cl::init(7));
+
+static cl::opt<bool> UseSummaries("nova-summaries",
+                                  cl::desc("Analyze each function once bottom-up and apply its summary at call sites"),
+                                  cl::init(false));
+
+static cl::opt<bool> DemandDriven("nova-demand-driven",
+                                  cl::desc("Only summarize the functions annotated variables flow through"),
+                                  cl::init(false));
+
+static cl::opt<bool> HoistLoopEvents("nova-hoist-loop-events",
+                                     cl::desc("Move def/use events of loop invariant locations out of loops"),
+                                     cl::init(true));
+
+static cl::opt<bool> ProfilePlacement("nova-profile-placement",
+                                      cl::desc("Use the profile of -pgo-instr-use to move checks to colder points"),
+                                      cl::init(true));
+
 // statistics
 int define_event_count = 0;
 int use_event_count = 0;
+int eliminated_define_event_count = 0;
+int eliminated_use_event_count = 0;
 
 Type *m_void_ptr_type;
 ConstantPointerNull* m_void_null_ptr;
@@ -94,6 +150,8 @@ bool INDIRECTCALLCHECKS = true;
 bool Nova::runOnModule(Module &M) {
     GlobalStateRef GS;
     Function *f = NULL;
+    ValueSet senVarSet;
+    std::string cacheFile;
 
     // add function definition for constructors and checkers 
     //ConstructCheckHandlers(M);
@@ -111,33 +169,73 @@ bool Nova::runOnModule(Module &M) {
     GS->pMap = new PointsToMap();
     GS->vMap = new VisitMap();
     GS->senVarSet = new ValueSet();
+    GS->ci = NULL;
+    GS->summary = NULL;
+    GS->memChanges = 0;
+
+#if !defined(INSTRUMENT_ALL) && !defined(INSTRUMENT_HALF)
+    // an identical module was analyzed before, reuse its sensitive variables
+    if (!NovaCacheDir.empty()) {
+        ComputeCacheKeys(M);
+        cacheFile = GetCacheFile(M);
+    }
+#endif
 
-    // initialize pointsto map
-    InitializeGS(GS, M);
+    if (cacheFile.empty() || !LoadSensitiveVars(M, cacheFile, senVarSet)) {
+        // initialize pointsto map
+        InitializeGS(GS, M);
+        CollectAddressTaken(M);
 
-    f = M.getFunction("main");
-    if (f == NULL)
-        errs() << "f is NULL!" <<"\n";
-    Traversal(GS, f);
+        f = M.getFunction("main");
+        if (f == NULL)
+            errs() << "f is NULL!" <<"\n";
+        if (DemandDriven)
+            ComputeDemandedFunctions(M);
+        if (DemandDriven || UseSummaries) {
+            // only the functions whose entry is stale are computed again
+            if (!cacheFile.empty())
+                LoadSummaries(M, GS);
+            ComputeSummaries(GS, M);
+            if (!cacheFile.empty())
+                StoreSummaries(M, GS);
+        } else
+            Traversal(GS, f);
 
-    errs() << "Points To Map:\n";
-    //PrintPointsToMap(GS);
+        errs() << "Points To Map:\n";
+        //PrintPointsToMap(GS);
 
-    errs() << "\nTaint Map:\n";
-    //PrintTaintMap(GS);
+        errs() << "\nTaint Map:\n";
+        //PrintTaintMap(GS);
 
-    // get initial set of sensitive variables annotated by programmer.
-    GetAnnotatedVariables(M, GS);
+        // get initial set of sensitive variables annotated by programmer.
+        GetAnnotatedVariables(M, GS);
+
+        // annotated variables and everything aliasing them
+        CollectSensitiveVars(GS, senVarSet);
+
+        if (!cacheFile.empty())
+            StoreSensitiveVars(M, cacheFile, senVarSet);
+    }
 
     // enforce def-use check
-    DefUseCheck(M, GS);
+    DefUseCheck(M, GS, senVarSet);
 
     errs() << "\ndefine_event_count: " << define_event_count << "\n";
     errs() << "\nuse_event_count: " << use_event_count << "\n";
+    errs() << "\neliminated_define_event_count: " << eliminated_define_event_count << "\n";
+    errs() << "\neliminated_use_event_count: " << eliminated_use_event_count << "\n";
+
+    ReleaseGlobalState(GS);
 
     return true;
 }
 
+void Nova::getAnalysisUsage(AnalysisUsage &AU) const {
+    // analyses of OptimizePlannedEvents
+    AU.addRequired<AssumptionCacheTracker>();
+    getAAResultsAnalysisUsage(AU);
+}
+
 void Nova::ConstructCheckHandlers(Module &module){
 
   Type* void_ty = Type::getVoidTy(module.getContext());
@@ -365,6 +463,16 @@ void Nova::GetAnnotatedVariables(Module &M, GlobalStateRef gs) {
         }
     }
 
+    // llvm.var.annotation moved to metadata by -oat-preserve-annotations
+    for (Function &F : M) {
+        for (Instruction &I : instructions(F)) {
+            if (isa<AllocaInst>(&I) && I.getMetadata(oat::SensitiveMDName)) {
+                gs->senVarSet->insert(&I);
+                errs() << "oat.sensitive: " << I.getName() << " \n";
+            }
+        }
+    }
+
     return;
 }
 
@@ -387,7 +495,7 @@ void Nova::InitializeGS(GlobalStateRef gs, Module &M) {
     Type *type = NULL;
     AliasObjectRef aor = NULL;
     AliasObjectTupleRef aot = NULL;
-    TupleSet *ts = NULL;
+    TupleSet ts;
     InstSet *is = NULL;
 
     //errs() <<__func__<<" : \n";
@@ -405,21 +513,20 @@ void Nova::InitializeGS(GlobalStateRef gs, Module &M) {
         //errs() << "GlobalValue gv pointee typeID: " << type->getPointerElementType()->getTypeID() << "\n";
 
         aor = CreateAliasObject(type->getPointerElementType(), gv);
+        Arena.roots[gv] = aor;
 
         // create alias object tuple
-        aot = new struct AliasObjectTuple();
-        aot->offset = 0;
-        aot->ao = aor;
+        aot = GetAliasObjectTuple(aor, 0);
 
         // create tuple set
-        ts = new TupleSet();
-        ts->insert(aot);
+        ts.clear();
+        ts.insert(aot);
 
         // add ele into points to map
-        (*(gs->pMap))[gv] = ts;
+        (*(gs->pMap))[gv] = InternTupleSet(ts);
 
         // initialize global taint map
-        is = new InstSet();
+        is = NewInstSet();
         (*(gs->tMap))[gv] = is;
     }
 
@@ -448,20 +555,135 @@ void Nova::ReverseSCC(std::vector<SCCRef> &sccVector, Function *f) {
     return;
 }
 
-uint32_t Nova::LongestUseDefChain(SCC &scc) {
-    // TODOO
-    return MAX_RUNS;
+// Visit the loop to a fixpoint. After a first visit in order, only the users
+// of a value whose points-to or taint set changed are revisited, and the loads
+// and calls of the loop when a store grew the sets of some object.
+void Nova::HandleLoop(GlobalStateRef gs, SCC &scc) {
+    std::deque<Instruction *> worklist;
+    SmallPtrSet<Instruction *, 32> inLoop, queued;
+    SmallVector<Instruction *, 16> memReaders;
+    DenseMap<Instruction *, uint32_t> visits;
+    Instruction *I;
+    TupleSet *ts;
+    InstSet *is;
+    size_t taintSize;
+    uint64_t memChanges;
+    bool capped = false;
+
+    for (BasicBlock *BB : scc) {
+        for (Instruction &LI : *BB) {
+            inLoop.insert(&LI);
+            queued.insert(&LI);
+            worklist.push_back(&LI);
+            if (isa<LoadInst>(&LI) || isa<CallInst>(&LI))
+                memReaders.push_back(&LI);
+        }
+    }
+
+    auto Enqueue = [&](Instruction *UI) {
+        if (inLoop.count(UI) && queued.insert(UI).second)
+            worklist.push_back(UI);
+    };
+
+    while (!worklist.empty()) {
+        I = worklist.front();
+        worklist.pop_front();
+        queued.erase(I);
+
+        // allocas create a new object on each visit, the sets only grow
+        // otherwise but bound the visits in case they do not settle down
+        uint32_t &count = visits[I];
+        if (count > 0 && isa<AllocaInst>(I))
+            continue;
+        if (count >= MAX_LOOP_VISITS) {
+            capped = true;
+            continue;
+        }
+        count++;
+
+        ts = gs->pMap->lookup(I);
+        is = gs->tMap->lookup(I);
+        taintSize = is != NULL ? is->count() : 0;
+        memChanges = gs->memChanges;
+
+        VisitInstruction(gs, *I);
+
+        is = gs->tMap->lookup(I);
+        if (gs->pMap->lookup(I) != ts || (is != NULL ? is->count() : 0) != taintSize) {
+            for (User *U : I->users()) {
+                if (auto *UI = dyn_cast<Instruction>(U))
+                    Enqueue(UI);
+            }
+        }
+
+        if (gs->memChanges != memChanges) {
+            for (Instruction *MI : memReaders)
+                Enqueue(MI);
+        }
+    }
+
+    if (capped)
+        HandleUnsettledLoop(gs, scc);
+
+    return;
 }
 
-void Nova::HandleLoop(GlobalStateRef gs, SCC &scc) {
-    uint32_t i, numRuns = LongestUseDefChain(scc);
+// The sets of a loop did not settle within MAX_LOOP_VISITS. Assume every
+// value of the loop may point to what any other points to and carries the
+// taint of all of them, and so does everything the loop stores to.
+void Nova::HandleUnsettledLoop(GlobalStateRef gs, SCC &scc) {
+    InstSet all;
+    TupleSet pts;
+    TupleSet *ts;
+    InstSet *is;
 
-    i = 0;
-    while (i < numRuns) {
-        //errs() << "SCC: ";
-        VisitSCC(gs, scc);
-        //errs() << "\n";
-        i++;
+    DEBUG(dbgs() << "nova: loop at " << scc.front()->getName() << " in "
+                 << scc.front()->getParent()->getName() << " hit "
+                 << MAX_LOOP_VISITS << " visits, assuming the worst\n");
+
+    for (BasicBlock *BB : scc) {
+        for (Instruction &LI : *BB) {
+            all.set(GetInstID(&LI));
+            if ((is = gs->tMap->lookup(&LI)) != NULL)
+                all |= *is;
+            if ((ts = gs->pMap->lookup(&LI)) != NULL)
+                pts.insert(ts->begin(), ts->end());
+        }
+    }
+
+    for (BasicBlock *BB : scc) {
+        for (Instruction &LI : *BB) {
+            if ((is = gs->tMap->lookup(&LI)) == NULL) {
+                is = NewInstSet();
+                (*(gs->tMap))[&LI] = is;
+            }
+            *is |= all;
+            if (LI.getType()->isPointerTy() && !pts.empty())
+                (*(gs->pMap))[&LI] = InternTupleSet(pts);
+        }
+    }
+
+    for (BasicBlock *BB : scc) {
+        for (Instruction &LI : *BB) {
+            if (!isa<StoreInst>(&LI))
+                continue;
+            VisitInstruction(gs, LI);
+
+            ts = gs->pMap->lookup(cast<StoreInst>(&LI)->getPointerOperand());
+            if (ts == NULL)
+                continue;
+            for (AliasObjectTupleRef aot : *ts) {
+                LocalTaintMapRef taintMap = aot->ao->taintMap;
+                if (taintMap == NULL)
+                    continue;
+                if (taintMap->find(aot->offset) == taintMap->end())
+                    (*taintMap)[aot->offset] = NewInstSet();
+                if (*(*taintMap)[aot->offset] |= all) {
+                    gs->memChanges++;
+                    aot->ao->changes++;
+                }
+            }
+        }
     }
 
     return;
@@ -514,10 +736,23 @@ void Nova::InitializeFunction(GlobalStateRef gs, Function *f, CallInst &I) {
 }
 
 void Nova::HandleCall(GlobalStateRef gs, CallInst &I) {
+    SmallVector<Function *, 4> targets;
     Value *var;
     Function *f;
 
-    f = ResolveCall(gs, I);
+    // a summary is applied at every call site, no need to track visits
+    if (gs->summary != NULL)
+        f = I.getCalledFunction();
+    else
+        f = ResolveCall(gs, I);
+
+    // an indirect call may run any of its targets
+    if (gs->summary != NULL && f == NULL) {
+        GetCallTargets(&I, targets);
+        for (Function *target : targets)
+            ApplySummary(gs, target, I);
+        return;
+    }
 
     if (f != NULL && f->getName() == "llvm.var.annotation") {
         //llvm.var.annotation(arg0, arg1, arg2, arg3), arg0 is the annotated variable
@@ -529,7 +764,9 @@ void Nova::HandleCall(GlobalStateRef gs, CallInst &I) {
         //errs() << "called func: " << f->getName() << "\n";
 
         // handle parameters and global variables
-        if (!f->isDeclaration()) {
+        if (gs->summary != NULL) {
+            ApplySummary(gs, f, I);
+        } else if (!f->isDeclaration()) {
             InitializeFunction(gs, f, I);
             Traversal(gs, f);
         }
@@ -548,13 +785,15 @@ AliasObject *Nova::CreateAliasObject(Type *type, Value *v) {
     assert(type != NULL);
 
     // create a alias object 
-    aor = new struct AliasObject();
+    aor = new (Arena.aliasObjects.Allocate()) AliasObject();
     aor->val = v;
     aor->type = type;
     aor->isStruct = type->isStructTy();
     aor->isLocation = false;
-    aor->aliasMap = new AliasMap();
-    aor->taintMap = new LocalTaintMap();
+    aor->isParam = false;
+    aor->aliasMap = new (Arena.aliasMaps.Allocate()) AliasMap();
+    aor->taintMap = new (Arena.taintMaps.Allocate()) LocalTaintMap();
+    aor->changes = 0;
 
     if (type->isStructTy() && SkipStructType(type)) {
     	aor->isStruct = false;
@@ -566,7 +805,7 @@ AliasObject *Nova::CreateAliasObject(Type *type, Value *v) {
         for (Type::subtype_iterator it = type->subtype_begin(), ie = type->subtype_end();
                                                                 it != ie; ++it, ++i) {
             // alias object set
-            aos = new AliasObjectSet();
+            aos = NewAliasObjectSet();
 
             // recursively create aliasobject for struct type
             //errs() <<__func__<<" struct field: "<<(*it)->getTypeID()<<"\n";
@@ -578,7 +817,7 @@ AliasObject *Nova::CreateAliasObject(Type *type, Value *v) {
         }
     } else if (type->isPointerTy()) {
             // alias object set
-            aos = new AliasObjectSet();
+            aos = NewAliasObjectSet();
 
             // recursively create aliasobject for pointer type
             subtype = type->getPointerElementType();
@@ -589,14 +828,15 @@ AliasObject *Nova::CreateAliasObject(Type *type, Value *v) {
             (*(aor->aliasMap))[0] = aos;
     } else {
         // alias object set
-        aos = new AliasObjectSet();
+        aos = NewAliasObjectSet();
 
         // create a location object for stack var 
-        loc = new struct AliasObject();
+        loc = new (Arena.aliasObjects.Allocate()) AliasObject();
         loc->val = v;
         loc->type = NULL;
         loc->isStruct = false;
         loc->isLocation = true;
+        loc->isParam = false;
         loc->aliasMap = NULL;
         loc->taintMap = NULL;
 
@@ -609,6 +849,97 @@ AliasObject *Nova::CreateAliasObject(Type *type, Value *v) {
     return aor;
 }
 
+// tuples are interned, (ao, offset) always maps to the same tuple
+AliasObjectTupleRef Nova::GetAliasObjectTuple(AliasObjectRef ao, int offset) {
+    AliasObjectTupleRef &aot = Arena.tupleMap[std::make_pair(ao, offset)];
+
+    if (aot == NULL) {
+        aot = new (Arena.tuples.Allocate()) AliasObjectTuple();
+        aot->offset = offset;
+        aot->ao = ao;
+    }
+
+    return aot;
+}
+
+// Return the interned tuple set holding the tuples of ts.
+TupleSet *Nova::InternTupleSet(const TupleSet &ts) {
+    SmallVector<AliasObjectTupleRef, 8> key(ts.begin(), ts.end());
+    TupleSet *its;
+
+    std::sort(key.begin(), key.end());
+    SmallVector<TupleSet *, 1> &bucket =
+        Arena.tupleSetMap[hash_combine_range(key.begin(), key.end())];
+
+    for (TupleSet *candidate : bucket) {
+        if (candidate->size() != ts.size())
+            continue;
+        if (std::all_of(ts.begin(), ts.end(),
+                        [&](AliasObjectTupleRef aot) { return candidate->count(aot); }))
+            return candidate;
+    }
+
+    its = new (Arena.tupleSets.Allocate()) TupleSet(ts.begin(), ts.end());
+    bucket.push_back(its);
+
+    return its;
+}
+
+AliasObjectSet *Nova::NewAliasObjectSet() {
+    return new (Arena.aliasObjectSets.Allocate()) AliasObjectSet();
+}
+
+InstSet *Nova::NewInstSet() {
+    return new (Arena.instSets.Allocate()) InstSet();
+}
+
+unsigned Nova::GetInstID(Instruction *I) {
+    auto it = Arena.instIDs.insert(std::make_pair(I, Arena.insts.size()));
+
+    if (it.second)
+        Arena.insts.push_back(I);
+
+    return it.first->second;
+}
+
+void NovaArena::Reset() {
+    tupleMap.clear();
+    tupleSetMap.clear();
+    instIDs.clear();
+    insts.clear();
+    roots.clear();
+
+    summaries.DestroyAll();
+    instSets.DestroyAll();
+    taintMaps.DestroyAll();
+    aliasMaps.DestroyAll();
+    aliasObjectSets.DestroyAll();
+    tupleSets.DestroyAll();
+    tuples.DestroyAll();
+    aliasObjects.DestroyAll();
+}
+
+// the analysis state is only needed until DefUseCheck is done
+void Nova::ReleaseGlobalState(GlobalStateRef gs) {
+    summaries.clear();
+    paramBindings.clear();
+    demandedFuncs.clear();
+    addrTakenFuncs.clear();
+    allAddrTakenFuncs.clear();
+    usedGlobals.clear();
+    funcHashes.clear();
+    hashedAddrTaken.clear();
+    cachedSummaries.clear();
+
+    delete gs->tMap;
+    delete gs->pMap;
+    delete gs->vMap;
+    delete gs->senVarSet;
+    delete gs;
+
+    Arena.Reset();
+}
+
 void Nova::PrintAliasObject(AliasObjectRef ao) {
     unsigned i, size;
 
@@ -637,40 +968,43 @@ void Nova::UpdatePtoAlloca(GlobalStateRef gs, Instruction &I){
     Type *type = NULL;
     AliasObjectRef aor = NULL;
     AliasObjectTupleRef aot = NULL;
-    TupleSet *ts = NULL;
+    TupleSet ts;
 
     //errs() <<__func__<<" : "<<I<<"\n";
 
     assert(ai = cast<AllocaInst>(&I));
     assert(ai != NULL);
     
+    // a summary is computed until it settles, one object per alloca
+    if (gs->summary != NULL && gs->pMap->lookup(&I) != NULL)
+        return;
+
     type = ai->getAllocatedType();
     //errs() << "AllocaInst typeID: " << ai->getType()->getTypeID() << "\n";
     //errs() << "AllocaInst pointee typeID: " << ai->getType()->getPointerElementType()->getTypeID() << "\n";
     //errs() << "AllocaInst allocated typeID: " << type->getTypeID() << "\n";
 
     aor = CreateAliasObject(type, &I); 
+    Arena.roots[&I] = aor;
 
     // debug
     PrintAliasObject(aor);
 
     // create alias object tuple
-    aot = new struct AliasObjectTuple();
-    aot->offset = 0;
-    aot->ao = aor;
+    aot = GetAliasObjectTuple(aor, 0);
 
     // create tuple set
-    ts = new TupleSet();
-    ts->insert(aot);
+    ts.insert(aot);
 
     // add ele into points to map
-    (*(gs->pMap))[&I] = ts;
+    (*(gs->pMap))[&I] = InternTupleSet(ts);
 
     return;
 }
 
 void Nova::UpdatePtoBinOp(GlobalStateRef gs, Instruction &I){
-    TupleSet *ts1, *ts2, *ts;
+    TupleSet *ts1, *ts2;
+    TupleSet ts;
     Value *op1, *op2;
 
     //errs() <<__func__<<" : "<<I<<"\n";
@@ -694,34 +1028,34 @@ void Nova::UpdatePtoBinOp(GlobalStateRef gs, Instruction &I){
 
     // new tuple set is for v
     if (gs->pMap->find(&I) != gs->pMap->end()) {
-        ts = (*(gs->pMap))[&I];
-    } else {
-        ts = new TupleSet();
-        (*(gs->pMap))[&I] = ts;
+        ts.insert((*(gs->pMap))[&I]->begin(), (*(gs->pMap))[&I]->end());
     }
 
     // merge ts1, ts2 into ts
     if (ts1 != NULL) {
         for (TupleSet::iterator it = ts1->begin(), ie = ts1->end();
                                     it != ie; ++it) {
-            ts->insert(*it);
+            ts.insert(*it);
         }
     }
 
     if (ts2 != NULL) {
         for (TupleSet::iterator it = ts2->begin(), ie = ts2->end();
                                     it != ie; ++it) {
-            ts->insert(*it);
+            ts.insert(*it);
         }
     }
 
+    (*(gs->pMap))[&I] = InternTupleSet(ts);
+
     return;
 }
 
 void Nova::UpdatePtoLoad(GlobalStateRef gs, Instruction &I){
     LoadInst *li;
     Value *op;
-    TupleSet *ts, *nts;
+    TupleSet *ts;
+    TupleSet nts;
     AliasObjectTupleRef aot;
     AliasObjectSet *aos;
     AliasMapRef aliasMap;
@@ -743,7 +1077,6 @@ void Nova::UpdatePtoLoad(GlobalStateRef gs, Instruction &I){
         return;
     
     // create new tupleset for loadinst, llvm IR is in ssa form, so every load defines a new tmp var
-    nts = new TupleSet();
     for (TupleSet::iterator tsit = ts->begin(), tsie = ts->end();
                                                 tsit != tsie; ++tsit) {
         aliasMap = (*tsit)->ao->aliasMap;
@@ -760,22 +1093,21 @@ void Nova::UpdatePtoLoad(GlobalStateRef gs, Instruction &I){
         if (aliasMap == nullptr || aliasMap->find(offset) == aliasMap->end()) {
             return;
         }
+        NoteGlobalAccess(gs, (*tsit)->ao, offset, false);
     
         // create a new tuple
         aos = (*aliasMap)[offset];
         for(AliasObjectSet::iterator aosit = aos->begin(), aosie = aos->end();
                                                            aosit != aosie; ++aosit) {
-            aot = new struct AliasObjectTuple();
-            aot->offset = 0;
-            aot->ao = (*aosit);
+            aot = GetAliasObjectTuple(*aosit, 0);
 
             // insert new tuple into a new tupleset 
-            nts->insert(aot);
+            nts.insert(aot);
         }
     } 
 
     // add ele into points to map
-    (*(gs->pMap))[&I] = nts;
+    (*(gs->pMap))[&I] = InternTupleSet(nts);
 
     return;
 }
@@ -783,7 +1115,8 @@ void Nova::UpdatePtoLoad(GlobalStateRef gs, Instruction &I){
 void Nova::HandlePtoGEPOperator(GlobalStateRef gs, GEPOperator *gop) {
     Value *op, *idx1, *idx2;
     uint32_t i, off;
-    TupleSet *ts, *nts;
+    TupleSet *ts;
+    TupleSet nts;
     AliasObjectTupleRef aot;
 
     // get operand
@@ -847,12 +1180,9 @@ void Nova::HandlePtoGEPOperator(GlobalStateRef gs, GEPOperator *gop) {
 
         // create new tupleset for gep
         // NOTE: we don't dereference op here, op should always be the start address of the struct
-        nts = new TupleSet();
         for (TupleSet::iterator tsit = ts->begin(), tsie = ts->end();
                                                     tsit != tsie; ++tsit) {
-            aot = new struct AliasObjectTuple();
-            aot->offset = off;
-            aot->ao = (*tsit)->ao;
+            aot = GetAliasObjectTuple((*tsit)->ao, off);
 
             // debug
             //errs() << __func__ << ": new tuple : off = " << off << " ao->val: " << (*tsit)->ao->val <<"\n";
@@ -860,11 +1190,11 @@ void Nova::HandlePtoGEPOperator(GlobalStateRef gs, GEPOperator *gop) {
             PrintAliasObject((*tsit)->ao);
 
             // insert new tuple into a new tupleset 
-            nts->insert(aot);
+            nts.insert(aot);
         } 
 
         // add ele into points to map
-        (*(gs->pMap))[gop] = nts;
+        (*(gs->pMap))[gop] = InternTupleSet(nts);
     }
 
     return;
@@ -875,7 +1205,8 @@ void Nova::UpdatePtoStore(GlobalStateRef gs, Instruction &I){
     GEPOperator *gepop;
     Value *op, *v;
     TupleSet *ots, *vts;
-    AliasObjectSet *aos, *vaos;
+    AliasObjectSet *aos;
+    AliasObjectSet vaos;
     AliasMapRef aliasMap;
     AliasObjectRef ao;
     uint32_t offset;
@@ -917,11 +1248,10 @@ void Nova::UpdatePtoStore(GlobalStateRef gs, Instruction &I){
     // update aliasobject points-to by operand op
 
     // get operand v's AliasObject set
-    vaos = new AliasObjectSet();
     for (TupleSet::iterator vtsit = vts->begin(), vtsie = vts->end();
                                                 vtsit != vtsie; ++vtsit) {
         ao = (*vtsit)->ao;
-        vaos->insert(ao);
+        vaos.insert(ao);
     }
 
 
@@ -948,15 +1278,16 @@ void Nova::UpdatePtoStore(GlobalStateRef gs, Instruction &I){
         // copy v's aliasobject into op's value's aliasobject
         // TODOO we lose the v's ao'offset info here
         aos = (*aliasMap)[offset];
-        for(AliasObjectSet::iterator aosit = vaos->begin(), aosie = vaos->end();
+        for(AliasObjectSet::iterator aosit = vaos.begin(), aosie = vaos.end();
                                                            aosit != aosie; ++aosit) {
-            aos->insert(*aosit);
+            if (aos->insert(*aosit)) {
+                gs->memChanges++;
+                (*otsit)->ao->changes++;
+            }
         }
+        NoteGlobalAccess(gs, (*otsit)->ao, offset, true);
     } 
 
-    // release allocated tempary objects
-    delete vaos;
-
     return;
 }
 
@@ -964,7 +1295,8 @@ void Nova::UpdatePtoGEP(GlobalStateRef gs, Instruction &I){
     GetElementPtrInst *gepi;
     Value *op, *idx2;
     uint32_t i, off;
-    TupleSet *ts, *nts;
+    TupleSet *ts;
+    TupleSet nts;
     AliasObjectTupleRef aot;
 
     //errs() <<__func__<<" : "<<I<<"\n";
@@ -1026,12 +1358,9 @@ void Nova::UpdatePtoGEP(GlobalStateRef gs, Instruction &I){
 
         // create new tupleset for gep
         // NOTE: we don't dereference op here, op should always be the start address of the struct
-        nts = new TupleSet();
         for (TupleSet::iterator tsit = ts->begin(), tsie = ts->end();
                                                     tsit != tsie; ++tsit) {
-            aot = new struct AliasObjectTuple();
-            aot->offset = off;
-            aot->ao = (*tsit)->ao;
+            aot = GetAliasObjectTuple((*tsit)->ao, off);
 
             // debug
             //errs() << __func__ << ": new tuple : off = " << off << " ao->val: " << (*tsit)->ao->val <<"\n";
@@ -1039,11 +1368,11 @@ void Nova::UpdatePtoGEP(GlobalStateRef gs, Instruction &I){
             PrintAliasObject((*tsit)->ao);
 
             // insert new tuple into a new tupleset 
-            nts->insert(aot);
+            nts.insert(aot);
         } 
 
         // add ele into points to map
-        (*(gs->pMap))[&I] = nts;
+        (*(gs->pMap))[&I] = InternTupleSet(nts);
     } else {
         // errs() << __func__ << " nearly skip instruction : " << I << "\n"; 
         (*(gs->pMap))[&I] = ts;
@@ -1065,6 +1394,17 @@ void Nova::UpdatePtoRet(GlobalStateRef gs, Instruction &I){
     if (gs->pMap->find(ret) != gs->pMap->end())
         ts = (*(gs->pMap))[ret];
 
+    // computing a summary, the returned value goes to the summary
+    if (gs->summary != NULL) {
+        if (ts != NULL) {
+            TupleSet mts(ts->begin(), ts->end());
+            if (gs->summary->ret != NULL)
+                mts.insert(gs->summary->ret->begin(), gs->summary->ret->end());
+            gs->summary->ret = InternTupleSet(mts);
+        }
+        return;
+    }
+
     // get current callInst and the corresponding tuple set
     ci = gs->ci;
     if (gs->pMap->find(ci) != gs->pMap->end())
@@ -1072,11 +1412,13 @@ void Nova::UpdatePtoRet(GlobalStateRef gs, Instruction &I){
 
     if (ts != NULL) {
         if (nts != NULL) {
-            // merge ts and nts
+            // merge ts and nts, nts is interned so build a new one
+            TupleSet mts(nts->begin(), nts->end());
             for (TupleSet::iterator it = ts->begin(), ie = ts->end();
                                             it != ie; ++it ) {
-                nts->insert(*it);
+                mts.insert(*it);
             }
+            (*(gs->pMap))[ci] = InternTupleSet(mts);
         } else {
             // assign ts to ci's points-to map, thus ci will carry the ret's info back to caller
             (*(gs->pMap))[ci] = ts;
@@ -1107,6 +1449,28 @@ void Nova::UpdatePtoBitCast(GlobalStateRef gs, Instruction &I){
     (*(gs->pMap))[bci] = ts;
 }
 
+// phi and select, which optimized builds have instead of allocas, may point to
+// whatever any of their operands points to
+void Nova::UpdatePtoMerge(GlobalStateRef gs, Instruction &I, ArrayRef<Value *> ops){
+    TupleSet mts;
+    TupleSet *ts;
+
+    if (gs->pMap->find(&I) != gs->pMap->end() && (*(gs->pMap))[&I] != NULL)
+        mts.insert((*(gs->pMap))[&I]->begin(), (*(gs->pMap))[&I]->end());
+
+    // operands on a back edge have no entry yet on the first visit
+    for (Value *op : ops) {
+        if (gs->pMap->find(op) == gs->pMap->end())
+            continue;
+        ts = (*(gs->pMap))[op];
+        if (ts != NULL)
+            mts.insert(ts->begin(), ts->end());
+    }
+
+    if (!mts.empty())
+        (*(gs->pMap))[&I] = InternTupleSet(mts);
+}
+
 void Nova::UpdateTaintAlloca(GlobalStateRef gs, Instruction &I){
     // TODOO
     //errs() <<__func__<<" : "<<I<<"\n";
@@ -1139,26 +1503,18 @@ void Nova::UpdateTaintBinOp(GlobalStateRef gs, Instruction &I){
     if (gs->tMap->find(&I) != gs->tMap->end()) {
         is = (*(gs->tMap))[&I];
     } else {
-        is = new InstSet();
+        is = NewInstSet();
         (*(gs->tMap))[&I] = is;
     }
 
     // merge is1, is2 into is
-    if (is1 != NULL) {
-        for (InstSet::iterator it = is1->begin(), ie = is1->end();
-                                    it != ie; ++it) {
-            is->insert(*it);
-        }
-    }
+    if (is1 != NULL)
+        *is |= *is1;
 
-    if (is2 != NULL) {
-        for (InstSet::iterator it = is2->begin(), ie = is2->end();
-                                    it != ie; ++it) {
-            is->insert(*it);
-        }
-    }
+    if (is2 != NULL)
+        *is |= *is2;
 
-    is->insert(&I);
+    is->set(GetInstID(&I));
 
 
     return;
@@ -1169,7 +1525,7 @@ void Nova::UpdateTaintLoad(GlobalStateRef gs, Instruction &I){
     Value *op;
     TupleSet *ts;
     LocalTaintMapRef taintMap;
-    InstSet *is, *bis, *obis;
+    InstSet *is, *bis;
     uint32_t offset;
 
     //errs() <<__func__<<" : "<<I<<"\n";
@@ -1187,8 +1543,14 @@ void Nova::UpdateTaintLoad(GlobalStateRef gs, Instruction &I){
     if (ts == NULL)
         return;
     
-    // collect local instset from all aliasobject's local taintmap, put them into big instset bis
-    bis = new InstSet();
+    // collect local instset from all aliasobject's local taintmap, put them into big instset bis,
+    // the old bis only grows
+    if (gs->tMap->find(&I) != gs->tMap->end()) {
+        bis = (*(gs->tMap))[&I];
+    } else {
+        bis = NewInstSet();
+        (*(gs->tMap))[&I] = bis;
+    }
     for (TupleSet::iterator tsit = ts->begin(), tsie = ts->end();
                                                 tsit != tsie; ++tsit) {
         taintMap = (*tsit)->ao->taintMap;
@@ -1201,30 +1563,17 @@ void Nova::UpdateTaintLoad(GlobalStateRef gs, Instruction &I){
         if (taintMap->find(offset) != taintMap->end()) {
             is = (*taintMap)[offset];
         } else {
-            is = new InstSet();
+            is = NewInstSet();
             (*taintMap)[offset] = is;
         }
 
-        // iterate over local taintmap's instset is
-        for(InstSet::iterator it = is->begin(), ie = is->end();
-                                                it != ie; ++it) {
-           bis->insert(*it);
-        }
-    }
-
-    bis->insert(&I);
+        NoteGlobalAccess(gs, (*tsit)->ao, offset, false);
 
-    // merge old bis with new bis
-    if (gs->tMap->find(&I) != gs->tMap->end()) {
-        obis = (*(gs->tMap))[&I];
-        for (InstSet::iterator it = obis->begin(), ie = obis->end();
-                                                it != ie; ++it) {
-            bis->insert(*it);
-        }
-    } 
+        // merge local taintmap's instset is
+        *bis |= *is;
+    }
 
-    // add (I, bis) into taint map
-    (*(gs->tMap))[&I] = bis;
+    bis->set(GetInstID(&I));
 
     return;
 }
@@ -1282,22 +1631,24 @@ void Nova::UpdateTaintStore(GlobalStateRef gs, Instruction &I) {
         // if taintMap at ao'offset does not exist, create one.
         assert(taintMap != NULL);
         if (taintMap->find(offset) == taintMap->end()) {
-            is = new InstSet();
+            is = NewInstSet();
             (*taintMap)[offset] = is;
         } else {
             is = (*taintMap)[offset];
         }
 
         // merge v's taintmap into op's aliasobject's local taintmap at offset
-        if (vis != NULL) {
-            for(InstSet::iterator it = vis->begin(), ie = vis->end();
-                                                    it != ie; ++it) {
-                is->insert(*it);
-            }
+        if (vis != NULL && (*is |= *vis)) {
+            gs->memChanges++;
+            (*tsit)->ao->changes++;
         }
 
         // include this storeinst I
-        is->insert(&I);
+        if (is->test_and_set(GetInstID(&I))) {
+            gs->memChanges++;
+            (*tsit)->ao->changes++;
+        }
+        NoteGlobalAccess(gs, (*tsit)->ao, offset, true);
     }
 
     return;
@@ -1321,27 +1672,42 @@ void Nova::UpdateTaintGEP(GlobalStateRef gs, Instruction &I) {
         is1 = NULL;
     }
 
-    // new instset is for v
-    is = new InstSet();
-
-    // merge is1, is2 into is
-    if (is1 != NULL) {
-        for (InstSet::iterator it = is1->begin(), ie = is1->end();
-                                    it != ie; ++it) {
-            is->insert(*it);
-        }
+    // new instset is for v, the old one only grows
+    if (gs->tMap->find(&I) != gs->tMap->end()) {
+        is = (*(gs->tMap))[&I];
+    } else {
+        is = NewInstSet();
+        (*(gs->tMap))[&I] = is;
     }
 
-    // don't forget this GEP inst
-    is->insert(&I);
+    // merge is1 into is
+    if (is1 != NULL)
+        *is |= *is1;
 
-    // add (I, is) into taint map
-    //assert(gs->tMap->find(&I) == gs->tMap->end());
-    (*(gs->tMap))[&I] = is;
+    // don't forget this GEP inst
+    is->set(GetInstID(&I));
 
     return;
 }
 
+void Nova::UpdateTaintMerge(GlobalStateRef gs, Instruction &I, ArrayRef<Value *> ops){
+    InstSet *is;
+
+    if (gs->tMap->find(&I) != gs->tMap->end()) {
+        is = (*(gs->tMap))[&I];
+    } else {
+        is = NewInstSet();
+        (*(gs->tMap))[&I] = is;
+    }
+
+    for (Value *op : ops) {
+        if (gs->tMap->find(op) != gs->tMap->end() && (*(gs->tMap))[op] != NULL)
+            *is |= *(*(gs->tMap))[op];
+    }
+
+    is->set(GetInstID(&I));
+}
+
 void Nova::UpdateTaintRet(GlobalStateRef gs, Instruction &I){
     ReturnInst *ri;
     Value *ret, *ci;
@@ -1355,6 +1721,13 @@ void Nova::UpdateTaintRet(GlobalStateRef gs, Instruction &I){
     if (gs->tMap->find(ret) != gs->tMap->end())
         is = (*(gs->tMap))[ret];
 
+    // computing a summary, the returned value goes to the summary
+    if (gs->summary != NULL) {
+        if (is != NULL)
+            *gs->summary->retTaint |= *is;
+        return;
+    }
+
     // get current callInst and the corresponding tuple set
     ci = gs->ci;
     if (gs->tMap->find(ci) != gs->tMap->end())
@@ -1363,10 +1736,7 @@ void Nova::UpdateTaintRet(GlobalStateRef gs, Instruction &I){
     if (is != NULL) {
         if (nis != NULL) {
             // merge is and nis
-            for (InstSet::iterator it = is->begin(), ie = is->end();
-                                            it != ie; ++it ) {
-                nis->insert(*it);
-            }
+            *nis |= *is;
         } else {
             // assign ts to ci's points-to map, thus ci will carry the ret's info back to caller
             (*(gs->tMap))[ci] = is;
@@ -1389,9 +1759,9 @@ void Nova::UpdateTaintBitCast(GlobalStateRef gs, Instruction &I){
     if (gs->tMap->find(op) != gs->tMap->end())
         is = (*(gs->tMap))[op];
     else
-        is = new InstSet();
+        is = NewInstSet();
 
-    is->insert(&I);
+    is->set(GetInstID(&I));
 
     // for cast inst, the target and src share the same tuple set
     if (gs->tMap->find(bci) != gs->tMap->end()) {
@@ -1416,6 +1786,10 @@ void Nova::PointsToAnalysis(GlobalStateRef gs, Instruction &I) {
         UpdatePtoRet(gs, I);
     } else if (isa<BitCastInst>(&I)){
         UpdatePtoBitCast(gs, I);
+    } else if (auto *phi = dyn_cast<PHINode>(&I)){
+        UpdatePtoMerge(gs, I, SmallVector<Value *, 4>(phi->incoming_values()));
+    } else if (auto *si = dyn_cast<SelectInst>(&I)){
+        UpdatePtoMerge(gs, I, {si->getTrueValue(), si->getFalseValue()});
     } else {
         // Not handled inst
         //errs() <<"Unhandled Inst: "<<I<<"\n";
@@ -1437,6 +1811,10 @@ void Nova::TaintAnalysis(GlobalStateRef gs, Instruction &I) {
         UpdateTaintRet(gs, I);
     } else if (isa<BitCastInst>(&I)){
         UpdateTaintBitCast(gs, I);
+    } else if (auto *phi = dyn_cast<PHINode>(&I)){
+        UpdateTaintMerge(gs, I, SmallVector<Value *, 4>(phi->incoming_values()));
+    } else if (auto *si = dyn_cast<SelectInst>(&I)){
+        UpdateTaintMerge(gs, I, {si->getCondition(), si->getTrueValue(), si->getFalseValue()});
     } else {
         // Not handled inst
         //errs() <<"Unhandled Inst: "<<I<<"\n";
@@ -1448,17 +1826,21 @@ void Nova::DispatchClients(GlobalStateRef gs, Instruction &I) {
     TaintAnalysis(gs, I);
 }
 
+void Nova::VisitInstruction(GlobalStateRef gs, Instruction &I) {
+    if (auto *callInst = dyn_cast<CallInst>(&I)) {
+        HandleCall(gs, *callInst);
+    } else {
+        DispatchClients(gs, I);
+    }
+}
+
 void Nova::VisitSCC(GlobalStateRef gs, SCC &scc) {
     for (SCC::iterator BBI = scc.begin(),
                        BBIE = scc.end();
                        BBI != BBIE; ++BBI) {
         errs() << (*BBI)->getName() << " ";
         for (Instruction &I: *(*BBI)) {
-            if (auto *callInst = dyn_cast<CallInst>(&I)) {
-                HandleCall(gs, *callInst);
-            } else {
-                DispatchClients(gs, I);
-            }
+            VisitInstruction(gs, I);
         }
     }
     return;
@@ -1472,8 +1854,9 @@ void Nova::Traversal(GlobalStateRef gs, Function *f) {
     for (std::vector<SCCRef>::iterator it = sccVector.begin(), 
                                        ie = sccVector.end();
                                        it != ie; ++it) {
-        // Is loop ?
-        if ((*it)->size() > 1) {
+        // Is loop ? a single block loops if it branches to itself
+        BasicBlock *BB = (*it)->front();
+        if ((*it)->size() > 1 || is_contained(successors(BB), BB)) {
             HandleLoop(gs, *(*it));
         } else {
             //errs() << "SCC: ";
@@ -1482,1088 +1865,1855 @@ void Nova::Traversal(GlobalStateRef gs, Function *f) {
         }
     }
 
+    for (SCCRef scc : sccVector)
+        delete scc;
+
     return;
 }
 
-void Nova::PrintPointsToMap(GlobalStateRef gs) {
-    AliasMapRef aliasMap;
-    unsigned offset;
-    AliasObjectSet *aos;
+// Functions the annotated variables can flow to or from.
+// Forward: over def-use edges, into and out of memory (storing a tracked value
+// tracks the location, storing into a tracked location tracks the stored
+// value), through arguments and through return values.
+// Backward, from every tracked value: the operands it is computed from, the
+// values stored to the memory it is loaded from, the args bound to it as a
+// parameter and the values returned to it by a call.
+// Indirect calls reach every target of GetCallTargets. The other functions
+// never see a value derived from an annotated variable, their calls are
+// havocked instead of summarized, see HavocCall.
+void Nova::ComputeDemandedFunctions(Module &M) {
+    const DataLayout &DL = M.getDataLayout();
+    DenseMap<Function *, std::vector<Instruction *>> callers;
+    SmallVector<Function *, 4> targets;
+    SmallPtrSet<Value *, 32> tracked, sliced, slicedMem;
+    std::vector<Value *> worklist, slice, sliceMem;
+    GlobalVariable *ga;
+    ConstantArray *ca;
+    Function *f;
+    Value *v;
 
-    for (PointsToMap::iterator it = gs->pMap->begin(), ie = gs->pMap->end();
-                                                         it != ie; ++it) { 
-        if ((it)->second == NULL) {
-            errs() << "it->second is NULL!" << "\n";
-            continue;
+    auto Demand = [&](Value *dv) {
+        if (auto *A = dyn_cast<Argument>(dv))
+            demandedFuncs.insert(A->getParent());
+        else if (auto *I = dyn_cast<Instruction>(dv))
+            demandedFuncs.insert(I->getFunction());
+    };
+
+    auto Slice = [&](Value *sv) {
+        if (sv == NULL || isa<BasicBlock>(sv) || isa<MetadataAsValue>(sv))
+            return;
+        // constant GEPs and casts of globals
+        if (isa<ConstantExpr>(sv))
+            sv = GetUnderlyingObject(sv, DL);
+        if (isa<Constant>(sv) && !isa<GlobalVariable>(sv))
+            return;
+        if (sliced.insert(sv).second)
+            slice.push_back(sv);
+    };
+
+    // the values stored to the memory of an object
+    auto SliceMemory = [&](Value *mv) {
+        if (mv != NULL && !isa<ConstantData>(mv) && slicedMem.insert(mv).second)
+            sliceMem.push_back(mv);
+    };
+
+    auto Track = [&](Value *tv) {
+        if (tv != NULL && !isa<ConstantData>(tv) && tracked.insert(tv).second) {
+            worklist.push_back(tv);
+            Slice(tv);
         }
+    };
 
-        errs() << it->first->getName() << " : " << "\n";
-        for (TupleSet::iterator tsit = it->second->begin(), tsie = it->second->end();
-                                                    tsit != tsie; ++tsit) {
-            if ((*tsit)->ao == NULL) {
-                errs() << "tsit->ao is NULL!" << "\n";
+    // the call sites of each function, indirect ones included
+    for (Function &F : M) {
+        for (Instruction &I : instructions(F)) {
+            if (!isa<CallInst>(&I) && !isa<InvokeInst>(&I))
                 continue;
-            }
+            GetCallTargets(&I, targets);
+            for (Function *target : targets)
+                callers[target].push_back(&I);
+        }
+    }
 
-            errs() << "(" << (*tsit)->offset << ", " << (*tsit)->ao->val->getName() << ")" << "\n";
-            aliasMap = (*tsit)->ao->aliasMap;
-            offset = (*tsit)->offset;
-            if (aliasMap != NULL && aliasMap->find(offset) != aliasMap->end()) {
-                aos = (*aliasMap)[offset];
-                if (aos == NULL) {
-                    errs() << "aos is NULL!" << "\n";
+    // seeds: llvm.global.annotations, llvm.var.annotation and !oat.sensitive,
+    // as in GetAnnotatedVariables and HandleCall
+    ga = M.getNamedGlobal("llvm.global.annotations");
+    if (ga != NULL && (ca = dyn_cast<ConstantArray>(ga->getOperand(0)))) {
+        for (unsigned i = 0; i < ca->getNumOperands(); i++)
+            Track(ca->getOperand(i)->getOperand(0)->stripPointerCasts());
+    }
+
+    if ((f = M.getFunction("llvm.var.annotation")) != NULL) {
+        for (User *U : f->users()) {
+            if (auto *CI = dyn_cast<CallInst>(U))
+                Track(CI->getArgOperand(0)->stripPointerCasts());
+        }
+    }
+
+    for (Function &F : M) {
+        for (Instruction &I : instructions(F)) {
+            if (isa<AllocaInst>(&I) && I.getMetadata(oat::SensitiveMDName))
+                Track(&I);
+        }
+    }
+
+    while (!worklist.empty() || !slice.empty() || !sliceMem.empty()) {
+        if (!worklist.empty()) {
+            v = worklist.back();
+            worklist.pop_back();
+            Demand(v);
+
+            for (User *U : v->users()) {
+                // constant GEPs and casts of tracked globals
+                if (isa<ConstantExpr>(U)) {
+                    Track(U);
                     continue;
                 }
-                errs() << "alias object set: ";
-                for (AliasObjectSet::iterator aosit = aos->begin(), aosie = aos->end();
-                                                    aosit != aosie; ++aosit) {
-                    errs() << (*aosit)->val->getName() << ",";
+
+                auto *UI = dyn_cast<Instruction>(U);
+                if (UI == NULL)
+                    continue;
+                demandedFuncs.insert(UI->getFunction());
+
+                if (auto *SI = dyn_cast<StoreInst>(UI)) {
+                    if (SI->getValueOperand() == v)
+                        Track(GetUnderlyingObject(SI->getPointerOperand(), DL));
+                    else
+                        Track(SI->getValueOperand());
+                } else if (auto *RI = dyn_cast<ReturnInst>(UI)) {
+                    for (Instruction *call : callers.lookup(RI->getFunction()))
+                        Track(call);
+                } else if (auto *CI = dyn_cast<CallInst>(UI)) {
+                    GetCallTargets(CI, targets);
+                    for (Function *target : targets) {
+                        if (target->isDeclaration())
+                            continue;
+                        for (unsigned i = 0; i < CI->getNumArgOperands() && i < target->arg_size(); i++) {
+                            if (CI->getArgOperand(i) == v)
+                                Track(&*std::next(target->arg_begin(), i));
+                        }
+                    }
+                    Track(CI);
+                } else {
+                    Track(UI);
                 }
-                errs() << "\n";
-            } else {
-                errs() << "location object ?" << "\n";
             }
+            continue;
+        }
 
-            if ((*tsit)->ao->type != NULL && (*tsit)->ao->type->isStructTy()) {
-                // print struct field aliasMap
-                errs() << "struct internal alias map: \n";
-                for (AliasMap::iterator ait = aliasMap->begin(), aie = aliasMap->end();
-                                                ait != aie; ++ait) {
-                    offset = ait->first;
-                    aos = ait->second;
-                    if (aos == NULL) {
-                        errs() << "aos is NULL!" << "\n";
-                        continue;
+        if (!slice.empty()) {
+            v = slice.back();
+            slice.pop_back();
+            Demand(v);
+
+            if (auto *A = dyn_cast<Argument>(v)) {
+                for (Instruction *call : callers.lookup(A->getParent())) {
+                    CallSite cs(call);
+                    if (A->getArgNo() < cs.arg_size())
+                        Slice(cs.getArgument(A->getArgNo()));
+                }
+            } else if (isa<GlobalVariable>(v) || isa<AllocaInst>(v)) {
+                SliceMemory(v);
+            } else if (auto *I = dyn_cast<Instruction>(v)) {
+                if (auto *LI = dyn_cast<LoadInst>(I))
+                    SliceMemory(GetUnderlyingObject(LI->getPointerOperand(), DL));
+
+                if (isa<CallInst>(I) || isa<InvokeInst>(I)) {
+                    CallSite cs(I);
+                    for (Value *arg : cs.args())
+                        Slice(arg);
+
+                    GetCallTargets(I, targets);
+                    for (Function *target : targets) {
+                        for (Instruction &TI : instructions(target)) {
+                            if (auto *RI = dyn_cast<ReturnInst>(&TI))
+                                Slice(RI->getReturnValue());
+                        }
                     }
-                    errs() << "alias object set at offset " << offset << " : ";
-                    for (AliasObjectSet::iterator aosit = aos->begin(), aosie = aos->end();
-                                                        aosit != aosie; ++aosit) {
-                        errs() << (*aosit)->val->getName() << ",";
+                } else {
+                    for (Value *op : I->operands())
+                        Slice(op);
+                }
+            }
+            continue;
+        }
+
+        // stores through the object and everything derived from it, including
+        // the stores of the callees it is passed to
+        SmallVector<Value *, 8> ptrs;
+        SmallPtrSet<Value *, 8> visited;
+
+        v = sliceMem.back();
+        sliceMem.pop_back();
+        ptrs.push_back(v);
+        visited.insert(v);
+        while (!ptrs.empty()) {
+            Value *p = ptrs.pop_back_val();
+
+            for (User *U : p->users()) {
+                if (isa<GEPOperator>(U) || isa<BitCastOperator>(U) ||
+                    isa<PHINode>(U) || isa<SelectInst>(U)) {
+                    if (visited.insert(U).second)
+                        ptrs.push_back(U);
+                } else if (auto *SI = dyn_cast<StoreInst>(U)) {
+                    if (SI->getPointerOperand() == p) {
+                        Demand(SI);
+                        Slice(SI->getValueOperand());
+                    }
+                } else if (auto *CI = dyn_cast<CallInst>(U)) {
+                    Demand(CI);
+                    GetCallTargets(CI, targets);
+                    for (Function *target : targets) {
+                        for (unsigned i = 0; i < CI->getNumArgOperands(); i++) {
+                            Value *arg = CI->getArgOperand(i);
+
+                            if (!target->isDeclaration()) {
+                                if (arg == p && i < target->arg_size())
+                                    SliceMemory(&*std::next(target->arg_begin(), i));
+                            } else if (arg != p) {
+                                // e.g. memcpy, the other args are copied in
+                                Slice(arg);
+                                if (arg->getType()->isPointerTy())
+                                    SliceMemory(GetUnderlyingObject(arg, DL));
+                            }
+                        }
                     }
-                    errs() << "\n";
                 }
             }
         }
-        errs() << "\n";
     }
-}
 
-void Nova::PrintTaintMap(GlobalStateRef gs) {
-    LocalTaintMapRef taintMap;
-    AliasObjectRef ao;
-    unsigned offset;
-    InstSet *is;
+    errs() << "demanded functions: " << demandedFuncs.size() << "\n";
 
-    for (TaintMap::iterator it = gs->tMap->begin(), ie = gs->tMap->end();
-                                                        it != ie; ++it) { 
-        errs() << it->first->getName() << " : " << "\n";
-        for (InstSet::iterator isit = it->second->begin(), isie = it->second->end();
-                                                    isit != isie; ++isit) {
-            if ((*isit) != NULL)
-                errs() << *(*isit) << "\n";
-            else {
-                errs() << "(*isit) == NULL!\n";
-                continue;
+    return;
+}
+
+void Nova::CollectAddressTaken(Module &M) {
+    for (Function &F : M) {
+        if (F.isDeclaration() || !F.hasAddressTaken())
+            continue;
+        addrTakenFuncs[F.getFunctionType()].push_back(&F);
+        allAddrTakenFuncs.push_back(&F);
+    }
+}
+
+// The functions a call may run. Nova has no points-to sets of function
+// pointers, an indirect call may run any address-taken function of its type,
+// or any address-taken function at all if none has its type, as the pointer
+// may have been cast.
+void Nova::GetCallTargets(Instruction *call, SmallVectorImpl<Function *> &targets) {
+    CallSite cs(call);
+    Function *callee;
+
+    targets.clear();
+    if (!cs || cs.isInlineAsm())
+        return;
+
+    callee = dyn_cast<Function>(cs.getCalledValue()->stripPointerCasts());
+    if (callee != NULL) {
+        targets.push_back(callee);
+        return;
+    }
+
+    auto it = addrTakenFuncs.find(cs.getFunctionType());
+    if (it != addrTakenFuncs.end())
+        targets.append(it->second.begin(), it->second.end());
+    else
+        targets.append(allAddrTakenFuncs.begin(), allAddrTakenFuncs.end());
+}
+
+// globals f and everything it may call refer to
+std::vector<GlobalVariable *> &Nova::GetUsedGlobals(Function *f) {
+    SmallPtrSet<Function *, 16> visited;
+    SmallVector<Function *, 16> worklist;
+    SmallPtrSet<Constant *, 32> seen;
+    SmallVector<Constant *, 32> consts;
+    SmallVector<Function *, 4> targets;
+
+    auto it = usedGlobals.find(f);
+    if (it != usedGlobals.end())
+        return it->second;
+
+    std::vector<GlobalVariable *> &globals = usedGlobals[f];
+
+    worklist.push_back(f);
+    visited.insert(f);
+    while (!worklist.empty()) {
+        Function *cur = worklist.pop_back_val();
+
+        for (Instruction &I : instructions(cur)) {
+            for (Value *op : I.operands()) {
+                if (auto *c = dyn_cast<Constant>(op))
+                    consts.push_back(c);
             }
-        }
 
-        if (gs->pMap->find(it->first) != gs->pMap->end()) {
-            if (((*(gs->pMap))[it->first]) == NULL || ((*(gs->pMap))[it->first])->empty()) {
-                errs() << "pMap[it->first] == empty !\n";
-                ao = NULL;
-            } else {
-                ao = (*(*(gs->pMap))[it->first])[0]->ao;
+            GetCallTargets(&I, targets);
+            for (Function *target : targets) {
+                if (!target->isDeclaration() && visited.insert(target).second)
+                    worklist.push_back(target);
             }
-        } else {
-            ao = NULL;
         }
+    }
 
-        if (ao!= NULL) {
-            taintMap = ao->taintMap;
-        } else {
-            taintMap = NULL;
+    // through constant expressions and initializers
+    while (!consts.empty()) {
+        Constant *c = consts.pop_back_val();
+        if (!seen.insert(c).second)
+            continue;
+
+        if (auto *gv = dyn_cast<GlobalVariable>(c)) {
+            globals.push_back(gv);
+            if (gv->hasInitializer())
+                consts.push_back(gv->getInitializer());
+        } else if (isa<ConstantExpr>(c) || isa<ConstantAggregate>(c)) {
+            for (Value *op : c->operands())
+                consts.push_back(cast<Constant>(op));
         }
+    }
 
-        offset = 0;
-        if (taintMap != NULL && taintMap->find(offset) != taintMap->end()) {
-            is = (*taintMap)[offset];
-            errs() << "alias object local taint trace: \n";
-            for (InstSet::iterator iit = is->begin(), iie = is->end();
-                                                iit != iie; ++iit) {
-                errs() << *(*iit) << "\n";
-            }
-            errs() << "\n";
-        } else {
-            errs() << "location object ?" << "\n";
+    return globals;
+}
+
+// f was not summarized, it never sees a value derived from an annotated
+// variable. Assume it stores every object it can reach from its pointer args
+// and the globals it uses to every pointer it can reach, taints all of them
+// with its args, and returns any of them.
+void Nova::HavocCall(GlobalStateRef gs, Function *f, CallInst &I) {
+    SmallPtrSet<AliasObjectRef, 32> visited;
+    SmallVector<AliasObjectRef, 32> worklist;
+    AliasObjectSet reach;
+    AliasObjectSet *aos;
+    InstSet *is, taint;
+    TupleSet mts;
+    Value *arg;
+    size_t size;
+
+    auto AddObjects = [&](Value *pv) {
+        if (gs->pMap->find(pv) == gs->pMap->end() || (*(gs->pMap))[pv] == NULL)
+            return;
+        for (AliasObjectTupleRef aot : *(*(gs->pMap))[pv])
+            worklist.push_back(aot->ao);
+    };
+
+    taint.set(GetInstID(&I));
+    for (unsigned i = 0; i < I.getNumArgOperands(); i++) {
+        arg = I.getArgOperand(i);
+        if (gs->tMap->find(arg) != gs->tMap->end() && (*(gs->tMap))[arg] != NULL)
+            taint |= *(*(gs->tMap))[arg];
+        AddObjects(arg);
+    }
+    for (GlobalVariable *gv : GetUsedGlobals(f))
+        AddObjects(gv);
+
+    while (!worklist.empty()) {
+        AliasObjectRef ao = worklist.pop_back_val();
+        if (ao->isLocation || !visited.insert(ao).second)
+            continue;
+
+        reach.insert(ao);
+        if (ao->taintMap != NULL) {
+            for (LocalTaintMap::iterator it = ao->taintMap->begin(), ie = ao->taintMap->end();
+                                                                    it != ie; ++it)
+                taint |= *it->second;
         }
+        if (ao->aliasMap != NULL) {
+            for (AliasMap::iterator it = ao->aliasMap->begin(), ie = ao->aliasMap->end();
+                                                                it != ie; ++it)
+                worklist.append(it->second->begin(), it->second->end());
+        }
+    }
 
-        errs() << "\n";
+    for (AliasObjectRef ao : reach) {
+        if (ao->type != NULL && ao->type->isPointerTy() && ao->aliasMap != NULL) {
+            if (ao->aliasMap->find(0) == ao->aliasMap->end())
+                (*(ao->aliasMap))[0] = NewAliasObjectSet();
+            aos = (*(ao->aliasMap))[0];
+            size = aos->size();
+            aos->insert(reach.begin(), reach.end());
+            gs->memChanges += aos->size() - size;
+            ao->changes += aos->size() - size;
+        }
 
-        if (ao != NULL && taintMap != NULL && ao->type != NULL && ao->type->isStructTy()) {
-            // print struct field taintMap
-            errs() << "struct internal alias map: \n";
-            for (LocalTaintMap::iterator tit = taintMap->begin(), tie = taintMap->end();
-                                            tit != tie; ++tit) {
-                offset = tit->first;
-                is = tit->second;
-                errs() << "locat taint map at offset " << offset << " : " << "\n";
-                for (InstSet::iterator iit = is->begin(), iie = is->end();
-                                                    iit != iie; ++iit) {
-                    errs() << *(*iit) << "\n";
+        if (ao->taintMap != NULL) {
+            if (ao->taintMap->find(0) == ao->taintMap->end())
+                (*(ao->taintMap))[0] = NewInstSet();
+            for (LocalTaintMap::iterator it = ao->taintMap->begin(), ie = ao->taintMap->end();
+                                                                    it != ie; ++it) {
+                if (*it->second |= taint) {
+                    gs->memChanges++;
+                    ao->changes++;
                 }
-                errs() << "\n";
             }
         }
+
+        // read and written, noted after the write not to go stale at once
+        NoteGlobalAccess(gs, ao, 0, true);
+        NoteGlobalAccess(gs, ao, 0, false);
     }
-}
 
-// for pointer type, we get boundary info when it's initialized
-// it could be initialized by malloc, getAddrOf array type, or others.
-// step : find its definition
-// step : instrument its definition to collect boundary info
-// step : check pointer-based read&write
-void Nova::PointerAccessCheck(Module &M, Value *v) {
-}
+    if (I.getType()->isPointerTy()) {
+        if (gs->pMap->find(&I) != gs->pMap->end() && (*(gs->pMap))[&I] != NULL)
+            mts.insert((*(gs->pMap))[&I]->begin(), (*(gs->pMap))[&I]->end());
+        for (AliasObjectRef ao : reach)
+            mts.insert(GetAliasObjectTuple(ao, 0));
+        if (!mts.empty())
+            (*(gs->pMap))[&I] = InternTupleSet(mts);
+    }
 
-BasicBlock::iterator Nova::GetInstIterator(Value *v) {
-    Instruction *inst;
-    BasicBlock *bb;
+    is = NewInstSet();
+    if (gs->tMap->find(&I) != gs->tMap->end() && (*(gs->tMap))[&I] != NULL)
+        *is |= *(*(gs->tMap))[&I];
+    *is |= taint;
+    (*(gs->tMap))[&I] = is;
 
-    inst = dyn_cast<Instruction>(v);
-    assert(inst && "v should be a instruction!");
-    bb = inst->getParent();
+    return;
+}
 
-    for (BasicBlock::iterator i = bb->begin(), ie = bb->end(); i != ie; ++i) {
-        if (&(*i) == inst)
-            return i;
-    }
+// Summary mode: every function is analyzed callees before callers, with a
+// placeholder object for what each pointer parameter points to. A call
+// applies the callee's effect on the placeholders to the objects the args
+// point to, instead of traversing the callee again for this call path.
+// Summaries are computed again until none is stale: recursive functions see
+// each other's partial summaries, and a caller may store to a global that a
+// callee computed before it reads.
+void Nova::ComputeSummaries(GlobalStateRef gs, Module &M) {
+    CallGraph CG(M);
+    bool stale, changed;
+
+    do {
+        stale = false;
+        for (scc_iterator<CallGraph *> I = scc_begin(&CG), IE = scc_end(&CG);
+                                       I != IE; ++I) {
+            const std::vector<CallGraphNode *> &SCCNodes = *I;
+
+            do {
+                changed = false;
+                for (CallGraphNode *node : SCCNodes) {
+                    Function *f = node->getFunction();
+                    FunctionSummary *summary;
+
+                    if (f == NULL || f->isDeclaration())
+                        continue;
+                    if (DemandDriven && !demandedFuncs.count(f))
+                        continue;
 
-    assert( 0 && "Can't find inst in its parent basicblock!");
-    return bb->end();
-}
+                    summary = summaries.lookup(f);
+                    if (summary != NULL && !IsSummaryStale(summary))
+                        continue;
 
-//
-// Method: getSizeOfType 
-// 
-// Description: This function returns the size of the memory access
-// based on the type of the pointer which is being dereferenced.  This
-// function is used to pass the size of the access in many checks to
-// perform byte granularity checking.
-//
-// Comments: May we should use TargetData instead of m_is_64_bit
-// according Criswell's comments.
- 
+                    ComputeSummary(gs, f);
+                    changed = stale = true;
+                }
+            } while (changed);
+        }
+    } while (stale);
 
-Value* Nova::GetSizeOfType(Type* input_type) {
+    return;
+}
 
-  // Create a Constant Pointer Null of the input type.  Then get a
-  // getElementPtr of it with next element access cast it to unsigned
-  // int
-   
-  const PointerType* ptr_type = dyn_cast<PointerType>(input_type);
+// Grows with everything a call takes from the summary: the returned objects
+// and taint, the stores through the param placeholders and to globals.
+uint64_t Nova::GetSummaryVersion(FunctionSummary *summary) {
+    SmallPtrSet<AliasObjectRef, 16> visited;
+    SmallVector<AliasObjectRef, 16> worklist;
+    AliasObjectRef ao;
+    uint64_t version;
 
-  if (isa<FunctionType>(ptr_type->getElementType())) {
-      return ConstantInt::get(Type::getInt64Ty(ptr_type->getContext()), 0);
-  }
+    version = summary->retTaint->count() + summary->globalDefs.size();
+    if (summary->ret != NULL)
+        version += summary->ret->size();
+    for (auto &gd : summary->globalDefs)
+        version += gd.first->changes;
 
-  const SequentialType* seq_type = dyn_cast<SequentialType>(input_type);
-  Constant* int64_size = NULL;
-  if (!seq_type) {
-    if(input_type->isSized()){
-      return ConstantInt::get(Type::getInt64Ty(input_type->getContext()), 0);
+    for (AliasObjectRef param : summary->params) {
+        if (param != NULL)
+            worklist.push_back(param);
     }
-  }
-  assert(seq_type && "pointer dereference and it is not a sequential type\n");
-  
-  StructType* struct_type = dyn_cast<StructType>(input_type);
+    while (!worklist.empty()) {
+        ao = worklist.pop_back_val();
+        if (!visited.insert(ao).second)
+            continue;
 
-  if(struct_type){
-    if(struct_type->isOpaque()){
-        return ConstantInt::get(Type::getInt64Ty(seq_type->getContext()), 0);        
+        version += ao->changes;
+        if (ao->aliasMap == NULL)
+            continue;
+        for (AliasMap::iterator it = ao->aliasMap->begin(), ie = ao->aliasMap->end();
+                                                            it != ie; ++it) {
+            for (AliasObjectRef nao : *(it->second)) {
+                if (nao->isParam)
+                    worklist.push_back(nao);
+            }
+        }
     }
-  }
-  
-  if(!seq_type->getElementType()->isSized()){
-    return ConstantInt::get(Type::getInt64Ty(seq_type->getContext()), 0);
-  }
-  int64_size = ConstantExpr::getSizeOf(seq_type->getElementType());
-  return int64_size;
-}
-
-// 
-// Method: castToVoidPtr()
-// **Borrowed from SoftBoundsCETS
-//
-// Description: 
-// 
-// This function introduces a bitcast instruction in the IR when an
-// input operand that is a pointer type is not of type i8*. This is
-// required as all the SoftBound/CETS handlers take i8*s
-//
 
-Value* Nova::CastToVoidPtr(Value* operand, Instruction* insert_at) {
-
-  Value* cast_bitcast = operand;
-  if (operand->getType() != m_void_ptr_type) {
-    cast_bitcast = new BitCastInst(operand, m_void_ptr_type,
-                                   "bitcast",
-                                   insert_at);
-  }
-  return cast_bitcast;
+    return version;
 }
 
-//
-// Method: dissociateBaseBound
-// **Borrowed from SoftboundCETS
-//
-// Description: This function removes the base/bound metadata
-// associated with the pointer operand in the SoftBound/CETS maps.
+// A global the function read or a callee summary it applied changed since.
+bool Nova::IsSummaryStale(FunctionSummary *summary) {
+    FunctionSummary *callee;
 
-void Nova::DissociateBaseBound(Value* pointer_operand){
+    for (auto &gu : summary->globalUses) {
+        if (gu.first->changes != gu.second)
+            return true;
+    }
 
-  if(m_pointer_base.count(pointer_operand)){
-    m_pointer_base.erase(pointer_operand);
-  }
-  if(m_pointer_bound.count(pointer_operand)){
-    m_pointer_bound.erase(pointer_operand);
-  }
-  assert((m_pointer_base.count(pointer_operand) == 0) && 
-         "dissociating base failed\n");
-  assert((m_pointer_bound.count(pointer_operand) == 0) && 
-         "dissociating bound failed");
-}
+    for (auto &c : summary->callees) {
+        callee = summaries.lookup(c.first);
+        if (callee != NULL && GetSummaryVersion(callee) != c.second)
+            return true;
+    }
 
-//
-// Method: associateBaseBound
-// **Borrowed from SoftboundCETS
-//
-// Description: This function associates the base bound with the
-// pointer operand in the SoftBound/CETS maps.
+    return false;
+}
 
+// computing a summary, remember what it reads from and stores to globals
+void Nova::NoteGlobalAccess(GlobalStateRef gs, AliasObjectRef ao, int offset, bool isDef) {
+    if (gs->summary == NULL || ao->isParam || !isa<GlobalVariable>(ao->val))
+        return;
 
-void Nova::AssociateBaseBound(Value* pointer_operand, 
-                              Value* pointer_base, 
-                              Value* pointer_bound){
+    if (isDef)
+        gs->summary->globalDefs.insert(std::make_pair(ao, offset));
+    else
+        gs->summary->globalUses[ao] = ao->changes;
+}
 
-  if(m_pointer_base.count(pointer_operand)){
-    DissociateBaseBound(pointer_operand);
-  }
+void Nova::ComputeSummary(GlobalStateRef gs, Function *f) {
+    FunctionSummary *summary = summaries.lookup(f);
+    AliasObjectRef param;
+    TupleSet ts;
 
-  if(pointer_base->getType() != m_void_ptr_type){
-    assert(0 && "base does not have a void pointer type ");
-  }
-  m_pointer_base[pointer_operand] = pointer_base;
+    if (summary == NULL) {
+        summary = new (Arena.summaries.Allocate()) FunctionSummary();
+        summary->ret = NULL;
+        summary->retTaint = NewInstSet();
 
-  if(m_pointer_bound.count(pointer_operand)){
-    assert(0 && "bound map already has an entry in the map");
-  }
-  if(pointer_bound->getType() != m_void_ptr_type) {
-    assert(0 && "bound does not have a void pointer type ");
-  }
-  m_pointer_bound[pointer_operand] = pointer_bound;
-}
+        for (Argument &A : f->args()) {
+            param = NULL;
 
-//
-// Methods: getAssociatedBase, getAssociatedBound, getAssociatedKey,
-// getAssociatedLock
-//
-// Description: Retrieves the metadata from SoftBound/CETS maps 
-//
+            if (A.getType()->isPointerTy()) {
+                param = CreateAliasObject(A.getType()->getPointerElementType(), &A);
+                MarkParamObject(param);
+                Arena.roots[&A] = param;
 
-Value* Nova::GetAssociatedBase(Value* pointer_operand) {
-    
+                ts.clear();
+                ts.insert(GetAliasObjectTuple(param, 0));
+                (*(gs->pMap))[&A] = InternTupleSet(ts);
+            }
 
-  if(isa<Constant>(pointer_operand)){
-    Value* base = NULL;
-    Value* bound = NULL;
-    Constant* ptr_constant = dyn_cast<Constant>(pointer_operand);
-    GetConstantExprBaseBound(ptr_constant, base, bound);
+            (*(gs->tMap))[&A] = NewInstSet();
+            summary->params.push_back(param);
+        }
 
-    if(base->getType() != m_void_ptr_type){
-      Constant* base_given_const = dyn_cast<Constant>(base);
-      assert(base_given_const!=NULL);
-      Constant* base_const = ConstantExpr::getBitCast(base_given_const, m_void_ptr_type);
-      return base_const;
+        summaries[f] = summary;
     }
-    return base;
-  }
 
-  if(!m_pointer_base.count(pointer_operand)){
-    pointer_operand->dump();
-  }
-  assert(m_pointer_base.count(pointer_operand) && 
-         "Base absent. Try compiling with -simplifycfg option?");
-    
-  Value* pointer_base = m_pointer_base[pointer_operand];
-  assert(pointer_base && "base present in the map but null?");
+    // the cached entry no longer matches
+    cachedSummaries.erase(f);
 
-  if(pointer_base->getType() != m_void_ptr_type)
-    assert(0 && "base in the map does not have the right type");
+    gs->summary = summary;
+    Traversal(gs, f);
+    gs->summary = NULL;
 
-  return pointer_base;
+    return;
 }
 
-Value* Nova::GetAssociatedBound(Value* pointer_operand) {
+void Nova::MarkParamObject(AliasObjectRef ao) {
+    ao->isParam = true;
 
-  if(isa<Constant>(pointer_operand)){
-    Value* base = NULL;
-    Value* bound = NULL;
-    Constant* ptr_constant = dyn_cast<Constant>(pointer_operand);
-    GetConstantExprBaseBound(ptr_constant, base, bound);
+    if (ao->aliasMap == NULL)
+        return;
 
-    if(bound->getType() != m_void_ptr_type){
-      Constant* bound_given_const = dyn_cast<Constant>(bound);
-      assert(bound_given_const != NULL);
-      Constant* bound_const = ConstantExpr::getBitCast(bound_given_const, m_void_ptr_type);
-      return bound_const;
+    for (AliasMap::iterator it = ao->aliasMap->begin(), ie = ao->aliasMap->end();
+                                                        it != ie; ++it) {
+        for (AliasObjectRef nao : *(it->second))
+            MarkParamObject(nao);
     }
 
-    return bound;
-  }
+    return;
+}
 
-    
-  assert(m_pointer_bound.count(pointer_operand) && 
-         "Bound absent.");
-  Value* pointer_bound = m_pointer_bound[pointer_operand];
-  assert(pointer_bound && 
-         "bound present in the map but null?");    
+// bind param and the placeholders nested in it to actual and its fields
+void Nova::BindParamObject(AliasObjectRef param, AliasObjectRef actual,
+                           DenseMap<AliasObjectRef, AliasObjectSet> &subst) {
+    AliasMapRef aliasMap;
 
-  if(pointer_bound->getType() != m_void_ptr_type)
-    assert(0 && "bound in the map does not have the right type");
+    if (!subst[param].insert(actual))
+        return;
 
-  return pointer_bound;
-}
+    aliasMap = actual->aliasMap;
+    if (param->aliasMap == NULL || aliasMap == NULL)
+        return;
 
-Instruction* Nova:: GetGlobalInitInstruction(Module& module){
-  Function* global_init_function = module.getFunction("__softboundcets_global_init");    
-  assert(global_init_function && "no __softboundcets_global_init function??");    
-  Instruction *global_init_terminator = NULL;
-  bool return_inst_flag = false;
-  for(Function::iterator fi = global_init_function->begin(), fe = global_init_function->end(); fi != fe; ++fi) {
-      
-    BasicBlock* bb = dyn_cast<BasicBlock>(fi);
-    assert(bb && "basic block null");
-    Instruction* bb_term = dyn_cast<Instruction>(bb->getTerminator());
-    assert(bb_term && "terminator null?");
-      
-    if(isa<ReturnInst>(bb_term)) {
-      assert((return_inst_flag == false) && "has multiple returns?");
-      return_inst_flag = true;
-      global_init_terminator = dyn_cast<ReturnInst>(bb_term);
-      assert(global_init_terminator && "return inst null?");
-    }
-  }
-  assert(global_init_terminator && "global init does not have return, strange");
-  return global_init_terminator;
-}
+    for (AliasMap::iterator it = param->aliasMap->begin(), ie = param->aliasMap->end();
+                                                           it != ie; ++it) {
+        if (aliasMap->find(it->first) == aliasMap->end())
+            continue;
 
-// Method: handleGlobalStructTypeInitializer()
-//
-// Description: handles the global
-// initialization for global variables which are of struct type and
-// have a pointer as one of their fields and is globally
-// initialized 
-//
-// Comments: This function requires review and rewrite
+        for (AliasObjectRef nparam : *(it->second)) {
+            if (!nparam->isParam)
+                continue;
+            for (AliasObjectRef nactual : *((*aliasMap)[it->first]))
+                BindParamObject(nparam, nactual, subst);
+        }
+    }
 
-void Nova::HandleGlobalStructTypeInitializer(Module& module, 
-                                  StructType* init_struct_type,
-                                  Constant* initializer, 
-                                  GlobalVariable* gv, 
-                                  std::vector<Constant*> indices_addr_ptr, 
-                                  int length) {
-  
-  // TODOO:URGENT: Do I handle nesxted structures
-  //errs() << __func__ <<"\n";
-  
-  // has zero initializer 
-  if(initializer->isNullValue())
     return;
-    
-  Instruction* first = GetGlobalInitInstruction(module);
-  unsigned num_elements = init_struct_type->getNumElements();
-  Constant* constant = dyn_cast<Constant>(initializer);
-  assert(constant && 
-         "[handleGlobalStructTypeInit] global stype with init but not CA?");
+}
 
-  for(unsigned i = 0; i < num_elements ; i++) {
-    
-    CompositeType* struct_comp_type = 
-      dyn_cast<CompositeType>(init_struct_type);
-    assert(struct_comp_type && "not a struct type?");
-    
-    Type* element_type = struct_comp_type->getTypeAtIndex(i);      
-    if(isa<PointerType>(element_type)){        
-      Value* initializer_opd = constant->getOperand(i);
-      Value* operand_base = NULL;
-      Value* operand_bound = NULL;
-      
-      Constant* addr_of_ptr = NULL;
-      
-      Constant* given_constant = dyn_cast<Constant>(initializer_opd);
-      assert(given_constant && 
-             "[handleGlobalStructTypeInitializer] not a constant?");
-      
-      GetConstantExprBaseBound(given_constant, operand_base, operand_bound);   
-      
-      // Creating the address of ptr
-        //      Constant* index1 = 
-        //                ConstantInt::get(Type::getInt32Ty(module.getContext()), 0);
-      Constant* index2 = ConstantInt::get(Type::getInt32Ty(module.getContext()), i);
-      
-      //      indices_addr_ptr.push_back(index1);
-      indices_addr_ptr.push_back(index2);
-      length++;
+void Nova::ApplySummary(GlobalStateRef gs, Function *f, CallInst &I) {
+    FunctionSummary *summary;
+    DenseMap<AliasObjectRef, AliasObjectSet> subst;
+    AliasObjectRef param;
+    AliasObjectSet *aos, *bound;
+    LocalTaintMapRef taintMap;
+    InstSet *is, argTaint;
+    TupleSet *ts, mts;
+    Value *arg;
+    unsigned i, e;
+    size_t size;
+
+    // declarations, and callees in the same recursive SCC on the first run
+    summary = summaries.lookup(f);
+    if (summary == NULL) {
+        if (DemandDriven && !f->isDeclaration() && !demandedFuncs.count(f)) {
+            HavocCall(gs, f, I);
+            return;
+        }
+        if (!f->isDeclaration())
+            gs->summary->callees[f] = ~0ULL;
+        return;
+    }
 
-      addr_of_ptr = ConstantExpr::getGetElementPtr(nullptr, gv, indices_addr_ptr);
-      
-      Type* initializer_type = initializer_opd->getType();
-      Value* initializer_size = GetSizeOfType(initializer_type);     
-      AddStoreBaseBoundFunc(addr_of_ptr, operand_base, 
-                            operand_bound,initializer_opd, 
-                            initializer_size, first);
-      
-      indices_addr_ptr.pop_back();
-      length--;
+    // bind the param placeholders to what the args point to
+    // TODOO we lose the arg's offset info here, as for GEPs
+    e = std::min<unsigned>(I.getNumArgOperands(), summary->params.size());
+    for (i = 0; i < e; i++) {
+        param = summary->params[i];
+        arg = I.getArgOperand(i);
+        if (param == NULL || gs->pMap->find(arg) == gs->pMap->end())
+            continue;
 
-      continue;
-    }     
-    if(isa<StructType>(element_type)){
-      StructType* child_element_type = 
-        dyn_cast<StructType>(element_type);
-      Constant* struct_initializer = 
-        dyn_cast<Constant>(constant->getOperand(i));      
-      Constant* index2 =
-        ConstantInt::get(Type::getInt32Ty(module.getContext()), i);
-      indices_addr_ptr.push_back(index2);
-      length++;
-      HandleGlobalStructTypeInitializer(module, child_element_type, 
-                                        struct_initializer, gv, 
-                                        indices_addr_ptr, length); 
-      indices_addr_ptr.pop_back();
-      length--;
-      continue;
+        ts = (*(gs->pMap))[arg];
+        if (ts == NULL)
+            continue;
+
+        for (AliasObjectTupleRef aot : *ts)
+            BindParamObject(param, aot->ao, subst);
     }
-  }
-}
 
-//
-// Method: getConstantExprBaseBound
-//
-// Description: This function uniform handles all global constant
-// expression and obtains the base and bound for these expressions
-// without introducing any extra IR modifications.
+    auto Substitute = [&](AliasObjectRef ao, AliasObjectSet &out) {
+        if (!ao->isParam)
+            out.insert(ao);
+        else if (subst.find(ao) != subst.end())
+            out.insert(subst[ao].begin(), subst[ao].end());
+    };
 
-void Nova::GetConstantExprBaseBound(Constant* given_constant, 
-                                             Value* & tmp_base,
-                                             Value* & tmp_bound){
+    // replay the callee's stores through its params on the bound objects
+    for (auto &it : subst) {
+        param = it.first;
 
+        for (AliasObjectRef actual : it.second) {
+            // recursion passing the param on, nothing new
+            if (actual == param)
+                continue;
 
-  if(isa<ConstantPointerNull>(given_constant)){
-    tmp_base = m_void_null_ptr;
-    tmp_bound = m_void_null_ptr;
-    return;
-  }
-  
-  ConstantExpr* cexpr = dyn_cast<ConstantExpr>(given_constant);
-  tmp_base = NULL;
-  tmp_bound = NULL;
-    
+            if (param->aliasMap != NULL && actual->aliasMap != NULL) {
+                for (AliasMap::iterator amit = param->aliasMap->begin(),
+                                        amie = param->aliasMap->end();
+                                        amit != amie; ++amit) {
+                    if (actual->aliasMap->find(amit->first) == actual->aliasMap->end())
+                        continue;
 
-  if(cexpr) {
+                    aos = (*(actual->aliasMap))[amit->first];
+                    size = aos->size();
+                    for (AliasObjectRef ao : *(amit->second))
+                        Substitute(ao, *aos);
+                    gs->memChanges += aos->size() - size;
+                    actual->changes += aos->size() - size;
+                }
+            }
 
-    assert(cexpr && "ConstantExpr and Value* is null??");
-    switch(cexpr->getOpcode()) {
-        
-    case Instruction::GetElementPtr:
-      {
-        Constant* internal_constant = dyn_cast<Constant>(cexpr->getOperand(0));
-        GetConstantExprBaseBound(internal_constant, tmp_base, tmp_bound);
-        break;
-      }
-      
-    case BitCastInst::BitCast:
-      {
-        Constant* internal_constant = dyn_cast<Constant>(cexpr->getOperand(0));
-        GetConstantExprBaseBound(internal_constant, tmp_base, tmp_bound);
-        break;
-      }
-    case Instruction::IntToPtr:
-      {
-        tmp_base = m_void_null_ptr;
-        tmp_bound = m_void_null_ptr;
-        return;
-        break;
-      }
-    default:
-      {
-        break;
-      }
-    } // Switch ends
-    
-  } else {
-      
-    const PointerType* func_ptr_type = 
-      dyn_cast<PointerType>(given_constant->getType());
-      
-    if(isa<FunctionType>(func_ptr_type->getElementType())) {
-      tmp_base = m_void_null_ptr;
-      tmp_bound = m_infinite_bound_ptr;
-      return;
+            taintMap = actual->taintMap;
+            if (param->taintMap == NULL || taintMap == NULL)
+                continue;
+
+            for (LocalTaintMap::iterator tmit = param->taintMap->begin(),
+                                         tmie = param->taintMap->end();
+                                         tmit != tmie; ++tmit) {
+                if (taintMap->find(tmit->first) == taintMap->end())
+                    (*taintMap)[tmit->first] = NewInstSet();
+                if (*(*taintMap)[tmit->first] |= *tmit->second) {
+                    gs->memChanges++;
+                    actual->changes++;
+                }
+            }
+        }
     }
-    // Create getElementPtrs to create the base and bound 
 
-    std::vector<Constant*> indices_base;
-    std::vector<Constant*> indices_bound;
-      
-    GlobalVariable* gv = dyn_cast<GlobalVariable>(given_constant);
+    // the callee's placeholders stored to globals stand for the args, and
+    // the stored values depend on all args, as the result does below
+    for (i = 0; i < I.getNumArgOperands(); i++) {
+        arg = I.getArgOperand(i);
+        if (gs->tMap->find(arg) != gs->tMap->end() && (*(gs->tMap))[arg] != NULL)
+            argTaint |= *(*(gs->tMap))[arg];
+    }
+    // by index, a recursive call adds to the summary it applies
+    for (i = 0; i < summary->globalDefs.size(); i++) {
+        std::pair<AliasObjectRef, int> gd = summary->globalDefs[i];
+        AliasObjectRef global = gd.first;
+
+        if (global->aliasMap != NULL &&
+                global->aliasMap->find(gd.second) != global->aliasMap->end()) {
+            AliasObjectSet objs;
+            aos = (*(global->aliasMap))[gd.second];
+            for (AliasObjectRef ao : *aos) {
+                if (ao->isParam)
+                    Substitute(ao, objs);
+            }
+            size = aos->size();
+            aos->insert(objs.begin(), objs.end());
+            gs->memChanges += aos->size() - size;
+            global->changes += aos->size() - size;
+        }
+
+        if (global->taintMap != NULL) {
+            if (global->taintMap->find(gd.second) == global->taintMap->end())
+                (*(global->taintMap))[gd.second] = NewInstSet();
+            if (*(*(global->taintMap))[gd.second] |= argTaint) {
+                gs->memChanges++;
+                global->changes++;
+            }
+        }
 
+        gs->summary->globalDefs.insert(gd);
+    }
 
-    // TODO: External globals get zero base and infinite_bound 
+    // the call carries the returned value's objects and taint
+    if (summary->ret != NULL) {
+        mts.clear();
+        if (gs->pMap->find(&I) != gs->pMap->end() && (*(gs->pMap))[&I] != NULL)
+            mts.insert((*(gs->pMap))[&I]->begin(), (*(gs->pMap))[&I]->end());
 
-    if(gv && !gv->hasInitializer()) {
-      tmp_base = m_void_null_ptr;
-      tmp_bound = m_infinite_bound_ptr;
-      return;
+        for (AliasObjectTupleRef aot : *(summary->ret)) {
+            AliasObjectSet objs;
+            Substitute(aot->ao, objs);
+            for (AliasObjectRef ao : objs)
+                mts.insert(GetAliasObjectTuple(ao, aot->offset));
+        }
+
+        if (!mts.empty())
+            (*(gs->pMap))[&I] = InternTupleSet(mts);
     }
 
-    Constant* index_base0 = 
-      Constant::
-      getNullValue(Type::getInt32Ty(given_constant->getType()->getContext()));
+    // params have no taint of their own, assume the result depends on all args
+    is = NewInstSet();
+    if (gs->tMap->find(&I) != gs->tMap->end() && (*(gs->tMap))[&I] != NULL)
+        *is |= *(*(gs->tMap))[&I];
+    *is |= *summary->retTaint;
+    for (i = 0; i < I.getNumArgOperands(); i++) {
+        arg = I.getArgOperand(i);
+        if (gs->tMap->find(arg) != gs->tMap->end() && (*(gs->tMap))[arg] != NULL)
+            *is |= *(*(gs->tMap))[arg];
+    }
+    (*(gs->tMap))[&I] = is;
 
-    Constant* index_bound0 = 
-      ConstantInt::
-      get(Type::getInt32Ty(given_constant->getType()->getContext()), 1);
+    // remember the bindings, DefUseCheck resolves placeholders through them
+    for (auto &it : subst) {
+        bound = paramBindings.lookup(it.first);
+        if (bound == NULL) {
+            bound = NewAliasObjectSet();
+            paramBindings[it.first] = bound;
+        }
+        bound->insert(it.second.begin(), it.second.end());
+        gs->summary->bindings[it.first].insert(it.second.begin(), it.second.end());
+    }
 
-    indices_base.push_back(index_base0);
-    indices_bound.push_back(index_bound0);
+    gs->summary->callees[f] = GetSummaryVersion(summary);
 
-    Constant* gep_base = ConstantExpr::getGetElementPtr(nullptr,
-							given_constant, 
-                                                        indices_base);    
-    Constant* gep_bound = ConstantExpr::getGetElementPtr(nullptr,
-							 given_constant, 
-                                                         indices_bound);
-      
-    tmp_base = gep_base;
-    tmp_bound = gep_bound;      
-  }
+    return;
 }
 
-//
-// Method: addStoreBaseBoundFunc
-//
-// Description:
-//
-// This function inserts metadata stores into the bitcode whenever a
-// pointer is being stored to memory.
-//
-// Inputs:
-//
-// pointer_dest: address where the pointer being stored
-//
-// pointer_base, pointer_bound, pointer_key, pointer_lock: metadata
-// associated with the pointer being stored
-//
-// pointer : pointer being stored to memory
-//
-// size_of_type: size of the access
-//
-// insert_at: the insertion point in the bitcode before which the
-// metadata store is introduced.
-//
-void Nova::AddStoreBaseBoundFunc(Value* pointer_dest, 
-                                 Value* pointer_base, 
-                                 Value* pointer_bound, 
-                                 Value* pointer,
-                                 Value* size_of_type, 
-                                 Instruction* insert_at) {
-
-  Value* pointer_base_cast = NULL;
-  Value* pointer_bound_cast = NULL;
-
-  
-  Value* pointer_dest_cast = CastToVoidPtr(pointer_dest, insert_at);
+// expand a param placeholder to the objects it is bound to at all call sites
+void Nova::ResolveAliasObject(AliasObjectRef ao, SmallPtrSetImpl<AliasObjectRef> &visited,
+                              SmallVectorImpl<AliasObjectRef> &objs) {
+    AliasObjectSet *bound;
 
-  pointer_base_cast = CastToVoidPtr(pointer_base, insert_at);
-  pointer_bound_cast = CastToVoidPtr(pointer_bound, insert_at);
+    if (!visited.insert(ao).second)
+        return;
 
-  //  Value* pointer_cast = castToVoidPtr(pointer, insert_at);
-    
-  SmallVector<Value*, 8> args;
+    if (!ao->isParam) {
+        objs.push_back(ao);
+        return;
+    }
 
-  args.push_back(pointer_dest_cast);
+    bound = paramBindings.lookup(ao);
+    if (bound == NULL)
+        return;
 
-  args.push_back(pointer_base_cast);
-  args.push_back(pointer_bound_cast);
+    for (AliasObjectRef bao : *bound)
+        ResolveAliasObject(bao, visited, objs);
 
-  CallInst::Create(m_store_base_bound_func, args, "", insert_at);
+    return;
 }
 
-//
-// Method: handleGlobalSequentialTypeInitializer
-//
-// Description: This performs the initialization of the metadata for
-// the pointers in the global segments that are initialized with
-// non-zero values.
-//
-// Comments: This function requires review and rewrite
+void Nova::InsertObjectValues(AliasObjectRef ao, ValueSet &senVarSet) {
+    SmallPtrSet<AliasObjectRef, 8> visited;
+    SmallVector<AliasObjectRef, 8> objs;
 
-void Nova::HandleGlobalSequentialTypeInitializer(Module& module, GlobalVariable* gv) {
+    if (!ao->isParam) {
+        senVarSet.insert(ao->val);
+        return;
+    }
 
-  //errs() << __func__ <<"\n";
-  // Sequential type can be an array type, a pointer type 
-  const SequentialType* init_seq_type = 
-    dyn_cast<SequentialType>((gv->getInitializer())->getType());
-  assert(init_seq_type && 
-         "[handleGlobalSequentialTypeInitializer] initializer  null?");
+    ResolveAliasObject(ao, visited, objs);
+    for (AliasObjectRef rao : objs)
+        senVarSet.insert(rao->val);
 
-  Instruction* init_function_terminator = GetGlobalInitInstruction(module);
-  if(gv->getInitializer()->isNullValue())
     return;
-    
-  if(isa<ArrayType>(init_seq_type)){      
-    const ArrayType* init_array_type = dyn_cast<ArrayType>(init_seq_type);     
-    if(isa<StructType>(init_array_type->getElementType())){
-      // It is an array of structures
+}
 
-      // Check whether the structure has a pointer, if it has a
-      // pointer then, we need to store the base and bound of the
-      // pointer into the metadata space. However, if the structure
-      // does not have any pointer, we can make a quick exit in
-      // processing this global
-      //
+void Nova::PrintPointsToMap(GlobalStateRef gs) {
+    AliasMapRef aliasMap;
+    unsigned offset;
+    AliasObjectSet *aos;
 
-      bool struct_has_pointers = false;
-      StructType* init_struct_type = 
-        dyn_cast<StructType>(init_array_type->getElementType());
-      CompositeType* struct_comp_type = 
-        dyn_cast<CompositeType>(init_struct_type);
-      
-      assert(struct_comp_type && "struct composite type null?");
-      assert(init_struct_type && 
-             "Array of structures and struct type null?");        
-      unsigned num_struct_elements = init_struct_type->getNumElements();        
-      for(unsigned i = 0; i < num_struct_elements; i++) {
-        Type* element_type = struct_comp_type->getTypeAtIndex(i);
-        if(isa<PointerType>(element_type)){
-          struct_has_pointers = true;
+    for (PointsToMap::iterator it = gs->pMap->begin(), ie = gs->pMap->end();
+                                                         it != ie; ++it) { 
+        if ((it)->second == NULL) {
+            errs() << "it->second is NULL!" << "\n";
+            continue;
         }
-      }
-      if(!struct_has_pointers)
-        return;
-
-      // Here implies, global variable is an array of structures with
-      // a pointer. Thus for each pointer we need to store the base
-      // and bound
-
-      size_t num_array_elements = init_array_type->getNumElements();
-      ConstantArray* const_array = 
-        dyn_cast<ConstantArray>(gv->getInitializer());
-      if(!const_array)
-        return;
 
-      for( unsigned i = 0; i < num_array_elements ; i++) {
-        Constant* struct_constant = const_array->getOperand(i);
-        assert(struct_constant && 
-               "Initializer structure type but not a constant?");          
-        // Constant has zero initializer 
-        if(struct_constant->isNullValue())
-          continue;
-          
-        for( unsigned j = 0 ; j < num_struct_elements; j++) {
-          const Type* element_type = init_struct_type->getTypeAtIndex(j);
-            
-          if(isa<PointerType>(element_type)){
-              
-            Value* initializer_opd = struct_constant->getOperand(j);
-            Value* operand_base = NULL;
-            Value* operand_bound = NULL;
-            Constant* given_constant = dyn_cast<Constant>(initializer_opd);
-            assert(given_constant && 
-                   "[handleGlobalStructTypeInitializer] not a constant?");
-              
-            GetConstantExprBaseBound(given_constant, operand_base, operand_bound);            
-            // Creating the address of ptr
-            Constant* index0 = 
-              ConstantInt::get(Type::getInt32Ty(module.getContext()), 0);
-            Constant* index1 = 
-              ConstantInt::get(Type::getInt32Ty(module.getContext()), i);
-            Constant* index2 = 
-              ConstantInt::get(Type::getInt32Ty(module.getContext()), j);
-              
-            std::vector<Constant *> indices_addr_ptr;            
-                            
-            indices_addr_ptr.push_back(index0);
-            indices_addr_ptr.push_back(index1);
-            indices_addr_ptr.push_back(index2);
+        errs() << it->first->getName() << " : " << "\n";
+        for (TupleSet::iterator tsit = it->second->begin(), tsie = it->second->end();
+                                                    tsit != tsie; ++tsit) {
+            if ((*tsit)->ao == NULL) {
+                errs() << "tsit->ao is NULL!" << "\n";
+                continue;
+            }
 
-            Constant* Indices[3] = {index0, index1, index2};
-            Constant* addr_of_ptr = ConstantExpr::getGetElementPtr(nullptr, gv, Indices);
-            Type* initializer_type = initializer_opd->getType();
-            Value* initializer_size = GetSizeOfType(initializer_type);
-            
-            AddStoreBaseBoundFunc(addr_of_ptr, operand_base, operand_bound, 
-                                  initializer_opd, initializer_size, init_function_terminator);
-          }                       
-        } // Iterating over struct element ends 
-      } // Iterating over array element ends         
-    }/// Array of Structures Ends 
+            errs() << "(" << (*tsit)->offset << ", " << (*tsit)->ao->val->getName() << ")" << "\n";
+            aliasMap = (*tsit)->ao->aliasMap;
+            offset = (*tsit)->offset;
+            if (aliasMap != NULL && aliasMap->find(offset) != aliasMap->end()) {
+                aos = (*aliasMap)[offset];
+                if (aos == NULL) {
+                    errs() << "aos is NULL!" << "\n";
+                    continue;
+                }
+                errs() << "alias object set: ";
+                for (AliasObjectSet::iterator aosit = aos->begin(), aosie = aos->end();
+                                                    aosit != aosie; ++aosit) {
+                    errs() << (*aosit)->val->getName() << ",";
+                }
+                errs() << "\n";
+            } else {
+                errs() << "location object ?" << "\n";
+            }
 
-    if (isa<PointerType>(init_array_type->getElementType())){
-      // It is a array of pointers
+            if ((*tsit)->ao->type != NULL && (*tsit)->ao->type->isStructTy()) {
+                // print struct field aliasMap
+                errs() << "struct internal alias map: \n";
+                for (AliasMap::iterator ait = aliasMap->begin(), aie = aliasMap->end();
+                                                ait != aie; ++ait) {
+                    offset = ait->first;
+                    aos = ait->second;
+                    if (aos == NULL) {
+                        errs() << "aos is NULL!" << "\n";
+                        continue;
+                    }
+                    errs() << "alias object set at offset " << offset << " : ";
+                    for (AliasObjectSet::iterator aosit = aos->begin(), aosie = aos->end();
+                                                        aosit != aosie; ++aosit) {
+                        errs() << (*aosit)->val->getName() << ",";
+                    }
+                    errs() << "\n";
+                }
+            }
+        }
+        errs() << "\n";
     }
-  }  // Array type case ends 
-
-  if(isa<PointerType>(init_seq_type)){
-    // individual pointer stores 
-    Value* initializer_base = NULL;
-    Value* initializer_bound = NULL;
-    Value* initializer = gv->getInitializer();
-    Constant* given_constant = dyn_cast<Constant>(initializer);
-    GetConstantExprBaseBound(given_constant, 
-                             initializer_base, 
-                             initializer_bound);
-    Type* initializer_type = initializer->getType();
-    Value* initializer_size = GetSizeOfType(initializer_type);
-    
-    AddStoreBaseBoundFunc(gv, initializer_base, initializer_bound,
-                          initializer, initializer_size, 
-                          init_function_terminator);        
-  }
-
 }
 
-void Nova::AddBaseBoundGlobalValue(Module &M, Value *v){
+void Nova::PrintTaintMap(GlobalStateRef gs) {
+    LocalTaintMapRef taintMap;
+    AliasObjectRef ao;
+    unsigned offset;
+    InstSet *is;
 
-    GlobalVariable* gv = dyn_cast<GlobalVariable>(v);
-    
-    if(!gv){
-      return;
-    }
+    for (TaintMap::iterator it = gs->tMap->begin(), ie = gs->tMap->end();
+                                                        it != ie; ++it) { 
+        errs() << it->first->getName() << " : " << "\n";
+        for (InstSet::iterator isit = it->second->begin(), isie = it->second->end();
+                                                    isit != isie; ++isit) {
+            errs() << *Arena.insts[*isit] << "\n";
+        }
 
-    if(StringRef(gv->getSection()) == "llvm.metadata"){
-      return;
-    }
-    if(gv->getName() == "llvm.global_ctors"){
-      return;
-    }
-    
-    if(!gv->hasInitializer())
-      return;
-    
-    /* gv->hasInitializer() is true */
-    
-    Constant* initializer = dyn_cast<Constant>(gv->getInitializer());
-    ConstantArray* constant_array = dyn_cast<ConstantArray>(initializer);
-    
-    if(initializer && isa<CompositeType>(initializer->getType())){
+        if (gs->pMap->find(it->first) != gs->pMap->end()) {
+            if (((*(gs->pMap))[it->first]) == NULL || ((*(gs->pMap))[it->first])->empty()) {
+                errs() << "pMap[it->first] == empty !\n";
+                ao = NULL;
+            } else {
+                ao = (*(*(gs->pMap))[it->first])[0]->ao;
+            }
+        } else {
+            ao = NULL;
+        }
 
-      if(isa<StructType>(initializer->getType())){
-        std::vector<Constant*> indices_addr_ptr;
-        Constant* index1 = ConstantInt::get(Type::getInt32Ty(M.getContext()), 0);
-        indices_addr_ptr.push_back(index1);
-        StructType* struct_type = dyn_cast<StructType>(initializer->getType());
-        HandleGlobalStructTypeInitializer(M, struct_type, initializer, gv, indices_addr_ptr, 1);
-        return;
-      }
-      
-      if(isa<SequentialType>(initializer->getType())){
-        HandleGlobalSequentialTypeInitializer(M, gv);
-      }
-    }
-    
-    if(initializer && !constant_array){
-        errs() <<"gv doesn't have constant_array initializer\n";
-        initializer->getType()->dump();
-      
-      if(isa<PointerType>(initializer->getType())){
-        errs() <<"gv has Pointer type initializer\n";
-      }
-    }
-    
-    if(!constant_array)
-      return;
-    
-    int num_ca_opds = constant_array->getNumOperands();
-    errs() <<"gv has constant_array initializer, num_ca_opds: "<< num_ca_opds << "\n";
-    
-    for(int i = 0; i < num_ca_opds; i++){
-      Value* initializer_opd = constant_array->getOperand(i);
-      Instruction* first = GetGlobalInitInstruction(M);
-      Value* operand_base = NULL;
-      Value* operand_bound = NULL;
-      
-      Constant* global_constant_initializer = dyn_cast<Constant>(initializer_opd);
-      if(!isa<PointerType>(global_constant_initializer->getType())){
-        break;
-      }
-      GetConstantExprBaseBound(global_constant_initializer, operand_base, operand_bound);
-      
-      SmallVector<Value*, 8> args;
-      Constant* index1 = ConstantInt::get(Type::getInt32Ty(M.getContext()), 0);
-      Constant* index2 = ConstantInt::get(Type::getInt32Ty(M.getContext()), i);
+        if (ao!= NULL) {
+            taintMap = ao->taintMap;
+        } else {
+            taintMap = NULL;
+        }
 
-      std::vector<Constant*> indices_addr_ptr;
-      indices_addr_ptr.push_back(index1);
-      indices_addr_ptr.push_back(index2);
+        offset = 0;
+        if (taintMap != NULL && taintMap->find(offset) != taintMap->end()) {
+            is = (*taintMap)[offset];
+            errs() << "alias object local taint trace: \n";
+            for (InstSet::iterator iit = is->begin(), iie = is->end();
+                                                iit != iie; ++iit) {
+                errs() << *Arena.insts[*iit] << "\n";
+            }
+            errs() << "\n";
+        } else {
+            errs() << "location object ?" << "\n";
+        }
 
-      Constant* addr_of_ptr = ConstantExpr::getGetElementPtr(nullptr, gv, indices_addr_ptr);
-      Type* initializer_type = initializer_opd->getType();
-      Value* initializer_size = GetSizeOfType(initializer_type);
-      
-      AddStoreBaseBoundFunc(addr_of_ptr, operand_base, operand_bound, initializer_opd, initializer_size, first);
+        errs() << "\n";
+
+        if (ao != NULL && taintMap != NULL && ao->type != NULL && ao->type->isStructTy()) {
+            // print struct field taintMap
+            errs() << "struct internal alias map: \n";
+            for (LocalTaintMap::iterator tit = taintMap->begin(), tie = taintMap->end();
+                                            tit != tie; ++tit) {
+                offset = tit->first;
+                is = tit->second;
+                errs() << "locat taint map at offset " << offset << " : " << "\n";
+                for (InstSet::iterator iit = is->begin(), iie = is->end();
+                                                    iit != iie; ++iit) {
+                    errs() << *Arena.insts[*iit] << "\n";
+                }
+                errs() << "\n";
+            }
+        }
     }
 }
 
-void Nova::CollectArrayBoundaryInfo(Module &M, Value *v) {
-    AllocaInst *ai;
+// for pointer type, we get boundary info when it's initialized
+// it could be initialized by malloc, getAddrOf array type, or others.
+// step : find its definition
+// step : instrument its definition to collect boundary info
+// step : check pointer-based read&write
+void Nova::PointerAccessCheck(Module &M, Value *v) {
+}
+
+BasicBlock::iterator Nova::GetInstIterator(Value *v) {
     Instruction *inst;
+    BasicBlock *bb;
 
+    inst = dyn_cast<Instruction>(v);
+    assert(inst && "v should be a instruction!");
+    bb = inst->getParent();
 
-    if (isa<GlobalVariable>(v)) { // handle global variable here
-        errs() << __func__ << " global v is :" << *v << "\n";
-        AddBaseBoundGlobalValue(M, v);
-    } else { // handle local variable here
+    for (BasicBlock::iterator i = bb->begin(), ie = bb->end(); i != ie; ++i) {
+        if (&(*i) == inst)
+            return i;
+    }
 
-        errs() << __func__ << " local v is :" << *v << "\n";
+    assert( 0 && "Can't find inst in its parent basicblock!");
+    return bb->end();
+}
 
-        ai = dyn_cast<AllocaInst>(v);
-        assert(ai && " local array is not defined as alloca inst!");
-        
-        // get next inst after ai
-        BasicBlock::iterator nextInst = GetInstIterator(v);
-        nextInst++;
-        Instruction *next = dyn_cast<Instruction>(nextInst);
-        assert (next && "Cannot increment the instruction iterator?");
+//
+// Method: getSizeOfType 
+// 
+// Description: This function returns the size of the memory access
+// based on the type of the pointer which is being dereferenced.  This
+// function is used to pass the size of the access in many checks to
+// perform byte granularity checking.
+//
+// Comments: May we should use TargetData instead of m_is_64_bit
+// according Criswell's comments.
+ 
 
-        // get basicblock that ai belongs to
-        inst = dyn_cast<Instruction>(v);
-        assert (inst && "v should be an instruction!");
+Value* Nova::GetSizeOfType(Type* input_type) {
 
-        unsigned numOperands = ai->getNumOperands();
+  // Create a Constant Pointer Null of the input type.  Then get a
+  // getElementPtr of it with next element access cast it to unsigned
+  // int
+   
+  const PointerType* ptr_type = dyn_cast<PointerType>(input_type);
 
-        /* For any alloca instruction, base is bitcast of alloca,
-           bound is bitcast of alloca_ptr + 1. Refer to SoftboundsCETS */
-        PointerType* ptrType = PointerType::get(ai->getAllocatedType(), 0);
-        Type* ty1 = ptrType;
-        BitCastInst* ptr = new BitCastInst(ai, ty1, ai->getName(), next);
+  if (isa<FunctionType>(ptr_type->getElementType())) {
+      return ConstantInt::get(Type::getInt64Ty(ptr_type->getContext()), 0);
+  }
 
-        Value* ptrBase = CastToVoidPtr(v, next);
-        Value* intBound;
+  const SequentialType* seq_type = dyn_cast<SequentialType>(input_type);
+  Constant* int64_size = NULL;
+  if (!seq_type) {
+    if(input_type->isSized()){
+      return ConstantInt::get(Type::getInt64Ty(input_type->getContext()), 0);
+    }
+  }
+  assert(seq_type && "pointer dereference and it is not a sequential type\n");
+  
+  StructType* struct_type = dyn_cast<StructType>(input_type);
 
-        if(numOperands == 0) {
-            // TODO: We only support 64-bit architechture
-            intBound = ConstantInt::get(Type::getInt64Ty(ai->getType()->getContext()), 1, false);
-        } else {
-            // What can be operand of alloca instruction?
-            intBound = ai->getOperand(0);
-        }
+  if(struct_type){
+    if(struct_type->isOpaque()){
+        return ConstantInt::get(Type::getInt64Ty(seq_type->getContext()), 0);        
+    }
+  }
+  
+  if(!seq_type->getElementType()->isSized()){
+    return ConstantInt::get(Type::getInt64Ty(seq_type->getContext()), 0);
+  }
+  int64_size = ConstantExpr::getSizeOf(seq_type->getElementType());
+  return int64_size;
+}
 
-        GetElementPtrInst* gep = GetElementPtrInst::Create(nullptr,
-                                                           ptr,
-                                                           intBound,
-                                                           "mtmp",
-                                                           next);
-        Value *boundPtr = gep;
-        Value* ptrBound = CastToVoidPtr(boundPtr, next);
+// 
+// Method: castToVoidPtr()
+// **Borrowed from SoftBoundsCETS
+//
+// Description: 
+// 
+// This function introduces a bitcast instruction in the IR when an
+// input operand that is a pointer type is not of type i8*. This is
+// required as all the SoftBound/CETS handlers take i8*s
+//
 
-        // TODOO instrument or leave it there?
-        AssociateBaseBound(v, ptrBase, ptrBound);
-    }
+Value* Nova::CastToVoidPtr(Value* operand, Instruction* insert_at) {
 
-    return;
+  Value* cast_bitcast = operand;
+  if (operand->getType() != m_void_ptr_type) {
+    cast_bitcast = new BitCastInst(operand, m_void_ptr_type,
+                                   "bitcast",
+                                   insert_at);
+  }
+  return cast_bitcast;
 }
 
-// Method: isStructOperand
-// **Borrowed from SoftboundCETS
 //
+// Method: dissociateBaseBound
+// **Borrowed from SoftboundCETS
 //
-//Description: This function elides the checks for the structure
-//accesses. This is safe when there are no casts in the program.
-//
-bool Nova::IsStructOperand(Value* pointer_operand) {
-  
-  if(isa<GetElementPtrInst>(pointer_operand)){
-    GetElementPtrInst* gep = dyn_cast<GetElementPtrInst>(pointer_operand);
-    Value* gep_operand = gep->getOperand(0);
-    const PointerType* ptr_type = dyn_cast<PointerType>(gep_operand->getType());
-    if(isa<StructType>(ptr_type->getElementType())){
-      return true;
-    }
+// Description: This function removes the base/bound metadata
+// associated with the pointer operand in the SoftBound/CETS maps.
+
+void Nova::DissociateBaseBound(Value* pointer_operand){
+
+  if(m_pointer_base.count(pointer_operand)){
+    m_pointer_base.erase(pointer_operand);
   }
-  return false;
+  if(m_pointer_bound.count(pointer_operand)){
+    m_pointer_bound.erase(pointer_operand);
+  }
+  assert((m_pointer_base.count(pointer_operand) == 0) && 
+         "dissociating base failed\n");
+  assert((m_pointer_bound.count(pointer_operand) == 0) && 
+         "dissociating bound failed");
 }
 
-// for array type, we get boundary info immediately
-void Nova::ArrayAccessCheck(Module &M, Value *v) {
-    Value *pointerOperand = NULL;
-    Instruction *inst = NULL;
-    Value* tmpBase = NULL;
-    Value* tmpBound = NULL;
-    Value* bitcastBase = NULL;
-    Value* bitcastBound = NULL;
-    Value* castPointerValue = NULL;
-    ValueSet kinSet; // propagated variable set with the same metadata as v.
-    SmallVector<Value*, 8> args;
-    // if array is global variable, we should initialize it before program exeucte
-    // if array is local variable, we should insert code after the last alloca instruction
-    // in the first bb.
+//
+// Method: associateBaseBound
+// **Borrowed from SoftboundCETS
+//
+// Description: This function associates the base bound with the
+// pointer operand in the SoftBound/CETS maps.
 
-    // collect array boundary info
-    CollectArrayBoundaryInfo(M, v);
 
-    // propagate metadata to a set of related variables
-    kinSet.insert(v);
-    for (User *UoV : v->users()) {
-        if ((inst = (dyn_cast<Instruction>(UoV)))) {
-            if (isa<GetElementPtrInst>(inst)) {
-                GetElementPtrInst *gepi = dyn_cast<GetElementPtrInst>(inst);
-                assert(gepi && "Not a GEP instruction");
-                pointerOperand = gepi->getPointerOperand();
-                assert(v == pointerOperand && "not propagate from v to GEP's Pointer Operand ?");
-                tmpBase = GetAssociatedBase(pointerOperand);
-                tmpBound = GetAssociatedBound(pointerOperand);
-                AssociateBaseBound(inst, tmpBase, tmpBound);   
-                kinSet.insert(inst);
-                errs() <<"add to kinSet: " <<*inst << "\n";
-            } else if (isa<BitCastInst>(inst)) {
-                BitCastInst *bci = dyn_cast<BitCastInst>(inst);
-                assert(bci && "Not a BitCast instruction");
-                pointerOperand = bci->getOperand(0);
-                assert(v == pointerOperand && "not propagate from v to BitCast's Pointer Operand ?");
-                tmpBase = GetAssociatedBase(pointerOperand);
-                tmpBound = GetAssociatedBound(pointerOperand);
-                AssociateBaseBound(inst, tmpBase, tmpBound); 
-                kinSet.insert(inst);
-                errs() <<"add to kinSet: " <<*inst << "\n";
-            } else {
-                errs() <<"not add to kinSet: " <<*inst << "\n";
-            }
-        } else {
-            errs() <<"Attention: v("<< *v << ") is not used in any instruction:\n";
-        }
-    }
+void Nova::AssociateBaseBound(Value* pointer_operand, 
+                              Value* pointer_base, 
+                              Value* pointer_bound){
 
-    // check array-based read&write
-    // TODOO
-    for (ValueSet::iterator it = kinSet.begin(), ie = kinSet.end(); it != ie; ++it) {
-        for (User *UoV : (*it)->users()) {
-            if ((inst = (dyn_cast<Instruction>(UoV)))) {
-                errs() << "v is used in instruction:\n";
-                errs() << *inst << "\n";
+  if(m_pointer_base.count(pointer_operand)){
+    DissociateBaseBound(pointer_operand);
+  }
 
-                if (isa<LoadInst>(inst)) {
-                    LoadInst *ldi = dyn_cast<LoadInst>(inst);
-                    assert(ldi && "Not a load instruction");
-                    pointerOperand = ldi->getPointerOperand();
-                } else if (isa<StoreInst>(inst)) {
-                    StoreInst *sti = dyn_cast<StoreInst>(inst);
-                    assert(sti && "Not a store instruction");
-                    pointerOperand = sti->getPointerOperand();
-                } else {
-                    errs() << "not load nor store inst, skip\n";
-                    continue;
-                }
+  if(pointer_base->getType() != m_void_ptr_type){
+    assert(0 && "base does not have a void pointer type ");
+  }
+  m_pointer_base[pointer_operand] = pointer_base;
 
-                assert(pointerOperand && "pointer operand null?");
-                if (pointerOperand != (*it)) {
-                    // pointerOperand isn't the sensitive var, need to handle its boundary collection
-                    CollectArrayBoundaryInfo(M, pointerOperand);
-                }
+  if(m_pointer_bound.count(pointer_operand)){
+    assert(0 && "bound map already has an entry in the map");
+  }
+  if(pointer_bound->getType() != m_void_ptr_type) {
+    assert(0 && "bound does not have a void pointer type ");
+  }
+  m_pointer_bound[pointer_operand] = pointer_bound;
+}
 
-                // should we ignore stuct pointer check?
-                // TODO
-                if(IsStructOperand(pointerOperand))
-                    continue;
+//
+// Methods: getAssociatedBase, getAssociatedBound, getAssociatedKey,
+// getAssociatedLock
+//
+// Description: Retrieves the metadata from SoftBound/CETS maps 
+//
 
-                // If it is a null pointer which is being loaded, then it must seg
-                // fault, no dereference check here. Refer to SoftboundCETS
-                if(isa<ConstantPointerNull>(pointerOperand))
-                    continue;
+Value* Nova::GetAssociatedBase(Value* pointer_operand) {
+    
 
-                tmpBase = GetAssociatedBase(pointerOperand);
-                tmpBound = GetAssociatedBound(pointerOperand);
+  if(isa<Constant>(pointer_operand)){
+    Value* base = NULL;
+    Value* bound = NULL;
+    Constant* ptr_constant = dyn_cast<Constant>(pointer_operand);
+    GetConstantExprBaseBound(ptr_constant, base, bound);
 
-                // empty args
-                args.clear();
+    if(base->getType() != m_void_ptr_type){
+      Constant* base_given_const = dyn_cast<Constant>(base);
+      assert(base_given_const!=NULL);
+      Constant* base_const = ConstantExpr::getBitCast(base_given_const, m_void_ptr_type);
+      return base_const;
+    }
+    return base;
+  }
 
-                bitcastBase = CastToVoidPtr(tmpBase, inst);
-                args.push_back(bitcastBase);
-                
-                bitcastBound = CastToVoidPtr(tmpBound, inst);    
-                args.push_back(bitcastBound);
-                 
-                castPointerValue = CastToVoidPtr(pointerOperand, inst);    
-                args.push_back(castPointerValue);
+  if(!m_pointer_base.count(pointer_operand)){
+    pointer_operand->dump();
+  }
+  assert(m_pointer_base.count(pointer_operand) && 
+         "Base absent. Try compiling with -simplifycfg option?");
+    
+  Value* pointer_base = m_pointer_base[pointer_operand];
+  assert(pointer_base && "base present in the map but null?");
 
-                // Pushing the size of the type 
-                Type* pointerOperandType = pointerOperand->getType();
-                Value* sizeOfType = GetSizeOfType(pointerOperandType);
-                args.push_back(sizeOfType);
+  if(pointer_base->getType() != m_void_ptr_type)
+    assert(0 && "base in the map does not have the right type");
 
-                // add check inst
-                // TODOO create function symbol for it.
-                errs() << "insert load/store dereference check \n";
-                CallInst::Create(m_spatial_load_dereference_check, args, "", inst);
-            }
-        }
+  return pointer_base;
+}
+
+Value* Nova::GetAssociatedBound(Value* pointer_operand) {
+
+  if(isa<Constant>(pointer_operand)){
+    Value* base = NULL;
+    Value* bound = NULL;
+    Constant* ptr_constant = dyn_cast<Constant>(pointer_operand);
+    GetConstantExprBaseBound(ptr_constant, base, bound);
+
+    if(bound->getType() != m_void_ptr_type){
+      Constant* bound_given_const = dyn_cast<Constant>(bound);
+      assert(bound_given_const != NULL);
+      Constant* bound_const = ConstantExpr::getBitCast(bound_given_const, m_void_ptr_type);
+      return bound_const;
     }
+
+    return bound;
+  }
+
+    
+  assert(m_pointer_bound.count(pointer_operand) && 
+         "Bound absent.");
+  Value* pointer_bound = m_pointer_bound[pointer_operand];
+  assert(pointer_bound && 
+         "bound present in the map but null?");    
+
+  if(pointer_bound->getType() != m_void_ptr_type)
+    assert(0 && "bound in the map does not have the right type");
+
+  return pointer_bound;
 }
 
-// step : instrument its definition to collect boundary info
-//void Nova::CollectArrayBoundaryInfo(Value *v) {
-//    // TODOO
-//    IRBuilder<> B(inst);
-//    Module *M = B.GetInsertBlock()->getModule();
-//    Type *VoidTy = B.getVoidTy();
-//    Type *I64Ty = B.getInt64Ty();
-//    Value *castAddr, *castVal;
-//
-//    //errs() << __func__ << " : "<< *inst << "\n";
-//
-//    Constant *RecordDefEvt = M->getOrInsertFunction("__record_defevt", VoidTy,
-//                                                                      I64Ty,
-//                                                                      I64Ty, 
-//                                                                      nullptr);
-//
-//    Function *RecordDefEvtFunc = cast<Function>(RecordDefEvt);
-//    castAddr = CastInst::Create(Instruction::PtrToInt, addr, I64Ty, "recptrtoint", inst);
-//
-//    if (val->getType()->isPointerTy()) {
-//        castVal = CastInst::Create(Instruction::PtrToInt, val, I64Ty, "recptrtoint", inst);
-//    } else if (val->getType()->isIntegerTy(64)) {
-//        castVal = val;
-//    } else if (val->getType()->isIntegerTy()) {
-//        castVal = CastInst::Create(Instruction::ZExt, val, I64Ty, "reczexttoi64", inst);
-//    } else
-//	return;
-//
-//    B.CreateCall(RecordDefEvtFunc, {castAddr, castVal});
-//
-//    return;
-//}
+Instruction* Nova:: GetGlobalInitInstruction(Module& module){
+  Function* global_init_function = module.getFunction("__softboundcets_global_init");    
+  assert(global_init_function && "no __softboundcets_global_init function??");    
+  Instruction *global_init_terminator = NULL;
+  bool return_inst_flag = false;
+  for(Function::iterator fi = global_init_function->begin(), fe = global_init_function->end(); fi != fe; ++fi) {
+      
+    BasicBlock* bb = dyn_cast<BasicBlock>(fi);
+    assert(bb && "basic block null");
+    Instruction* bb_term = dyn_cast<Instruction>(bb->getTerminator());
+    assert(bb_term && "terminator null?");
+      
+    if(isa<ReturnInst>(bb_term)) {
+      assert((return_inst_flag == false) && "has multiple returns?");
+      return_inst_flag = true;
+      global_init_terminator = dyn_cast<ReturnInst>(bb_term);
+      assert(global_init_terminator && "return inst null?");
+    }
+  }
+  assert(global_init_terminator && "global init does not have return, strange");
+  return global_init_terminator;
+}
 
+// Method: handleGlobalStructTypeInitializer()
 //
-// Method: isFuncDefSoftBound
-//
-// Description: 
-//
-// This function checks if the input function name is a
-// SoftBound/CETS defined function
+// Description: handles the global
+// initialization for global variables which are of struct type and
+// have a pointer as one of their fields and is globally
+// initialized 
 //
+// Comments: This function requires review and rewrite
 
-bool Nova::IsFuncDefSoftBound(const std::string &str) {
-  if (m_func_def_softbound.getNumItems() == 0) {
+void Nova::HandleGlobalStructTypeInitializer(Module& module, 
+                                  StructType* init_struct_type,
+                                  Constant* initializer, 
+                                  GlobalVariable* gv, 
+                                  std::vector<Constant*> indices_addr_ptr, 
+                                  int length) {
+  
+  // TODOO:URGENT: Do I handle nesxted structures
+  //errs() << __func__ <<"\n";
+  
+  // has zero initializer 
+  if(initializer->isNullValue())
+    return;
+    
+  Instruction* first = GetGlobalInitInstruction(module);
+  unsigned num_elements = init_struct_type->getNumElements();
+  Constant* constant = dyn_cast<Constant>(initializer);
+  assert(constant && 
+         "[handleGlobalStructTypeInit] global stype with init but not CA?");
 
-    m_func_wrappers_available["system"] = true;
-    m_func_wrappers_available["setreuid"] = true;
-    m_func_wrappers_available["mkstemp"] = true;
-    m_func_wrappers_available["getuid"] = true;
-    m_func_wrappers_available["getrlimit"] = true;
-    m_func_wrappers_available["setrlimit"] = true;
-    m_func_wrappers_available["fread"] = true;
-    m_func_wrappers_available["umask"] = true;
+  for(unsigned i = 0; i < num_elements ; i++) {
+    
+    CompositeType* struct_comp_type = 
+      dyn_cast<CompositeType>(init_struct_type);
+    assert(struct_comp_type && "not a struct type?");
+    
+    Type* element_type = struct_comp_type->getTypeAtIndex(i);      
+    if(isa<PointerType>(element_type)){        
+      Value* initializer_opd = constant->getOperand(i);
+      Value* operand_base = NULL;
+      Value* operand_bound = NULL;
+      
+      Constant* addr_of_ptr = NULL;
+      
+      Constant* given_constant = dyn_cast<Constant>(initializer_opd);
+      assert(given_constant && 
+             "[handleGlobalStructTypeInitializer] not a constant?");
+      
+      GetConstantExprBaseBound(given_constant, operand_base, operand_bound);   
+      
+      // Creating the address of ptr
+        //      Constant* index1 = 
+        //                ConstantInt::get(Type::getInt32Ty(module.getContext()), 0);
+      Constant* index2 = ConstantInt::get(Type::getInt32Ty(module.getContext()), i);
+      
+      //      indices_addr_ptr.push_back(index1);
+      indices_addr_ptr.push_back(index2);
+      length++;
+
+      addr_of_ptr = ConstantExpr::getGetElementPtr(nullptr, gv, indices_addr_ptr);
+      
+      Type* initializer_type = initializer_opd->getType();
+      Value* initializer_size = GetSizeOfType(initializer_type);     
+      AddStoreBaseBoundFunc(addr_of_ptr, operand_base, 
+                            operand_bound,initializer_opd, 
+                            initializer_size, first);
+      
+      indices_addr_ptr.pop_back();
+      length--;
+
+      continue;
+    }     
+    if(isa<StructType>(element_type)){
+      StructType* child_element_type = 
+        dyn_cast<StructType>(element_type);
+      Constant* struct_initializer = 
+        dyn_cast<Constant>(constant->getOperand(i));      
+      Constant* index2 =
+        ConstantInt::get(Type::getInt32Ty(module.getContext()), i);
+      indices_addr_ptr.push_back(index2);
+      length++;
+      HandleGlobalStructTypeInitializer(module, child_element_type, 
+                                        struct_initializer, gv, 
+                                        indices_addr_ptr, length); 
+      indices_addr_ptr.pop_back();
+      length--;
+      continue;
+    }
+  }
+}
+
+//
+// Method: getConstantExprBaseBound
+//
+// Description: This function uniform handles all global constant
+// expression and obtains the base and bound for these expressions
+// without introducing any extra IR modifications.
+
+void Nova::GetConstantExprBaseBound(Constant* given_constant, 
+                                             Value* & tmp_base,
+                                             Value* & tmp_bound){
+
+
+  if(isa<ConstantPointerNull>(given_constant)){
+    tmp_base = m_void_null_ptr;
+    tmp_bound = m_void_null_ptr;
+    return;
+  }
+  
+  ConstantExpr* cexpr = dyn_cast<ConstantExpr>(given_constant);
+  tmp_base = NULL;
+  tmp_bound = NULL;
+    
+
+  if(cexpr) {
+
+    assert(cexpr && "ConstantExpr and Value* is null??");
+    switch(cexpr->getOpcode()) {
+        
+    case Instruction::GetElementPtr:
+      {
+        Constant* internal_constant = dyn_cast<Constant>(cexpr->getOperand(0));
+        GetConstantExprBaseBound(internal_constant, tmp_base, tmp_bound);
+        break;
+      }
+      
+    case BitCastInst::BitCast:
+      {
+        Constant* internal_constant = dyn_cast<Constant>(cexpr->getOperand(0));
+        GetConstantExprBaseBound(internal_constant, tmp_base, tmp_bound);
+        break;
+      }
+    case Instruction::IntToPtr:
+      {
+        tmp_base = m_void_null_ptr;
+        tmp_bound = m_void_null_ptr;
+        return;
+        break;
+      }
+    default:
+      {
+        break;
+      }
+    } // Switch ends
+    
+  } else {
+      
+    const PointerType* func_ptr_type = 
+      dyn_cast<PointerType>(given_constant->getType());
+      
+    if(isa<FunctionType>(func_ptr_type->getElementType())) {
+      tmp_base = m_void_null_ptr;
+      tmp_bound = m_infinite_bound_ptr;
+      return;
+    }
+    // Create getElementPtrs to create the base and bound 
+
+    std::vector<Constant*> indices_base;
+    std::vector<Constant*> indices_bound;
+      
+    GlobalVariable* gv = dyn_cast<GlobalVariable>(given_constant);
+
+
+    // TODO: External globals get zero base and infinite_bound 
+
+    if(gv && !gv->hasInitializer()) {
+      tmp_base = m_void_null_ptr;
+      tmp_bound = m_infinite_bound_ptr;
+      return;
+    }
+
+    Constant* index_base0 = 
+      Constant::
+      getNullValue(Type::getInt32Ty(given_constant->getType()->getContext()));
+
+    Constant* index_bound0 = 
+      ConstantInt::
+      get(Type::getInt32Ty(given_constant->getType()->getContext()), 1);
+
+    indices_base.push_back(index_base0);
+    indices_bound.push_back(index_bound0);
+
+    Constant* gep_base = ConstantExpr::getGetElementPtr(nullptr,
+							given_constant, 
+                                                        indices_base);    
+    Constant* gep_bound = ConstantExpr::getGetElementPtr(nullptr,
+							 given_constant, 
+                                                         indices_bound);
+      
+    tmp_base = gep_base;
+    tmp_bound = gep_bound;      
+  }
+}
+
+//
+// Method: addStoreBaseBoundFunc
+//
+// Description:
+//
+// This function inserts metadata stores into the bitcode whenever a
+// pointer is being stored to memory.
+//
+// Inputs:
+//
+// pointer_dest: address where the pointer being stored
+//
+// pointer_base, pointer_bound, pointer_key, pointer_lock: metadata
+// associated with the pointer being stored
+//
+// pointer : pointer being stored to memory
+//
+// size_of_type: size of the access
+//
+// insert_at: the insertion point in the bitcode before which the
+// metadata store is introduced.
+//
+void Nova::AddStoreBaseBoundFunc(Value* pointer_dest, 
+                                 Value* pointer_base, 
+                                 Value* pointer_bound, 
+                                 Value* pointer,
+                                 Value* size_of_type, 
+                                 Instruction* insert_at) {
+
+  Value* pointer_base_cast = NULL;
+  Value* pointer_bound_cast = NULL;
+
+  
+  Value* pointer_dest_cast = CastToVoidPtr(pointer_dest, insert_at);
+
+  pointer_base_cast = CastToVoidPtr(pointer_base, insert_at);
+  pointer_bound_cast = CastToVoidPtr(pointer_bound, insert_at);
+
+  //  Value* pointer_cast = castToVoidPtr(pointer, insert_at);
+    
+  SmallVector<Value*, 8> args;
+
+  args.push_back(pointer_dest_cast);
+
+  args.push_back(pointer_base_cast);
+  args.push_back(pointer_bound_cast);
+
+  CallInst::Create(m_store_base_bound_func, args, "", insert_at);
+}
+
+//
+// Method: handleGlobalSequentialTypeInitializer
+//
+// Description: This performs the initialization of the metadata for
+// the pointers in the global segments that are initialized with
+// non-zero values.
+//
+// Comments: This function requires review and rewrite
+
+void Nova::HandleGlobalSequentialTypeInitializer(Module& module, GlobalVariable* gv) {
+
+  //errs() << __func__ <<"\n";
+  // Sequential type can be an array type, a pointer type 
+  const SequentialType* init_seq_type = 
+    dyn_cast<SequentialType>((gv->getInitializer())->getType());
+  assert(init_seq_type && 
+         "[handleGlobalSequentialTypeInitializer] initializer  null?");
+
+  Instruction* init_function_terminator = GetGlobalInitInstruction(module);
+  if(gv->getInitializer()->isNullValue())
+    return;
+    
+  if(isa<ArrayType>(init_seq_type)){      
+    const ArrayType* init_array_type = dyn_cast<ArrayType>(init_seq_type);     
+    if(isa<StructType>(init_array_type->getElementType())){
+      // It is an array of structures
+
+      // Check whether the structure has a pointer, if it has a
+      // pointer then, we need to store the base and bound of the
+      // pointer into the metadata space. However, if the structure
+      // does not have any pointer, we can make a quick exit in
+      // processing this global
+      //
+
+      bool struct_has_pointers = false;
+      StructType* init_struct_type = 
+        dyn_cast<StructType>(init_array_type->getElementType());
+      CompositeType* struct_comp_type = 
+        dyn_cast<CompositeType>(init_struct_type);
+      
+      assert(struct_comp_type && "struct composite type null?");
+      assert(init_struct_type && 
+             "Array of structures and struct type null?");        
+      unsigned num_struct_elements = init_struct_type->getNumElements();        
+      for(unsigned i = 0; i < num_struct_elements; i++) {
+        Type* element_type = struct_comp_type->getTypeAtIndex(i);
+        if(isa<PointerType>(element_type)){
+          struct_has_pointers = true;
+        }
+      }
+      if(!struct_has_pointers)
+        return;
+
+      // Here implies, global variable is an array of structures with
+      // a pointer. Thus for each pointer we need to store the base
+      // and bound
+
+      size_t num_array_elements = init_array_type->getNumElements();
+      ConstantArray* const_array = 
+        dyn_cast<ConstantArray>(gv->getInitializer());
+      if(!const_array)
+        return;
+
+      for( unsigned i = 0; i < num_array_elements ; i++) {
+        Constant* struct_constant = const_array->getOperand(i);
+        assert(struct_constant && 
+               "Initializer structure type but not a constant?");          
+        // Constant has zero initializer 
+        if(struct_constant->isNullValue())
+          continue;
+          
+        for( unsigned j = 0 ; j < num_struct_elements; j++) {
+          const Type* element_type = init_struct_type->getTypeAtIndex(j);
+            
+          if(isa<PointerType>(element_type)){
+              
+            Value* initializer_opd = struct_constant->getOperand(j);
+            Value* operand_base = NULL;
+            Value* operand_bound = NULL;
+            Constant* given_constant = dyn_cast<Constant>(initializer_opd);
+            assert(given_constant && 
+                   "[handleGlobalStructTypeInitializer] not a constant?");
+              
+            GetConstantExprBaseBound(given_constant, operand_base, operand_bound);            
+            // Creating the address of ptr
+            Constant* index0 = 
+              ConstantInt::get(Type::getInt32Ty(module.getContext()), 0);
+            Constant* index1 = 
+              ConstantInt::get(Type::getInt32Ty(module.getContext()), i);
+            Constant* index2 = 
+              ConstantInt::get(Type::getInt32Ty(module.getContext()), j);
+              
+            std::vector<Constant *> indices_addr_ptr;            
+                            
+            indices_addr_ptr.push_back(index0);
+            indices_addr_ptr.push_back(index1);
+            indices_addr_ptr.push_back(index2);
+
+            Constant* Indices[3] = {index0, index1, index2};
+            Constant* addr_of_ptr = ConstantExpr::getGetElementPtr(nullptr, gv, Indices);
+            Type* initializer_type = initializer_opd->getType();
+            Value* initializer_size = GetSizeOfType(initializer_type);
+            
+            AddStoreBaseBoundFunc(addr_of_ptr, operand_base, operand_bound, 
+                                  initializer_opd, initializer_size, init_function_terminator);
+          }                       
+        } // Iterating over struct element ends 
+      } // Iterating over array element ends         
+    }/// Array of Structures Ends 
+
+    if (isa<PointerType>(init_array_type->getElementType())){
+      // It is a array of pointers
+    }
+  }  // Array type case ends 
+
+  if(isa<PointerType>(init_seq_type)){
+    // individual pointer stores 
+    Value* initializer_base = NULL;
+    Value* initializer_bound = NULL;
+    Value* initializer = gv->getInitializer();
+    Constant* given_constant = dyn_cast<Constant>(initializer);
+    GetConstantExprBaseBound(given_constant, 
+                             initializer_base, 
+                             initializer_bound);
+    Type* initializer_type = initializer->getType();
+    Value* initializer_size = GetSizeOfType(initializer_type);
+    
+    AddStoreBaseBoundFunc(gv, initializer_base, initializer_bound,
+                          initializer, initializer_size, 
+                          init_function_terminator);        
+  }
+
+}
+
+void Nova::AddBaseBoundGlobalValue(Module &M, Value *v){
+
+    GlobalVariable* gv = dyn_cast<GlobalVariable>(v);
+    
+    if(!gv){
+      return;
+    }
+
+    if(StringRef(gv->getSection()) == "llvm.metadata"){
+      return;
+    }
+    if(gv->getName() == "llvm.global_ctors"){
+      return;
+    }
+    
+    if(!gv->hasInitializer())
+      return;
+    
+    /* gv->hasInitializer() is true */
+    
+    Constant* initializer = dyn_cast<Constant>(gv->getInitializer());
+    ConstantArray* constant_array = dyn_cast<ConstantArray>(initializer);
+    
+    if(initializer && isa<CompositeType>(initializer->getType())){
+
+      if(isa<StructType>(initializer->getType())){
+        std::vector<Constant*> indices_addr_ptr;
+        Constant* index1 = ConstantInt::get(Type::getInt32Ty(M.getContext()), 0);
+        indices_addr_ptr.push_back(index1);
+        StructType* struct_type = dyn_cast<StructType>(initializer->getType());
+        HandleGlobalStructTypeInitializer(M, struct_type, initializer, gv, indices_addr_ptr, 1);
+        return;
+      }
+      
+      if(isa<SequentialType>(initializer->getType())){
+        HandleGlobalSequentialTypeInitializer(M, gv);
+      }
+    }
+    
+    if(initializer && !constant_array){
+        errs() <<"gv doesn't have constant_array initializer\n";
+        initializer->getType()->dump();
+      
+      if(isa<PointerType>(initializer->getType())){
+        errs() <<"gv has Pointer type initializer\n";
+      }
+    }
+    
+    if(!constant_array)
+      return;
+    
+    int num_ca_opds = constant_array->getNumOperands();
+    errs() <<"gv has constant_array initializer, num_ca_opds: "<< num_ca_opds << "\n";
+    
+    for(int i = 0; i < num_ca_opds; i++){
+      Value* initializer_opd = constant_array->getOperand(i);
+      Instruction* first = GetGlobalInitInstruction(M);
+      Value* operand_base = NULL;
+      Value* operand_bound = NULL;
+      
+      Constant* global_constant_initializer = dyn_cast<Constant>(initializer_opd);
+      if(!isa<PointerType>(global_constant_initializer->getType())){
+        break;
+      }
+      GetConstantExprBaseBound(global_constant_initializer, operand_base, operand_bound);
+      
+      SmallVector<Value*, 8> args;
+      Constant* index1 = ConstantInt::get(Type::getInt32Ty(M.getContext()), 0);
+      Constant* index2 = ConstantInt::get(Type::getInt32Ty(M.getContext()), i);
+
+      std::vector<Constant*> indices_addr_ptr;
+      indices_addr_ptr.push_back(index1);
+      indices_addr_ptr.push_back(index2);
+
+      Constant* addr_of_ptr = ConstantExpr::getGetElementPtr(nullptr, gv, indices_addr_ptr);
+      Type* initializer_type = initializer_opd->getType();
+      Value* initializer_size = GetSizeOfType(initializer_type);
+      
+      AddStoreBaseBoundFunc(addr_of_ptr, operand_base, operand_bound, initializer_opd, initializer_size, first);
+    }
+}
+
+void Nova::CollectArrayBoundaryInfo(Module &M, Value *v) {
+    AllocaInst *ai;
+    Instruction *inst;
+
+
+    if (isa<GlobalVariable>(v)) { // handle global variable here
+        errs() << __func__ << " global v is :" << *v << "\n";
+        AddBaseBoundGlobalValue(M, v);
+    } else { // handle local variable here
+
+        errs() << __func__ << " local v is :" << *v << "\n";
+
+        ai = dyn_cast<AllocaInst>(v);
+        assert(ai && " local array is not defined as alloca inst!");
+        
+        // get next inst after ai
+        BasicBlock::iterator nextInst = GetInstIterator(v);
+        nextInst++;
+        Instruction *next = dyn_cast<Instruction>(nextInst);
+        assert (next && "Cannot increment the instruction iterator?");
+
+        // get basicblock that ai belongs to
+        inst = dyn_cast<Instruction>(v);
+        assert (inst && "v should be an instruction!");
+
+        unsigned numOperands = ai->getNumOperands();
+
+        /* For any alloca instruction, base is bitcast of alloca,
+           bound is bitcast of alloca_ptr + 1. Refer to SoftboundsCETS */
+        PointerType* ptrType = PointerType::get(ai->getAllocatedType(), 0);
+        Type* ty1 = ptrType;
+        BitCastInst* ptr = new BitCastInst(ai, ty1, ai->getName(), next);
+
+        Value* ptrBase = CastToVoidPtr(v, next);
+        Value* intBound;
+
+        if(numOperands == 0) {
+            // TODO: We only support 64-bit architechture
+            intBound = ConstantInt::get(Type::getInt64Ty(ai->getType()->getContext()), 1, false);
+        } else {
+            // What can be operand of alloca instruction?
+            intBound = ai->getOperand(0);
+        }
+
+        GetElementPtrInst* gep = GetElementPtrInst::Create(nullptr,
+                                                           ptr,
+                                                           intBound,
+                                                           "mtmp",
+                                                           next);
+        Value *boundPtr = gep;
+        Value* ptrBound = CastToVoidPtr(boundPtr, next);
+
+        // TODOO instrument or leave it there?
+        AssociateBaseBound(v, ptrBase, ptrBound);
+    }
+
+    return;
+}
+
+// Method: isStructOperand
+// **Borrowed from SoftboundCETS
+//
+//
+//Description: This function elides the checks for the structure
+//accesses. This is safe when there are no casts in the program.
+//
+bool Nova::IsStructOperand(Value* pointer_operand) {
+  
+  if(isa<GetElementPtrInst>(pointer_operand)){
+    GetElementPtrInst* gep = dyn_cast<GetElementPtrInst>(pointer_operand);
+    Value* gep_operand = gep->getOperand(0);
+    const PointerType* ptr_type = dyn_cast<PointerType>(gep_operand->getType());
+    if(isa<StructType>(ptr_type->getElementType())){
+      return true;
+    }
+  }
+  return false;
+}
+
+// for array type, we get boundary info immediately
+void Nova::ArrayAccessCheck(Module &M, Value *v) {
+    Value *pointerOperand = NULL;
+    Instruction *inst = NULL;
+    Value* tmpBase = NULL;
+    Value* tmpBound = NULL;
+    Value* bitcastBase = NULL;
+    Value* bitcastBound = NULL;
+    Value* castPointerValue = NULL;
+    ValueSet kinSet; // propagated variable set with the same metadata as v.
+    SmallVector<Value*, 8> args;
+    // if array is global variable, we should initialize it before program exeucte
+    // if array is local variable, we should insert code after the last alloca instruction
+    // in the first bb.
+
+    // collect array boundary info
+    CollectArrayBoundaryInfo(M, v);
+
+    // propagate metadata to a set of related variables
+    kinSet.insert(v);
+    for (User *UoV : v->users()) {
+        if ((inst = (dyn_cast<Instruction>(UoV)))) {
+            if (isa<GetElementPtrInst>(inst)) {
+                GetElementPtrInst *gepi = dyn_cast<GetElementPtrInst>(inst);
+                assert(gepi && "Not a GEP instruction");
+                pointerOperand = gepi->getPointerOperand();
+                assert(v == pointerOperand && "not propagate from v to GEP's Pointer Operand ?");
+                tmpBase = GetAssociatedBase(pointerOperand);
+                tmpBound = GetAssociatedBound(pointerOperand);
+                AssociateBaseBound(inst, tmpBase, tmpBound);   
+                kinSet.insert(inst);
+                errs() <<"add to kinSet: " <<*inst << "\n";
+            } else if (isa<BitCastInst>(inst)) {
+                BitCastInst *bci = dyn_cast<BitCastInst>(inst);
+                assert(bci && "Not a BitCast instruction");
+                pointerOperand = bci->getOperand(0);
+                assert(v == pointerOperand && "not propagate from v to BitCast's Pointer Operand ?");
+                tmpBase = GetAssociatedBase(pointerOperand);
+                tmpBound = GetAssociatedBound(pointerOperand);
+                AssociateBaseBound(inst, tmpBase, tmpBound); 
+                kinSet.insert(inst);
+                errs() <<"add to kinSet: " <<*inst << "\n";
+            } else {
+                errs() <<"not add to kinSet: " <<*inst << "\n";
+            }
+        } else {
+            errs() <<"Attention: v("<< *v << ") is not used in any instruction:\n";
+        }
+    }
+
+    // check array-based read&write
+    // TODOO
+    for (ValueSet::iterator it = kinSet.begin(), ie = kinSet.end(); it != ie; ++it) {
+        for (User *UoV : (*it)->users()) {
+            if ((inst = (dyn_cast<Instruction>(UoV)))) {
+                errs() << "v is used in instruction:\n";
+                errs() << *inst << "\n";
+
+                if (isa<LoadInst>(inst)) {
+                    LoadInst *ldi = dyn_cast<LoadInst>(inst);
+                    assert(ldi && "Not a load instruction");
+                    pointerOperand = ldi->getPointerOperand();
+                } else if (isa<StoreInst>(inst)) {
+                    StoreInst *sti = dyn_cast<StoreInst>(inst);
+                    assert(sti && "Not a store instruction");
+                    pointerOperand = sti->getPointerOperand();
+                } else {
+                    errs() << "not load nor store inst, skip\n";
+                    continue;
+                }
+
+                assert(pointerOperand && "pointer operand null?");
+                if (pointerOperand != (*it)) {
+                    // pointerOperand isn't the sensitive var, need to handle its boundary collection
+                    CollectArrayBoundaryInfo(M, pointerOperand);
+                }
+
+                // should we ignore stuct pointer check?
+                // TODO
+                if(IsStructOperand(pointerOperand))
+                    continue;
+
+                // If it is a null pointer which is being loaded, then it must seg
+                // fault, no dereference check here. Refer to SoftboundCETS
+                if(isa<ConstantPointerNull>(pointerOperand))
+                    continue;
+
+                tmpBase = GetAssociatedBase(pointerOperand);
+                tmpBound = GetAssociatedBound(pointerOperand);
+
+                // empty args
+                args.clear();
+
+                bitcastBase = CastToVoidPtr(tmpBase, inst);
+                args.push_back(bitcastBase);
+                
+                bitcastBound = CastToVoidPtr(tmpBound, inst);    
+                args.push_back(bitcastBound);
+                 
+                castPointerValue = CastToVoidPtr(pointerOperand, inst);    
+                args.push_back(castPointerValue);
+
+                // Pushing the size of the type 
+                Type* pointerOperandType = pointerOperand->getType();
+                Value* sizeOfType = GetSizeOfType(pointerOperandType);
+                args.push_back(sizeOfType);
+
+                // add check inst
+                // TODOO create function symbol for it.
+                errs() << "insert load/store dereference check \n";
+                CallInst::Create(m_spatial_load_dereference_check, args, "", inst);
+            }
+        }
+    }
+}
+
+//
+// Method: isFuncDefSoftBound
+//
+// Description: 
+//
+// This function checks if the input function name is a
+// SoftBound/CETS defined function
+//
+
+bool Nova::IsFuncDefSoftBound(const std::string &str) {
+  if (m_func_def_softbound.getNumItems() == 0) {
+
+    m_func_wrappers_available["system"] = true;
+    m_func_wrappers_available["setreuid"] = true;
+    m_func_wrappers_available["mkstemp"] = true;
+    m_func_wrappers_available["getuid"] = true;
+    m_func_wrappers_available["getrlimit"] = true;
+    m_func_wrappers_available["setrlimit"] = true;
+    m_func_wrappers_available["fread"] = true;
+    m_func_wrappers_available["umask"] = true;
     m_func_wrappers_available["mkdir"] = true;
     m_func_wrappers_available["chroot"] = true;
     m_func_wrappers_available["rmdir"] = true;
@@ -2666,2340 +3816,3479 @@ bool Nova::IsFuncDefSoftBound(const std::string &str) {
     m_func_wrappers_available["malloc"] = true;
     m_func_wrappers_available["mmap"] = true;
 
-    m_func_wrappers_available["putchar"] = true;
-    m_func_wrappers_available["times"] = true;
-    m_func_wrappers_available["strftime"] = true;
-    m_func_wrappers_available["localtime"] = true;
-    m_func_wrappers_available["time"] = true;
-    m_func_wrappers_available["drand48"] = true;
-    m_func_wrappers_available["free"] = true;
-    m_func_wrappers_available["lrand48"] = true;
-    m_func_wrappers_available["ctime"] = true;
-    m_func_wrappers_available["difftime"] = true;
-    m_func_wrappers_available["toupper"] = true;
-    m_func_wrappers_available["tolower"] = true;
-    m_func_wrappers_available["setbuf"] = true;
-    m_func_wrappers_available["getenv"] = true;
-    m_func_wrappers_available["atexit"] = true;
-    m_func_wrappers_available["strerror"] = true;
-    m_func_wrappers_available["unlink"] = true;
-    m_func_wrappers_available["close"] = true;
-    m_func_wrappers_available["open"] = true;
-    m_func_wrappers_available["read"] = true;
-    m_func_wrappers_available["write"] = true;
-    m_func_wrappers_available["lseek"] = true;
-    m_func_wrappers_available["gettimeofday"] = true;
-    m_func_wrappers_available["select"] = true;
-    m_func_wrappers_available["__errno_location"] = true;
-    m_func_wrappers_available["__ctype_b_loc"] = true;
-    m_func_wrappers_available["__ctype_toupper_loc"] = true;
-    m_func_wrappers_available["__ctype_tolower_loc"] = true;
-    m_func_wrappers_available["qsort"] = true;
+    m_func_wrappers_available["putchar"] = true;
+    m_func_wrappers_available["times"] = true;
+    m_func_wrappers_available["strftime"] = true;
+    m_func_wrappers_available["localtime"] = true;
+    m_func_wrappers_available["time"] = true;
+    m_func_wrappers_available["drand48"] = true;
+    m_func_wrappers_available["free"] = true;
+    m_func_wrappers_available["lrand48"] = true;
+    m_func_wrappers_available["ctime"] = true;
+    m_func_wrappers_available["difftime"] = true;
+    m_func_wrappers_available["toupper"] = true;
+    m_func_wrappers_available["tolower"] = true;
+    m_func_wrappers_available["setbuf"] = true;
+    m_func_wrappers_available["getenv"] = true;
+    m_func_wrappers_available["atexit"] = true;
+    m_func_wrappers_available["strerror"] = true;
+    m_func_wrappers_available["unlink"] = true;
+    m_func_wrappers_available["close"] = true;
+    m_func_wrappers_available["open"] = true;
+    m_func_wrappers_available["read"] = true;
+    m_func_wrappers_available["write"] = true;
+    m_func_wrappers_available["lseek"] = true;
+    m_func_wrappers_available["gettimeofday"] = true;
+    m_func_wrappers_available["select"] = true;
+    m_func_wrappers_available["__errno_location"] = true;
+    m_func_wrappers_available["__ctype_b_loc"] = true;
+    m_func_wrappers_available["__ctype_toupper_loc"] = true;
+    m_func_wrappers_available["__ctype_tolower_loc"] = true;
+    m_func_wrappers_available["qsort"] = true;
+
+    m_func_def_softbound["puts"] = true;
+    m_func_def_softbound["__softboundcets_intermediate"]= true;
+    m_func_def_softbound["__softboundcets_dummy"] = true;
+    m_func_def_softbound["__softboundcets_print_metadata"] = true;
+    m_func_def_softbound["__softboundcets_introspect_metadata"] = true;
+    m_func_def_softbound["__softboundcets_copy_metadata"] = true;
+    m_func_def_softbound["__softboundcets_allocate_shadow_stack_space"] = true;
+    m_func_def_softbound["__softboundcets_load_base_shadow_stack"] = true;
+    m_func_def_softbound["__softboundcets_load_bound_shadow_stack"] = true;
+    m_func_def_softbound["__softboundcets_load_key_shadow_stack"] = true;
+    m_func_def_softbound["__softboundcets_load_lock_shadow_stack"] = true;
+    m_func_def_softbound["__softboundcets_store_base_shadow_stack"] = true;      
+    m_func_def_softbound["__softboundcets_store_bound_shadow_stack"] = true;      
+    m_func_def_softbound["__softboundcets_store_key_shadow_stack"] = true;      
+    m_func_def_softbound["__softboundcets_store_lock_shadow_stack"] = true;      
+    m_func_def_softbound["__softboundcets_deallocate_shadow_stack_space"] = true;
+
+    m_func_def_softbound["__softboundcets_trie_allocate"] = true;
+    m_func_def_softbound["__shrinkBounds"] = true;
+    m_func_def_softbound["__softboundcets_memcopy_check"] = true;
+
+    m_func_def_softbound["__softboundcets_spatial_load_dereference_check"] = true;
+
+    m_func_def_softbound["__softboundcets_spatial_store_dereference_check"] = true;
+    m_func_def_softbound["__softboundcets_spatial_call_dereference_check"] = true;
+    m_func_def_softbound["__softboundcets_temporal_load_dereference_check"] = true;
+    m_func_def_softbound["__softboundcets_temporal_store_dereference_check"] = true;
+    m_func_def_softbound["__softboundcets_stack_memory_allocation"] = true;
+    m_func_def_softbound["__softboundcets_memory_allocation"] = true;
+    m_func_def_softbound["__softboundcets_get_global_lock"] = true;
+    m_func_def_softbound["__softboundcets_add_to_free_map"] = true;
+    m_func_def_softbound["__softboundcets_check_remove_from_free_map"] = true;
+    m_func_def_softbound["__softboundcets_allocation_secondary_trie_allocate"] = true;
+    m_func_def_softbound["__softboundcets_allocation_secondary_trie_allocate_range"] = true;
+    m_func_def_softbound["__softboundcets_allocate_lock_location"] = true;
+    m_func_def_softbound["__softboundcets_memory_deallocation"] = true;
+    m_func_def_softbound["__softboundcets_stack_memory_deallocation"] = true;
+
+    m_func_def_softbound["__softboundcets_metadata_load_vector"] = true;
+    m_func_def_softbound["__softboundcets_metadata_store_vector"] = true;
+    
+    m_func_def_softbound["__softboundcets_metadata_load"] = true;
+    m_func_def_softbound["__softboundcets_metadata_store"] = true;
+    m_func_def_softbound["__hashProbeAddrOfPtr"] = true;
+    m_func_def_softbound["__memcopyCheck"] = true;
+    m_func_def_softbound["__memcopyCheck_i64"] = true;
+
+    m_func_def_softbound["__softboundcets_global_init"] = true;      
+    m_func_def_softbound["__softboundcets_init"] = true;      
+    m_func_def_softbound["__softboundcets_abort"] = true;      
+    m_func_def_softbound["__softboundcets_printf"] = true;
+    
+    m_func_def_softbound["__softboundcets_stub"] = true;
+    m_func_def_softbound["safe_mmap"] = true;
+    m_func_def_softbound["safe_calloc"] = true;
+    m_func_def_softbound["safe_malloc"] = true;
+    m_func_def_softbound["safe_free"] = true;
+
+    m_func_def_softbound["__assert_fail"] = true;
+    m_func_def_softbound["assert"] = true;
+    m_func_def_softbound["__strspn_c2"] = true;
+    m_func_def_softbound["__strcspn_c2"] = true;
+    m_func_def_softbound["__strtol_internal"] = true;
+    m_func_def_softbound["__stroul_internal"] = true;
+    m_func_def_softbound["ioctl"] = true;
+    m_func_def_softbound["error"] = true;
+    m_func_def_softbound["__strtod_internal"] = true;
+    m_func_def_softbound["__strtoul_internal"] = true;
+    
+    
+    m_func_def_softbound["fflush_unlocked"] = true;
+    m_func_def_softbound["full_write"] = true;
+    m_func_def_softbound["safe_read"] = true;
+    m_func_def_softbound["_IO_getc"] = true;
+    m_func_def_softbound["_IO_putc"] = true;
+    m_func_def_softbound["__xstat"] = true;
+
+    m_func_def_softbound["select"] = true;
+    m_func_def_softbound["_setjmp"] = true;
+    m_func_def_softbound["longjmp"] = true;
+    m_func_def_softbound["fork"] = true;
+    m_func_def_softbound["pipe"] = true;
+    m_func_def_softbound["dup2"] = true;
+    m_func_def_softbound["execv"] = true;
+    m_func_def_softbound["compare_pic_by_pic_num_desc"] = true;
+     
+    m_func_def_softbound["wprintf"] = true;
+    m_func_def_softbound["vfprintf"] = true;
+    m_func_def_softbound["vsprintf"] = true;
+    m_func_def_softbound["fprintf"] = true;
+    m_func_def_softbound["printf"] = true;
+    m_func_def_softbound["sprintf"] = true;
+    m_func_def_softbound["snprintf"] = true;
+
+    m_func_def_softbound["scanf"] = true;
+    m_func_def_softbound["fscanf"] = true;
+    m_func_def_softbound["sscanf"] = true;   
+
+    m_func_def_softbound["asprintf"] = true;
+    m_func_def_softbound["vasprintf"] = true;
+    m_func_def_softbound["__fpending"] = true;
+    m_func_def_softbound["fcntl"] = true;
+
+    m_func_def_softbound["vsnprintf"] = true;
+    m_func_def_softbound["fwrite_unlocked"] = true;
+    m_func_def_softbound["__overflow"] = true;
+    m_func_def_softbound["__uflow"] = true;
+    m_func_def_softbound["execlp"] = true;
+    m_func_def_softbound["execl"] = true;
+    m_func_def_softbound["waitpid"] = true;
+    m_func_def_softbound["dup"] = true;
+    m_func_def_softbound["setuid"] = true;
+    
+    m_func_def_softbound["_exit"] = true;
+    m_func_def_softbound["funlockfile"] = true;
+    m_func_def_softbound["flockfile"] = true;
+
+    m_func_def_softbound["__option_is_short"] = true;
+    
+
+  }
+
+  // Is the function name in the above list?
+  if (m_func_def_softbound.count(str) > 0) {
+    return true;
+  }
+
+  // FIXME: handling new intrinsics which have isoc99 in their name
+  if (str.find("isoc99") != std::string::npos){
+    return true;
+  }
+
+  // If the function is an llvm intrinsic, don't transform it
+  if (str.find("llvm.") == 0) {
+    return true;
+  }
+
+  return false;
+}
+
+//
+// Method: hasPtrArgRetType()
+//
+// Description:
+//
+// This function checks if the function has either pointer arguments
+// or returns a pointer value. This function is used to determine
+// whether shadow stack loads/stores need to be introduced for
+// metadata propagation.
+//
+
+bool Nova::HasPtrArgRetType(Function* func) {
+   
+  const Type* ret_type = func->getReturnType();
+  if (isa<PointerType>(ret_type))
+    return true;
+
+  for (Function::arg_iterator i = func->arg_begin(), e = func->arg_end(); 
+      i != e; ++i) {
+      
+    if (isa<PointerType>(i->getType()))
+      return true;
+  }
+  return false;
+}
+
+// 
+// Method: identifyFuncToTrans
+//
+// Description: This function traverses the module and identifies the
+// functions that need to be transformed by SoftBound/CETS
+//
+
+void Nova::IdentifyFuncToTrans(Module& module) {
+    
+  for (Module::iterator fb_it = module.begin(), fe_it = module.end(); 
+      fb_it != fe_it; ++fb_it) {
+
+    Function* func = dyn_cast<Function>(fb_it);
+    assert(func && " Not a function");
+
+    // Check if the function is defined in the module
+    if (!func->isDeclaration()) {
+      if (IsFuncDefSoftBound(func->getName())) 
+        continue;
+      
+      m_func_softboundcets_transform[func->getName()] = true;
+      if (HasPtrArgRetType(func)) {
+        m_func_to_transform[func->getName()] = true;
+      }
+    }
+  }
+}
+
+/* Identify the initial globals present in the program before we add
+ * extra base and bound for all globals
+ */
+void Nova::IdentifyInitialGlobals(Module& module) {
+
+  for(Module::global_iterator it = module.global_begin(), 
+        ite = module.global_end();
+      it != ite; ++it) {
+      
+    GlobalVariable* gv = dyn_cast<GlobalVariable>(it);
+    if(gv) {
+      m_initial_globals[gv] = true;
+    }      
+  }
+}
+
+// Currently just a placeholder for functions introduced by us
+bool Nova::CheckIfFunctionOfInterest(Function* func) {
+
+  if(IsFuncDefSoftBound(func->getName()))
+    return false;
+
+  if(func->isDeclaration())
+    return false;
+
+
+  /* TODO: URGENT: Need to do base and bound propagation in variable
+   * argument functions
+   */
+#if 0
+  if(func.isVarArg())
+    return false;
+#endif
+
+  return true;
+}
+
+void Nova::IdentifyOriginalInst (Function * func) {
+
+  for(Function::iterator bb_begin = func->begin(), bb_end = func->end();
+      bb_begin != bb_end; ++bb_begin) {
+
+    for(BasicBlock::iterator i_begin = bb_begin->begin(),
+          i_end = bb_begin->end(); i_begin != i_end; ++i_begin){
+
+      Value* insn = dyn_cast<Value>(i_begin);
+      if(!m_present_in_original.count(insn)) {
+        m_present_in_original[insn] = 1;
+      }
+      else {
+        assert(0 && "present in original map already has the insn?");
+      }
+
+      if(isa<PointerType>(insn->getType())) {
+        if(!m_is_pointer.count(insn)){
+          m_is_pointer[insn] = 1;
+        }
+      }
+    } /* BasicBlock ends */
+  }/* Function ends */
+}
+
+bool Nova::CheckPtrsInST(StructType* struct_type){
+  
+  StructType::element_iterator I = struct_type->element_begin();
+
+  bool ptr_flag = false;
+  for(StructType::element_iterator E = struct_type->element_end(); I != E; ++I){
+    
+    Type* element_type = *I;
+
+    if(isa<StructType>(element_type)){
+      StructType* struct_element_type = dyn_cast<StructType>(element_type);
+      bool recursive_flag = CheckPtrsInST(struct_element_type);
+      ptr_flag = ptr_flag | recursive_flag;
+    }
+    if(isa<PointerType>(element_type)){
+      ptr_flag = true;
+    }
+    if(isa<ArrayType>(element_type)){
+      ptr_flag = true;      
+    }
+  }
+  return ptr_flag;
+}
+
+bool Nova::CheckTypeHasPtrs(Argument* ptr_argument){
+
+  if(!ptr_argument->hasByValAttr())
+    return false;
+
+  SequentialType* seq_type = dyn_cast<SequentialType>(ptr_argument->getType());
+  assert(seq_type && "byval attribute with non-sequential type pointer, not handled?");
+
+  StructType* struct_type = dyn_cast<StructType>(seq_type->getElementType());
+
+  if(struct_type){
+    bool has_ptrs = CheckPtrsInST(struct_type);
+    return has_ptrs;
+  }
+  else{
+    assert(0 && "non-struct byval parameters?");
+  }
+
+  // By default we assume any struct can return pointers 
+  return true;                                              
+
+}
+
+void Nova::HandleAlloca (AllocaInst* alloca_inst,
+                         BasicBlock* bb, 
+                         BasicBlock::iterator& i) {
+
+  Value *alloca_inst_value = alloca_inst;
+
+  /* Get the base type of the alloca object For alloca instructions,
+   * instructions need to inserted after the alloca instruction LLVM
+   * provides interface for inserting before.  So use the iterators
+   * and handle the case
+   */
+  
+  BasicBlock::iterator nextInst = i;
+  nextInst++;
+  Instruction* next = dyn_cast<Instruction>(nextInst);
+  assert(next && "Cannot increment the instruction iterator?");
+  
+  unsigned num_operands = alloca_inst->getNumOperands();
+  
+  /* For any alloca instruction, base is bitcast of alloca, bound is bitcast of alloca_ptr + 1
+   */
+  PointerType* ptr_type = PointerType::get(alloca_inst->getAllocatedType(), 0);
+  Type* ty1 = ptr_type;
+  //    Value* alloca_inst_temp_value = alloca_inst;
+  BitCastInst* ptr = new BitCastInst(alloca_inst, ty1, alloca_inst->getName(), next);
+  
+  Value* ptr_base = CastToVoidPtr(alloca_inst_value, next);
+  
+  Value* intBound;
+  
+  if(num_operands == 0) {
+      intBound = ConstantInt::get(Type::getInt64Ty(alloca_inst->getType()->getContext()), 1, false);
+  } else {
+    // What can be operand of alloca instruction?
+    intBound = alloca_inst->getOperand(0);
+  }
+
+  GetElementPtrInst* gep = GetElementPtrInst::Create(nullptr,
+  					                                 ptr,
+                                                     intBound,
+                                                     "mtmp",
+                                                     next);
+  Value *bound_ptr = gep;
+  
+  Value* ptr_bound = CastToVoidPtr(bound_ptr, next);
+  
+  AssociateBaseBound(alloca_inst_value, ptr_base, ptr_bound);
+}
+
+// 
+// Method: getNextInstruction
+// 
+// Description:
+// This method returns the next instruction after the input instruction.
+//
+
+Instruction* Nova::GetNextInstruction(Instruction* I){
+  
+  if (isa<TerminatorInst>(I)) {
+    return I;
+  } else {
+    BasicBlock::iterator BBI(I);
+    Instruction* temp = &*(++BBI);
+    return temp;
+  }    
+}
+
+void Nova::InsertMetadataLoad(LoadInst* load_inst){
+
+  AllocaInst* base_alloca;
+  AllocaInst* bound_alloca;
+
+  SmallVector<Value*, 8> args;
+
+  Value* load_inst_value = load_inst;
+  Value* pointer_operand = load_inst->getPointerOperand();
+  Instruction* load = load_inst;    
+  Instruction* insert_at = GetNextInstruction(load);
+
+  /* If the load returns a pointer, then load the base and bound
+   * from the shadow space
+   */
+  Value* pointer_operand_bitcast =  CastToVoidPtr(pointer_operand, insert_at);      
+  Instruction* first_inst_func = dyn_cast<Instruction>(load_inst->getParent()->getParent()->begin()->begin());
+  assert(first_inst_func && "function doesn't have any instruction and there is load???");
+  
+  /* address of pointer being pushed */
+  args.push_back(pointer_operand_bitcast);
+
+  base_alloca = new AllocaInst(m_void_ptr_type, "base.alloca", first_inst_func);
+  bound_alloca = new AllocaInst(m_void_ptr_type, "bound.alloca", first_inst_func);
+
+  /* base */
+  args.push_back(base_alloca);
+  /* bound */
+  args.push_back(bound_alloca);
+
+  CallInst::Create(m_load_base_bound_func, args, "", insert_at);
+
+  Instruction* base_load = new LoadInst(base_alloca, "base.load", insert_at);
+  Instruction* bound_load = new LoadInst(bound_alloca, "bound.load", insert_at);
+  AssociateBaseBound(load_inst_value, base_load, bound_load);
+}
+
+/* handleLoad Takes a load_inst If the load is through a pointer
+ * which is a global then inserts base and bound for that global
+ * Also if the loaded value is a pointer then loads the base and
+ * bound for for the pointer from the shadow space
+ */
+
+void Nova::HandleLoad(LoadInst* load_inst) { 
+
+
+  if(!isa<VectorType>(load_inst->getType()) && !isa<PointerType>(load_inst->getType())){
+    return;
+  }
+  
+  if(isa<PointerType>(load_inst->getType())){
+    InsertMetadataLoad(load_inst);
+    return;
+  }
+ 
+  if(isa<VectorType>(load_inst->getType())){
+    
+#if 0
+    if(!spatial_safety || !temporal_safety){
+      assert(0 && "Loading and Storing Pointers as a first-class types");            
+      return;
+    }
+
+#endif
+    
+    // It should be a vector if here
+    const VectorType* vector_ty = dyn_cast<VectorType>(load_inst->getType());
+    // Introduce a series of metadata loads and associated it pointers
+    if(!isa<PointerType>(vector_ty->getElementType()))
+       return;
+ 
+#if 0   
+    Value* load_inst_value = load_inst;
+    Instruction* load = load_inst;    
+#endif
+
+    Value* pointer_operand = load_inst->getPointerOperand();
+    Instruction* insert_at = GetNextInstruction(load_inst);
+        
+    Value* pointer_operand_bitcast =  CastToVoidPtr(pointer_operand, insert_at);      
+    Instruction* first_inst_func = dyn_cast<Instruction>(load_inst->getParent()->getParent()->begin()->begin());
+    assert(first_inst_func && "function doesn't have any instruction and there is load???");
+   
+    uint64_t num_elements = vector_ty->getNumElements();
+
+    
+    SmallVector<Value*, 8> vector_base;
+    SmallVector<Value*, 8> vector_bound;
+
+    for(uint64_t i = 0; i < num_elements; i++){
+      AllocaInst* base_alloca;
+      AllocaInst* bound_alloca;
+      
+      SmallVector<Value*, 8> args;
+      
+      args.push_back(pointer_operand_bitcast);
+      
+      base_alloca = new AllocaInst(m_void_ptr_type, "base.alloca", first_inst_func);
+      bound_alloca = new AllocaInst(m_void_ptr_type, "bound.alloca", first_inst_func);
+	 
+      /* base */
+      args.push_back(base_alloca);
+      /* bound */
+      args.push_back(bound_alloca);
+
+      Constant* index = ConstantInt::get(Type::getInt32Ty(load_inst->getContext()), i);
+
+      args.push_back(index);
+          
+      CallInst::Create(m_metadata_load_vector_func, args, "", insert_at);
+      
+      Instruction* base_load = new LoadInst(base_alloca, "base.load", insert_at);
+      Instruction* bound_load = new LoadInst(bound_alloca, "bound.load", insert_at);
+      
+      vector_base.push_back(base_load);
+      vector_bound.push_back(bound_load);
+    }
+    
+    if (num_elements > 2){
+      assert(0 && "Loading and Storing Pointers as a first-class types with more than 2 elements");      
+    }
+    
+    VectorType* metadata_ptr_type = VectorType::get(m_void_ptr_type, num_elements);
+    
+    Value *CV0 = ConstantInt::get(Type::getInt32Ty(load_inst->getContext()), 0);
+    Value *CV1 = ConstantInt::get(Type::getInt32Ty(load_inst->getContext()), 1);
+
+    Value* base_vector = InsertElementInst::Create(UndefValue::get(metadata_ptr_type),     vector_base[0],  CV0, "", insert_at);
+    Value* base_vector_final = InsertElementInst::Create(base_vector, vector_base[1], CV1, "", insert_at);
+  
+    m_vector_pointer_base[load_inst] = base_vector_final;
+
+    Value* bound_vector = InsertElementInst::Create(UndefValue::get(metadata_ptr_type),     vector_bound[0],  CV0, "", insert_at);
+    Value* bound_vector_final = InsertElementInst::Create(bound_vector, vector_bound[1], CV1, "", insert_at); 
+    m_vector_pointer_bound[load_inst] = bound_vector_final;
+
+    return;
+  }
+
+#if 0
+  if(unsafe_byval_opt && isByValDerived(load_inst->getOperand(0))) {
+
+    if(spatial_safety){
+      associateBaseBound(load_inst, m_void_null_ptr, m_infinite_bound_ptr);
+    }
+    if(temporal_safety){
+      Value* func_lock = getAssociatedFuncLock(load_inst);
+      associateKeyLock(load_inst, m_constantint64ty_one, func_lock);
+    }
+    return;
+  }
+#endif
+
+}
+
+//
+// Method: checkBaseBoundMetadataPresent()
+//
+// Description:
+// Checks if the metadata is present in the SoftBound/CETS maps.
+
+bool Nova::CheckBaseBoundMetadataPresent(Value* pointer_operand){
 
-    m_func_def_softbound["puts"] = true;
-    m_func_def_softbound["__softboundcets_intermediate"]= true;
-    m_func_def_softbound["__softboundcets_dummy"] = true;
-    m_func_def_softbound["__softboundcets_print_metadata"] = true;
-    m_func_def_softbound["__softboundcets_introspect_metadata"] = true;
-    m_func_def_softbound["__softboundcets_copy_metadata"] = true;
-    m_func_def_softbound["__softboundcets_allocate_shadow_stack_space"] = true;
-    m_func_def_softbound["__softboundcets_load_base_shadow_stack"] = true;
-    m_func_def_softbound["__softboundcets_load_bound_shadow_stack"] = true;
-    m_func_def_softbound["__softboundcets_load_key_shadow_stack"] = true;
-    m_func_def_softbound["__softboundcets_load_lock_shadow_stack"] = true;
-    m_func_def_softbound["__softboundcets_store_base_shadow_stack"] = true;      
-    m_func_def_softbound["__softboundcets_store_bound_shadow_stack"] = true;      
-    m_func_def_softbound["__softboundcets_store_key_shadow_stack"] = true;      
-    m_func_def_softbound["__softboundcets_store_lock_shadow_stack"] = true;      
-    m_func_def_softbound["__softboundcets_deallocate_shadow_stack_space"] = true;
+  if(m_pointer_base.count(pointer_operand) && 
+     m_pointer_bound.count(pointer_operand)){
+      return true;
+  }
+  return false;
+}
 
-    m_func_def_softbound["__softboundcets_trie_allocate"] = true;
-    m_func_def_softbound["__shrinkBounds"] = true;
-    m_func_def_softbound["__softboundcets_memcopy_check"] = true;
+//
+// Method: propagateMetadata
+//
+// Descripton;
+//
+// This function propagates the metadata from the source to the
+// destination in the map for pointer arithmetic operations~(gep) and
+// bitcasts. This is the place where we need to shrink bounds.
+//
 
-    m_func_def_softbound["__softboundcets_spatial_load_dereference_check"] = true;
+void Nova::PropagateMetadata(Value* pointer_operand, 
+                                      Instruction* inst, 
+                                      int instruction_type){
 
-    m_func_def_softbound["__softboundcets_spatial_store_dereference_check"] = true;
-    m_func_def_softbound["__softboundcets_spatial_call_dereference_check"] = true;
-    m_func_def_softbound["__softboundcets_temporal_load_dereference_check"] = true;
-    m_func_def_softbound["__softboundcets_temporal_store_dereference_check"] = true;
-    m_func_def_softbound["__softboundcets_stack_memory_allocation"] = true;
-    m_func_def_softbound["__softboundcets_memory_allocation"] = true;
-    m_func_def_softbound["__softboundcets_get_global_lock"] = true;
-    m_func_def_softbound["__softboundcets_add_to_free_map"] = true;
-    m_func_def_softbound["__softboundcets_check_remove_from_free_map"] = true;
-    m_func_def_softbound["__softboundcets_allocation_secondary_trie_allocate"] = true;
-    m_func_def_softbound["__softboundcets_allocation_secondary_trie_allocate_range"] = true;
-    m_func_def_softbound["__softboundcets_allocate_lock_location"] = true;
-    m_func_def_softbound["__softboundcets_memory_deallocation"] = true;
-    m_func_def_softbound["__softboundcets_stack_memory_deallocation"] = true;
+  // Need to just propagate the base and bound here if I am not
+  // shrinking bounds
+  if(CheckBaseBoundMetadataPresent(inst)){
+    // Metadata added to the map in the first pass
+    return;
+  }
 
-    m_func_def_softbound["__softboundcets_metadata_load_vector"] = true;
-    m_func_def_softbound["__softboundcets_metadata_store_vector"] = true;
-    
-    m_func_def_softbound["__softboundcets_metadata_load"] = true;
-    m_func_def_softbound["__softboundcets_metadata_store"] = true;
-    m_func_def_softbound["__hashProbeAddrOfPtr"] = true;
-    m_func_def_softbound["__memcopyCheck"] = true;
-    m_func_def_softbound["__memcopyCheck_i64"] = true;
+  if(isa<ConstantPointerNull>(pointer_operand)) {
+    AssociateBaseBound(inst, m_void_null_ptr, m_void_null_ptr);
+    return;
+  }
 
-    m_func_def_softbound["__softboundcets_global_init"] = true;      
-    m_func_def_softbound["__softboundcets_init"] = true;      
-    m_func_def_softbound["__softboundcets_abort"] = true;      
-    m_func_def_softbound["__softboundcets_printf"] = true;
-    
-    m_func_def_softbound["__softboundcets_stub"] = true;
-    m_func_def_softbound["safe_mmap"] = true;
-    m_func_def_softbound["safe_calloc"] = true;
-    m_func_def_softbound["safe_malloc"] = true;
-    m_func_def_softbound["safe_free"] = true;
+  if (CheckBaseBoundMetadataPresent(pointer_operand)) {
+    Value* tmp_base = GetAssociatedBase(pointer_operand); 
+    Value* tmp_bound = GetAssociatedBound(pointer_operand);       
+    AssociateBaseBound(inst, tmp_base, tmp_bound);
+  } else{
+    if(isa<Constant>(pointer_operand)) {
+      
+      Value* tmp_base = NULL;
+      Value* tmp_bound = NULL;
+      Constant* given_constant = dyn_cast<Constant>(pointer_operand);
+      GetConstantExprBaseBound(given_constant, tmp_base, tmp_bound);
+      assert(tmp_base && "gep with cexpr and base null?");
+      assert(tmp_bound && "gep with cexpr and bound null?");
+      tmp_base = CastToVoidPtr(tmp_base, inst);
+      tmp_bound = CastToVoidPtr(tmp_bound, inst);        
+  
+      AssociateBaseBound(inst, tmp_base, tmp_bound);
+    } // Constant case ends here
+    // Could be in the first pass, do nothing here
+  }
+}
 
-    m_func_def_softbound["__assert_fail"] = true;
-    m_func_def_softbound["assert"] = true;
-    m_func_def_softbound["__strspn_c2"] = true;
-    m_func_def_softbound["__strcspn_c2"] = true;
-    m_func_def_softbound["__strtol_internal"] = true;
-    m_func_def_softbound["__stroul_internal"] = true;
-    m_func_def_softbound["ioctl"] = true;
-    m_func_def_softbound["error"] = true;
-    m_func_def_softbound["__strtod_internal"] = true;
-    m_func_def_softbound["__strtoul_internal"] = true;
+void Nova::HandleGEP(GetElementPtrInst* gep_inst) {
+  Value* getelementptr_operand = gep_inst->getPointerOperand();
+  PropagateMetadata(getelementptr_operand, gep_inst, SBCETS_GEP);
+}
+
+//
+// Method: handleBitCast
+//
+// Description: Propagate metadata from source to destination with
+// pointer bitcast operations.
+
+void Nova::HandleBitCast(BitCastInst* bitcast_inst) {
+
+  Value* pointer_operand = bitcast_inst->getOperand(0);  
+  PropagateMetadata(pointer_operand, bitcast_inst, SBCETS_BITCAST);
+}
+
+//
+// The metadata propagation for PHINode occurs in two passes. In the
+// first pass, SoftBound/CETS transformation just creates the metadata
+// PHINodes and records it in the maps maintained by
+// SoftBound/CETS. In the second pass, it populates the incoming
+// values of the PHINodes. This two pass approach ensures that every
+// incoming value of the original PHINode will have metadata in the
+// SoftBound/CETS maps
+// 
+
+//
+// Method: handlePHIPass1()
+//
+// Description:
+//
+// This function creates a PHINode for the metadata in the bitcode for
+// pointer PHINodes. It is important to note that this function just
+// creates the PHINode and does not populate the incoming values of
+// the PHINode, which is handled by the handlePHIPass2.
+//
+
+void Nova::HandlePHIPass1(PHINode* phi_node) {
+
+  // Not a Pointer PHINode, then just return
+  if (!isa<PointerType>(phi_node->getType()))
+    return;
+
+  unsigned num_incoming_values = phi_node->getNumIncomingValues();
+
+  PHINode* base_phi_node = PHINode::Create(m_void_ptr_type,
+                                           num_incoming_values,
+                                           "phi.base",
+                                           phi_node);
+  
+  PHINode* bound_phi_node = PHINode::Create(m_void_ptr_type, 
+                                            num_incoming_values,
+                                            "phi.bound", 
+                                            phi_node);
+  
+  Value* base_phi_node_value = base_phi_node;
+  Value* bound_phi_node_value = bound_phi_node;
+  
+  AssociateBaseBound(phi_node, base_phi_node_value, bound_phi_node_value);
+}
+
+void Nova::AddMemcopyMemsetCheck(CallInst* call_inst, Function* called_func) {
+  SmallVector<Value*, 8> args;
+
+  if(called_func->getName().find("llvm.memcpy") == 0 || 
+     called_func->getName().find("llvm.memmove") == 0){
+
+    CallSite cs(call_inst);
+
+    Value* dest_ptr = cs.getArgument(0);
+    Value* src_ptr  = cs.getArgument(1);
+    Value* size_ptr = cs.getArgument(2);
     
+    args.push_back(dest_ptr);
+    args.push_back(src_ptr);
+
+    Value* cast_size_ptr = size_ptr;
+    if(size_ptr->getType() != m_key_type){
+      BitCastInst* bitcast = new BitCastInst(size_ptr, m_key_type, "", call_inst);
+      cast_size_ptr = bitcast;
+    }
+
+    args.push_back(cast_size_ptr);
+
+    Value* dest_base = GetAssociatedBase(dest_ptr);
+    Value* dest_bound =GetAssociatedBound(dest_ptr);
     
-    m_func_def_softbound["fflush_unlocked"] = true;
-    m_func_def_softbound["full_write"] = true;
-    m_func_def_softbound["safe_read"] = true;
-    m_func_def_softbound["_IO_getc"] = true;
-    m_func_def_softbound["_IO_putc"] = true;
-    m_func_def_softbound["__xstat"] = true;
+    Value* src_base = GetAssociatedBase(src_ptr);
+    Value* src_bound = GetAssociatedBound(src_ptr);
 
-    m_func_def_softbound["select"] = true;
-    m_func_def_softbound["_setjmp"] = true;
-    m_func_def_softbound["longjmp"] = true;
-    m_func_def_softbound["fork"] = true;
-    m_func_def_softbound["pipe"] = true;
-    m_func_def_softbound["dup2"] = true;
-    m_func_def_softbound["execv"] = true;
-    m_func_def_softbound["compare_pic_by_pic_num_desc"] = true;
-     
-    m_func_def_softbound["wprintf"] = true;
-    m_func_def_softbound["vfprintf"] = true;
-    m_func_def_softbound["vsprintf"] = true;
-    m_func_def_softbound["fprintf"] = true;
-    m_func_def_softbound["printf"] = true;
-    m_func_def_softbound["sprintf"] = true;
-    m_func_def_softbound["snprintf"] = true;
+    args.push_back(dest_base);
+    args.push_back(dest_bound);
+    
+    args.push_back(src_base);
+    args.push_back(src_bound);
 
-    m_func_def_softbound["scanf"] = true;
-    m_func_def_softbound["fscanf"] = true;
-    m_func_def_softbound["sscanf"] = true;   
+    CallInst::Create(m_memcopy_check, args, "", call_inst);
+    return;
+  }
 
-    m_func_def_softbound["asprintf"] = true;
-    m_func_def_softbound["vasprintf"] = true;
-    m_func_def_softbound["__fpending"] = true;
-    m_func_def_softbound["fcntl"] = true;
+  if(called_func->getName().find("llvm.memset") == 0){
 
-    m_func_def_softbound["vsnprintf"] = true;
-    m_func_def_softbound["fwrite_unlocked"] = true;
-    m_func_def_softbound["__overflow"] = true;
-    m_func_def_softbound["__uflow"] = true;
-    m_func_def_softbound["execlp"] = true;
-    m_func_def_softbound["execl"] = true;
-    m_func_def_softbound["waitpid"] = true;
-    m_func_def_softbound["dup"] = true;
-    m_func_def_softbound["setuid"] = true;
-    
-    m_func_def_softbound["_exit"] = true;
-    m_func_def_softbound["funlockfile"] = true;
-    m_func_def_softbound["flockfile"] = true;
+    args.clear();
+    CallSite cs(call_inst);
+    Value* dest_ptr = cs.getArgument(0);
+    // Whats cs.getArgrument(1) return? Why am I not using it?
+    Value* size_ptr = cs.getArgument(2);
 
-    m_func_def_softbound["__option_is_short"] = true;
+    Value* cast_size_ptr = size_ptr;
+    assert(size_ptr != NULL);
+
+    if(size_ptr->getType() != m_key_type){
+      BitCastInst* bitcast = new BitCastInst(size_ptr, m_key_type, "", call_inst);
+      cast_size_ptr = bitcast;
+    }
+
+    args.push_back(dest_ptr);
+    args.push_back(cast_size_ptr);
     
+    Value* dest_base = GetAssociatedBase(dest_ptr);
+    Value* dest_bound = GetAssociatedBound(dest_ptr);
+    args.push_back(dest_base);
+    args.push_back(dest_bound);   
 
+    CallInst::Create(m_memset_check, args, "", call_inst);
+    return;
   }
+}
 
-  // Is the function name in the above list?
-  if (m_func_def_softbound.count(str) > 0) {
-    return true;
-  }
+void Nova::HandleMemcpy(CallInst* call_inst){
+  Function* func = call_inst->getCalledFunction();
+  if(!func)
+    return;
 
-  // FIXME: handling new intrinsics which have isoc99 in their name
-  if (str.find("isoc99") != std::string::npos){
-    return true;
-  }
+  assert(func && "function is null?");
 
-  // If the function is an llvm intrinsic, don't transform it
-  if (str.find("llvm.") == 0) {
-    return true;
+  CallSite cs(call_inst);
+  Value* arg1 = cs.getArgument(0);
+  Value* arg2 = cs.getArgument(1);
+  Value* arg3 = cs.getArgument(2);
+
+  SmallVector<Value*, 8> args;
+  args.push_back(arg1);
+  args.push_back(arg2);
+  args.push_back(arg3);
+
+  if(arg3->getType() == Type::getInt64Ty(arg3->getContext())){
+    CallInst::Create(m_copy_metadata, args, "", call_inst);
+  }
+  else{
+    //    CallInst::Create(m_copy_metadata, args, "", call_inst);
   }
+  args.clear();
 
-  return false;
+#if 0
+
+  Value* arg1_base = castToVoidPtr(getAssociatedBase(arg1), call_inst);
+  Value* arg1_bound = castToVoidPtr(getAssociatedBound(arg1), call_inst);
+  Value* arg2_base = castToVoidPtr(getAssociatedBase(arg2), call_inst);
+  Value* arg2_bound = castToVoidPtr(getAssociatedBound(arg2), call_inst);
+  args.push_back(arg1);
+  args.push_back(arg1_base);
+  args.push_back(arg1_bound);
+  args.push_back(arg2);
+  args.push_back(arg2_base);
+  args.push_back(arg2_bound);
+  args.push_back(arg3);
+
+  CallInst::Create(m_memcopy_check,args.begin(), args.end(), "", call_inst);
+
+#endif
+  return;
+    
 }
 
 //
-// Method: hasPtrArgRetType()
-//
-// Description:
-//
-// This function checks if the function has either pointer arguments
-// or returns a pointer value. This function is used to determine
-// whether shadow stack loads/stores need to be introduced for
-// metadata propagation.
+// Method: introduceShadowStackAllocation
 //
+// Description: For every function call that has a pointer argument or
+// a return value, shadow stack is used to propagate metadata. This
+// function inserts the shadow stack allocation C-handler that
+// reserves space in the shadow stack by reserving the requiste amount
+// of space based on the input passed to it(number of pointer
+// arguments/return).
 
-bool Nova::HasPtrArgRetType(Function* func) {
-   
-  const Type* ret_type = func->getReturnType();
-  if (isa<PointerType>(ret_type))
-    return true;
 
-  for (Function::arg_iterator i = func->arg_begin(), e = func->arg_end(); 
-      i != e; ++i) {
-      
-    if (isa<PointerType>(i->getType()))
-      return true;
-  }
-  return false;
+void Nova::IntroduceShadowStackAllocation(CallInst* call_inst){
+    
+  // Count the number of pointer arguments and whether a pointer return     
+  int pointer_args_return = GetNumPointerArgsAndReturn(call_inst);
+  if(pointer_args_return == 0)
+    return;
+  Value* total_ptr_args;    
+  total_ptr_args = 
+    ConstantInt::get(Type::getInt32Ty(call_inst->getType()->getContext()), 
+                     pointer_args_return, false);
+
+  SmallVector<Value*, 8> args;
+  args.push_back(total_ptr_args);
+  CallInst::Create(m_shadow_stack_allocate, args, "", call_inst);
 }
 
-// 
-// Method: identifyFuncToTrans
 //
-// Description: This function traverses the module and identifies the
-// functions that need to be transformed by SoftBound/CETS
+// Method: introduceShadowStackStores
 //
+// Description: This function inserts a call to the shadow stack store
+// C-handler that stores the metadata, before the function call in the
+// bitcode for pointer arguments.
 
-void Nova::IdentifyFuncToTrans(Module& module) {
-    
-  for (Module::iterator fb_it = module.begin(), fe_it = module.end(); 
-      fb_it != fe_it; ++fb_it) {
-
-    Function* func = dyn_cast<Function>(fb_it);
-    assert(func && " Not a function");
+void Nova::IntroduceShadowStackStores(Value* ptr_value, 
+                                              Instruction* insert_at, 
+                                              int arg_no){
+  if(!isa<PointerType>(ptr_value->getType()))
+    return;
 
-    // Check if the function is defined in the module
-    if (!func->isDeclaration()) {
-      if (IsFuncDefSoftBound(func->getName())) 
-        continue;
-      
-      m_func_softboundcets_transform[func->getName()] = true;
-      if (HasPtrArgRetType(func)) {
-        m_func_to_transform[func->getName()] = true;
-      }
-    }
-  }
-}
+  Value* argno_value;    
+  argno_value = 
+    ConstantInt::get(Type::getInt32Ty(ptr_value->getType()->getContext()), 
+                     arg_no, false);
 
-/* Identify the initial globals present in the program before we add
- * extra base and bound for all globals
- */
-void Nova::IdentifyInitialGlobals(Module& module) {
+  Value* ptr_base = GetAssociatedBase(ptr_value);
+  Value* ptr_bound = GetAssociatedBound(ptr_value);
+  
+  Value* ptr_base_cast = CastToVoidPtr(ptr_base, insert_at);
+  Value* ptr_bound_cast = CastToVoidPtr(ptr_bound, insert_at);
 
-  for(Module::global_iterator it = module.global_begin(), 
-        ite = module.global_end();
-      it != ite; ++it) {
-      
-    GlobalVariable* gv = dyn_cast<GlobalVariable>(it);
-    if(gv) {
-      m_initial_globals[gv] = true;
-    }      
-  }
+  SmallVector<Value*, 8> args;
+  args.push_back(ptr_base_cast);
+  args.push_back(argno_value);
+  CallInst::Create(m_shadow_stack_base_store, args, "", insert_at);
+  
+  args.clear();
+  args.push_back(ptr_bound_cast);
+  args.push_back(argno_value);
+  CallInst::Create(m_shadow_stack_bound_store, args, "", insert_at);    
 }
 
-// Currently just a placeholder for functions introduced by us
-bool Nova::CheckIfFunctionOfInterest(Function* func) {
+//
+// Method: introduceShadowStackDeallocation
+//
+// Description: This function inserts a call to the C-handler that
+// deallocates the shadow stack space on function exit.
+  
 
-  if(IsFuncDefSoftBound(func->getName()))
-    return false;
+void Nova::IntroduceShadowStackDeallocation(CallInst* call_inst, Instruction* insert_at){
 
-  if(func->isDeclaration())
-    return false;
+  int pointer_args_return = GetNumPointerArgsAndReturn(call_inst);
+  if(pointer_args_return == 0)
+    return;
+  SmallVector<Value*, 8> args;    
+  CallInst::Create(m_shadow_stack_deallocate, args, "", insert_at);
+}
 
+//
+// Method: getNumPointerArgsAndReturn
+//
+// Description: Returns the number of pointer arguments and return.
+//
+int Nova::GetNumPointerArgsAndReturn(CallInst* call_inst){
 
-  /* TODO: URGENT: Need to do base and bound propagation in variable
-   * argument functions
-   */
-#if 0
-  if(func.isVarArg())
-    return false;
-#endif
+  int total_pointer_count = 0;
+  CallSite cs(call_inst);
+  for(unsigned i = 0; i < cs.arg_size(); i++){
+    Value* arg_value = cs.getArgument(i);
+    if(isa<PointerType>(arg_value->getType())){
+      total_pointer_count++;
+    }
+  }
 
-  return true;
+  if (total_pointer_count != 0) {
+    // Reserve one for the return address if it has atleast one
+    // pointer argument 
+    total_pointer_count++;
+  } else{
+    // Increment the pointer arg return if the call instruction
+    // returns a pointer
+    if(isa<PointerType>(call_inst->getType())){
+      total_pointer_count++;
+    }
+  }
+  return total_pointer_count;
 }
 
-void Nova::IdentifyOriginalInst (Function * func) {
-
-  for(Function::iterator bb_begin = func->begin(), bb_end = func->end();
-      bb_begin != bb_end; ++bb_begin) {
-
-    for(BasicBlock::iterator i_begin = bb_begin->begin(),
-          i_end = bb_begin->end(); i_begin != i_end; ++i_begin){
-
-      Value* insn = dyn_cast<Value>(i_begin);
-      if(!m_present_in_original.count(insn)) {
-        m_present_in_original[insn] = 1;
-      }
-      else {
-        assert(0 && "present in original map already has the insn?");
-      }
+// 
+// Method: introduceShadowStackLoads
+//
+// Description: This function introduces calls to the C-handlers that
+// performs the loads from the shadow stack to retrieve the metadata.
+// This function also associates the loaded metadata with the pointer
+// arguments in the SoftBound/CETS maps.
 
-      if(isa<PointerType>(insn->getType())) {
-        if(!m_is_pointer.count(insn)){
-          m_is_pointer[insn] = 1;
-        }
-      }
-    } /* BasicBlock ends */
-  }/* Function ends */
+void Nova::IntroduceShadowStackLoads(Value* ptr_value, 
+                                             Instruction* insert_at, 
+                                             int arg_no){
+    
+  if (!isa<PointerType>(ptr_value->getType()))
+    return;
+      
+  Value* argno_value;    
+  argno_value = 
+    ConstantInt::get(Type::getInt32Ty(ptr_value->getType()->getContext()), 
+                     arg_no, false);
+    
+  SmallVector<Value*, 8> args;
+  args.clear();
+  args.push_back(argno_value);
+  Value* base = CallInst::Create(m_shadow_stack_base_load, args, "", 
+                                 insert_at);    
+  args.clear();
+  args.push_back(argno_value);
+  Value* bound = CallInst::Create(m_shadow_stack_bound_load, args, "", 
+                                  insert_at);
+  AssociateBaseBound(ptr_value, base, bound);
 }
 
-bool Nova::CheckPtrsInST(StructType* struct_type){
-  
-  StructType::element_iterator I = struct_type->element_begin();
+void Nova::IterateCallSiteIntroduceShadowStackStores(CallInst* call_inst){
+    
+  int pointer_args_return = GetNumPointerArgsAndReturn(call_inst);
 
-  bool ptr_flag = false;
-  for(StructType::element_iterator E = struct_type->element_end(); I != E; ++I){
+  if(pointer_args_return == 0)
+    return;
     
-    Type* element_type = *I;
+  int pointer_arg_no = 1;
 
-    if(isa<StructType>(element_type)){
-      StructType* struct_element_type = dyn_cast<StructType>(element_type);
-      bool recursive_flag = CheckPtrsInST(struct_element_type);
-      ptr_flag = ptr_flag | recursive_flag;
-    }
-    if(isa<PointerType>(element_type)){
-      ptr_flag = true;
-    }
-    if(isa<ArrayType>(element_type)){
-      ptr_flag = true;      
+  CallSite cs(call_inst);
+  for(unsigned i = 0; i < cs.arg_size(); i++){
+    Value* arg_value = cs.getArgument(i);
+    if(isa<PointerType>(arg_value->getType())){
+      IntroduceShadowStackStores(arg_value, call_inst, pointer_arg_no);
+      pointer_arg_no++;
     }
-  }
-  return ptr_flag;
+  }    
 }
 
-bool Nova::CheckTypeHasPtrs(Argument* ptr_argument){
-
-  if(!ptr_argument->hasByValAttr())
-    return false;
+void Nova::HandleCallInst(CallInst* call_inst) {
+  // Function* func = call_inst->getCalledFunction();
+  Value* mcall = call_inst;
 
-  SequentialType* seq_type = dyn_cast<SequentialType>(ptr_argument->getType());
-  assert(seq_type && "byval attribute with non-sequential type pointer, not handled?");
+#if 0
+  CallingConv::ID id = call_inst->getCallingConv();
 
-  StructType* struct_type = dyn_cast<StructType>(seq_type->getElementType());
 
-  if(struct_type){
-    bool has_ptrs = CheckPtrsInST(struct_type);
-    return has_ptrs;
+  if(id == CallingConv::Fast){
+    printf("fast calling convention not handled\n");
+    exit(1);
   }
-  else{
-    assert(0 && "non-struct byval parameters?");
+#endif 
+    
+  Function* func = call_inst->getCalledFunction();
+  if(func && ((func->getName().find("llvm.memcpy") == 0) || 
+              (func->getName().find("llvm.memmove") == 0))){
+    AddMemcopyMemsetCheck(call_inst, func);
+    HandleMemcpy(call_inst);
+    return;
   }
 
-  // By default we assume any struct can return pointers 
-  return true;                                              
+  if(func && func->getName().find("llvm.memset") == 0){
+    AddMemcopyMemsetCheck(call_inst, func);
+  }
 
-}
+  if(func && IsFuncDefSoftBound(func->getName())){
+    if(!isa<PointerType>(call_inst->getType())){
+      return;
+    }
+    
+    AssociateBaseBound(call_inst, m_void_null_ptr, m_void_null_ptr);
+    return;
+  }
 
-void Nova::HandleAlloca (AllocaInst* alloca_inst,
-                         BasicBlock* bb, 
-                         BasicBlock::iterator& i) {
+  Instruction* insert_at = GetNextInstruction(call_inst);
+  //  call_inst->setCallingConv(CallingConv::C);
 
-  Value *alloca_inst_value = alloca_inst;
+  IntroduceShadowStackAllocation(call_inst);
+  IterateCallSiteIntroduceShadowStackStores(call_inst);
+    
+  if(isa<PointerType>(mcall->getType())) {
 
-  /* Get the base type of the alloca object For alloca instructions,
-   * instructions need to inserted after the alloca instruction LLVM
-   * provides interface for inserting before.  So use the iterators
-   * and handle the case
-   */
-  
-  BasicBlock::iterator nextInst = i;
-  nextInst++;
-  Instruction* next = dyn_cast<Instruction>(nextInst);
-  assert(next && "Cannot increment the instruction iterator?");
-  
-  unsigned num_operands = alloca_inst->getNumOperands();
-  
-  /* For any alloca instruction, base is bitcast of alloca, bound is bitcast of alloca_ptr + 1
-   */
-  PointerType* ptr_type = PointerType::get(alloca_inst->getAllocatedType(), 0);
-  Type* ty1 = ptr_type;
-  //    Value* alloca_inst_temp_value = alloca_inst;
-  BitCastInst* ptr = new BitCastInst(alloca_inst, ty1, alloca_inst->getName(), next);
-  
-  Value* ptr_base = CastToVoidPtr(alloca_inst_value, next);
-  
-  Value* intBound;
-  
-  if(num_operands == 0) {
-      intBound = ConstantInt::get(Type::getInt64Ty(alloca_inst->getType()->getContext()), 1, false);
-  } else {
-    // What can be operand of alloca instruction?
-    intBound = alloca_inst->getOperand(0);
+      /* ShadowStack for the return value is 0 */
+      IntroduceShadowStackLoads(call_inst, insert_at, 0);       
   }
-
-  GetElementPtrInst* gep = GetElementPtrInst::Create(nullptr,
-  					                                 ptr,
-                                                     intBound,
-                                                     "mtmp",
-                                                     next);
-  Value *bound_ptr = gep;
-  
-  Value* ptr_bound = CastToVoidPtr(bound_ptr, next);
-  
-  AssociateBaseBound(alloca_inst_value, ptr_base, ptr_bound);
+  IntroduceShadowStackDeallocation(call_inst,insert_at);
 }
 
-// 
-// Method: getNextInstruction
-// 
-// Description:
-// This method returns the next instruction after the input instruction.
 //
+// Method: handleSelect
+//
+// This function propagates the metadata with Select IR instruction.
+// Select  instruction is also handled in two passes.
 
-Instruction* Nova::GetNextInstruction(Instruction* I){
-  
-  if (isa<TerminatorInst>(I)) {
-    return I;
-  } else {
-    BasicBlock::iterator BBI(I);
-    Instruction* temp = &*(++BBI);
-    return temp;
-  }    
-}
-
-void Nova::InsertMetadataLoad(LoadInst* load_inst){
-
-  AllocaInst* base_alloca;
-  AllocaInst* bound_alloca;
-
-  SmallVector<Value*, 8> args;
-
-  Value* load_inst_value = load_inst;
-  Value* pointer_operand = load_inst->getPointerOperand();
-  Instruction* load = load_inst;    
-  Instruction* insert_at = GetNextInstruction(load);
-
-  /* If the load returns a pointer, then load the base and bound
-   * from the shadow space
-   */
-  Value* pointer_operand_bitcast =  CastToVoidPtr(pointer_operand, insert_at);      
-  Instruction* first_inst_func = dyn_cast<Instruction>(load_inst->getParent()->getParent()->begin()->begin());
-  assert(first_inst_func && "function doesn't have any instruction and there is load???");
-  
-  /* address of pointer being pushed */
-  args.push_back(pointer_operand_bitcast);
+void Nova::HandleSelect(SelectInst* select_ins, int pass) {
 
-  base_alloca = new AllocaInst(m_void_ptr_type, "base.alloca", first_inst_func);
-  bound_alloca = new AllocaInst(m_void_ptr_type, "bound.alloca", first_inst_func);
+  if (!isa<PointerType>(select_ins->getType())) 
+    return;
+    
+  Value* condition = select_ins->getOperand(0);
+  Value* operand_base[2];
+  Value* operand_bound[2];    
 
-  /* base */
-  args.push_back(base_alloca);
-  /* bound */
-  args.push_back(bound_alloca);
+  for(unsigned m = 0; m < 2; m++) {
+    Value* operand = select_ins->getOperand(m+1);
 
-  CallInst::Create(m_load_base_bound_func, args, "", insert_at);
+    operand_base[m] = NULL;
+    operand_bound[m] = NULL;
 
-  Instruction* base_load = new LoadInst(base_alloca, "base.load", insert_at);
-  Instruction* bound_load = new LoadInst(bound_alloca, "bound.load", insert_at);
-  AssociateBaseBound(load_inst_value, base_load, bound_load);
+    if (CheckBaseBoundMetadataPresent(operand)) {      
+      operand_base[m] = GetAssociatedBase(operand);
+      operand_bound[m] = GetAssociatedBound(operand);
+    }
+    
+    if (isa<ConstantPointerNull>(operand) && 
+        !CheckBaseBoundMetadataPresent(operand)) {            
+      operand_base[m] = m_void_null_ptr;
+      operand_bound[m] = m_void_null_ptr;
+    }        
+      
+    Constant* given_constant = dyn_cast<Constant>(operand);
+    if(given_constant) {
+      GetConstantExprBaseBound(given_constant, 
+                               operand_base[m], 
+                               operand_bound[m]);     
+    }    
+    assert(operand_base[m] != NULL && 
+           "operand doesn't have base with select?");
+    assert(operand_bound[m] != NULL && 
+           "operand doesn't have bound with select?");
+    
+    // Introduce a bit cast if the types don't match 
+    if (operand_base[m]->getType() != m_void_ptr_type) {          
+      operand_base[m] = new BitCastInst(operand_base[m], m_void_ptr_type,
+                                        "select.base", select_ins);          
+    }
+    
+    if (operand_bound[m]->getType() != m_void_ptr_type) {
+      operand_bound[m] = new BitCastInst(operand_bound[m], m_void_ptr_type,
+                                         "select_bound", select_ins);
+    }
+  } // for loop ends
+    
+    SelectInst* select_base = SelectInst::Create(condition, 
+                                                 operand_base[0], 
+                                                 operand_base[1], 
+                                                 "select.base",
+                                                 select_ins);
+    
+    SelectInst* select_bound = SelectInst::Create(condition, 
+                                                  operand_bound[0], 
+                                                  operand_bound[1], 
+                                                  "select.bound",
+                                                  select_ins);
+    AssociateBaseBound(select_ins, select_base, select_bound);
 }
 
-/* handleLoad Takes a load_inst If the load is through a pointer
- * which is a global then inserts base and bound for that global
- * Also if the loaded value is a pointer then loads the base and
- * bound for for the pointer from the shadow space
- */
+void Nova::HandleIntToPtr(IntToPtrInst* inttoptrinst) {
+    
+  Value* inst = inttoptrinst;
+    
+  AssociateBaseBound(inst, m_void_null_ptr, m_void_null_ptr);
+}
 
-void Nova::HandleLoad(LoadInst* load_inst) { 
+//
+// Method: handleReturnInst
+//
+// Description: 
+// This function inserts C-handler calls to store
+// metadata for return values in the shadow stack.
 
+void Nova::HandleReturnInst(ReturnInst* ret){
 
-  if(!isa<VectorType>(load_inst->getType()) && !isa<PointerType>(load_inst->getType())){
+  Value* pointer = ret->getReturnValue();
+  if(pointer == NULL){
     return;
   }
-  
-  if(isa<PointerType>(load_inst->getType())){
-    InsertMetadataLoad(load_inst);
-    return;
+  if(isa<PointerType>(pointer->getType())){
+    IntroduceShadowStackStores(pointer, ret, 0);
   }
- 
-  if(isa<VectorType>(load_inst->getType())){
+}
+
+void Nova::HandleExtractElement(ExtractElementInst* EEI){
+  
+  if(!isa<PointerType>(EEI->getType()))
+     return;
+  
+  Value* EEIOperand = EEI->getOperand(0);
+  
+  if(isa<VectorType>(EEIOperand->getType())){
     
-#if 0
-    if(!spatial_safety || !temporal_safety){
-      assert(0 && "Loading and Storing Pointers as a first-class types");            
-      return;
+    if(!m_vector_pointer_base.count(EEIOperand) ||
+       !m_vector_pointer_bound.count(EEIOperand)){
+      assert(0 && "Extract element does not have vector metadata");
     }
 
-#endif
+    Constant* index = dyn_cast<Constant>(EEI->getOperand(1));
     
-    // It should be a vector if here
-    const VectorType* vector_ty = dyn_cast<VectorType>(load_inst->getType());
-    // Introduce a series of metadata loads and associated it pointers
-    if(!isa<PointerType>(vector_ty->getElementType()))
-       return;
- 
-#if 0   
-    Value* load_inst_value = load_inst;
-    Instruction* load = load_inst;    
-#endif
+    Value* vector_base = m_vector_pointer_base[EEIOperand];
+    Value* vector_bound = m_vector_pointer_bound[EEIOperand];
+    
+    Value* ptr_base = ExtractElementInst::Create(vector_base, index, "", EEI);
+    Value* ptr_bound = ExtractElementInst::Create(vector_bound, index, "", EEI);
+    
+    AssociateBaseBound(EEI, ptr_base, ptr_bound);
+    return;
+  }
+     
+  assert (0 && "ExtractElement is returning a pointer, possibly some vectorization going on, not handled, try running with O0 or O1 or O2");    
+}
 
-    Value* pointer_operand = load_inst->getPointerOperand();
-    Instruction* insert_at = GetNextInstruction(load_inst);
-        
-    Value* pointer_operand_bitcast =  CastToVoidPtr(pointer_operand, insert_at);      
-    Instruction* first_inst_func = dyn_cast<Instruction>(load_inst->getParent()->getParent()->begin()->begin());
-    assert(first_inst_func && "function doesn't have any instruction and there is load???");
-   
-    uint64_t num_elements = vector_ty->getNumElements();
+void Nova::HandleExtractValue(ExtractValueInst* EVI){
+    if(isa<PointerType>(EVI->getType())){
+        assert(0 && "ExtractValue is returning a pointer, possibly some vectorization going on, not handled, try running with O0 or O1 or O2");
+    }
+  
+    AssociateBaseBound(EVI, m_void_null_ptr, m_infinite_bound_ptr);
 
+  return;  
+}
+
+void Nova::GatherBaseBoundPass1 (Function * func) {
+  int arg_count= 0;
     
-    SmallVector<Value*, 8> vector_base;
-    SmallVector<Value*, 8> vector_bound;
+  //    std::cerr<<"transforming function with name:"<<func->getName()<< "\n";
+  /* Scan over the pointer arguments and introduce base and bound */
 
-    for(uint64_t i = 0; i < num_elements; i++){
-      AllocaInst* base_alloca;
-      AllocaInst* bound_alloca;
-      
-      SmallVector<Value*, 8> args;
-      
-      args.push_back(pointer_operand_bitcast);
-      
-      base_alloca = new AllocaInst(m_void_ptr_type, "base.alloca", first_inst_func);
-      bound_alloca = new AllocaInst(m_void_ptr_type, "bound.alloca", first_inst_func);
-	 
-      /* base */
-      args.push_back(base_alloca);
-      /* bound */
-      args.push_back(bound_alloca);
+  for(Function::arg_iterator ib = func->arg_begin(), ie = func->arg_end();
+      ib != ie; ++ib) {
 
-      Constant* index = ConstantInt::get(Type::getInt32Ty(load_inst->getContext()), i);
+    if(!isa<PointerType>(ib->getType())) 
+      continue;
 
-      args.push_back(index);
-          
-      CallInst::Create(m_metadata_load_vector_func, args, "", insert_at);
+    /* it is a pointer, so increment the arg count */
+    arg_count++;
+
+    Argument* ptr_argument = dyn_cast<Argument>(ib);
+    Value* ptr_argument_value = ptr_argument;
+    //Instruction* fst_inst = &*(func->begin()->begin());
       
-      Instruction* base_load = new LoadInst(base_alloca, "base.load", insert_at);
-      Instruction* bound_load = new LoadInst(bound_alloca, "bound.load", insert_at);
+    /* Urgent: Need to think about what we need to do about byval attributes */
+    if(ptr_argument->hasByValAttr()){
       
-      vector_base.push_back(base_load);
-      vector_bound.push_back(bound_load);
+      if(CheckTypeHasPtrs(ptr_argument)){
+        assert(0 && "Pointer argument has byval attributes and the underlying structure returns pointers");
+      }
+      
+      AssociateBaseBound(ptr_argument_value, m_void_null_ptr, m_infinite_bound_ptr);
     }
-    
-    if (num_elements > 2){
-      assert(0 && "Loading and Storing Pointers as a first-class types with more than 2 elements");      
+    else{
+      // TODOO: don't know what byval attributes means here.
+      // introduceShadowStackLoads(ptr_argument_value, fst_inst, arg_count);
+      //      introspectMetadata(func, ptr_argument_value, fst_inst, arg_count);
     }
-    
-    VectorType* metadata_ptr_type = VectorType::get(m_void_ptr_type, num_elements);
-    
-    Value *CV0 = ConstantInt::get(Type::getInt32Ty(load_inst->getContext()), 0);
-    Value *CV1 = ConstantInt::get(Type::getInt32Ty(load_inst->getContext()), 1);
-
-    Value* base_vector = InsertElementInst::Create(UndefValue::get(metadata_ptr_type),     vector_base[0],  CV0, "", insert_at);
-    Value* base_vector_final = InsertElementInst::Create(base_vector, vector_base[1], CV1, "", insert_at);
-  
-    m_vector_pointer_base[load_inst] = base_vector_final;
-
-    Value* bound_vector = InsertElementInst::Create(UndefValue::get(metadata_ptr_type),     vector_bound[0],  CV0, "", insert_at);
-    Value* bound_vector_final = InsertElementInst::Create(bound_vector, vector_bound[1], CV1, "", insert_at); 
-    m_vector_pointer_bound[load_inst] = bound_vector_final;
-
-    return;
   }
 
-#if 0
-  if(unsafe_byval_opt && isByValDerived(load_inst->getOperand(0))) {
+  /* WorkList Algorithm for propagating the base and bound. Each
+   * basic block is visited only once. We start by visiting the
+   * current basic block, then push all the successors of the
+   * current basic block on to the queue if it has not been visited
+   */
+  std::set<BasicBlock*> bb_visited;
+  std::queue<BasicBlock*> bb_worklist;
+  Function:: iterator bb_begin = func->begin();
 
-    if(spatial_safety){
-      associateBaseBound(load_inst, m_void_null_ptr, m_infinite_bound_ptr);
-    }
-    if(temporal_safety){
-      Value* func_lock = getAssociatedFuncLock(load_inst);
-      associateKeyLock(load_inst, m_constantint64ty_one, func_lock);
-    }
-    return;
-  }
-#endif
+  BasicBlock* bb = dyn_cast<BasicBlock>(bb_begin);
+  assert( bb && "Not a basic block and I am gathering base and bound?");
+  bb_worklist.push(bb);
 
-}
+  while(bb_worklist.size() != 0) {
 
-//
-// Method: checkBaseBoundMetadataPresent()
-//
-// Description:
-// Checks if the metadata is present in the SoftBound/CETS maps.
+    bb = bb_worklist.front();
+    assert(bb && "Not a BasicBlock?");
 
-bool Nova::CheckBaseBoundMetadataPresent(Value* pointer_operand){
+    bb_worklist.pop();
+    if( bb_visited.count(bb)) {
+      /* Block already visited */
+      continue;
+    }
+    /* If here implies basic block not visited */
+      
+    /* Insert the block into the set of visited blocks */
+    bb_visited.insert(bb);
 
-  if(m_pointer_base.count(pointer_operand) && 
-     m_pointer_bound.count(pointer_operand)){
-      return true;
-  }
-  return false;
-}
+    /* Iterating over the successors and adding the successors to
+     * the work list
+     */
+    for(succ_iterator si = succ_begin(bb), se = succ_end(bb); si != se; ++si) {
 
-//
-// Method: propagateMetadata
-//
-// Descripton;
-//
-// This function propagates the metadata from the source to the
-// destination in the map for pointer arithmetic operations~(gep) and
-// bitcasts. This is the place where we need to shrink bounds.
-//
+      BasicBlock* next_bb = *si;
+      assert(next_bb && "Not a basic block and I am adding to the base and bound worklist?");
+      bb_worklist.push(next_bb);
+    }
+      
+    for(BasicBlock::iterator i = bb->begin(), ie = bb->end(); i != ie; ++i){
+        Value* v1 = dyn_cast<Value>(i);
+        Instruction* new_inst = dyn_cast<Instruction>(i);
 
-void Nova::PropagateMetadata(Value* pointer_operand, 
-                                      Instruction* inst, 
-                                      int instruction_type){
 
-  // Need to just propagate the base and bound here if I am not
-  // shrinking bounds
-  if(CheckBaseBoundMetadataPresent(inst)){
-    // Metadata added to the map in the first pass
-    return;
-  }
+        /* If the instruction is not present in the original, no
+         * instrumentaion 
+         */
+        if(!m_present_in_original.count(v1)) {
+          continue;
+        }
 
-  if(isa<ConstantPointerNull>(pointer_operand)) {
-    AssociateBaseBound(inst, m_void_null_ptr, m_void_null_ptr);
-    return;
-  }
+        /* All instructions have been defined here as defining it in
+         * switch causes compilation errors. Assertions have been in
+         * the inserted in the specific cases
+         */
+        //errs() <<"inst: " << *new_inst << "\n";
 
-  if (CheckBaseBoundMetadataPresent(pointer_operand)) {
-    Value* tmp_base = GetAssociatedBase(pointer_operand); 
-    Value* tmp_bound = GetAssociatedBound(pointer_operand);       
-    AssociateBaseBound(inst, tmp_base, tmp_bound);
-  } else{
-    if(isa<Constant>(pointer_operand)) {
-      
-      Value* tmp_base = NULL;
-      Value* tmp_bound = NULL;
-      Constant* given_constant = dyn_cast<Constant>(pointer_operand);
-      GetConstantExprBaseBound(given_constant, tmp_base, tmp_bound);
-      assert(tmp_base && "gep with cexpr and base null?");
-      assert(tmp_bound && "gep with cexpr and bound null?");
-      tmp_base = CastToVoidPtr(tmp_base, inst);
-      tmp_bound = CastToVoidPtr(tmp_bound, inst);        
-  
-      AssociateBaseBound(inst, tmp_base, tmp_bound);
-    } // Constant case ends here
-    // Could be in the first pass, do nothing here
-  }
-}
+        switch(new_inst->getOpcode()) {
+          
+        case Instruction::Alloca:
+          {
+            AllocaInst* alloca_inst = dyn_cast<AllocaInst>(v1);
+            assert(alloca_inst && "Not an Alloca inst?");
+            HandleAlloca(alloca_inst, bb, i);
+          }
+          break;
 
-void Nova::HandleGEP(GetElementPtrInst* gep_inst) {
-  Value* getelementptr_operand = gep_inst->getPointerOperand();
-  PropagateMetadata(getelementptr_operand, gep_inst, SBCETS_GEP);
-}
+        case Instruction::Load:
+          {
+            LoadInst* load_inst = dyn_cast<LoadInst>(v1);            
+            assert(load_inst && "Not a Load inst?");
+            HandleLoad(load_inst);
+          }
+          break;
 
-//
-// Method: handleBitCast
-//
-// Description: Propagate metadata from source to destination with
-// pointer bitcast operations.
+        case Instruction::GetElementPtr:
+          {
+            GetElementPtrInst* gep_inst = dyn_cast<GetElementPtrInst>(v1);
+            assert(gep_inst && "Not a GEP inst?");
+            HandleGEP(gep_inst);
+          }
+          break;
+	
+        case BitCastInst::BitCast:
+          {
+            BitCastInst* bitcast_inst = dyn_cast<BitCastInst>(v1);
+            assert(bitcast_inst && "Not a BitCast inst?");
+            HandleBitCast(bitcast_inst);
+          }
+          break;
 
-void Nova::HandleBitCast(BitCastInst* bitcast_inst) {
+        case Instruction::PHI:
+          {
+            PHINode* phi_node = dyn_cast<PHINode>(v1);
+            assert(phi_node && "Not a phi node?");
+            //printInstructionMap(v1);
+            HandlePHIPass1(phi_node);
+          }
+          /* PHINode ends */
+          break;
+          
+        case Instruction::Call:
+          {
+            CallInst* call_inst = dyn_cast<CallInst>(v1);
+            assert(call_inst && "Not a Call inst?");
+            HandleCallInst(call_inst);
+          }
+          break;
 
-  Value* pointer_operand = bitcast_inst->getOperand(0);  
-  PropagateMetadata(pointer_operand, bitcast_inst, SBCETS_BITCAST);
-}
+        case Instruction::Select:
+          {
+            SelectInst* select_insn = dyn_cast<SelectInst>(v1);
+            assert(select_insn && "Not a select inst?");
+            int pass = 1;
+            HandleSelect(select_insn, pass);
+          }
+          break;
 
-//
-// The metadata propagation for PHINode occurs in two passes. In the
-// first pass, SoftBound/CETS transformation just creates the metadata
-// PHINodes and records it in the maps maintained by
-// SoftBound/CETS. In the second pass, it populates the incoming
-// values of the PHINodes. This two pass approach ensures that every
-// incoming value of the original PHINode will have metadata in the
-// SoftBound/CETS maps
-// 
+        case Instruction::Store:
+          {
+            break;
+          }
 
-//
-// Method: handlePHIPass1()
-//
-// Description:
-//
-// This function creates a PHINode for the metadata in the bitcode for
-// pointer PHINodes. It is important to note that this function just
-// creates the PHINode and does not populate the incoming values of
-// the PHINode, which is handled by the handlePHIPass2.
-//
+        case Instruction::IntToPtr:
+          {
+            IntToPtrInst* inttoptrinst = dyn_cast<IntToPtrInst>(v1);
+            assert(inttoptrinst && "Not a IntToPtrInst?");
+            HandleIntToPtr(inttoptrinst);
+            break;
+          }
 
-void Nova::HandlePHIPass1(PHINode* phi_node) {
+        case Instruction::Ret:
+          {
+            ReturnInst* ret = dyn_cast<ReturnInst>(v1);
+            assert(ret && "not a return inst?");
+            HandleReturnInst(ret);
+          }
+          break;
+	
+        case Instruction::ExtractElement:
+	    {
+	      ExtractElementInst * EEI = dyn_cast<ExtractElementInst>(v1);
+	      assert(EEI && "ExtractElementInst inst?");
+	      HandleExtractElement(EEI);
+	    }
+	    break;
 
-  // Not a Pointer PHINode, then just return
-  if (!isa<PointerType>(phi_node->getType()))
-    return;
+        case Instruction::ExtractValue:
+	    {
+	      ExtractValueInst * EVI = dyn_cast<ExtractValueInst>(v1);
+	      assert(EVI && "handle extract value inst?");
+	      HandleExtractValue(EVI);
+	    }
+	    break;
+            
+        default:
+          if(isa<PointerType>(v1->getType()))
+            assert(!isa<PointerType>(v1->getType())&&
+                   " Generating Pointer and not being handled");
+        } // for-end
+    }/* Basic Block iterator Ends */
+  } /* Function iterator Ends */
+}
 
-  unsigned num_incoming_values = phi_node->getNumIncomingValues();
+void Nova::HandleVectorStore(StoreInst* store_inst){
 
-  PHINode* base_phi_node = PHINode::Create(m_void_ptr_type,
-                                           num_incoming_values,
-                                           "phi.base",
-                                           phi_node);
-  
-  PHINode* bound_phi_node = PHINode::Create(m_void_ptr_type, 
-                                            num_incoming_values,
-                                            "phi.bound", 
-                                            phi_node);
-  
-  Value* base_phi_node_value = base_phi_node;
-  Value* bound_phi_node_value = bound_phi_node;
-  
-  AssociateBaseBound(phi_node, base_phi_node_value, bound_phi_node_value);
-}
+  Value* operand = store_inst->getOperand(0);
+  Value* pointer_dest = store_inst->getOperand(1);
+  Instruction* insert_at = GetNextInstruction(store_inst);
 
-void Nova::AddMemcopyMemsetCheck(CallInst* call_inst, Function* called_func) {
-  SmallVector<Value*, 8> args;
+  if(!m_vector_pointer_base.count(operand)){
+    assert(0 && "vector base not found");
+  }
+  if(!m_vector_pointer_bound.count(operand)){
+    assert(0 && "vector bound not found");
+  }
+  
+  Value* vector_base = m_vector_pointer_base[operand];
+  Value* vector_bound = m_vector_pointer_bound[operand];
 
-  if(called_func->getName().find("llvm.memcpy") == 0 || 
-     called_func->getName().find("llvm.memmove") == 0){
+  const VectorType* vector_ty = dyn_cast<VectorType>(operand->getType());
+  uint64_t num_elements = vector_ty->getNumElements();
+  if (num_elements > 2){
+    assert(0 && "more than 2 element vectors not handled");
+  }
 
-    CallSite cs(call_inst);
+  Value* pointer_operand_bitcast = CastToVoidPtr(pointer_dest, insert_at);
+  for (uint64_t i = 0; i < num_elements; i++){
+    Constant* index = ConstantInt::get(Type::getInt32Ty(store_inst->getContext()), i);
 
-    Value* dest_ptr = cs.getArgument(0);
-    Value* src_ptr  = cs.getArgument(1);
-    Value* size_ptr = cs.getArgument(2);
+    Value* ptr_base = ExtractElementInst::Create(vector_base, index,"", insert_at);
+    Value* ptr_bound = ExtractElementInst::Create(vector_bound, index, "", insert_at);
     
-    args.push_back(dest_ptr);
-    args.push_back(src_ptr);
-
-    Value* cast_size_ptr = size_ptr;
-    if(size_ptr->getType() != m_key_type){
-      BitCastInst* bitcast = new BitCastInst(size_ptr, m_key_type, "", call_inst);
-      cast_size_ptr = bitcast;
-    }
+    SmallVector<Value*, 8> args;
+    args.clear();
 
-    args.push_back(cast_size_ptr);
+    args.push_back(pointer_operand_bitcast);
+    args.push_back(ptr_base);
+    args.push_back(ptr_bound);
+    args.push_back(index);
 
-    Value* dest_base = GetAssociatedBase(dest_ptr);
-    Value* dest_bound =GetAssociatedBound(dest_ptr);
-    
-    Value* src_base = GetAssociatedBase(src_ptr);
-    Value* src_bound = GetAssociatedBound(src_ptr);
+    CallInst::Create(m_metadata_store_vector_func, args, "", insert_at);    
+  }
+}   
 
-    args.push_back(dest_base);
-    args.push_back(dest_bound);
+void Nova::HandleStore(StoreInst* store_inst) {
+  Value* operand = store_inst->getOperand(0);
+  Value* pointer_dest = store_inst->getOperand(1);
+  Instruction* insert_at = GetNextInstruction(store_inst);
     
-    args.push_back(src_base);
-    args.push_back(src_bound);
-
-    CallInst::Create(m_memcopy_check, args, "", call_inst);
-    return;
+  if(isa<VectorType>(operand->getType())){
+    const VectorType* vector_ty = dyn_cast<VectorType>(operand->getType());
+    if(isa<PointerType>(vector_ty->getElementType())){
+      HandleVectorStore(store_inst);
+      return;
+    }
   }
 
-  if(called_func->getName().find("llvm.memset") == 0){
+  /* If a pointer is being stored, then the base and bound
+   * corresponding to the pointer must be stored in the shadow space
+   */
+  if(!isa<PointerType>(operand->getType()))
+    return;
+      
 
-    args.clear();
-    CallSite cs(call_inst);
-    Value* dest_ptr = cs.getArgument(0);
-    // Whats cs.getArgrument(1) return? Why am I not using it?
-    Value* size_ptr = cs.getArgument(2);
+  if(isa<ConstantPointerNull>(operand)) {
+    /* it is a constant pointer null being stored
+     * store null to the shadow space
+     */
+#if 0    
+    StructType* ST = dyn_cast<StructType>(operand->getType());
 
-    Value* cast_size_ptr = size_ptr;
-    assert(size_ptr != NULL);
+    if(ST){
+      if(ST->isOpaque()){
+        DEBUG(errs()<<"Opaque type found\n");        
+      }
 
-    if(size_ptr->getType() != m_key_type){
-      BitCastInst* bitcast = new BitCastInst(size_ptr, m_key_type, "", call_inst);
-      cast_size_ptr = bitcast;
     }
+      Value* size_of_type = getSizeOfType(operand->getType());
+#endif
 
-    args.push_back(dest_ptr);
-    args.push_back(cast_size_ptr);
-    
-    Value* dest_base = GetAssociatedBase(dest_ptr);
-    Value* dest_bound = GetAssociatedBound(dest_ptr);
-    args.push_back(dest_base);
-    args.push_back(dest_bound);   
+      Value* size_of_type = NULL;
 
-    CallInst::Create(m_memset_check, args, "", call_inst);
-    return;
+      AddStoreBaseBoundFunc(pointer_dest, m_void_null_ptr, 
+                            m_void_null_ptr, m_void_null_ptr, 
+                            size_of_type, insert_at);
+
+    return; 
   }
-}
 
-void Nova::HandleMemcpy(CallInst* call_inst){
-  Function* func = call_inst->getCalledFunction();
-  if(!func)
-    return;
+      
+  /* if it is a global expression being stored, then add add
+   * suitable base and bound
+   */
+    
+  Value* tmp_base = NULL;
+  Value* tmp_bound = NULL;
 
-  assert(func && "function is null?");
+  //  Value* xmm_base_bound = NULL;
+  //  Value* xmm_key_lock = NULL;
+    
+  Constant* given_constant = dyn_cast<Constant>(operand);
+  if(given_constant) {      
+      GetConstantExprBaseBound(given_constant, tmp_base, tmp_bound);
+      assert(tmp_base && "global doesn't have base");
+      assert(tmp_bound && "global doesn't have bound");        
+  } else {      
+    /* storing an external function pointer */
+      if(!CheckBaseBoundMetadataPresent(operand)) {
+        return;
+      }
 
-  CallSite cs(call_inst);
-  Value* arg1 = cs.getArgument(0);
-  Value* arg2 = cs.getArgument(1);
-  Value* arg3 = cs.getArgument(2);
+      tmp_base = GetAssociatedBase(operand);
+      tmp_bound = GetAssociatedBound(operand);              
+  }    
+  
+  /* Store the metadata into the metadata space
+   */
+  
 
-  SmallVector<Value*, 8> args;
-  args.push_back(arg1);
-  args.push_back(arg2);
-  args.push_back(arg3);
+  //  Type* stored_pointer_type = operand->getType();
+  Value* size_of_type = NULL;
+  //    Value* size_of_type  = getSizeOfType(stored_pointer_type);
+  AddStoreBaseBoundFunc(pointer_dest, tmp_base, tmp_bound, operand,  size_of_type, insert_at);    
+  
+}
 
-  if(arg3->getType() == Type::getInt64Ty(arg3->getContext())){
-    CallInst::Create(m_copy_metadata, args, "", call_inst);
-  }
-  else{
-    //    CallInst::Create(m_copy_metadata, args, "", call_inst);
-  }
-  args.clear();
+//
+// Method: getGlobalVariableBaseBound
 
-#if 0
+// Description: This function returns the base and bound for the
+// global variables in the input reference arguments. This function
+// may now be obsolete. We should try to use getConstantExprBaseBound
+// instead in all places.
+void Nova::GetGlobalVariableBaseBound(Value* operand, 
+                                              Value* & operand_base, 
+                                              Value* & operand_bound){
 
-  Value* arg1_base = castToVoidPtr(getAssociatedBase(arg1), call_inst);
-  Value* arg1_bound = castToVoidPtr(getAssociatedBound(arg1), call_inst);
-  Value* arg2_base = castToVoidPtr(getAssociatedBase(arg2), call_inst);
-  Value* arg2_bound = castToVoidPtr(getAssociatedBound(arg2), call_inst);
-  args.push_back(arg1);
-  args.push_back(arg1_base);
-  args.push_back(arg1_bound);
-  args.push_back(arg2);
-  args.push_back(arg2_base);
-  args.push_back(arg2_bound);
-  args.push_back(arg3);
+  GlobalVariable* gv = dyn_cast<GlobalVariable>(operand);
+  Module* module = gv->getParent();
+  assert(gv && "[getGlobalVariableBaseBound] not a global variable?");
+    
+  std::vector<Constant*> indices_base;
+  Constant* index_base = 
+    ConstantInt::get(Type::getInt32Ty(module->getContext()), 0);
+  indices_base.push_back(index_base);
 
-  CallInst::Create(m_memcopy_check,args.begin(), args.end(), "", call_inst);
+  Constant* base_exp = ConstantExpr::getGetElementPtr(nullptr, gv, indices_base);
+        
+  std::vector<Constant*> indices_bound;
+  Constant* index_bound = 
+    ConstantInt::get(Type::getInt32Ty(module->getContext()), 1);
+  indices_bound.push_back(index_bound);
 
-#endif
-  return;
+  Constant* bound_exp = ConstantExpr::getGetElementPtr(nullptr, gv, indices_bound);
     
+  operand_base = base_exp;
+  operand_bound = bound_exp;    
 }
 
 //
-// Method: introduceShadowStackAllocation
+// Method: handlePHIPass2()
 //
-// Description: For every function call that has a pointer argument or
-// a return value, shadow stack is used to propagate metadata. This
-// function inserts the shadow stack allocation C-handler that
-// reserves space in the shadow stack by reserving the requiste amount
-// of space based on the input passed to it(number of pointer
-// arguments/return).
+// Description: This pass fills the incoming values for the metadata
+// PHINodes inserted in the first pass. There are four cases that
+// needs to be handled for each incoming value.  First, if the
+// incoming value is a ConstantPointerNull, then base, bound, key,
+// lock will be default values.  Second, the incoming value can be an
+// undef which results in default metadata values.  Third, Global
+// variables need to get the same base and bound for each
+// occurence. So we maintain a map which maps the base and boundfor
+// each global variable in the incoming value.  Fourth, by default it
+// retrieves the metadata from the SoftBound/CETS maps.
 
+// Check if we need separate global variable and constant expression
+// cases.
 
-void Nova::IntroduceShadowStackAllocation(CallInst* call_inst){
-    
-  // Count the number of pointer arguments and whether a pointer return     
-  int pointer_args_return = GetNumPointerArgsAndReturn(call_inst);
-  if(pointer_args_return == 0)
+void Nova::HandlePHIPass2(PHINode* phi_node) {
+  // Work to be done only for pointer PHINodes.
+  if (!isa<PointerType>(phi_node->getType())) 
     return;
-  Value* total_ptr_args;    
-  total_ptr_args = 
-    ConstantInt::get(Type::getInt32Ty(call_inst->getType()->getContext()), 
-                     pointer_args_return, false);
 
-  SmallVector<Value*, 8> args;
-  args.push_back(total_ptr_args);
-  CallInst::Create(m_shadow_stack_allocate, args, "", call_inst);
-}
+  PHINode* base_phi_node = NULL;
+  PHINode* bound_phi_node  = NULL;
 
-//
-// Method: introduceShadowStackStores
-//
-// Description: This function inserts a call to the shadow stack store
-// C-handler that stores the metadata, before the function call in the
-// bitcode for pointer arguments.
+  // Obtain the metada PHINodes 
+  base_phi_node = dyn_cast<PHINode>(GetAssociatedBase(phi_node));
+  bound_phi_node = dyn_cast<PHINode>(GetAssociatedBound(phi_node));
 
-void Nova::IntroduceShadowStackStores(Value* ptr_value, 
-                                              Instruction* insert_at, 
-                                              int arg_no){
-  if(!isa<PointerType>(ptr_value->getType()))
-    return;
+  std::map<Value*, Value*> globals_base;
+  std::map<Value*, Value*> globals_bound;
+ 
+  unsigned num_incoming_values = phi_node->getNumIncomingValues();
+  for (unsigned m = 0; m < num_incoming_values; m++) {
 
-  Value* argno_value;    
-  argno_value = 
-    ConstantInt::get(Type::getInt32Ty(ptr_value->getType()->getContext()), 
-                     arg_no, false);
+    Value* incoming_value = phi_node->getIncomingValue(m);
+    BasicBlock* bb_incoming = phi_node->getIncomingBlock(m);
 
-  Value* ptr_base = GetAssociatedBase(ptr_value);
-  Value* ptr_bound = GetAssociatedBound(ptr_value);
-  
-  Value* ptr_base_cast = CastToVoidPtr(ptr_base, insert_at);
-  Value* ptr_bound_cast = CastToVoidPtr(ptr_bound, insert_at);
+    if (isa<ConstantPointerNull>(incoming_value)) {
+        base_phi_node->addIncoming(m_void_null_ptr, bb_incoming);
+        bound_phi_node->addIncoming(m_void_null_ptr, bb_incoming);
+      continue;
+    } // ConstantPointerNull ends
+   
+    // The incoming vlaue can be a UndefValue
+    if (isa<UndefValue>(incoming_value)) {        
+        base_phi_node->addIncoming(m_void_null_ptr, bb_incoming);
+        bound_phi_node->addIncoming(m_void_null_ptr, bb_incoming);
+      continue;
+    } // UndefValue ends
+      
+    Value* incoming_value_base = NULL;
+    Value* incoming_value_bound = NULL;
+    
+    // handle global variables      
+    GlobalVariable* gv = dyn_cast<GlobalVariable>(incoming_value);
+    if (gv) {
+        if (!globals_base.count(gv)) {
+          Value* tmp_base = NULL;
+          Value* tmp_bound = NULL;
+          GetGlobalVariableBaseBound(incoming_value, tmp_base, tmp_bound);
+          assert(tmp_base && "base of a global variable null?");
+          assert(tmp_bound && "bound of a global variable null?");
+          
+          Function * PHI_func = phi_node->getParent()->getParent();
+          Instruction* PHI_func_entry = &*(PHI_func->begin()->begin());
+          
+          incoming_value_base = CastToVoidPtr(tmp_base, PHI_func_entry);                                               
+          incoming_value_bound = CastToVoidPtr(tmp_bound, PHI_func_entry);
+            
+          globals_base[incoming_value] = incoming_value_base;
+          globals_bound[incoming_value] = incoming_value_bound;       
+        } else {
+          incoming_value_base = globals_base[incoming_value];
+          incoming_value_bound = globals_bound[incoming_value];          
+        }
+    } // global variable ends
+      
+    // handle constant expressions 
+    Constant* given_constant = dyn_cast<Constant>(incoming_value);
+    if (given_constant) {
+        if (!globals_base.count(incoming_value)) {
+          Value* tmp_base = NULL;
+          Value* tmp_bound = NULL;
+          GetConstantExprBaseBound(given_constant, tmp_base, tmp_bound);
+          assert(tmp_base && tmp_bound  &&
+                 "[handlePHIPass2] tmp_base tmp_bound, null?");
+          
+          Function* PHI_func = phi_node->getParent()->getParent();
+          Instruction* PHI_func_entry = &*(PHI_func->begin()->begin());
 
-  SmallVector<Value*, 8> args;
-  args.push_back(ptr_base_cast);
-  args.push_back(argno_value);
-  CallInst::Create(m_shadow_stack_base_store, args, "", insert_at);
-  
-  args.clear();
-  args.push_back(ptr_bound_cast);
-  args.push_back(argno_value);
-  CallInst::Create(m_shadow_stack_bound_store, args, "", insert_at);    
-}
+          incoming_value_base = CastToVoidPtr(tmp_base, PHI_func_entry);
+          incoming_value_bound = CastToVoidPtr(tmp_bound, PHI_func_entry);
+          
+          globals_base[incoming_value] = incoming_value_base;
+          globals_bound[incoming_value] = incoming_value_bound;        
+        }
+        else{
+          incoming_value_base = globals_base[incoming_value];
+          incoming_value_bound = globals_bound[incoming_value];          
+        }
+    }
+    
+    // handle values having map based pointer base and bounds 
+    if(CheckBaseBoundMetadataPresent(incoming_value)){
+      incoming_value_base = GetAssociatedBase(incoming_value);
+      incoming_value_bound = GetAssociatedBound(incoming_value);
+    }
 
-//
-// Method: introduceShadowStackDeallocation
-//
-// Description: This function inserts a call to the C-handler that
-// deallocates the shadow stack space on function exit.
-  
+    assert(incoming_value_base &&
+           "[handlePHIPass2] incoming_value doesn't have base?");
+    assert(incoming_value_bound && 
+           "[handlePHIPass2] incoming_value doesn't have bound?");
+    
+    base_phi_node->addIncoming(incoming_value_base, bb_incoming);
+    bound_phi_node->addIncoming(incoming_value_bound, bb_incoming);
+  } // Iterating over incoming values ends 
 
-void Nova::IntroduceShadowStackDeallocation(CallInst* call_inst, Instruction* insert_at){
+  assert(base_phi_node && "[handlePHIPass2] base_phi_node null?");
+  assert(bound_phi_node && "[handlePHIPass2] bound_phi_node null?");
 
-  int pointer_args_return = GetNumPointerArgsAndReturn(call_inst);
-  if(pointer_args_return == 0)
-    return;
-  SmallVector<Value*, 8> args;    
-  CallInst::Create(m_shadow_stack_deallocate, args, "", insert_at);
+  unsigned n_values = phi_node->getNumIncomingValues();
+  unsigned n_base_values = base_phi_node->getNumIncomingValues();
+  unsigned n_bound_values = bound_phi_node->getNumIncomingValues();    
+  assert((n_values == n_base_values)  && 
+         "[handlePHIPass2] number of values different for base");
+  assert((n_values == n_bound_values) && 
+         "[handlePHIPass2] number of values different for bound");
 }
+  
 
-//
-// Method: getNumPointerArgsAndReturn
-//
-// Description: Returns the number of pointer arguments and return.
-//
-int Nova::GetNumPointerArgsAndReturn(CallInst* call_inst){
-
-  int total_pointer_count = 0;
-  CallSite cs(call_inst);
-  for(unsigned i = 0; i < cs.arg_size(); i++){
-    Value* arg_value = cs.getArgument(i);
-    if(isa<PointerType>(arg_value->getType())){
-      total_pointer_count++;
-    }
-  }
-
-  if (total_pointer_count != 0) {
-    // Reserve one for the return address if it has atleast one
-    // pointer argument 
-    total_pointer_count++;
-  } else{
-    // Increment the pointer arg return if the call instruction
-    // returns a pointer
-    if(isa<PointerType>(call_inst->getType())){
-      total_pointer_count++;
-    }
-  }
-  return total_pointer_count;
-}
+void Nova::GatherBaseBoundPass2(Function* func){
 
-// 
-// Method: introduceShadowStackLoads
-//
-// Description: This function introduces calls to the C-handlers that
-// performs the loads from the shadow stack to retrieve the metadata.
-// This function also associates the loaded metadata with the pointer
-// arguments in the SoftBound/CETS maps.
+  /* WorkList Algorithm for propagating base and bound. Each basic
+   * block is visited only once
+   */
+  std::set<BasicBlock*> bb_visited;
+  std::queue<BasicBlock*> bb_worklist;
+  Function::iterator bb_begin = func->begin();
 
-void Nova::IntroduceShadowStackLoads(Value* ptr_value, 
-                                             Instruction* insert_at, 
-                                             int arg_no){
-    
-  if (!isa<PointerType>(ptr_value->getType()))
-    return;
-      
-  Value* argno_value;    
-  argno_value = 
-    ConstantInt::get(Type::getInt32Ty(ptr_value->getType()->getContext()), 
-                     arg_no, false);
+  BasicBlock* bb = dyn_cast<BasicBlock>(bb_begin);
+  assert(bb && "Not a basic block and gathering base bound in the next pass?");
+  bb_worklist.push(bb);
     
-  SmallVector<Value*, 8> args;
-  args.clear();
-  args.push_back(argno_value);
-  Value* base = CallInst::Create(m_shadow_stack_base_load, args, "", 
-                                 insert_at);    
-  args.clear();
-  args.push_back(argno_value);
-  Value* bound = CallInst::Create(m_shadow_stack_bound_load, args, "", 
-                                  insert_at);
-  AssociateBaseBound(ptr_value, base, bound);
-}
+  while( bb_worklist.size() != 0) {
 
-void Nova::IterateCallSiteIntroduceShadowStackStores(CallInst* call_inst){
-    
-  int pointer_args_return = GetNumPointerArgsAndReturn(call_inst);
+    bb = bb_worklist.front();
+    assert(bb && "Not a BasicBlock?");
 
-  if(pointer_args_return == 0)
-    return;
-    
-  int pointer_arg_no = 1;
+    bb_worklist.pop();
+    if( bb_visited.count(bb)) {
+      /* Block already visited */
 
-  CallSite cs(call_inst);
-  for(unsigned i = 0; i < cs.arg_size(); i++){
-    Value* arg_value = cs.getArgument(i);
-    if(isa<PointerType>(arg_value->getType())){
-      IntroduceShadowStackStores(arg_value, call_inst, pointer_arg_no);
-      pointer_arg_no++;
+      continue;
     }
-  }    
-}
-
-void Nova::HandleCallInst(CallInst* call_inst) {
-  // Function* func = call_inst->getCalledFunction();
-  Value* mcall = call_inst;
+    /* If here implies basic block not visited */
+      
+    /* Insert the block into the set of visited blocks */
+    bb_visited.insert(bb);
 
-#if 0
-  CallingConv::ID id = call_inst->getCallingConv();
+    /* Iterating over the successors and adding the successors to
+     * the work list
+     */
+    for(succ_iterator si = succ_begin(bb), se = succ_end(bb); si != se; ++si) {
 
+      BasicBlock* next_bb = *si;
+      assert(next_bb && "Not a basic block and I am adding to the base and bound worklist?");
+      bb_worklist.push(next_bb);
+    }
 
-  if(id == CallingConv::Fast){
-    printf("fast calling convention not handled\n");
-    exit(1);
-  }
-#endif 
-    
-  Function* func = call_inst->getCalledFunction();
-  if(func && ((func->getName().find("llvm.memcpy") == 0) || 
-              (func->getName().find("llvm.memmove") == 0))){
-    AddMemcopyMemsetCheck(call_inst, func);
-    HandleMemcpy(call_inst);
-    return;
-  }
+    for(BasicBlock::iterator i = bb->begin(), ie = bb->end(); i != ie; ++i) {
+      Value* v1 = dyn_cast<Value>(i);
+      Instruction* new_inst = dyn_cast<Instruction>(i);
 
-  if(func && func->getName().find("llvm.memset") == 0){
-    AddMemcopyMemsetCheck(call_inst, func);
-  }
+      // If the instruction is not present in the original, no instrumentaion
+      if(!m_present_in_original.count(v1))
+        continue;
 
-  if(func && IsFuncDefSoftBound(func->getName())){
-    if(!isa<PointerType>(call_inst->getType())){
-      return;
-    }
-    
-    AssociateBaseBound(call_inst, m_void_null_ptr, m_void_null_ptr);
-    return;
-  }
+      switch(new_inst->getOpcode()) {
 
-  Instruction* insert_at = GetNextInstruction(call_inst);
-  //  call_inst->setCallingConv(CallingConv::C);
+      case Instruction::GetElementPtr:
+        {
+          GetElementPtrInst* gep_inst = dyn_cast<GetElementPtrInst>(v1);         
+          assert(gep_inst && "Not a GEP instruction?");
+          HandleGEP(gep_inst);
+        }
+        break;
+          
+      case Instruction::Store:
+        {
+          StoreInst* store_inst = dyn_cast<StoreInst>(v1);
+          assert(store_inst && "Not a Store instruction?");
+          HandleStore(store_inst);
+        }
+        break;
 
-  IntroduceShadowStackAllocation(call_inst);
-  IterateCallSiteIntroduceShadowStackStores(call_inst);
-    
-  if(isa<PointerType>(mcall->getType())) {
+      case Instruction::PHI:
+        {
+          PHINode* phi_node = dyn_cast<PHINode>(v1);
+          assert(phi_node && "Not a PHINode?");
+          HandlePHIPass2(phi_node);
+        }
+        break;
+ 
+      case BitCastInst::BitCast:
+        {
+          BitCastInst* bitcast_inst = dyn_cast<BitCastInst>(v1);
+          assert(bitcast_inst && "Not a bitcast instruction?");
+          HandleBitCast(bitcast_inst);
+        }
+        break;
 
-      /* ShadowStack for the return value is 0 */
-      IntroduceShadowStackLoads(call_inst, insert_at, 0);       
-  }
-  IntroduceShadowStackDeallocation(call_inst,insert_at);
+      case SelectInst::Select:
+        {
+        }
+        break;
+          
+      default:
+        break;
+      }/* Switch Ends */
+    }/* BasicBlock iterator Ends */
+  }/* Function iterator Ends */
 }
 
-//
-// Method: handleSelect
-//
-// This function propagates the metadata with Select IR instruction.
-// Select  instruction is also handled in two passes.
-
-void Nova::HandleSelect(SelectInst* select_ins, int pass) {
+void Nova::AddBaseBoundGlobals(Module& M){
+  /* iterate over the globals here */
 
-  if (!isa<PointerType>(select_ins->getType())) 
-    return;
+  for(Module::global_iterator it = M.global_begin(), ite = M.global_end(); it != ite; ++it){
     
-  Value* condition = select_ins->getOperand(0);
-  Value* operand_base[2];
-  Value* operand_bound[2];    
-
-  for(unsigned m = 0; m < 2; m++) {
-    Value* operand = select_ins->getOperand(m+1);
-
-    operand_base[m] = NULL;
-    operand_bound[m] = NULL;
+    GlobalVariable* gv = dyn_cast<GlobalVariable>(it);
+    
+    if(!gv){
+      continue;
+    }
 
-    if (CheckBaseBoundMetadataPresent(operand)) {      
-      operand_base[m] = GetAssociatedBase(operand);
-      operand_bound[m] = GetAssociatedBound(operand);
+    if(StringRef(gv->getSection()) == "llvm.metadata"){
+      continue;
+    }
+    if(gv->getName() == "llvm.global_ctors"){
+      continue;
     }
     
-    if (isa<ConstantPointerNull>(operand) && 
-        !CheckBaseBoundMetadataPresent(operand)) {            
-      operand_base[m] = m_void_null_ptr;
-      operand_bound[m] = m_void_null_ptr;
-    }        
-      
-    Constant* given_constant = dyn_cast<Constant>(operand);
-    if(given_constant) {
-      GetConstantExprBaseBound(given_constant, 
-                               operand_base[m], 
-                               operand_bound[m]);     
-    }    
-    assert(operand_base[m] != NULL && 
-           "operand doesn't have base with select?");
-    assert(operand_bound[m] != NULL && 
-           "operand doesn't have bound with select?");
+    if(!gv->hasInitializer())
+      continue;
     
-    // Introduce a bit cast if the types don't match 
-    if (operand_base[m]->getType() != m_void_ptr_type) {          
-      operand_base[m] = new BitCastInst(operand_base[m], m_void_ptr_type,
-                                        "select.base", select_ins);          
-    }
+    /* gv->hasInitializer() is true */
     
-    if (operand_bound[m]->getType() != m_void_ptr_type) {
-      operand_bound[m] = new BitCastInst(operand_bound[m], m_void_ptr_type,
-                                         "select_bound", select_ins);
+    Constant* initializer = dyn_cast<Constant>(it->getInitializer());
+    ConstantArray* constant_array = dyn_cast<ConstantArray>(initializer);
+    
+    if(initializer && isa<CompositeType>(initializer->getType())){
+
+      if(isa<StructType>(initializer->getType())){
+        std::vector<Constant*> indices_addr_ptr;
+        Constant* index1 = ConstantInt::get(Type::getInt32Ty(M.getContext()), 0);
+        indices_addr_ptr.push_back(index1);
+        StructType* struct_type = dyn_cast<StructType>(initializer->getType());
+        HandleGlobalStructTypeInitializer(M, struct_type, initializer, gv, indices_addr_ptr, 1);
+        continue;
+      }
+      
+      if(isa<SequentialType>(initializer->getType())){
+        HandleGlobalSequentialTypeInitializer(M, gv);
+      }
     }
-  } // for loop ends
     
-    SelectInst* select_base = SelectInst::Create(condition, 
-                                                 operand_base[0], 
-                                                 operand_base[1], 
-                                                 "select.base",
-                                                 select_ins);
+    if(initializer && !constant_array){
+      
+      if(isa<PointerType>(initializer->getType())){
+        //        std::cerr<<"Pointer type initializer\n";
+      }
+    }
     
-    SelectInst* select_bound = SelectInst::Create(condition, 
-                                                  operand_bound[0], 
-                                                  operand_bound[1], 
-                                                  "select.bound",
-                                                  select_ins);
-    AssociateBaseBound(select_ins, select_base, select_bound);
-}
-
-void Nova::HandleIntToPtr(IntToPtrInst* inttoptrinst) {
+    if(!constant_array)
+      continue;
     
-  Value* inst = inttoptrinst;
+    int num_ca_opds = constant_array->getNumOperands();
     
-  AssociateBaseBound(inst, m_void_null_ptr, m_void_null_ptr);
+    for(int i = 0; i < num_ca_opds; i++){
+      Value* initializer_opd = constant_array->getOperand(i);
+      Instruction* first = GetGlobalInitInstruction(M);
+      Value* operand_base = NULL;
+      Value* operand_bound = NULL;
+      
+      Constant* global_constant_initializer = dyn_cast<Constant>(initializer_opd);
+      if(!isa<PointerType>(global_constant_initializer->getType())){
+        break;
+      }
+      GetConstantExprBaseBound(global_constant_initializer, operand_base, operand_bound);
+      
+      SmallVector<Value*, 8> args;
+      Constant* index1 = ConstantInt::get(Type::getInt32Ty(M.getContext()), 0);
+      Constant* index2 = ConstantInt::get(Type::getInt32Ty(M.getContext()), i);
+
+      std::vector<Constant*> indices_addr_ptr;
+      indices_addr_ptr.push_back(index1);
+      indices_addr_ptr.push_back(index2);
+
+      Constant* addr_of_ptr = ConstantExpr::getGetElementPtr(nullptr, gv, indices_addr_ptr);
+      Type* initializer_type = initializer_opd->getType();
+      Value* initializer_size = GetSizeOfType(initializer_type);
+      
+      AddStoreBaseBoundFunc(addr_of_ptr, operand_base, operand_bound, initializer_opd, initializer_size, first);
+      
+    }
+  }
+
 }
 
 //
-// Method: handleReturnInst
 //
-// Description: 
-// This function inserts C-handler calls to store
-// metadata for return values in the shadow stack.
-
-void Nova::HandleReturnInst(ReturnInst* ret){
+// Method: addLoadStoreChecks
+//
+// Description: This function inserts calls to C-handler spatial
+// safety check functions and elides the check if the map says it is
+// not necessary to check.
 
-  Value* pointer = ret->getReturnValue();
-  if(pointer == NULL){
-    return;
+void Nova::AddLoadStoreChecks(Instruction* load_store, 
+                                      std::map<Value*, int>& FDCE_map) {
+  SmallVector<Value*, 8> args;
+  Value* pointer_operand = NULL;
+    
+  if(isa<LoadInst>(load_store)) {
+    LoadInst* ldi = dyn_cast<LoadInst>(load_store);
+    assert(ldi && "not a load instruction");
+    pointer_operand = ldi->getPointerOperand();
   }
-  if(isa<PointerType>(pointer->getType())){
-    IntroduceShadowStackStores(pointer, ret, 0);
+    
+  if(isa<StoreInst>(load_store)){
+    StoreInst* sti = dyn_cast<StoreInst>(load_store);
+    assert(sti && "not a store instruction");
+    // The pointer where the element is being stored is the second
+    // operand
+    pointer_operand = sti->getOperand(1);
   }
-}
+    
+  assert(pointer_operand && "pointer operand null?");
 
-void Nova::HandleExtractElement(ExtractElementInst* EEI){
+  // If it is a null pointer which is being loaded, then it must seg
+  // fault, no dereference check here
   
-  if(!isa<PointerType>(EEI->getType()))
-     return;
   
-  Value* EEIOperand = EEI->getOperand(0);
+  if(isa<ConstantPointerNull>(pointer_operand))
+    return;
+
+  // Find all uses of pointer operand, then check if it dominates and
+  //if so, make a note in the map
   
-  if(isa<VectorType>(EEIOperand->getType())){
+  GlobalVariable* gv = dyn_cast<GlobalVariable>(pointer_operand);    
+  if(gv && GLOBALCONSTANTOPT && !isa<SequentialType>(gv->getType())) {
+    return;
+  }
+  
+  if(BOUNDSCHECKOPT) {
+    // Enable dominator based dereference check optimization only when
+    // suggested
     
-    if(!m_vector_pointer_base.count(EEIOperand) ||
-       !m_vector_pointer_bound.count(EEIOperand)){
-      assert(0 && "Extract element does not have vector metadata");
+    if(FDCE_map.count(load_store)) {
+      return;
     }
-
-    Constant* index = dyn_cast<Constant>(EEI->getOperand(1));
     
-    Value* vector_base = m_vector_pointer_base[EEIOperand];
-    Value* vector_bound = m_vector_pointer_bound[EEIOperand];
+    // FIXME: Add more comments here Iterate over the uses
     
-    Value* ptr_base = ExtractElementInst::Create(vector_base, index, "", EEI);
-    Value* ptr_bound = ExtractElementInst::Create(vector_bound, index, "", EEI);
+    for(Value::use_iterator ui = pointer_operand->use_begin(), 
+          ue = pointer_operand->use_end(); 
+        ui != ue; ++ui) {
+      
+      Instruction* temp_inst = dyn_cast<Instruction>(*ui);       
+      if(!temp_inst)
+        continue;
+      
+      if(temp_inst == load_store)
+        continue;
+      
+      if(!isa<LoadInst>(temp_inst) && !isa<StoreInst>(temp_inst))
+        continue;
+      
+      if(isa<StoreInst>(temp_inst)){
+        if(temp_inst->getOperand(1) != pointer_operand){
+          // When a pointer is a being stored at at a particular
+          // address, don't elide the check
+          continue;
+        }
+      }
+      
+#if 0
+        if(m_dominator_tree->dominates(load_store, temp_inst)) {
+          if(!FDCE_map.count(temp_inst)) {
+            FDCE_map[temp_inst] = true;
+            continue;
+          }                  
+        }
+#endif
+    } // Iterating over uses ends 
+  } // BOUNDSCHECKOPT ends 
+    
+  Value* tmp_base = NULL;
+  Value* tmp_bound = NULL;
+    
+  Constant* given_constant = dyn_cast<Constant>(pointer_operand);    
+  if(given_constant ) {
+    if(GLOBALCONSTANTOPT)
+      return;      
+
+    GetConstantExprBaseBound(given_constant, tmp_base, tmp_bound);
+  }
+  else {
+    tmp_base = GetAssociatedBase(pointer_operand);
+    tmp_bound = GetAssociatedBound(pointer_operand);
+  }
+
+  Value* bitcast_base = CastToVoidPtr(tmp_base, load_store);
+  args.push_back(bitcast_base);
+  
+  Value* bitcast_bound = CastToVoidPtr(tmp_bound, load_store);    
+  args.push_back(bitcast_bound);
+   
+  Value* cast_pointer_operand_value = CastToVoidPtr(pointer_operand, 
+                                                    load_store);    
+  args.push_back(cast_pointer_operand_value);
     
-    AssociateBaseBound(EEI, ptr_base, ptr_bound);
-    return;
+  // Pushing the size of the type 
+  Type* pointer_operand_type = pointer_operand->getType();
+  Value* size_of_type = GetSizeOfType(pointer_operand_type);
+  args.push_back(size_of_type);
+
+  if(isa<LoadInst>(load_store)){
+            
+    CallInst::Create(m_spatial_load_dereference_check, args, "", load_store);
   }
-     
-  assert (0 && "ExtractElement is returning a pointer, possibly some vectorization going on, not handled, try running with O0 or O1 or O2");    
+  else{    
+    CallInst::Create(m_spatial_store_dereference_check, args, "", load_store);
+  }
+
+  return;
 }
 
-void Nova::HandleExtractValue(ExtractValueInst* EVI){
-    if(isa<PointerType>(EVI->getType())){
-        assert(0 && "ExtractValue is returning a pointer, possibly some vectorization going on, not handled, try running with O0 or O1 or O2");
-    }
+void Nova::AddDereferenceChecks(Function* func, ValueSet &vs) {
+  Function &F = *func;
+  Value* pointer_operand = NULL;
   
-    AssociateBaseBound(EVI, m_void_null_ptr, m_infinite_bound_ptr);
-
-  return;  
-}
+  if(func->isVarArg())
+    return;
 
-void Nova::GatherBaseBoundPass1 (Function * func) {
-  int arg_count= 0;
-    
-  //    std::cerr<<"transforming function with name:"<<func->getName()<< "\n";
-  /* Scan over the pointer arguments and introduce base and bound */
+#if 0
+  if(Blacklist->isIn(F))
+    return;
 
-  for(Function::arg_iterator ib = func->arg_begin(), ie = func->arg_end();
-      ib != ie; ++ib) {
+#endif
 
-    if(!isa<PointerType>(ib->getType())) 
-      continue;
+  std::vector<Instruction*> CheckWorkList;
+  std::map<Value*, bool> ElideSpatialCheck;
+  std::map<Value*, bool> ElideTemporalCheck;
 
-    /* it is a pointer, so increment the arg count */
-    arg_count++;
+  // identify all the instructions where we need to insert the spatial checks
+  for(inst_iterator i = inst_begin(F), e = inst_end(F); i != e; ++i){
+    Instruction* I = &*i;
 
-    Argument* ptr_argument = dyn_cast<Argument>(ib);
-    Value* ptr_argument_value = ptr_argument;
-    //Instruction* fst_inst = &*(func->begin()->begin());
-      
-    /* Urgent: Need to think about what we need to do about byval attributes */
-    if(ptr_argument->hasByValAttr()){
-      
-      if(CheckTypeHasPtrs(ptr_argument)){
-        assert(0 && "Pointer argument has byval attributes and the underlying structure returns pointers");
-      }
-      
-      AssociateBaseBound(ptr_argument_value, m_void_null_ptr, m_infinite_bound_ptr);
-    }
-    else{
-      // TODOO: don't know what byval attributes means here.
-      // introduceShadowStackLoads(ptr_argument_value, fst_inst, arg_count);
-      //      introspectMetadata(func, ptr_argument_value, fst_inst, arg_count);
+    if(!m_present_in_original.count(I)){
+      continue;
     }
+    // add check optimizations here
+    // add checks for memory fences and atomic exchanges
+    if(isa<LoadInst>(I) || isa<StoreInst>(I)){
+      CheckWorkList.push_back(I);
+    }     
+    if(isa<AtomicCmpXchgInst>(I) || isa<AtomicRMWInst>(I)){
+      assert(0 && "Atomic Instructions not handled");
+    }    
   }
 
-  /* WorkList Algorithm for propagating the base and bound. Each
-   * basic block is visited only once. We start by visiting the
-   * current basic block, then push all the successors of the
-   * current basic block on to the queue if it has not been visited
-   */
-  std::set<BasicBlock*> bb_visited;
-  std::queue<BasicBlock*> bb_worklist;
-  Function:: iterator bb_begin = func->begin();
-
-  BasicBlock* bb = dyn_cast<BasicBlock>(bb_begin);
-  assert( bb && "Not a basic block and I am gathering base and bound?");
-  bb_worklist.push(bb);
-
-  while(bb_worklist.size() != 0) {
+#if 0
+  // spatial check optimizations here 
 
-    bb = bb_worklist.front();
-    assert(bb && "Not a BasicBlock?");
+  for(std::vector<Instruction*>::iterator i = CheckWorkList.begin(), 
+	e = CheckWorkList.end(); i!= e; ++i){
 
-    bb_worklist.pop();
-    if( bb_visited.count(bb)) {
-      /* Block already visited */
+    Instruction* inst = *i;
+    Value* pointer_operand = NULL;
+    
+    if(ElideSpatialCheck.count(inst))
       continue;
+    
+    if(isa<LoadInst>(inst)){
+      LoadInst* ldi = dyn_cast<LoadInst>(inst);
+      pointer_operand = ldi->getPointerOperand();
+    }
+    if(isa<StoreInst>(inst)){
+      StoreInst* st = dyn_cast<StoreInst>(inst);
+      pointer_operand = st->getOperand(1);      
     }
-    /* If here implies basic block not visited */
-      
-    /* Insert the block into the set of visited blocks */
-    bb_visited.insert(bb);
-
-    /* Iterating over the successors and adding the successors to
-     * the work list
-     */
-    for(succ_iterator si = succ_begin(bb), se = succ_end(bb); si != se; ++si) {
-
-      BasicBlock* next_bb = *si;
-      assert(next_bb && "Not a basic block and I am adding to the base and bound worklist?");
-      bb_worklist.push(next_bb);
-    }
-      
-    for(BasicBlock::iterator i = bb->begin(), ie = bb->end(); i != ie; ++i){
-        Value* v1 = dyn_cast<Value>(i);
-        Instruction* new_inst = dyn_cast<Instruction>(i);
-
-
-        /* If the instruction is not present in the original, no
-         * instrumentaion 
-         */
-        if(!m_present_in_original.count(v1)) {
-          continue;
-        }
-
-        /* All instructions have been defined here as defining it in
-         * switch causes compilation errors. Assertions have been in
-         * the inserted in the specific cases
-         */
-        //errs() <<"inst: " << *new_inst << "\n";
-
-        switch(new_inst->getOpcode()) {
-          
-        case Instruction::Alloca:
-          {
-            AllocaInst* alloca_inst = dyn_cast<AllocaInst>(v1);
-            assert(alloca_inst && "Not an Alloca inst?");
-            HandleAlloca(alloca_inst, bb, i);
-          }
-          break;
-
-        case Instruction::Load:
-          {
-            LoadInst* load_inst = dyn_cast<LoadInst>(v1);            
-            assert(load_inst && "Not a Load inst?");
-            HandleLoad(load_inst);
-          }
-          break;
-
-        case Instruction::GetElementPtr:
-          {
-            GetElementPtrInst* gep_inst = dyn_cast<GetElementPtrInst>(v1);
-            assert(gep_inst && "Not a GEP inst?");
-            HandleGEP(gep_inst);
-          }
-          break;
-	
-        case BitCastInst::BitCast:
-          {
-            BitCastInst* bitcast_inst = dyn_cast<BitCastInst>(v1);
-            assert(bitcast_inst && "Not a BitCast inst?");
-            HandleBitCast(bitcast_inst);
-          }
-          break;
-
-        case Instruction::PHI:
-          {
-            PHINode* phi_node = dyn_cast<PHINode>(v1);
-            assert(phi_node && "Not a phi node?");
-            //printInstructionMap(v1);
-            HandlePHIPass1(phi_node);
-          }
-          /* PHINode ends */
-          break;
-          
-        case Instruction::Call:
-          {
-            CallInst* call_inst = dyn_cast<CallInst>(v1);
-            assert(call_inst && "Not a Call inst?");
-            HandleCallInst(call_inst);
-          }
-          break;
-
-        case Instruction::Select:
-          {
-            SelectInst* select_insn = dyn_cast<SelectInst>(v1);
-            assert(select_insn && "Not a select inst?");
-            int pass = 1;
-            HandleSelect(select_insn, pass);
-          }
-          break;
-
-        case Instruction::Store:
-          {
-            break;
-          }
-
-        case Instruction::IntToPtr:
-          {
-            IntToPtrInst* inttoptrinst = dyn_cast<IntToPtrInst>(v1);
-            assert(inttoptrinst && "Not a IntToPtrInst?");
-            HandleIntToPtr(inttoptrinst);
-            break;
-          }
-
-        case Instruction::Ret:
-          {
-            ReturnInst* ret = dyn_cast<ReturnInst>(v1);
-            assert(ret && "not a return inst?");
-            HandleReturnInst(ret);
-          }
-          break;
-	
-        case Instruction::ExtractElement:
-	    {
-	      ExtractElementInst * EEI = dyn_cast<ExtractElementInst>(v1);
-	      assert(EEI && "ExtractElementInst inst?");
-	      HandleExtractElement(EEI);
-	    }
-	    break;
-
-        case Instruction::ExtractValue:
-	    {
-	      ExtractValueInst * EVI = dyn_cast<ExtractValueInst>(v1);
-	      assert(EVI && "handle extract value inst?");
-	      HandleExtractValue(EVI);
-	    }
-	    break;
-            
-        default:
-          if(isa<PointerType>(v1->getType()))
-            assert(!isa<PointerType>(v1->getType())&&
-                   " Generating Pointer and not being handled");
-        } // for-end
-    }/* Basic Block iterator Ends */
-  } /* Function iterator Ends */
-}
 
-void Nova::HandleVectorStore(StoreInst* store_inst){
+    for(Value::use_iterator ui = pointer_operand->use_begin(),  
+	  ue = pointer_operand->use_end();
+	ui != ue; ++ui){
 
-  Value* operand = store_inst->getOperand(0);
-  Value* pointer_dest = store_inst->getOperand(1);
-  Instruction* insert_at = GetNextInstruction(store_inst);
+      Instruction* use_inst = dyn_cast<Instruction>(*ui);
+      if(!use_inst || (use_inst == inst))
+	continue;
 
-  if(!m_vector_pointer_base.count(operand)){
-    assert(0 && "vector base not found");
-  }
-  if(!m_vector_pointer_bound.count(operand)){
-    assert(0 && "vector bound not found");
+      if(!isa<LoadInst>(use_inst)  && !isa<StoreInst>(use_inst))
+	continue;
+
+      if(isa<StoreInst>(use_inst)){
+	if(use_inst->getOperand(1) != pointer_operand)
+	  continue;
+      }
+
+#if 0
+      if(m_dominator_tree->dominates(inst, use_inst)){
+	if(!ElideSpatialCheck.count(use_inst))
+	  ElideSpatialCheck[use_inst] = true;		
+      }
+    }
+#endif  
   }
+
+#endif
+
+  //Temporal Check Optimizations
+
   
-  Value* vector_base = m_vector_pointer_base[operand];
-  Value* vector_bound = m_vector_pointer_bound[operand];
+#if 0
 
-  const VectorType* vector_ty = dyn_cast<VectorType>(operand->getType());
-  uint64_t num_elements = vector_ty->getNumElements();
-  if (num_elements > 2){
-    assert(0 && "more than 2 element vectors not handled");
-  }
+#endif
 
-  Value* pointer_operand_bitcast = CastToVoidPtr(pointer_dest, insert_at);
-  for (uint64_t i = 0; i < num_elements; i++){
-    Constant* index = ConstantInt::get(Type::getInt32Ty(store_inst->getContext()), i);
+  /* intra-procedural load dererference check elimination map */
+  std::map<Value*, int> func_deref_check_elim_map;
+  std::map<Value*, int> func_temporal_check_elim_map;
 
-    Value* ptr_base = ExtractElementInst::Create(vector_base, index,"", insert_at);
-    Value* ptr_bound = ExtractElementInst::Create(vector_bound, index, "", insert_at);
+  /* WorkList Algorithm for adding dereference checks. Each basic
+   * block is visited only once. We start by visiting the current
+   * basic block, then pushing all the successors of the current
+   * basic block on to the queue if it has not been visited
+   */
     
-    SmallVector<Value*, 8> args;
-    args.clear();
-
-    args.push_back(pointer_operand_bitcast);
-    args.push_back(ptr_base);
-    args.push_back(ptr_bound);
-    args.push_back(index);
+  std::set<BasicBlock*> bb_visited;
+  std::queue<BasicBlock*> bb_worklist;
+  Function:: iterator bb_begin = func->begin();
 
-    CallInst::Create(m_metadata_store_vector_func, args, "", insert_at);    
-  }
-}   
+  BasicBlock* bb = dyn_cast<BasicBlock>(bb_begin);
+  assert(bb && "Not a basic block  and I am adding dereference checks?");
+  bb_worklist.push(bb);
 
-void Nova::HandleStore(StoreInst* store_inst) {
-  Value* operand = store_inst->getOperand(0);
-  Value* pointer_dest = store_inst->getOperand(1);
-  Instruction* insert_at = GetNextInstruction(store_inst);
     
-  if(isa<VectorType>(operand->getType())){
-    const VectorType* vector_ty = dyn_cast<VectorType>(operand->getType());
-    if(isa<PointerType>(vector_ty->getElementType())){
-      HandleVectorStore(store_inst);
-      return;
+  while(bb_worklist.size() != 0) {
+      
+    bb = bb_worklist.front();
+    assert(bb && "Not a BasicBlock?");
+    bb_worklist.pop();
+
+    if(bb_visited.count(bb)) {
+      /* Block already visited */
+      continue;
     }
-  }
 
-  /* If a pointer is being stored, then the base and bound
-   * corresponding to the pointer must be stored in the shadow space
-   */
-  if(!isa<PointerType>(operand->getType()))
-    return;
-      
+    /* If here implies basic block not visited */
+    /* Insert the block into the set of visited blocks */
+    bb_visited.insert(bb);
 
-  if(isa<ConstantPointerNull>(operand)) {
-    /* it is a constant pointer null being stored
-     * store null to the shadow space
+    /* Iterating over the successors and adding the successors to
+     * the worklist
      */
-#if 0    
-    StructType* ST = dyn_cast<StructType>(operand->getType());
+    for(succ_iterator si = succ_begin(bb), se = succ_end(bb); si != se; ++si) {
+        
+      BasicBlock* next_bb = *si;
+      assert(next_bb && "Not a basic block and I am adding to the base and bound worklist?");
+      bb_worklist.push(next_bb);
+    }
 
-    if(ST){
-      if(ST->isOpaque()){
-        DEBUG(errs()<<"Opaque type found\n");        
+    /* basic block load deref check optimization */
+    std::map<Value*, int> bb_deref_check_map;
+    std::map<Value*, int> bb_temporal_check_elim_map;
+    /* structure check optimization */
+    std::map<Value*, int> bb_struct_check_opt;
+
+    for(BasicBlock::iterator i = bb->begin(), ie = bb->end(); i != ie; ++i){
+      Value* v1 = dyn_cast<Value>(i);
+      Instruction* new_inst = dyn_cast<Instruction>(i);
+      
+      /* Do the dereference check stuff */
+      if(!m_present_in_original.count(v1))
+        continue;
+      
+      if(isa<LoadInst>(new_inst)){
+        LoadInst* ldi = dyn_cast<LoadInst>(new_inst);
+        pointer_operand = ldi->getPointerOperand();
+        if (vs.count(pointer_operand) == 0) {
+            //errs() << "skip check for non-sensitive pointers\n" ;
+            continue;
+        }
+        AddLoadStoreChecks(new_inst, func_deref_check_elim_map);
+        continue;
       }
 
-    }
-      Value* size_of_type = getSizeOfType(operand->getType());
-#endif
+      if(isa<StoreInst>(new_inst)){
+        StoreInst* st = dyn_cast<StoreInst>(new_inst);
+        pointer_operand = st->getOperand(1);      
+        if (vs.count(pointer_operand) == 0) {
+            //errs() << "skip check for non-sensitive pointers\n" ;
+            continue;
+        }
+        AddLoadStoreChecks(new_inst, func_deref_check_elim_map);
+        continue;
+      }
 
-      Value* size_of_type = NULL;
+      /* check call through function pointers */
+      if(isa<CallInst>(new_inst)) {
+          
+        // ZC:COMMENT OUT CALL CHECK DUE TO COMPLAINS ABOUT NO BASE AND BOUND INFO
+        if(CALLCHECKS) {
+          continue;
+        }          
+	  
 
-      AddStoreBaseBoundFunc(pointer_dest, m_void_null_ptr, 
-                            m_void_null_ptr, m_void_null_ptr, 
-                            size_of_type, insert_at);
+        SmallVector<Value*, 8> args;
+        CallInst* call_inst = dyn_cast<CallInst>(new_inst);
+        Value* tmp_base = NULL;
+        Value* tmp_bound = NULL;
+        
+        assert(call_inst && "call instruction null?");
+        errs() << "DEBUG: " << *call_inst;
+        
+        if(!INDIRECTCALLCHECKS)
+          continue;
 
-    return; 
-  }
+        /* TODO:URGENT : indirect function call checking commented
+         * out for the time being to test other aspect of the code,
+         * problem was with spec benchmarks perl and h264. They were
+         * primarily complaining that the use of a function did not
+         * have base and bound in the map
+         */
 
-      
-  /* if it is a global expression being stored, then add add
-   * suitable base and bound
-   */
-    
-  Value* tmp_base = NULL;
-  Value* tmp_bound = NULL;
 
-  //  Value* xmm_base_bound = NULL;
-  //  Value* xmm_key_lock = NULL;
-    
-  Constant* given_constant = dyn_cast<Constant>(operand);
-  if(given_constant) {      
-      GetConstantExprBaseBound(given_constant, tmp_base, tmp_bound);
-      assert(tmp_base && "global doesn't have base");
-      assert(tmp_bound && "global doesn't have bound");        
-  } else {      
-    /* storing an external function pointer */
-      if(!CheckBaseBoundMetadataPresent(operand)) {
-        return;
-      }
+        /* here implies its an indirect call */
+        Value* indirect_func_called = call_inst->getOperand(0);
+            
+        Constant* func_constant = dyn_cast<Constant>(indirect_func_called);
+        if(func_constant) {
+          GetConstantExprBaseBound(func_constant, tmp_base, tmp_bound);           
+        }
+        else {
+          tmp_base = GetAssociatedBase(indirect_func_called);
+          tmp_bound = GetAssociatedBound(indirect_func_called);
+        }
+        /* Add BitCast Instruction for the base */
+        Value* bitcast_base = CastToVoidPtr(tmp_base, new_inst);
+        args.push_back(bitcast_base);
+            
+        /* Add BitCast Instruction for the bound */
+        Value* bitcast_bound = CastToVoidPtr(tmp_bound, new_inst);
+        args.push_back(bitcast_bound);
+        Value* pointer_operand_value = CastToVoidPtr(indirect_func_called, new_inst);
+        args.push_back(pointer_operand_value);            
+        CallInst::Create(m_call_dereference_func, args, "", new_inst);
+        continue;
+      } /* Call check ends */
+    }
+  }  
+}
+
+//
+// Method: transformMain()
+//
+// Description:
+//
+// This method renames the function "main" in the module as
+// pseudo_main. The C-handler has the main function which calls
+// pseudo_main. Actually transformation of the main takes places in
+// two steps.  Step1: change the name to pseudo_main and Step2:
+// Function renaming to append the function name with softboundcets_
+//
+// Inputs:
+// module: Input module with the function main
+//
+// Outputs:
+//
+// Changed module with any function named "main" is changed to
+// "pseudo_main"
+//
+// Comments:
+//
+// This function is doing redundant work. We should probably use
+// renameFunction to accomplish the task. The key difference is that
+// transform renames it the function as either pseudo_main or
+// softboundcets_pseudo_main which is subsequently renamed to
+// softboundcets_pseudo_main in the first case by renameFunction
+//
 
-      tmp_base = GetAssociatedBase(operand);
-      tmp_bound = GetAssociatedBound(operand);              
-  }    
-  
-  /* Store the metadata into the metadata space
-   */
-  
+void Nova::TransformMain(Module& module) {
+    
+  Function* main_func = module.getFunction("main");
 
-  //  Type* stored_pointer_type = operand->getType();
-  Value* size_of_type = NULL;
-  //    Value* size_of_type  = getSizeOfType(stored_pointer_type);
-  AddStoreBaseBoundFunc(pointer_dest, tmp_base, tmp_bound, operand,  size_of_type, insert_at);    
-  
-}
+  // 
+  // If the program doesn't have main then don't do anything
+  //
+  if (!main_func) return;
 
-//
-// Method: getGlobalVariableBaseBound
+  Type* ret_type = main_func->getReturnType();
+  const FunctionType* fty = main_func->getFunctionType();
+  std::vector<Type*> params;
 
-// Description: This function returns the base and bound for the
-// global variables in the input reference arguments. This function
-// may now be obsolete. We should try to use getConstantExprBaseBound
-// instead in all places.
-void Nova::GetGlobalVariableBaseBound(Value* operand, 
-                                              Value* & operand_base, 
-                                              Value* & operand_bound){
+  SmallVector<AttributeSet, 8> param_attrs_vec;
+  const AttributeSet& pal = main_func->getAttributes();
 
-  GlobalVariable* gv = dyn_cast<GlobalVariable>(operand);
-  Module* module = gv->getParent();
-  assert(gv && "[getGlobalVariableBaseBound] not a global variable?");
-    
-  std::vector<Constant*> indices_base;
-  Constant* index_base = 
-    ConstantInt::get(Type::getInt32Ty(module->getContext()), 0);
-  indices_base.push_back(index_base);
+  //
+  // Get the attributes of the return value
+  //
 
-  Constant* base_exp = ConstantExpr::getGetElementPtr(nullptr, gv, indices_base);
-        
-  std::vector<Constant*> indices_bound;
-  Constant* index_bound = 
-    ConstantInt::get(Type::getInt32Ty(module->getContext()), 1);
-  indices_bound.push_back(index_bound);
+  if(pal.hasAttributes(AttributeSet::ReturnIndex))
+    param_attrs_vec.push_back(AttributeSet::get(main_func->getContext(), pal.getRetAttributes()));
 
-  Constant* bound_exp = ConstantExpr::getGetElementPtr(nullptr, gv, indices_bound);
-    
-  operand_base = base_exp;
-  operand_bound = bound_exp;    
-}
+  // Get the attributes of the arguments 
+  int arg_index = 1;
+  for(Function::arg_iterator i = main_func->arg_begin(), 
+        e = main_func->arg_end();
+      i != e; ++i, arg_index++) {
+    params.push_back(i->getType());
 
-//
-// Method: handlePHIPass2()
-//
-// Description: This pass fills the incoming values for the metadata
-// PHINodes inserted in the first pass. There are four cases that
-// needs to be handled for each incoming value.  First, if the
-// incoming value is a ConstantPointerNull, then base, bound, key,
-// lock will be default values.  Second, the incoming value can be an
-// undef which results in default metadata values.  Third, Global
-// variables need to get the same base and bound for each
-// occurence. So we maintain a map which maps the base and boundfor
-// each global variable in the incoming value.  Fourth, by default it
-// retrieves the metadata from the SoftBound/CETS maps.
+    AttributeSet attrs = pal.getParamAttributes(arg_index);
 
-// Check if we need separate global variable and constant expression
-// cases.
+    if(attrs.hasAttributes(arg_index)){
+      AttrBuilder B(attrs, arg_index);
+      param_attrs_vec.push_back(AttributeSet::get(main_func->getContext(), params.size(), B));
+    }
+  }
 
-void Nova::HandlePHIPass2(PHINode* phi_node) {
-  // Work to be done only for pointer PHINodes.
-  if (!isa<PointerType>(phi_node->getType())) 
-    return;
+  FunctionType* nfty = FunctionType::get(ret_type, params, fty->isVarArg());
+  Function* new_func = NULL;
 
-  PHINode* base_phi_node = NULL;
-  PHINode* bound_phi_node  = NULL;
+  // create the new function 
+  new_func = Function::Create(nfty, main_func->getLinkage(), 
+                              "softboundcets_pseudo_main");
 
-  // Obtain the metada PHINodes 
-  base_phi_node = dyn_cast<PHINode>(GetAssociatedBase(phi_node));
-  bound_phi_node = dyn_cast<PHINode>(GetAssociatedBound(phi_node));
+  // set the new function attributes 
+  new_func->copyAttributesFrom(main_func);
+  new_func->setAttributes(AttributeSet::get(main_func->getContext(), param_attrs_vec));
+    
+  main_func->getParent()->getFunctionList().insert(main_func->getIterator(), new_func);
+  main_func->replaceAllUsesWith(new_func);
 
-  std::map<Value*, Value*> globals_base;
-  std::map<Value*, Value*> globals_bound;
- 
-  unsigned num_incoming_values = phi_node->getNumIncomingValues();
-  for (unsigned m = 0; m < num_incoming_values; m++) {
+  // 
+  // Splice the instructions from the old function into the new
+  // function and set the arguments appropriately
+  // 
+  new_func->getBasicBlockList().splice(new_func->begin(), 
+                                       main_func->getBasicBlockList());
+  Function::arg_iterator arg_i2 = new_func->arg_begin();
+  for(Function::arg_iterator arg_i = main_func->arg_begin(), 
+        arg_e = main_func->arg_end(); 
+      arg_i != arg_e; ++arg_i) {      
+    arg_i->replaceAllUsesWith(&*arg_i2);
+    arg_i2->takeName(&*arg_i);
+    ++arg_i2;
+    arg_index++;
+  }  
+  //
+  // Remove the old function from the module
+  //
+  main_func->eraseFromParent();
+}
 
-    Value* incoming_value = phi_node->getIncomingValue(m);
-    BasicBlock* bb_incoming = phi_node->getIncomingBlock(m);
+void Nova::PrepareForBoundsCheck(Module &M, ValueSet &vs) {
+    TransformMain(M);
+    IdentifyFuncToTrans(M);
+    IdentifyInitialGlobals(M);
+    AddBaseBoundGlobals(M);
 
-    if (isa<ConstantPointerNull>(incoming_value)) {
-        base_phi_node->addIncoming(m_void_null_ptr, bb_incoming);
-        bound_phi_node->addIncoming(m_void_null_ptr, bb_incoming);
-      continue;
-    } // ConstantPointerNull ends
-   
-    // The incoming vlaue can be a UndefValue
-    if (isa<UndefValue>(incoming_value)) {        
-        base_phi_node->addIncoming(m_void_null_ptr, bb_incoming);
-        bound_phi_node->addIncoming(m_void_null_ptr, bb_incoming);
-      continue;
-    } // UndefValue ends
+    for(Module::iterator ff_begin = M.begin(), ff_end = M.end(); 
+        ff_begin != ff_end; ++ff_begin){
+      Function* func_ptr = dyn_cast<Function>(ff_begin);
+      assert(func_ptr && "Not a function??");
       
-    Value* incoming_value_base = NULL;
-    Value* incoming_value_bound = NULL;
-    
-    // handle global variables      
-    GlobalVariable* gv = dyn_cast<GlobalVariable>(incoming_value);
-    if (gv) {
-        if (!globals_base.count(gv)) {
-          Value* tmp_base = NULL;
-          Value* tmp_bound = NULL;
-          GetGlobalVariableBaseBound(incoming_value, tmp_base, tmp_bound);
-          assert(tmp_base && "base of a global variable null?");
-          assert(tmp_bound && "bound of a global variable null?");
-          
-          Function * PHI_func = phi_node->getParent()->getParent();
-          Instruction* PHI_func_entry = &*(PHI_func->begin()->begin());
-          
-          incoming_value_base = CastToVoidPtr(tmp_base, PHI_func_entry);                                               
-          incoming_value_bound = CastToVoidPtr(tmp_bound, PHI_func_entry);
-            
-          globals_base[incoming_value] = incoming_value_base;
-          globals_bound[incoming_value] = incoming_value_bound;       
-        } else {
-          incoming_value_base = globals_base[incoming_value];
-          incoming_value_bound = globals_bound[incoming_value];          
+      //
+      // No instrumentation for functions introduced by us for updating
+      // and retrieving the shadow space
+      //
+        
+      if (!CheckIfFunctionOfInterest(func_ptr)) {
+        continue;
+      }  
+      //
+      // Iterating over the instructions in the function to identify IR
+      // instructions in the original program In this pass, the pointers
+      // in the original program are also identified
+      //
+        
+      IdentifyOriginalInst(func_ptr);
+        
+      //
+      // Iterate over all basic block and then each insn within a basic
+      // block We make two passes over the IR for base and bound
+      // propagation and one pass for dereference checks
+      //
+  
+      GatherBaseBoundPass1(func_ptr);
+      GatherBaseBoundPass2(func_ptr);
+      //AddDereferenceChecks(func_ptr, vs);
+    }
+}
+
+void Nova::PointerBoundaryCheck(Module &M, ValueSet &vs) {
+//    Value *v;
+
+    errs() << __func__ << " : "<< "\n";
+
+    // Note! we almost need to fully implement Softbound here, the
+    // only difference is that we selectively add check for sensitive vars.
+    // we simplify the implementation as follows:
+    //  1. we only support ARM64bit architecture.
+    //  2. we only support spatial safty check and don't support temporal safty.
+    //  3. we don't support shadow stack.
+    // Attention:
+    //  1. we might need to transform all functions that take pointer as params
+    //     or ret_type is pointer.
+    //  2. such functions can't be exported to outside module due to the transformation.
+    //  3. library calls, leave it as it is.
+    PrepareForBoundsCheck(M, vs);
+
+    // identify pointer types
+#if 0
+    for (ValueSet::iterator it = vs.begin(), ie = vs.end();
+                                              it != ie; ++it) {
+        v = *it;
+        errs() <<"var :" << (*v) << "\n";
+        if (v->getType()->isPointerTy()) {
+            errs() << v->getName() << " is pointer \n";
+            if (v->getType()->getPointerElementType()->isPointerTy()) {
+                errs() << v->getName() << " points to a pointer type\n";
+                //PointerAccessCheck(M, v);
+                ArrayAccessCheck(M, v);
+            } else if (v->getType()->getPointerElementType()->isArrayTy()) {
+                errs() << v->getName() << " points to a array type\n";
+                ArrayAccessCheck(M, v);
+            }
         }
-    } // global variable ends
-      
-    // handle constant expressions 
-    Constant* given_constant = dyn_cast<Constant>(incoming_value);
-    if (given_constant) {
-        if (!globals_base.count(incoming_value)) {
-          Value* tmp_base = NULL;
-          Value* tmp_bound = NULL;
-          GetConstantExprBaseBound(given_constant, tmp_base, tmp_bound);
-          assert(tmp_base && tmp_bound  &&
-                 "[handlePHIPass2] tmp_base tmp_bound, null?");
-          
-          Function* PHI_func = phi_node->getParent()->getParent();
-          Instruction* PHI_func_entry = &*(PHI_func->begin()->begin());
+    }
+#endif
 
-          incoming_value_base = CastToVoidPtr(tmp_base, PHI_func_entry);
-          incoming_value_bound = CastToVoidPtr(tmp_bound, PHI_func_entry);
-          
-          globals_base[incoming_value] = incoming_value_base;
-          globals_bound[incoming_value] = incoming_value_bound;        
+    return;
+}
+
+// enforce def-use check based on analysis result stored in gs
+// The IR of a function without its metadata: metadata is numbered across the
+// module, so an edit anywhere else would renumber the attachments printed here.
+// Only the kind of a non-debug attachment is kept, e.g. !oat.sensitive.
+std::string Nova::GetFunctionHash(Function &F, ModuleSlotTracker &MST) {
+    SmallVector<std::pair<unsigned, MDNode *>, 4> mds;
+    SmallVector<StringRef, 8> mdKinds;
+    MD5 hash;
+    MD5::MD5Result result;
+    SmallString<32> str;
+    std::string buf;
+    raw_string_ostream os(buf);
+
+    F.getContext().getMDKindNames(mdKinds);
+
+    os << F.getName() << " " << *F.getFunctionType() << "\n";
+    if (!F.isDeclaration()) {
+        MST.incorporateFunction(F);
+        for (Instruction &I : instructions(F)) {
+            if (isa<DbgInfoIntrinsic>(I))
+                continue;
+            os << I.getOpcodeName() << " " << *I.getType();
+            for (Value *op : I.operands()) {
+                if (isa<MetadataAsValue>(op))
+                    continue;
+                os << " ";
+                op->printAsOperand(os, true, MST);
+            }
+            mds.clear();
+            I.getAllMetadataOtherThanDebugLoc(mds);
+            for (auto &md : mds) {
+                if (md.first < mdKinds.size())
+                    os << " !" << mdKinds[md.first];
+            }
+            os << "\n";
         }
-        else{
-          incoming_value_base = globals_base[incoming_value];
-          incoming_value_bound = globals_bound[incoming_value];          
+    }
+    os.flush();
+
+    hash.update(buf);
+    hash.final(result);
+    MD5::stringifyResult(result, str);
+
+    return str.str();
+}
+
+// The key of a function covers its IR and the IR of everything it may call,
+// which is what its summary and the points-to sets of its values depend on.
+// An indirect call may reach any address-taken function.
+std::string Nova::GetFunctionKey(Function *f, DenseMap<Function *, std::string> &hashes,
+                                 std::vector<Function *> &addrTaken) {
+    SmallPtrSet<Function *, 32> visited;
+    SmallVector<Function *, 32> worklist;
+    std::vector<std::string> reached;
+    MD5 hash;
+    MD5::MD5Result result;
+    SmallString<32> str;
+
+    worklist.push_back(f);
+    visited.insert(f);
+    while (!worklist.empty()) {
+        Function *cur = worklist.pop_back_val();
+
+        reached.push_back(hashes[cur]);
+        for (Instruction &I : instructions(cur)) {
+            CallSite cs(&I);
+            if (!cs || cs.isInlineAsm())
+                continue;
+
+            if (auto *callee = dyn_cast<Function>(cs.getCalledValue()->stripPointerCasts())) {
+                if (visited.insert(callee).second)
+                    worklist.push_back(callee);
+                continue;
+            }
+            for (Function *callee : addrTaken) {
+                if (visited.insert(callee).second)
+                    worklist.push_back(callee);
+            }
         }
     }
-    
-    // handle values having map based pointer base and bounds 
-    if(CheckBaseBoundMetadataPresent(incoming_value)){
-      incoming_value_base = GetAssociatedBase(incoming_value);
-      incoming_value_bound = GetAssociatedBound(incoming_value);
+
+    // independent of the order of the functions in the module
+    std::sort(reached.begin(), reached.end());
+    for (std::string &h : reached)
+        hash.update(h);
+    hash.final(result);
+    MD5::stringifyResult(result, str);
+
+    return str.str();
+}
+
+// The digest every cache key starts from: NOVA_CACHE_VERSION, the analysis
+// options, the struct types and globals. The hash of each function is kept
+// for GetFunctionKey. The module header is left out, so the same program
+// linked in another directory still hits.
+void Nova::ComputeCacheKeys(Module &M) {
+    ModuleSlotTracker MST(&M, /*ShouldInitializeAllMetadata=*/false);
+    MD5 hash;
+    MD5::MD5Result result;
+    SmallString<32> str;
+    std::string buf;
+    raw_string_ostream os(buf);
+
+    os << NOVA_CACHE_VERSION << " " << UseSummaries << " " << DemandDriven << "\n";
+    for (StructType *st : M.getIdentifiedStructTypes()) {
+        st->print(os);
+        os << "\n";
+    }
+
+    // without their !dbg attachments, see GetFunctionHash
+    for (GlobalVariable &gv : M.globals()) {
+        os << gv.getName() << " " << *gv.getValueType() << " " << gv.isConstant();
+        if (gv.hasInitializer()) {
+            os << " ";
+            gv.getInitializer()->printAsOperand(os, true, MST);
+        }
+        os << "\n";
     }
+    os.flush();
 
-    assert(incoming_value_base &&
-           "[handlePHIPass2] incoming_value doesn't have base?");
-    assert(incoming_value_bound && 
-           "[handlePHIPass2] incoming_value doesn't have bound?");
-    
-    base_phi_node->addIncoming(incoming_value_base, bb_incoming);
-    bound_phi_node->addIncoming(incoming_value_bound, bb_incoming);
-  } // Iterating over incoming values ends 
+    hash.update(buf);
+    hash.final(result);
+    MD5::stringifyResult(result, str);
+    cacheHeader = str.str();
 
-  assert(base_phi_node && "[handlePHIPass2] base_phi_node null?");
-  assert(bound_phi_node && "[handlePHIPass2] bound_phi_node null?");
+    for (Function &F : M) {
+        funcHashes[&F] = GetFunctionHash(F, MST);
+        if (F.hasAddressTaken())
+            hashedAddrTaken.push_back(&F);
+    }
 
-  unsigned n_values = phi_node->getNumIncomingValues();
-  unsigned n_base_values = base_phi_node->getNumIncomingValues();
-  unsigned n_bound_values = bound_phi_node->getNumIncomingValues();    
-  assert((n_values == n_base_values)  && 
-         "[handlePHIPass2] number of values different for base");
-  assert((n_values == n_bound_values) && 
-         "[handlePHIPass2] number of values different for bound");
+    return;
 }
-  
 
-void Nova::GatherBaseBoundPass2(Function* func){
+// The key of the sensitive variables mixes cacheHeader and the keys of the
+// functions the result depends on: main and the functions with annotated
+// allocas when traversing call paths from main, every function otherwise.
+// Editing a function main does not reach leaves the entry valid.
+std::string Nova::GetCacheFile(Module &M) {
+    std::vector<std::string> keys;
+    SetVector<Function *> roots;
+    MD5 hash;
+    MD5::MD5Result result;
+    SmallString<32> key;
+    SmallString<128> file;
+
+    hash.update(cacheHeader);
+
+    for (Function &F : M) {
+        if (F.isDeclaration())
+            continue;
 
-  /* WorkList Algorithm for propagating base and bound. Each basic
-   * block is visited only once
-   */
-  std::set<BasicBlock*> bb_visited;
-  std::queue<BasicBlock*> bb_worklist;
-  Function::iterator bb_begin = func->begin();
+        if (UseSummaries || DemandDriven || F.getName() == "main") {
+            roots.insert(&F);
+            continue;
+        }
+        for (Instruction &I : instructions(F)) {
+            if (isa<AllocaInst>(&I) && I.getMetadata(oat::SensitiveMDName)) {
+                roots.insert(&F);
+                break;
+            }
+        }
+    }
 
-  BasicBlock* bb = dyn_cast<BasicBlock>(bb_begin);
-  assert(bb && "Not a basic block and gathering base bound in the next pass?");
-  bb_worklist.push(bb);
-    
-  while( bb_worklist.size() != 0) {
+    for (Function *f : roots)
+        keys.push_back(GetFunctionKey(f, funcHashes, hashedAddrTaken));
+    std::sort(keys.begin(), keys.end());
+    for (std::string &k : keys)
+        hash.update(k);
 
-    bb = bb_worklist.front();
-    assert(bb && "Not a BasicBlock?");
+    hash.final(result);
+    MD5::stringifyResult(result, key);
 
-    bb_worklist.pop();
-    if( bb_visited.count(bb)) {
-      /* Block already visited */
+    file = NovaCacheDir;
+    sys::path::append(file, "nova-" + key);
 
-      continue;
-    }
-    /* If here implies basic block not visited */
-      
-    /* Insert the block into the set of visited blocks */
-    bb_visited.insert(bb);
+    return file.str();
+}
 
-    /* Iterating over the successors and adding the successors to
-     * the work list
-     */
-    for(succ_iterator si = succ_begin(bb), se = succ_end(bb); si != se; ++si) {
+// write to a temporary and rename, concurrent builds may share the cache
+static void WriteCacheFile(StringRef file, StringRef buf) {
+    SmallString<128> tmpFile;
+    int fd;
 
-      BasicBlock* next_bb = *si;
-      assert(next_bb && "Not a basic block and I am adding to the base and bound worklist?");
-      bb_worklist.push(next_bb);
+    if (sys::fs::create_directories(NovaCacheDir) ||
+        sys::fs::createUniqueFile(file + "-%%%%%%", fd, tmpFile))
+        return;
+
+    {
+        raw_fd_ostream out(fd, /*shouldClose=*/true);
+        out << buf;
     }
 
-    for(BasicBlock::iterator i = bb->begin(), ie = bb->end(); i != ie; ++i) {
-      Value* v1 = dyn_cast<Value>(i);
-      Instruction* new_inst = dyn_cast<Instruction>(i);
+    if (sys::fs::rename(tmpFile, file))
+        sys::fs::remove(tmpFile);
 
-      // If the instruction is not present in the original, no instrumentaion
-      if(!m_present_in_original.count(v1))
-        continue;
+    return;
+}
 
-      switch(new_inst->getOpcode()) {
+static void PruneCache() {
+    CachePruning(NovaCacheDir)
+        .setPruningInterval(std::chrono::hours(1))
+        .setEntryExpiration(std::chrono::hours(24) * NovaCacheExpiration)
+        .prune();
+}
 
-      case Instruction::GetElementPtr:
-        {
-          GetElementPtrInst* gep_inst = dyn_cast<GetElementPtrInst>(v1);         
-          assert(gep_inst && "Not a GEP instruction?");
-          HandleGEP(gep_inst);
+// Return an instruction using CE, directly or through other constant
+// expressions, and append the operand numbers leading from it to CE to path.
+// Return NULL if only global initializers use CE.
+static Instruction *FindConstantUse(ConstantExpr *CE, SmallVectorImpl<unsigned> &path) {
+    for (Use &U : CE->uses()) {
+        if (auto *I = dyn_cast<Instruction>(U.getUser())) {
+            path.push_back(U.getOperandNo());
+            return I;
         }
-        break;
-          
-      case Instruction::Store:
-        {
-          StoreInst* store_inst = dyn_cast<StoreInst>(v1);
-          assert(store_inst && "Not a Store instruction?");
-          HandleStore(store_inst);
+        if (auto *UCE = dyn_cast<ConstantExpr>(U.getUser())) {
+            if (Instruction *I = FindConstantUse(UCE, path)) {
+                path.push_back(U.getOperandNo());
+                return I;
+            }
         }
-        break;
+    }
 
-      case Instruction::PHI:
-        {
-          PHINode* phi_node = dyn_cast<PHINode>(v1);
-          assert(phi_node && "Not a PHINode?");
-          HandlePHIPass2(phi_node);
+    return NULL;
+}
+
+// the constant expression path leads to from U, see FindConstantUse
+static Value *ResolveConstantUse(User *U, ArrayRef<unsigned> path) {
+    Value *v = NULL;
+
+    for (unsigned op : path) {
+        if (op >= U->getNumOperands() || !isa<ConstantExpr>(U->getOperand(op)))
+            return NULL;
+        v = U->getOperand(op);
+        U = cast<User>(v);
+    }
+
+    return v;
+}
+
+// Values are recorded as "g 0 <global>", "a <arg no> <function>",
+// "i <inst no> <function>" or "c <inst no>.<operand no>... <function>" for a
+// constant expression and the operands leading to it from an instruction,
+// see FindConstantUse. Instructions are numbered in inst_iterator order.
+bool Nova::LoadSensitiveVars(Module &M, StringRef file, ValueSet &senVarSet) {
+    DenseMap<Function *, std::vector<Instruction *>> insts;
+    SmallVector<StringRef, 3> fields;
+    SmallVector<StringRef, 4> nums;
+    SmallVector<unsigned, 4> path;
+    ErrorOr<std::unique_ptr<MemoryBuffer>> buf = MemoryBuffer::getFile(file);
+    ValueSet vars;
+    Value *v;
+    Function *f;
+    unsigned n, op;
+
+    if (!buf)
+        return false;
+
+    for (line_iterator it(**buf, /*SkipBlanks=*/true), ie; it != ie; ++it) {
+        // names may contain spaces, they come last
+        fields.clear();
+        it->split(fields, ' ', 2);
+        if (fields.size() != 3)
+            return false;
+
+        nums.clear();
+        fields[1].split(nums, '.');
+        if (nums[0].getAsInteger(10, n) || (fields[0] != "c" && nums.size() != 1))
+            return false;
+
+        if (fields[0] == "g") {
+            if (M.getNamedValue(fields[2]) == NULL)
+                return false;
+            vars.insert(M.getNamedValue(fields[2]));
+            continue;
         }
-        break;
- 
-      case BitCastInst::BitCast:
-        {
-          BitCastInst* bitcast_inst = dyn_cast<BitCastInst>(v1);
-          assert(bitcast_inst && "Not a bitcast instruction?");
-          HandleBitCast(bitcast_inst);
+
+        f = M.getFunction(fields[2]);
+        if (f == NULL)
+            return false;
+
+        if (fields[0] == "a" && n < f->arg_size()) {
+            vars.insert(&*std::next(f->arg_begin(), n));
+            continue;
         }
-        break;
 
-      case SelectInst::Select:
-        {
+        std::vector<Instruction *> &fi = insts[f];
+        if (fi.empty()) {
+            for (inst_iterator iit = inst_begin(f), iie = inst_end(f); iit != iie; ++iit)
+                fi.push_back(&*iit);
         }
-        break;
-          
-      default:
-        break;
-      }/* Switch Ends */
-    }/* BasicBlock iterator Ends */
-  }/* Function iterator Ends */
+        if (n >= fi.size())
+            return false;
+
+        if (fields[0] == "i") {
+            vars.insert(fi[n]);
+            continue;
+        }
+        if (fields[0] != "c" || nums.size() < 2)
+            return false;
+
+        path.clear();
+        for (unsigned i = 1; i < nums.size(); i++) {
+            if (nums[i].getAsInteger(10, op))
+                return false;
+            path.push_back(op);
+        }
+        v = ResolveConstantUse(fi[n], path);
+        if (v == NULL)
+            return false;
+        vars.insert(v);
+    }
+
+    errs() << "Nova cache hit: " << file << "\n";
+    senVarSet.insert(vars.begin(), vars.end());
+
+    return true;
 }
 
-void Nova::AddBaseBoundGlobals(Module& M){
-  /* iterate over the globals here */
+void Nova::StoreSensitiveVars(Module &M, StringRef file, ValueSet &senVarSet) {
+    DenseMap<Instruction *, unsigned> instNo;
+    SmallVector<unsigned, 4> path;
+    std::string buf;
+    raw_string_ostream os(buf);
+    Instruction *inst;
+    StringRef name;
+    Function *f;
+    unsigned n;
 
-  for(Module::global_iterator it = M.global_begin(), ite = M.global_end(); it != ite; ++it){
-    
-    GlobalVariable* gv = dyn_cast<GlobalVariable>(it);
-    
-    if(!gv){
-      continue;
-    }
+    auto NumberInsts = [&](Function *f) {
+        if (instNo.find(&*inst_begin(f)) != instNo.end())
+            return;
+        n = 0;
+        for (inst_iterator iit = inst_begin(f), iie = inst_end(f); iit != iie; ++iit)
+            instNo[&*iit] = n++;
+    };
+
+    for (Value *v : senVarSet) {
+        if (auto *gv = dyn_cast<GlobalValue>(v)) {
+            name = gv->getName();
+            os << "g 0 ";
+        } else if (auto *arg = dyn_cast<Argument>(v)) {
+            name = arg->getParent()->getName();
+            os << "a " << arg->getArgNo() << " ";
+        } else if ((inst = dyn_cast<Instruction>(v))) {
+            f = inst->getFunction();
+            NumberInsts(f);
+            name = f->getName();
+            os << "i " << instNo[inst] << " ";
+        } else if (auto *ce = dyn_cast<ConstantExpr>(v)) {
+            path.clear();
+            inst = FindConstantUse(ce, path);
+            if (inst == NULL) {
+                errs() << "Nova cache: not storing " << file << ", no instruction uses "
+                       << *ce << "\n";
+                return;
+            }
+            f = inst->getFunction();
+            NumberInsts(f);
+            name = f->getName();
+            os << "c " << instNo[inst];
+            for (unsigned op : path)
+                os << "." << op;
+            os << " ";
+        } else {
+            errs() << "Nova cache: not storing " << file << ", cannot record " << *v << "\n";
+            return;
+        }
 
-    if(StringRef(gv->getSection()) == "llvm.metadata"){
-      continue;
-    }
-    if(gv->getName() == "llvm.global_ctors"){
-      continue;
+        if (name.empty() || name.find('\n') != StringRef::npos) {
+            errs() << "Nova cache: not storing " << file << ", no usable name for "
+                   << *v << "\n";
+            return;
+        }
+        os << name << "\n";
     }
-    
-    if(!gv->hasInitializer())
-      continue;
-    
-    /* gv->hasInitializer() is true */
-    
-    Constant* initializer = dyn_cast<Constant>(it->getInitializer());
-    ConstantArray* constant_array = dyn_cast<ConstantArray>(initializer);
-    
-    if(initializer && isa<CompositeType>(initializer->getType())){
+    os.flush();
 
-      if(isa<StructType>(initializer->getType())){
-        std::vector<Constant*> indices_addr_ptr;
-        Constant* index1 = ConstantInt::get(Type::getInt32Ty(M.getContext()), 0);
-        indices_addr_ptr.push_back(index1);
-        StructType* struct_type = dyn_cast<StructType>(initializer->getType());
-        HandleGlobalStructTypeInitializer(M, struct_type, initializer, gv, indices_addr_ptr, 1);
-        continue;
-      }
-      
-      if(isa<SequentialType>(initializer->getType())){
-        HandleGlobalSequentialTypeInitializer(M, gv);
-      }
-    }
-    
-    if(initializer && !constant_array){
-      
-      if(isa<PointerType>(initializer->getType())){
-        //        std::cerr<<"Pointer type initializer\n";
-      }
-    }
-    
-    if(!constant_array)
-      continue;
-    
-    int num_ca_opds = constant_array->getNumOperands();
-    
-    for(int i = 0; i < num_ca_opds; i++){
-      Value* initializer_opd = constant_array->getOperand(i);
-      Instruction* first = GetGlobalInitInstruction(M);
-      Value* operand_base = NULL;
-      Value* operand_bound = NULL;
-      
-      Constant* global_constant_initializer = dyn_cast<Constant>(initializer_opd);
-      if(!isa<PointerType>(global_constant_initializer->getType())){
-        break;
-      }
-      GetConstantExprBaseBound(global_constant_initializer, operand_base, operand_bound);
-      
-      SmallVector<Value*, 8> args;
-      Constant* index1 = ConstantInt::get(Type::getInt32Ty(M.getContext()), 0);
-      Constant* index2 = ConstantInt::get(Type::getInt32Ty(M.getContext()), i);
+    WriteCacheFile(file, buf);
+    PruneCache();
 
-      std::vector<Constant*> indices_addr_ptr;
-      indices_addr_ptr.push_back(index1);
-      indices_addr_ptr.push_back(index2);
+    return;
+}
+
+// The entry of a function summary covers cacheHeader, the functions
+// -nova-demand-driven summarizes and the IR of the function and everything
+// it may call, see GetFunctionKey.
+std::string Nova::GetSummaryCacheFile(Function *f) {
+    MD5 hash;
+    MD5::MD5Result result;
+    SmallString<32> key;
+    SmallString<128> file;
+
+    hash.update(summaryKey);
+    hash.update(GetFunctionKey(f, funcHashes, hashedAddrTaken));
+    hash.final(result);
+    MD5::stringifyResult(result, key);
+
+    file = NovaCacheDir;
+    sys::path::append(file, "nova-fn-" + key);
+
+    return file.str();
+}
+
+// An entry of the summary cache holds everything the traversal of a function
+// computed, with every name it refers to listed first:
+//   n <index> <name>           a global or function the entry refers to
+//   f <fn>                     the function
+//   s <value>                  an annotated value
+//   p <value> <tuple>...       the points-to set of a value
+//   t <value> <inst>...        the taint set of a value
+//   r <tuple>...               the points-to set of the returned value
+//   R <inst>...                the taint of the returned value
+//   u <object>                 a global object read
+//   d <object> <offset>        a global object stored to
+//   c <fn>                     a callee summary applied
+//   b <object> <object>...     a callee placeholder and what the calls bound it to
+//   a <object> <offset> <object>...  the objects an object holds at offset
+//   m <object> <offset> <inst>...    the taint of an object at offset
+// A value is g<n> for a global, a<n>.<arg no>, i<n>.<inst no>, or
+// c<n>.<inst no>.<operand no>... for a constant expression operand, n
+// indexing the names and instructions numbered in inst_iterator order. An
+// object is the value it was created for followed by the path to it in the
+// nested objects CreateAliasObject created, e.g. i3.12/0/1, a tuple adds its
+// offset, e.g. i3.12/0@8. <inst> is <n>.<inst no>.
+// The objects are all the entry reaches, with what they held at the end of
+// the analysis. An entry refers to objects and instructions of other
+// functions, it is only loaded if their entries are.
+namespace {
+class SummaryCacheWriter {
+public:
+    SummaryCacheWriter(Nova &N, Module &M);
+    bool Write(GlobalStateRef gs, Function *f, FunctionSummary *summary,
+               std::string &out);
+    const char *failure;
+
+private:
+    Nova &N;
+    DenseMap<Instruction *, unsigned> instNo;
+    DenseMap<AliasObjectRef, std::pair<Value *, std::string>> objPaths;
+    MapVector<GlobalValue *, unsigned> names;
+
+    void AddObjectPaths(AliasObjectRef ao, Value *root, const std::string &path);
+    std::string NameIndex(GlobalValue *gv);
+    std::string ValueToken(Value *v);
+    std::string ObjectToken(AliasObjectRef ao);
+    std::string TupleToken(AliasObjectTupleRef aot);
+    std::string InstToken(unsigned id);
+};
+
+// An entry read back, see SummaryCacheWriter
+struct SummaryCacheEntry {
+    Function *f;
+    std::unique_ptr<MemoryBuffer> buf;
+    std::vector<GlobalValue *> names;
+    bool valid;
+};
+
+class SummaryCacheReader {
+public:
+    SummaryCacheReader(Nova &N, GlobalStateRef gs) : N(N), gs(gs) {}
+    bool Read(SummaryCacheEntry &e, bool apply);
+    DenseMap<Value *, AliasObjectRef> roots;
+
+private:
+    Nova &N;
+    GlobalStateRef gs;
+    SummaryCacheEntry *entry;
+    DenseMap<Function *, std::vector<Instruction *>> insts;
+
+    Function *ReadFunction(StringRef tok);
+    Instruction *ReadInst(StringRef tok);
+    Value *ReadValue(StringRef tok);
+    AliasObjectRef GetRoot(Value *v);
+    AliasObjectRef ReadObject(StringRef tok);
+    AliasObjectTupleRef ReadTuple(StringRef tok);
+    std::vector<Instruction *> &GetInsts(Function *f);
+};
+} // namespace
+
+SummaryCacheWriter::SummaryCacheWriter(Nova &N, Module &M) : N(N) {
+    unsigned n;
+
+    for (Function &F : M) {
+        n = 0;
+        for (Instruction &I : instructions(F))
+            instNo[&I] = n++;
+    }
+
+    for (auto &it : N.Arena.roots)
+        AddObjectPaths(it.second, it.first, "");
+}
+
+// the nested objects are the first ones in the fields CreateAliasObject
+// created, nothing is ever removed from an alias object set
+void SummaryCacheWriter::AddObjectPaths(AliasObjectRef ao, Value *root,
+                                        const std::string &path) {
+    unsigned fields = 1;
+
+    if (!objPaths.insert(std::make_pair(ao, std::make_pair(root, path))).second)
+        return;
+    if (ao->isLocation || ao->aliasMap == NULL)
+        return;
+
+    if (ao->isStruct)
+        fields = ao->type->getStructNumElements();
+    for (unsigned i = 0; i < fields; i++) {
+        auto it = ao->aliasMap->find(i);
+        if (it != ao->aliasMap->end() && !it->second->empty())
+            AddObjectPaths(*it->second->begin(), root, path + "/" + std::to_string(i));
+    }
+}
 
-      Constant* addr_of_ptr = ConstantExpr::getGetElementPtr(nullptr, gv, indices_addr_ptr);
-      Type* initializer_type = initializer_opd->getType();
-      Value* initializer_size = GetSizeOfType(initializer_type);
-      
-      AddStoreBaseBoundFunc(addr_of_ptr, operand_base, operand_bound, initializer_opd, initializer_size, first);
-      
+std::string SummaryCacheWriter::NameIndex(GlobalValue *gv) {
+    if (!gv->hasName() || gv->getName().find('\n') != StringRef::npos) {
+        failure = "it refers to an unnamed value";
+        return "";
     }
-  }
 
+    auto it = names.insert(std::make_pair(gv, names.size()));
+    return std::to_string(it.first->second);
 }
 
-//
-//
-// Method: addLoadStoreChecks
-//
-// Description: This function inserts calls to C-handler spatial
-// safety check functions and elides the check if the map says it is
-// not necessary to check.
+std::string SummaryCacheWriter::ValueToken(Value *v) {
+    if (auto *gv = dyn_cast<GlobalVariable>(v))
+        return "g" + NameIndex(gv);
+    if (auto *arg = dyn_cast<Argument>(v))
+        return "a" + NameIndex(arg->getParent()) + "." + std::to_string(arg->getArgNo());
+    if (auto *I = dyn_cast<Instruction>(v))
+        return "i" + NameIndex(I->getFunction()) + "." + std::to_string(instNo[I]);
 
-void Nova::AddLoadStoreChecks(Instruction* load_store, 
-                                      std::map<Value*, int>& FDCE_map) {
-  SmallVector<Value*, 8> args;
-  Value* pointer_operand = NULL;
-    
-  if(isa<LoadInst>(load_store)) {
-    LoadInst* ldi = dyn_cast<LoadInst>(load_store);
-    assert(ldi && "not a load instruction");
-    pointer_operand = ldi->getPointerOperand();
-  }
-    
-  if(isa<StoreInst>(load_store)){
-    StoreInst* sti = dyn_cast<StoreInst>(load_store);
-    assert(sti && "not a store instruction");
-    // The pointer where the element is being stored is the second
-    // operand
-    pointer_operand = sti->getOperand(1);
-  }
-    
-  assert(pointer_operand && "pointer operand null?");
+    failure = "it refers to an object without a global, argument or alloca";
+    return "";
+}
 
-  // If it is a null pointer which is being loaded, then it must seg
-  // fault, no dereference check here
-  
-  
-  if(isa<ConstantPointerNull>(pointer_operand))
-    return;
+std::string SummaryCacheWriter::ObjectToken(AliasObjectRef ao) {
+    auto it = objPaths.find(ao);
 
-  // Find all uses of pointer operand, then check if it dominates and
-  //if so, make a note in the map
-  
-  GlobalVariable* gv = dyn_cast<GlobalVariable>(pointer_operand);    
-  if(gv && GLOBALCONSTANTOPT && !isa<SequentialType>(gv->getType())) {
-    return;
-  }
-  
-  if(BOUNDSCHECKOPT) {
-    // Enable dominator based dereference check optimization only when
-    // suggested
-    
-    if(FDCE_map.count(load_store)) {
-      return;
+    if (it == objPaths.end()) {
+        failure = "it refers to an object without a global, argument or alloca";
+        return "";
     }
-    
-    // FIXME: Add more comments here Iterate over the uses
-    
-    for(Value::use_iterator ui = pointer_operand->use_begin(), 
-          ue = pointer_operand->use_end(); 
-        ui != ue; ++ui) {
-      
-      Instruction* temp_inst = dyn_cast<Instruction>(*ui);       
-      if(!temp_inst)
-        continue;
-      
-      if(temp_inst == load_store)
-        continue;
-      
-      if(!isa<LoadInst>(temp_inst) && !isa<StoreInst>(temp_inst))
-        continue;
-      
-      if(isa<StoreInst>(temp_inst)){
-        if(temp_inst->getOperand(1) != pointer_operand){
-          // When a pointer is a being stored at at a particular
-          // address, don't elide the check
-          continue;
-        }
-      }
-      
-#if 0
-        if(m_dominator_tree->dominates(load_store, temp_inst)) {
-          if(!FDCE_map.count(temp_inst)) {
-            FDCE_map[temp_inst] = true;
-            continue;
-          }                  
-        }
-#endif
-    } // Iterating over uses ends 
-  } // BOUNDSCHECKOPT ends 
-    
-  Value* tmp_base = NULL;
-  Value* tmp_bound = NULL;
-    
-  Constant* given_constant = dyn_cast<Constant>(pointer_operand);    
-  if(given_constant ) {
-    if(GLOBALCONSTANTOPT)
-      return;      
 
-    GetConstantExprBaseBound(given_constant, tmp_base, tmp_bound);
-  }
-  else {
-    tmp_base = GetAssociatedBase(pointer_operand);
-    tmp_bound = GetAssociatedBound(pointer_operand);
-  }
+    return ValueToken(it->second.first) + it->second.second;
+}
 
-  Value* bitcast_base = CastToVoidPtr(tmp_base, load_store);
-  args.push_back(bitcast_base);
-  
-  Value* bitcast_bound = CastToVoidPtr(tmp_bound, load_store);    
-  args.push_back(bitcast_bound);
-   
-  Value* cast_pointer_operand_value = CastToVoidPtr(pointer_operand, 
-                                                    load_store);    
-  args.push_back(cast_pointer_operand_value);
-    
-  // Pushing the size of the type 
-  Type* pointer_operand_type = pointer_operand->getType();
-  Value* size_of_type = GetSizeOfType(pointer_operand_type);
-  args.push_back(size_of_type);
+std::string SummaryCacheWriter::TupleToken(AliasObjectTupleRef aot) {
+    return ObjectToken(aot->ao) + "@" + std::to_string(aot->offset);
+}
 
-  if(isa<LoadInst>(load_store)){
-            
-    CallInst::Create(m_spatial_load_dereference_check, args, "", load_store);
-  }
-  else{    
-    CallInst::Create(m_spatial_store_dereference_check, args, "", load_store);
-  }
+std::string SummaryCacheWriter::InstToken(unsigned id) {
+    Instruction *I = N.Arena.insts[id];
 
-  return;
+    return NameIndex(I->getFunction()) + "." + std::to_string(instNo[I]);
 }
 
-void Nova::AddDereferenceChecks(Function* func, ValueSet &vs) {
-  Function &F = *func;
-  Value* pointer_operand = NULL;
-  
-  if(func->isVarArg())
-    return;
+bool SummaryCacheWriter::Write(GlobalStateRef gs, Function *f, FunctionSummary *summary,
+                               std::string &out) {
+    SmallPtrSet<AliasObjectRef, 32> visited;
+    SmallVector<AliasObjectRef, 32> worklist;
+    SmallPtrSet<Constant *, 16> seen;
+    SmallVector<std::pair<Constant *, std::string>, 8> consts;
+    AliasObjectRef ao;
+    std::string body, tok;
+    raw_string_ostream os(body);
 
-#if 0
-  if(Blacklist->isIn(F))
-    return;
+    names.clear();
+    failure = NULL;
 
-#endif
+    auto WriteTuples = [&](TupleSet *ts) {
+        for (AliasObjectTupleRef aot : *ts) {
+            os << " " << TupleToken(aot);
+            worklist.push_back(aot->ao);
+        }
+    };
+    auto WriteInsts = [&](InstSet *is) {
+        for (unsigned id : *is)
+            os << " " << InstToken(id);
+    };
+    auto WriteValue = [&](Value *v, const std::string &tok) {
+        TupleSet *ts = gs->pMap->lookup(v);
+        InstSet *is = gs->tMap->lookup(v);
+
+        if (gs->senVarSet->count(v))
+            os << "s " << tok << "\n";
+        if (ts != NULL) {
+            os << "p " << tok;
+            WriteTuples(ts);
+            os << "\n";
+        }
+        if (is != NULL && !is->empty()) {
+            os << "t " << tok;
+            WriteInsts(is);
+            os << "\n";
+        }
+    };
 
-  std::vector<Instruction*> CheckWorkList;
-  std::map<Value*, bool> ElideSpatialCheck;
-  std::map<Value*, bool> ElideTemporalCheck;
+    os << "f " << NameIndex(f) << "\n";
 
-  // identify all the instructions where we need to insert the spatial checks
-  for(inst_iterator i = inst_begin(F), e = inst_end(F); i != e; ++i){
-    Instruction* I = &*i;
+    for (Argument &A : f->args())
+        WriteValue(&A, ValueToken(&A));
+    for (Instruction &I : instructions(f)) {
+        WriteValue(&I, ValueToken(&I));
 
-    if(!m_present_in_original.count(I)){
-      continue;
+        // constant expressions, e.g. GEPs into globals, by their operand path
+        for (unsigned i = 0; i < I.getNumOperands(); i++) {
+            if (auto *CE = dyn_cast<ConstantExpr>(I.getOperand(i))) {
+                tok = "c" + NameIndex(f) + "." + std::to_string(instNo[&I]) + "." +
+                      std::to_string(i);
+                consts.push_back(std::make_pair(CE, tok));
+            }
+        }
+        while (!consts.empty()) {
+            std::pair<Constant *, std::string> c = consts.pop_back_val();
+            if (!seen.insert(c.first).second)
+                continue;
+
+            WriteValue(c.first, c.second);
+            for (unsigned i = 0; i < c.first->getNumOperands(); i++) {
+                if (auto *CE = dyn_cast<ConstantExpr>(c.first->getOperand(i)))
+                    consts.push_back(std::make_pair(CE, c.second + "." + std::to_string(i)));
+            }
+        }
     }
-    // add check optimizations here
-    // add checks for memory fences and atomic exchanges
-    if(isa<LoadInst>(I) || isa<StoreInst>(I)){
-      CheckWorkList.push_back(I);
-    }     
-    if(isa<AtomicCmpXchgInst>(I) || isa<AtomicRMWInst>(I)){
-      assert(0 && "Atomic Instructions not handled");
-    }    
-  }
 
-#if 0
-  // spatial check optimizations here 
+    os << "r";
+    if (summary->ret != NULL)
+        WriteTuples(summary->ret);
+    os << "\nR";
+    WriteInsts(summary->retTaint);
+    os << "\n";
+
+    for (auto &gu : summary->globalUses) {
+        os << "u " << ObjectToken(gu.first) << "\n";
+        worklist.push_back(gu.first);
+    }
+    for (auto &gd : summary->globalDefs) {
+        os << "d " << ObjectToken(gd.first) << " " << gd.second << "\n";
+        worklist.push_back(gd.first);
+    }
+    for (auto &c : summary->callees)
+        os << "c " << NameIndex(c.first) << "\n";
+    for (auto &b : summary->bindings) {
+        os << "b " << ObjectToken(b.first);
+        worklist.push_back(b.first);
+        for (AliasObjectRef bao : b.second) {
+            os << " " << ObjectToken(bao);
+            worklist.push_back(bao);
+        }
+        os << "\n";
+    }
+    for (AliasObjectRef param : summary->params) {
+        if (param != NULL)
+            worklist.push_back(param);
+    }
 
-  for(std::vector<Instruction*>::iterator i = CheckWorkList.begin(), 
-	e = CheckWorkList.end(); i!= e; ++i){
+    // everything the entry reaches
+    while (!worklist.empty()) {
+        ao = worklist.pop_back_val();
+        if (ao->isLocation || !visited.insert(ao).second)
+            continue;
 
-    Instruction* inst = *i;
-    Value* pointer_operand = NULL;
-    
-    if(ElideSpatialCheck.count(inst))
-      continue;
-    
-    if(isa<LoadInst>(inst)){
-      LoadInst* ldi = dyn_cast<LoadInst>(inst);
-      pointer_operand = ldi->getPointerOperand();
-    }
-    if(isa<StoreInst>(inst)){
-      StoreInst* st = dyn_cast<StoreInst>(inst);
-      pointer_operand = st->getOperand(1);      
+        tok = ObjectToken(ao);
+        if (ao->aliasMap != NULL) {
+            for (AliasMap::iterator it = ao->aliasMap->begin(), ie = ao->aliasMap->end();
+                                                                it != ie; ++it) {
+                os << "a " << tok << " " << it->first;
+                for (AliasObjectRef nao : *(it->second)) {
+                    os << " " << ObjectToken(nao);
+                    worklist.push_back(nao);
+                }
+                os << "\n";
+            }
+        }
+        if (ao->taintMap != NULL) {
+            for (LocalTaintMap::iterator it = ao->taintMap->begin(), ie = ao->taintMap->end();
+                                                                    it != ie; ++it) {
+                if (it->second->empty())
+                    continue;
+                os << "m " << tok << " " << it->first;
+                WriteInsts(it->second);
+                os << "\n";
+            }
+        }
     }
+    os.flush();
 
-    for(Value::use_iterator ui = pointer_operand->use_begin(),  
-	  ue = pointer_operand->use_end();
-	ui != ue; ++ui){
+    if (failure != NULL)
+        return false;
 
-      Instruction* use_inst = dyn_cast<Instruction>(*ui);
-      if(!use_inst || (use_inst == inst))
-	continue;
+    out.clear();
+    for (auto &it : names)
+        out += "n " + std::to_string(it.second) + " " + it.first->getName().str() + "\n";
+    out += body;
 
-      if(!isa<LoadInst>(use_inst)  && !isa<StoreInst>(use_inst))
-	continue;
+    return true;
+}
 
-      if(isa<StoreInst>(use_inst)){
-	if(use_inst->getOperand(1) != pointer_operand)
-	  continue;
-      }
+std::vector<Instruction *> &SummaryCacheReader::GetInsts(Function *f) {
+    std::vector<Instruction *> &fi = insts[f];
 
-#if 0
-      if(m_dominator_tree->dominates(inst, use_inst)){
-	if(!ElideSpatialCheck.count(use_inst))
-	  ElideSpatialCheck[use_inst] = true;		
-      }
+    if (fi.empty()) {
+        for (Instruction &I : instructions(f))
+            fi.push_back(&I);
     }
-#endif  
-  }
-
-#endif
 
-  //Temporal Check Optimizations
+    return fi;
+}
 
-  
-#if 0
+Function *SummaryCacheReader::ReadFunction(StringRef tok) {
+    unsigned n;
 
-#endif
+    if (tok.getAsInteger(10, n) || n >= entry->names.size())
+        return NULL;
 
-  /* intra-procedural load dererference check elimination map */
-  std::map<Value*, int> func_deref_check_elim_map;
-  std::map<Value*, int> func_temporal_check_elim_map;
+    auto *f = dyn_cast<Function>(entry->names[n]);
+    if (f == NULL || f->isDeclaration())
+        return NULL;
 
-  /* WorkList Algorithm for adding dereference checks. Each basic
-   * block is visited only once. We start by visiting the current
-   * basic block, then pushing all the successors of the current
-   * basic block on to the queue if it has not been visited
-   */
-    
-  std::set<BasicBlock*> bb_visited;
-  std::queue<BasicBlock*> bb_worklist;
-  Function:: iterator bb_begin = func->begin();
+    return f;
+}
 
-  BasicBlock* bb = dyn_cast<BasicBlock>(bb_begin);
-  assert(bb && "Not a basic block  and I am adding dereference checks?");
-  bb_worklist.push(bb);
+Instruction *SummaryCacheReader::ReadInst(StringRef tok) {
+    std::pair<StringRef, StringRef> fields = tok.split('.');
+    Function *f = ReadFunction(fields.first);
+    unsigned no;
 
-    
-  while(bb_worklist.size() != 0) {
-      
-    bb = bb_worklist.front();
-    assert(bb && "Not a BasicBlock?");
-    bb_worklist.pop();
+    if (f == NULL || fields.second.getAsInteger(10, no) || no >= GetInsts(f).size())
+        return NULL;
 
-    if(bb_visited.count(bb)) {
-      /* Block already visited */
-      continue;
-    }
+    return GetInsts(f)[no];
+}
 
-    /* If here implies basic block not visited */
-    /* Insert the block into the set of visited blocks */
-    bb_visited.insert(bb);
+Value *SummaryCacheReader::ReadValue(StringRef tok) {
+    SmallVector<StringRef, 4> fields;
+    SmallVector<unsigned, 4> path;
+    Function *f;
+    unsigned n, no;
 
-    /* Iterating over the successors and adding the successors to
-     * the worklist
-     */
-    for(succ_iterator si = succ_begin(bb), se = succ_end(bb); si != se; ++si) {
-        
-      BasicBlock* next_bb = *si;
-      assert(next_bb && "Not a basic block and I am adding to the base and bound worklist?");
-      bb_worklist.push(next_bb);
-    }
+    if (tok.empty())
+        return NULL;
 
-    /* basic block load deref check optimization */
-    std::map<Value*, int> bb_deref_check_map;
-    std::map<Value*, int> bb_temporal_check_elim_map;
-    /* structure check optimization */
-    std::map<Value*, int> bb_struct_check_opt;
+    tok.drop_front().split(fields, '.');
+    if (fields[0].getAsInteger(10, n) || n >= entry->names.size())
+        return NULL;
 
-    for(BasicBlock::iterator i = bb->begin(), ie = bb->end(); i != ie; ++i){
-      Value* v1 = dyn_cast<Value>(i);
-      Instruction* new_inst = dyn_cast<Instruction>(i);
-      
-      /* Do the dereference check stuff */
-      if(!m_present_in_original.count(v1))
-        continue;
-      
-      if(isa<LoadInst>(new_inst)){
-        LoadInst* ldi = dyn_cast<LoadInst>(new_inst);
-        pointer_operand = ldi->getPointerOperand();
-        if (vs.count(pointer_operand) == 0) {
-            //errs() << "skip check for non-sensitive pointers\n" ;
-            continue;
-        }
-        AddLoadStoreChecks(new_inst, func_deref_check_elim_map);
-        continue;
-      }
+    if (tok[0] == 'g')
+        return fields.size() == 1 ? dyn_cast<GlobalVariable>(entry->names[n]) : NULL;
 
-      if(isa<StoreInst>(new_inst)){
-        StoreInst* st = dyn_cast<StoreInst>(new_inst);
-        pointer_operand = st->getOperand(1);      
-        if (vs.count(pointer_operand) == 0) {
-            //errs() << "skip check for non-sensitive pointers\n" ;
-            continue;
-        }
-        AddLoadStoreChecks(new_inst, func_deref_check_elim_map);
-        continue;
-      }
+    f = ReadFunction(fields[0]);
+    if (f == NULL || fields.size() < 2 || fields[1].getAsInteger(10, no))
+        return NULL;
 
-      /* check call through function pointers */
-      if(isa<CallInst>(new_inst)) {
-          
-        // ZC:COMMENT OUT CALL CHECK DUE TO COMPLAINS ABOUT NO BASE AND BOUND INFO
-        if(CALLCHECKS) {
-          continue;
-        }          
-	  
+    if (tok[0] == 'a')
+        return fields.size() == 2 && no < f->arg_size() ? &*std::next(f->arg_begin(), no) : NULL;
 
-        SmallVector<Value*, 8> args;
-        CallInst* call_inst = dyn_cast<CallInst>(new_inst);
-        Value* tmp_base = NULL;
-        Value* tmp_bound = NULL;
-        
-        assert(call_inst && "call instruction null?");
-        errs() << "DEBUG: " << *call_inst;
-        
-        if(!INDIRECTCALLCHECKS)
-          continue;
+    if (no >= GetInsts(f).size())
+        return NULL;
+    if (tok[0] == 'i')
+        return fields.size() == 2 ? GetInsts(f)[no] : NULL;
+    if (tok[0] != 'c' || fields.size() < 3)
+        return NULL;
 
-        /* TODO:URGENT : indirect function call checking commented
-         * out for the time being to test other aspect of the code,
-         * problem was with spec benchmarks perl and h264. They were
-         * primarily complaining that the use of a function did not
-         * have base and bound in the map
-         */
+    for (unsigned i = 2; i < fields.size(); i++) {
+        if (fields[i].getAsInteger(10, n))
+            return NULL;
+        path.push_back(n);
+    }
 
+    return ResolveConstantUse(GetInsts(f)[no], path);
+}
 
-        /* here implies its an indirect call */
-        Value* indirect_func_called = call_inst->getOperand(0);
-            
-        Constant* func_constant = dyn_cast<Constant>(indirect_func_called);
-        if(func_constant) {
-          GetConstantExprBaseBound(func_constant, tmp_base, tmp_bound);           
-        }
-        else {
-          tmp_base = GetAssociatedBase(indirect_func_called);
-          tmp_bound = GetAssociatedBound(indirect_func_called);
+// the top-level object of a global, alloca or param placeholder, created for
+// the entries of the first load
+AliasObjectRef SummaryCacheReader::GetRoot(Value *v) {
+    AliasObjectRef ao = NULL;
+
+    auto it = roots.find(v);
+    if (it != roots.end())
+        return it->second;
+
+    if (isa<GlobalVariable>(v)) {
+        ao = N.Arena.roots.lookup(v);
+    } else if (auto *arg = dyn_cast<Argument>(v)) {
+        if (arg->getType()->isPointerTy()) {
+            ao = N.CreateAliasObject(arg->getType()->getPointerElementType(), arg);
+            N.MarkParamObject(ao);
         }
-        /* Add BitCast Instruction for the base */
-        Value* bitcast_base = CastToVoidPtr(tmp_base, new_inst);
-        args.push_back(bitcast_base);
-            
-        /* Add BitCast Instruction for the bound */
-        Value* bitcast_bound = CastToVoidPtr(tmp_bound, new_inst);
-        args.push_back(bitcast_bound);
-        Value* pointer_operand_value = CastToVoidPtr(indirect_func_called, new_inst);
-        args.push_back(pointer_operand_value);            
-        CallInst::Create(m_call_dereference_func, args, "", new_inst);
-        continue;
-      } /* Call check ends */
+    } else if (auto *ai = dyn_cast<AllocaInst>(v)) {
+        ao = N.CreateAliasObject(ai->getAllocatedType(), ai);
     }
-  }  
+
+    roots[v] = ao;
+    return ao;
 }
 
-//
-// Method: transformMain()
-//
-// Description:
-//
-// This method renames the function "main" in the module as
-// pseudo_main. The C-handler has the main function which calls
-// pseudo_main. Actually transformation of the main takes places in
-// two steps.  Step1: change the name to pseudo_main and Step2:
-// Function renaming to append the function name with softboundcets_
-//
-// Inputs:
-// module: Input module with the function main
-//
-// Outputs:
-//
-// Changed module with any function named "main" is changed to
-// "pseudo_main"
-//
-// Comments:
-//
-// This function is doing redundant work. We should probably use
-// renameFunction to accomplish the task. The key difference is that
-// transform renames it the function as either pseudo_main or
-// softboundcets_pseudo_main which is subsequently renamed to
-// softboundcets_pseudo_main in the first case by renameFunction
-//
+AliasObjectRef SummaryCacheReader::ReadObject(StringRef tok) {
+    std::pair<StringRef, StringRef> fields = tok.split('/');
+    SmallVector<StringRef, 4> path;
+    AliasObjectRef ao;
+    Value *v;
+    int i;
 
-void Nova::TransformMain(Module& module) {
-    
-  Function* main_func = module.getFunction("main");
+    v = ReadValue(fields.first);
+    if (v == NULL || (ao = GetRoot(v)) == NULL)
+        return NULL;
 
-  // 
-  // If the program doesn't have main then don't do anything
-  //
-  if (!main_func) return;
+    if (!fields.second.empty())
+        fields.second.split(path, '/');
+    for (StringRef field : path) {
+        if (field.getAsInteger(10, i) || ao->isLocation || ao->aliasMap == NULL)
+            return NULL;
 
-  Type* ret_type = main_func->getReturnType();
-  const FunctionType* fty = main_func->getFunctionType();
-  std::vector<Type*> params;
+        auto it = ao->aliasMap->find(i);
+        if (it == ao->aliasMap->end() || it->second->empty())
+            return NULL;
+        ao = *it->second->begin();
+    }
 
-  SmallVector<AttributeSet, 8> param_attrs_vec;
-  const AttributeSet& pal = main_func->getAttributes();
+    return ao;
+}
 
-  //
-  // Get the attributes of the return value
-  //
+AliasObjectTupleRef SummaryCacheReader::ReadTuple(StringRef tok) {
+    std::pair<StringRef, StringRef> fields = tok.rsplit('@');
+    AliasObjectRef ao = ReadObject(fields.first);
+    int offset;
 
-  if(pal.hasAttributes(AttributeSet::ReturnIndex))
-    param_attrs_vec.push_back(AttributeSet::get(main_func->getContext(), pal.getRetAttributes()));
+    if (ao == NULL || fields.second.getAsInteger(10, offset))
+        return NULL;
 
-  // Get the attributes of the arguments 
-  int arg_index = 1;
-  for(Function::arg_iterator i = main_func->arg_begin(), 
-        e = main_func->arg_end();
-      i != e; ++i, arg_index++) {
-    params.push_back(i->getType());
+    return N.GetAliasObjectTuple(ao, offset);
+}
 
-    AttributeSet attrs = pal.getParamAttributes(arg_index);
+// Check that every line of e resolves, and add what it records to the
+// analysis state if apply is set.
+bool SummaryCacheReader::Read(SummaryCacheEntry &e, bool apply) {
+    SmallVector<StringRef, 16> toks;
+    SmallVector<AliasObjectRef, 16> objs;
+    SmallVector<Instruction *, 16> is;
+    FunctionSummary *summary = NULL;
+    AliasObjectRef ao, param;
+    TupleSet ts;
+    Value *v = NULL;
+    int offset = 0;
+
+    entry = &e;
+
+    if (apply) {
+        summary = new (N.Arena.summaries.Allocate()) FunctionSummary();
+        summary->ret = NULL;
+        summary->retTaint = N.NewInstSet();
+
+        // as ComputeSummary does
+        for (Argument &A : e.f->args()) {
+            param = GetRoot(&A);
+            if (param != NULL) {
+                ts.clear();
+                ts.insert(N.GetAliasObjectTuple(param, 0));
+                (*(gs->pMap))[&A] = N.InternTupleSet(ts);
+            }
+            (*(gs->tMap))[&A] = N.NewInstSet();
+            summary->params.push_back(param);
+        }
 
-    if(attrs.hasAttributes(arg_index)){
-      AttrBuilder B(attrs, arg_index);
-      param_attrs_vec.push_back(AttributeSet::get(main_func->getContext(), params.size(), B));
+        N.summaries[e.f] = summary;
     }
-  }
 
-  FunctionType* nfty = FunctionType::get(ret_type, params, fty->isVarArg());
-  Function* new_func = NULL;
+    for (line_iterator it(*e.buf, /*SkipBlanks=*/true), ie; it != ie; ++it) {
+        toks.clear();
+        it->split(toks, ' ', -1, /*KeepEmpty=*/false);
+        StringRef op = toks[0];
+        unsigned first = 1;
 
-  // create the new function 
-  new_func = Function::Create(nfty, main_func->getLinkage(), 
-                              "softboundcets_pseudo_main");
+        if (op == "n")
+            continue;
+        if (op == "f") {
+            if (toks.size() != 2 || ReadFunction(toks[1]) != e.f)
+                return false;
+            continue;
+        }
+        if (op == "c") {
+            Function *callee = toks.size() == 2 ? ReadFunction(toks[1]) : NULL;
+            if (callee == NULL)
+                return false;
+            if (apply)
+                summary->callees[callee] = 0;
+            continue;
+        }
 
-  // set the new function attributes 
-  new_func->copyAttributesFrom(main_func);
-  new_func->setAttributes(AttributeSet::get(main_func->getContext(), param_attrs_vec));
-    
-  main_func->getParent()->getFunctionList().insert(main_func->getIterator(), new_func);
-  main_func->replaceAllUsesWith(new_func);
+        // the subject of the line
+        if (op == "s" || op == "p" || op == "t") {
+            if (toks.size() < 2 || (v = ReadValue(toks[1])) == NULL)
+                return false;
+            first = 2;
+        } else if (op == "u" || op == "d" || op == "b" || op == "a" || op == "m") {
+            if (toks.size() < 2 || (ao = ReadObject(toks[1])) == NULL)
+                return false;
+            first = 2;
+            if (op == "d" || op == "a" || op == "m") {
+                if (toks.size() < 3 || toks[2].getAsInteger(10, offset))
+                    return false;
+                first = 3;
+            }
+            if ((op == "a" && ao->aliasMap == NULL) || (op == "m" && ao->taintMap == NULL))
+                return false;
+        } else if (op != "r" && op != "R") {
+            return false;
+        }
 
-  // 
-  // Splice the instructions from the old function into the new
-  // function and set the arguments appropriately
-  // 
-  new_func->getBasicBlockList().splice(new_func->begin(), 
-                                       main_func->getBasicBlockList());
-  Function::arg_iterator arg_i2 = new_func->arg_begin();
-  for(Function::arg_iterator arg_i = main_func->arg_begin(), 
-        arg_e = main_func->arg_end(); 
-      arg_i != arg_e; ++arg_i) {      
-    arg_i->replaceAllUsesWith(&*arg_i2);
-    arg_i2->takeName(&*arg_i);
-    ++arg_i2;
-    arg_index++;
-  }  
-  //
-  // Remove the old function from the module
-  //
-  main_func->eraseFromParent();
+        // the rest of the line
+        ts.clear();
+        objs.clear();
+        is.clear();
+        for (unsigned i = first; i < toks.size(); i++) {
+            if (op == "p" || op == "r") {
+                AliasObjectTupleRef aot = ReadTuple(toks[i]);
+                if (aot == NULL)
+                    return false;
+                ts.insert(aot);
+            } else if (op == "b" || op == "a") {
+                AliasObjectRef nao = ReadObject(toks[i]);
+                if (nao == NULL)
+                    return false;
+                objs.push_back(nao);
+            } else if (op == "t" || op == "R" || op == "m") {
+                Instruction *I = ReadInst(toks[i]);
+                if (I == NULL)
+                    return false;
+                is.push_back(I);
+            } else {
+                return false;
+            }
+        }
+
+        if (!apply)
+            continue;
+
+        if (op == "s") {
+            gs->senVarSet->insert(v);
+        } else if (op == "p" || op == "r") {
+            TupleSet *old = op == "p" ? gs->pMap->lookup(v) : summary->ret;
+            if (old != NULL)
+                ts.insert(old->begin(), old->end());
+            if (op == "p")
+                (*(gs->pMap))[v] = N.InternTupleSet(ts);
+            else if (!ts.empty())
+                summary->ret = N.InternTupleSet(ts);
+        } else if (op == "t" || op == "R" || op == "m") {
+            InstSet *set;
+            if (op == "t") {
+                set = gs->tMap->lookup(v);
+                if (set == NULL) {
+                    set = N.NewInstSet();
+                    (*(gs->tMap))[v] = set;
+                }
+            } else if (op == "R") {
+                set = summary->retTaint;
+            } else {
+                if (ao->taintMap->find(offset) == ao->taintMap->end())
+                    (*(ao->taintMap))[offset] = N.NewInstSet();
+                set = (*(ao->taintMap))[offset];
+            }
+            for (Instruction *I : is)
+                set->set(N.GetInstID(I));
+        } else if (op == "u") {
+            summary->globalUses[ao] = 0;
+        } else if (op == "d") {
+            summary->globalDefs.insert(std::make_pair(ao, offset));
+        } else if (op == "b") {
+            AliasObjectSet *bound = N.paramBindings.lookup(ao);
+            if (bound == NULL) {
+                bound = N.NewAliasObjectSet();
+                N.paramBindings[ao] = bound;
+            }
+            bound->insert(objs.begin(), objs.end());
+            summary->bindings[ao].insert(objs.begin(), objs.end());
+        } else if (op == "a") {
+            if (ao->aliasMap->find(offset) == ao->aliasMap->end())
+                (*(ao->aliasMap))[offset] = N.NewAliasObjectSet();
+            (*(ao->aliasMap))[offset]->insert(objs.begin(), objs.end());
+        }
+    }
+
+    return true;
 }
 
-void Nova::PrepareForBoundsCheck(Module &M, ValueSet &vs) {
-    TransformMain(M);
-    IdentifyFuncToTrans(M);
-    IdentifyInitialGlobals(M);
-    AddBaseBoundGlobals(M);
+// Load the entry of every function whose key is unchanged. ComputeSummaries
+// then computes the functions without one, and the loaded functions again if
+// their callees' summaries or the globals they read change.
+// An entry holds the objects it reaches as the whole analysis left them, so
+// facts a stale function added to them stay. That may make more variables
+// sensitive than a full analysis would, not fewer.
+void Nova::LoadSummaries(Module &M, GlobalStateRef gs) {
+    std::vector<SummaryCacheEntry> entries;
+    DenseMap<Function *, unsigned> index;
+    std::vector<std::string> demanded;
+    SmallVector<StringRef, 3> fields;
+    SummaryCacheReader reader(*this, gs);
+    MD5 hash;
+    MD5::MD5Result result;
+    SmallString<32> key;
+    unsigned n, loaded;
+    bool changed;
+
+    hash.update(cacheHeader);
+    if (DemandDriven) {
+        for (Function *f : demandedFuncs)
+            demanded.push_back(funcHashes[f]);
+        std::sort(demanded.begin(), demanded.end());
+        for (std::string &h : demanded)
+            hash.update(h);
+    }
+    hash.final(result);
+    MD5::stringifyResult(result, key);
+    summaryKey = key.str();
+
+    for (Function &F : M) {
+        if (F.isDeclaration() || (DemandDriven && !demandedFuncs.count(&F)))
+            continue;
 
-    for(Module::iterator ff_begin = M.begin(), ff_end = M.end(); 
-        ff_begin != ff_end; ++ff_begin){
-      Function* func_ptr = dyn_cast<Function>(ff_begin);
-      assert(func_ptr && "Not a function??");
-      
-      //
-      // No instrumentation for functions introduced by us for updating
-      // and retrieving the shadow space
-      //
-        
-      if (!CheckIfFunctionOfInterest(func_ptr)) {
-        continue;
-      }  
-      //
-      // Iterating over the instructions in the function to identify IR
-      // instructions in the original program In this pass, the pointers
-      // in the original program are also identified
-      //
-        
-      IdentifyOriginalInst(func_ptr);
-        
-      //
-      // Iterate over all basic block and then each insn within a basic
-      // block We make two passes over the IR for base and bound
-      // propagation and one pass for dereference checks
-      //
-  
-      GatherBaseBoundPass1(func_ptr);
-      GatherBaseBoundPass2(func_ptr);
-      //AddDereferenceChecks(func_ptr, vs);
+        ErrorOr<std::unique_ptr<MemoryBuffer>> buf =
+            MemoryBuffer::getFile(GetSummaryCacheFile(&F));
+        if (!buf)
+            continue;
+
+        SummaryCacheEntry e;
+        e.f = &F;
+        e.buf = std::move(*buf);
+        e.valid = true;
+        for (line_iterator it(*e.buf, /*SkipBlanks=*/true), ie; it != ie; ++it) {
+            fields.clear();
+            it->split(fields, ' ', 2);
+            if (fields[0] != "n")
+                continue;
+            if (fields.size() != 3 || fields[1].getAsInteger(10, n) || n != e.names.size() ||
+                    M.getNamedValue(fields[2]) == NULL) {
+                e.valid = false;
+                break;
+            }
+            e.names.push_back(M.getNamedValue(fields[2]));
+        }
+
+        if (e.valid) {
+            index[&F] = entries.size();
+            entries.push_back(std::move(e));
+        }
+    }
+
+    // drop the entries referring to functions without a valid entry, and
+    // those that do not resolve
+    do {
+        do {
+            changed = false;
+            for (SummaryCacheEntry &e : entries) {
+                if (!e.valid)
+                    continue;
+
+                for (GlobalValue *gv : e.names) {
+                    auto *f = dyn_cast<Function>(gv);
+                    if (f == NULL || f->isDeclaration())
+                        continue;
+                    if (index.find(f) == index.end() || !entries[index[f]].valid) {
+                        e.valid = false;
+                        changed = true;
+                        break;
+                    }
+                }
+            }
+        } while (changed);
+
+        for (SummaryCacheEntry &e : entries) {
+            if (e.valid && !reader.Read(e, /*apply=*/false)) {
+                errs() << "Nova summary cache: dropping the entry of " << e.f->getName() << "\n";
+                e.valid = false;
+                changed = true;
+            }
+        }
+    } while (changed);
+
+    loaded = 0;
+    for (SummaryCacheEntry &e : entries) {
+        if (!e.valid)
+            continue;
+        reader.Read(e, /*apply=*/true);
+        cachedSummaries.insert(e.f);
+        loaded++;
+    }
+
+    // the nested objects of the loaded functions, see SummaryCacheWriter
+    for (auto &it : reader.roots) {
+        Function *f = NULL;
+        if (auto *arg = dyn_cast<Argument>(it.first))
+            f = arg->getParent();
+        else if (auto *I = dyn_cast<Instruction>(it.first))
+            f = I->getFunction();
+        if (f != NULL && it.second != NULL && cachedSummaries.count(f))
+            Arena.roots[it.first] = it.second;
+    }
+
+    // nothing changed since the summaries were loaded
+    for (Function *f : cachedSummaries) {
+        FunctionSummary *summary = summaries[f];
+
+        for (auto &gu : summary->globalUses)
+            gu.second = gu.first->changes;
+        for (auto &c : summary->callees) {
+            FunctionSummary *callee = summaries.lookup(c.first);
+            c.second = callee != NULL ? GetSummaryVersion(callee) : ~0ULL;
+        }
     }
+
+    errs() << "Nova summary cache: loaded " << loaded << " of " << summaries.size()
+           << " summaries\n";
+
+    return;
 }
 
-void Nova::PointerBoundaryCheck(Module &M, ValueSet &vs) {
-//    Value *v;
+// store the entries of the functions ComputeSummaries computed
+void Nova::StoreSummaries(Module &M, GlobalStateRef gs) {
+    SummaryCacheWriter writer(*this, M);
+    std::string buf;
 
-    errs() << __func__ << " : "<< "\n";
+    for (Function &F : M) {
+        FunctionSummary *summary = summaries.lookup(&F);
 
-    // Note! we almost need to fully implement Softbound here, the
-    // only difference is that we selectively add check for sensitive vars.
-    // we simplify the implementation as follows:
-    //  1. we only support ARM64bit architecture.
-    //  2. we only support spatial safty check and don't support temporal safty.
-    //  3. we don't support shadow stack.
-    // Attention:
-    //  1. we might need to transform all functions that take pointer as params
-    //     or ret_type is pointer.
-    //  2. such functions can't be exported to outside module due to the transformation.
-    //  3. library calls, leave it as it is.
-    PrepareForBoundsCheck(M, vs);
+        if (summary == NULL || cachedSummaries.count(&F))
+            continue;
 
-    // identify pointer types
-#if 0
-    for (ValueSet::iterator it = vs.begin(), ie = vs.end();
-                                              it != ie; ++it) {
-        v = *it;
-        errs() <<"var :" << (*v) << "\n";
-        if (v->getType()->isPointerTy()) {
-            errs() << v->getName() << " is pointer \n";
-            if (v->getType()->getPointerElementType()->isPointerTy()) {
-                errs() << v->getName() << " points to a pointer type\n";
-                //PointerAccessCheck(M, v);
-                ArrayAccessCheck(M, v);
-            } else if (v->getType()->getPointerElementType()->isArrayTy()) {
-                errs() << v->getName() << " points to a array type\n";
-                ArrayAccessCheck(M, v);
-            }
+        if (!writer.Write(gs, &F, summary, buf)) {
+            errs() << "Nova summary cache: not storing " << F.getName() << ", "
+                   << writer.failure << "\n";
+            continue;
         }
+        WriteCacheFile(GetSummaryCacheFile(&F), buf);
     }
-#endif
+
+    PruneCache();
 
     return;
 }
 
-// enforce def-use check based on analysis result stored in gs
-void Nova::DefUseCheck(Module &M, GlobalStateRef gs) {
-    ValueSet senVarSet;
+void Nova::CollectSensitiveVars(GlobalStateRef gs, ValueSet &senVarSet) {
     Value *v;
     AliasMapRef aliasMap;
     TupleSet *ts = NULL;
@@ -5044,7 +7333,7 @@ void Nova::DefUseCheck(Module &M, GlobalStateRef gs) {
                         errs() << "aosit == NULL!\n";
                         continue;
                     }
-                    senVarSet.insert((*aosit)->val);
+                    InsertObjectValues(*aosit, senVarSet);
                 }
             } else {
                 //errs() << "location object ?" << "\n";
@@ -5068,26 +7357,40 @@ void Nova::DefUseCheck(Module &M, GlobalStateRef gs) {
                             errs() << "aosit == NULL!\n";
                             continue;
                         }
-                        senVarSet.insert((*aosit)->val);
+                        InsertObjectValues(*aosit, senVarSet);
                     }
                 }
             }
         }
     }
 
-    // scan over all vars, put those whose alias is in the senVar set into senVar, too
-    for (PointsToMap::iterator it = gs->pMap->begin(), ie = gs->pMap->end();
-                                                         it != ie; ++it) { 
-        // skip sensitive var, they are already in senVarSet.
-        if (senVarSet.count(it->first) != 0)
-            continue;
+    // index: alias object value -> pointers reaching an alias object of that
+    // value through their points-to set, i.e. the pointers the scan would add
+    // once the value is sensitive
+    DenseMap<Value *, SmallVector<Value *, 4>> reachedBy;
 
-        //errs() << it->first->getName() << " : " << "\n";
+    auto AddEdges = [&](Value *p, AliasObjectSet *aos) {
+        SmallPtrSet<AliasObjectRef, 8> visited;
+        SmallVector<AliasObjectRef, 8> objs;
 
-        if (it->second == NULL) {
-            errs() << "it->second == NULL\n";
-            continue;
+        for (AliasObjectSet::iterator aosit = aos->begin(), aosie = aos->end();
+                                            aosit != aosie; ++aosit) {
+            if ((*aosit) == NULL)
+                continue;
+            ResolveAliasObject(*aosit, visited, objs);
+        }
+
+        for (AliasObjectRef ao : objs) {
+            SmallVector<Value *, 4> &ps = reachedBy[ao->val];
+            if (ps.empty() || ps.back() != p)
+                ps.push_back(p);
         }
+    };
+
+    for (PointsToMap::iterator it = gs->pMap->begin(), ie = gs->pMap->end();
+                                                         it != ie; ++it) { 
+        if (it->second == NULL)
+            continue;
 
         for (TupleSet::iterator tsit = it->second->begin(), tsie = it->second->end();
                                                     tsit != tsie; ++tsit) {
@@ -5096,62 +7399,45 @@ void Nova::DefUseCheck(Module &M, GlobalStateRef gs) {
                 continue;
             }
 
-            //errs() << "(" << (*tsit)->offset << ", " << (*tsit)->ao->val->getName() << ")" << "\n";
             aliasMap = (*tsit)->ao->aliasMap;
             offset = (*tsit)->offset;
-            if (aliasMap != NULL && aliasMap->find(offset) != aliasMap->end()) {
-                aos = (*aliasMap)[offset];
-                if (aos == NULL) {
-                        errs() << "aos == NULL"<<"\n";
-                        continue;
-                }
-                //errs() << "alias object set: ";
-                for (AliasObjectSet::iterator aosit = aos->begin(), aosie = aos->end();
-                                                    aosit != aosie; ++aosit) {
-                    //errs() << (*aosit)->val->getName() << ",";
-                    if (senVarSet.count((*aosit)->val) != 0) {
-                        // var contains sensitive var as its alias object, so add it to senVarSet
-                        errs() << " added to senVarSet!!\n";
-                        if (senVarSet.count(it->first) == 0) {
-                            senVarSet.insert(it->first);
-                        }
+            if (aliasMap == NULL)
+                continue;
 
-                        break; // end the inner for-loop
-                    }
-                }
-                //errs() << "\n";
-            } else {
-                //errs() << "location object ?" << "\n";
-            }
+            if (aliasMap->find(offset) != aliasMap->end() && (*aliasMap)[offset] != NULL)
+                AddEdges(it->first, (*aliasMap)[offset]);
 
+            // any field of a struct
             if ((*tsit)->ao->type != NULL && (*tsit)->ao->type->isStructTy()) {
-                // print struct field aliasMap
-                //errs() << "struct internal alias map: \n";
                 for (AliasMap::iterator ait = aliasMap->begin(), aie = aliasMap->end();
                                                 ait != aie; ++ait) {
-                    offset = ait->first;
-                    aos = ait->second;
-                    //errs() << "alias object set at offset " << offset << " : ";
-                    for (AliasObjectSet::iterator aosit = aos->begin(), aosie = aos->end();
-                                                        aosit != aosie; ++aosit) {
-                        //errs() << (*aosit)->val->getName() << ",";
-                        if (senVarSet.count((*aosit)->val) != 0) {
-                            // var contains sensitive var as its alias object, so add it to senVarSet
-                            errs() << " added to senVarSet!!\n";
-                            if (senVarSet.count(it->first) == 0) {
-                                senVarSet.insert(it->first);
-                            }
-
-                            break; // end the inner for-loop
-                        }
-                    }
-                    //errs() << "\n";
+                    if (ait->second != NULL)
+                        AddEdges(it->first, ait->second);
                 }
             }
         }
-        //errs() << "\n";
     }
 
+    // close senVarSet over the index, starting at the annotated vars
+    std::vector<Value *> worklist(senVarSet.begin(), senVarSet.end());
+    while (!worklist.empty()) {
+        v = worklist.back();
+        worklist.pop_back();
+
+        auto rit = reachedBy.find(v);
+        if (rit == reachedBy.end())
+            continue;
+
+        for (Value *p : rit->second) {
+            if (senVarSet.insert(p))
+                worklist.push_back(p);
+        }
+    }
+
+    return;
+}
+
+void Nova::DefUseCheck(Module &M, GlobalStateRef gs, ValueSet &senVarSet) {
 
     // step2: for all sensitive pointers, add boundary check
     //PointerBoundaryCheck(M, senVarSet);
@@ -5177,6 +7463,9 @@ void Nova::DefUseCheck(Module &M, GlobalStateRef gs) {
         CheckUseEvent(M, (it->first));
     }
 #else
+    // sensitive globals only accessed directly get dense IDs
+    CollectSensitiveGlobals(M, senVarSet);
+
     errs() << "senVarSet : \n";
     for (ValueSet::iterator it = senVarSet.begin(), ie = senVarSet.end();
                                     it != ie; ++it) {
@@ -5186,6 +7475,11 @@ void Nova::DefUseCheck(Module &M, GlobalStateRef gs) {
     }
 #endif
 
+    OptimizePlannedEvents(M);
+    InstrumentPlannedEvents();
+
+    EmitSensitiveCount(M);
+
     return;
 }
 
@@ -5198,27 +7492,28 @@ void Nova::DefUseCheck(Module &M, GlobalStateRef gs) {
 //  For pointer variable,  we also consider pointer based write, which first load var's
 //  value into tmp var, then use tmp var as address to write.
 void Nova::RecordDefineEvent(Module &M, Value *var) {
-    Value *op, *val;
+    Value *op;
     for (User *UoV : var->users()) {
         errs()<<"RecordDefineEvent: UoV:" << *UoV <<"\n";
         if (Instruction *Inst = dyn_cast<Instruction>(UoV)) {
+            // not run by the attested operation
+            if (!oat::isInScope(*Inst->getFunction()))
+                continue;
             errs()<<"RecordDefineEvent: Inst:" << *Inst <<"\n";
             // normal variable
             if (isa<StoreInst>(Inst)){
                 op = cast<StoreInst>(Inst)->getPointerOperand();
-                val = cast<StoreInst>(Inst)->getValueOperand();
                 if (op == var) {
                     // define event :insert call to void record_defevt(uint64 addr, uint64 val)
-                    InstrumentStoreInst(Inst, op, val);
+                    plannedDefs.insert(cast<StoreInst>(Inst));
                 }
             } else if (isa<LoadInst>(Inst)) {
                 for (User *UoL : Inst->users()) {
                     if (Instruction *Inst1 = dyn_cast<Instruction>(UoL)) {
                         if (isa<StoreInst>(Inst1)){
-                            val = cast<StoreInst>(Inst1)->getValueOperand();
                             op = cast<StoreInst>(Inst1)->getPointerOperand();
                             if (op == Inst) {
-                                InstrumentStoreInst(Inst1, op, val);
+                                plannedDefs.insert(cast<StoreInst>(Inst1));
                             }
                         }
                     } else {
@@ -5240,15 +7535,14 @@ void Nova::InstrumentStoreInst(Instruction *inst, Value *addr, Value *val) {
     //errs() << __func__ << " : "<< *inst << "\n";
     define_event_count++;
 
-    Constant *RecordDefEvt = M->getOrInsertFunction("__record_defevt", VoidTy,
-                                                                      I64Ty,
-                                                                      I64Ty, 
-                                                                      nullptr);
-
-    Function *RecordDefEvtFunc = cast<Function>(RecordDefEvt);
-    castAddr = CastInst::Create(Instruction::PtrToInt, addr, I64Ty, "recptrtoint", inst);
+    Function *RecordDefEvtFunc = oat::getOrInsertHook(*M, "__record_defevt",
+                                        FunctionType::get(VoidTy, {I64Ty, I64Ty}, false));
+    castAddr = GetSensitiveKey(addr, inst, "recptrtoint");
 
-    if (val->getType()->isPointerTy()) {
+    castVal = GetWideSensitiveValue(addr, val, inst, true);
+    if (castVal != NULL) {
+        // part of a wide range
+    } else if (val->getType()->isPointerTy()) {
         castVal = CastInst::Create(Instruction::PtrToInt, val, I64Ty, "recptrtoint", inst);
     } else if (val->getType()->isIntegerTy(64)) {
         castVal = val;
@@ -5257,7 +7551,7 @@ void Nova::InstrumentStoreInst(Instruction *inst, Value *addr, Value *val) {
     } else
 	return;
 
-    B.CreateCall(RecordDefEvtFunc, {castAddr, castVal});
+    oat::createHookCall(B, RecordDefEvtFunc, {castAddr, castVal});
 
     return;
 }
@@ -5274,15 +7568,14 @@ void Nova::InstrumentLoadInst(Instruction *inst, Value *addr, Value *val) {
     //errs() << __func__ << " addr->name: "<< addr->getName() << "\n";
     //errs() << __func__ << " val->name: "<< val->getName() << "\n";
 
-    Constant *CheckUseEvt = M->getOrInsertFunction("__check_useevt", VoidTy,
-                                                                     I64Ty,
-                                                                     I64Ty, 
-                                                                     nullptr);
+    Function *CheckUseEvtFunc = oat::getOrInsertHook(*M, "__check_useevt",
+                                        FunctionType::get(VoidTy, {I64Ty, I64Ty}, false));
+    castAddr = GetSensitiveKey(addr, inst, "chkptrtoint");
 
-    Function *CheckUseEvtFunc = cast<Function>(CheckUseEvt);
-    castAddr = CastInst::Create(Instruction::PtrToInt, addr, I64Ty, "chkptrtoint", inst);
-
-    if (val->getType()->isPointerTy()) {
+    castVal = GetWideSensitiveValue(addr, val, inst, false);
+    if (castVal != NULL) {
+        // part of a wide range
+    } else if (val->getType()->isPointerTy()) {
         //errs() << "val cast from pointer to int64\n";
         //errs() << "val:"<< *val;
         castVal = CastInst::Create(Instruction::PtrToInt, val, I64Ty, "chkptrtoint", inst);
@@ -5295,7 +7588,7 @@ void Nova::InstrumentLoadInst(Instruction *inst, Value *addr, Value *val) {
     } else
         return;
 
-    B.CreateCall(CheckUseEvtFunc, {castAddr, castVal});
+    oat::createHookCall(B, CheckUseEvtFunc, {castAddr, castVal});
 
     // remove fake inst
     inst->eraseFromParent();
@@ -5304,26 +7597,616 @@ void Nova::InstrumentLoadInst(Instruction *inst, Value *addr, Value *val) {
 }
 
 void Nova::CheckUseEvent(Module &M, Value *var) {
-    LLVMContext& ctxt = M.getContext();
     Value *op;
-    BasicBlock *pb;
-    Instruction *fakeInst;
-    Type *I64Ty = Type::getInt64Ty(ctxt);
     for (User *UoV : var->users()) {
         if (Instruction *Inst = dyn_cast<Instruction>(UoV)) {
+            if (!oat::isInScope(*Inst->getFunction()))
+                continue;
             if (isa<LoadInst>(Inst)){
                 op = cast<LoadInst>(Inst)->getPointerOperand();
                 if (op == var) {
-                    // define event :insert call to record_defevt(uint64 addr, uint64 val)
-                    fakeInst = CastInst::Create(Instruction::PtrToInt, op, I64Ty, "fptrtoint");
-                    pb = Inst->getParent();
-                    assert(pb != nullptr);
-                    pb->getInstList().insertAfter(Inst->getIterator(), fakeInst);
-                    InstrumentLoadInst(fakeInst, op, Inst);
+                    // use event :insert call to check_useevt(uint64 addr, uint64 val)
+                    plannedUses.insert(cast<LoadInst>(Inst));
+                }
+            }
+        }
+    }
+}
+
+// Build the analyses of every function with planned events and drop or move
+// the events that do not need to run where they were planned.
+void Nova::OptimizePlannedEvents(Module &M) {
+    for (Function &F : M) {
+        if (F.isDeclaration())
+            continue;
+
+        bool planned = false;
+        for (Instruction &I : instructions(F)) {
+            if ((isa<StoreInst>(I) && plannedDefs.count(cast<StoreInst>(&I))) ||
+                    (isa<LoadInst>(I) && plannedUses.count(cast<LoadInst>(&I)))) {
+                planned = true;
+                break;
+            }
+        }
+        if (!planned)
+            continue;
+
+        DominatorTree DT(F);
+        LoopInfo LI(DT);
+        BasicAAResult BAR(createLegacyPMBasicAAResult(*this, F));
+        AAResults AA(createLegacyPMAAResults(*this, F, BAR));
+        MemorySSA MSSA(F, &AA, &DT);
+
+        // execution counts, if -pgo-instr-use annotated the module
+        std::unique_ptr<BranchProbabilityInfo> BPI;
+        std::unique_ptr<BlockFrequencyInfo> BFI;
+        if (ProfilePlacement && F.getEntryCount().hasValue()) {
+            BPI.reset(new BranchProbabilityInfo(F, LI));
+            BFI.reset(new BlockFrequencyInfo(F, *BPI, LI));
+        }
+
+        if (EliminateRedundant)
+            EliminateRedundantEvents(F, DT, AA, MSSA);
+        // moves events out of loops, the analyses are stale afterwards
+        if (HoistLoopEvents)
+            HoistLoopInvariantEvents(F, DT, LI, AA, MSSA, BFI.get());
+    }
+}
+
+// Drop the planned events that cannot tell the TA anything new:
+//  # a use whose value was just defined: its clobbering access is a planned
+//    def of the same location, or a checked load of the same location with
+//    the same clobbering access dominates it.
+//  # a def overwritten by a later planned def of the same location in the
+//    same block, with nothing in between that may read the location.
+void Nova::EliminateRedundantEvents(Function &F, DominatorTree &DT,
+                                    AAResults &AA, MemorySSA &MSSA) {
+    MemorySSAWalker *walker = MSSA.getWalker();
+    SmallVector<StoreInst *, 16> defs;
+    SmallVector<LoadInst *, 16> uses;
+
+    for (Instruction &I : instructions(F)) {
+        if (StoreInst *si = dyn_cast<StoreInst>(&I)) {
+            if (plannedDefs.count(si) && si->isSimple())
+                defs.push_back(si);
+        } else if (LoadInst *li = dyn_cast<LoadInst>(&I)) {
+            if (plannedUses.count(li) && li->isSimple())
+                uses.push_back(li);
+        }
+    }
+
+    // dead defs
+    SmallPtrSet<StoreInst *, 16> deadDefs;
+    for (StoreInst *si : defs) {
+        MemoryLocation loc = MemoryLocation::get(si);
+        Type *ty = si->getValueOperand()->getType();
+        for (BasicBlock::iterator it = std::next(si->getIterator()),
+                ie = si->getParent()->end(); it != ie; ++it) {
+            StoreInst *next = dyn_cast<StoreInst>(&*it);
+            if (next && plannedDefs.count(next) && next->isSimple() &&
+                    next->getValueOperand()->getType() == ty &&
+                    AA.alias(MemoryLocation::get(next), loc) == MustAlias) {
+                deadDefs.insert(si);
+                break;
+            }
+            if (AA.getModRefInfo(&*it, loc) & MRI_Ref)
+                break;
+        }
+    }
+    plannedDefs.remove_if([&](StoreInst *si) { return deadDefs.count(si); });
+    eliminated_define_event_count += deadDefs.size();
+
+    // redundant uses
+    SmallPtrSet<LoadInst *, 16> redundantUses;
+    std::map<std::pair<MemoryAccess *, Value *>, SmallVector<LoadInst *, 4>> checked;
+    for (LoadInst *li : uses) {
+        if (MSSA.getMemoryAccess(li) == nullptr)
+            continue;
+        MemoryAccess *clobber = walker->getClobberingMemoryAccess(li);
+        if (MemoryDef *md = dyn_cast<MemoryDef>(clobber)) {
+            StoreInst *si = dyn_cast_or_null<StoreInst>(md->getMemoryInst());
+            if (si && plannedDefs.count(si) && si->isSimple() &&
+                    si->getValueOperand()->getType() == li->getType() &&
+                    AA.alias(MemoryLocation::get(si), MemoryLocation::get(li)) == MustAlias) {
+                redundantUses.insert(li);
+                continue;
+            }
+        }
+        checked[std::make_pair(clobber, li->getPointerOperand()->stripPointerCasts())].push_back(li);
+    }
+    // every load of a group reads the same value, a load dominated by
+    // another one of its group needs no check.
+    for (auto &group : checked) {
+        for (LoadInst *li : group.second) {
+            for (LoadInst *dom : group.second) {
+                if (dom != li && dom->getType() == li->getType() &&
+                        DT.dominates(dom, li)) {
+                    redundantUses.insert(li);
+                    break;
                 }
             }
         }
     }
+    plannedUses.remove_if([&](LoadInst *li) { return redundantUses.count(li); });
+    eliminated_use_event_count += redundantUses.size();
+}
+
+// I runs at least once whenever L is entered and left.
+static bool IsGuaranteedToExecute(Instruction *I, Loop *L, DominatorTree &DT) {
+    SmallVector<BasicBlock *, 8> exits;
+    L->getExitBlocks(exits);
+    if (exits.empty())
+        return false;
+
+    for (BasicBlock *exit : exits)
+        if (!DT.dominates(I->getParent(), exit))
+            return false;
+
+    return true;
+}
+
+// With a profile, a use check may also move to a preheader that runs less
+// often than the load when the load may be skipped on the way out of the
+// loop. The load must still run on every iteration that goes on, i.e. its
+// block dominates the latch, and the location must be readable there on any
+// path.
+static bool IsColderSafePoint(LoadInst *li, Loop *L,
+                              BlockFrequencyInfo *BFI, DominatorTree &DT) {
+    BasicBlock *preheader = L->getLoopPreheader();
+    BasicBlock *latch = L->getLoopLatch();
+    if (BFI == nullptr || latch == nullptr || !DT.dominates(li->getParent(), latch))
+        return false;
+
+    Optional<uint64_t> hot = BFI->getBlockProfileCount(li->getParent());
+    Optional<uint64_t> cold = BFI->getBlockProfileCount(preheader);
+    if (!hot.hasValue() || !cold.hasValue() || cold.getValue() >= hot.getValue())
+        return false;
+
+    return isSafeToLoadUnconditionally(li->getPointerOperand(), li->getAlignment(),
+                                       li->getModule()->getDataLayout(),
+                                       preheader->getTerminator(), &DT);
+}
+
+// Keep the number of events of a loop independent of its trip count:
+//  # a use check of a location no store in the loop may write is done once
+//    in the preheader of the outermost such loop, all checks hoisted to one
+//    preheader are batched into a single __check_useevt_multi call.
+//  # the def of the only store in the loop that may write a location nothing
+//    in the loop checks or may read through a call is replaced by one def at
+//    each loop exit. The store runs before every exit, so the value it
+//    stored last reaches the exits in SSA form and the exit def does not
+//    record whatever memory holds by then.
+void Nova::HoistLoopInvariantEvents(Function &F, DominatorTree &DT, LoopInfo &LI,
+                                    AAResults &AA, MemorySSA &MSSA,
+                                    BlockFrequencyInfo *BFI) {
+    MemorySSAWalker *walker = MSSA.getWalker();
+    std::set<std::tuple<BasicBlock *, Value *, Type *>> hoisted;
+    SmallVector<LoadInst *, 16> hoistUses;
+    SmallVector<std::pair<StoreInst *, Loop *>, 16> sinkDefs;
+
+    for (Instruction &I : instructions(F)) {
+        if (LoadInst *li = dyn_cast<LoadInst>(&I)) {
+            if (plannedUses.count(li) && li->isSimple() &&
+                    LI.getLoopFor(li->getParent()) != nullptr)
+                hoistUses.push_back(li);
+        } else if (StoreInst *si = dyn_cast<StoreInst>(&I)) {
+            if (plannedDefs.count(si) && si->isSimple() &&
+                    LI.getLoopFor(si->getParent()) != nullptr)
+                sinkDefs.push_back(std::make_pair(si, LI.getLoopFor(si->getParent())));
+        }
+    }
+
+    // invariant uses
+    SmallVector<std::pair<LoadInst *, BasicBlock *>, 16> hoistTo;
+    for (LoadInst *li : hoistUses) {
+        Type *ty = li->getType();
+        if (!ty->isPointerTy() && !ty->isIntegerTy())
+            continue;
+        if (MSSA.getMemoryAccess(li) == nullptr)
+            continue;
+
+        MemoryAccess *clobber = walker->getClobberingMemoryAccess(li);
+        BasicBlock *clobberBB = MSSA.isLiveOnEntryDef(clobber) ? nullptr : clobber->getBlock();
+        Value *ptr = li->getPointerOperand();
+        Loop *target = nullptr;
+        for (Loop *L = LI.getLoopFor(li->getParent()); L != nullptr; L = L->getParentLoop()) {
+            if (L->getLoopPreheader() == nullptr || !L->isLoopInvariant(ptr))
+                break;
+            if (clobberBB != nullptr && L->contains(clobberBB))
+                break;
+            if (!IsGuaranteedToExecute(li, L, DT) &&
+                    !IsColderSafePoint(li, L, BFI, DT))
+                break;
+            target = L;
+        }
+        if (target != nullptr)
+            hoistTo.push_back(std::make_pair(li, target->getLoopPreheader()));
+    }
+
+    // accumulator defs
+    SmallVector<std::pair<StoreInst *, Loop *>, 16> sinkTo;
+    for (auto &sd : sinkDefs) {
+        StoreInst *si = sd.first;
+        Loop *L = sd.second;
+        Type *ty = si->getValueOperand()->getType();
+        if (!ty->isPointerTy() && !ty->isIntegerTy())
+            continue;
+        if (!L->isLoopInvariant(si->getPointerOperand()) || !L->hasDedicatedExits())
+            continue;
+
+        // the exit def must not record a value the loop never stored
+        if (!IsGuaranteedToExecute(si, L, DT))
+            continue;
+
+        SmallVector<BasicBlock *, 8> exits;
+        L->getExitBlocks(exits);
+        bool ok = true;
+        for (BasicBlock *exit : exits)
+            if (exit->isEHPad())
+                ok = false;
+
+        MemoryLocation loc = MemoryLocation::get(si);
+        for (BasicBlock *BB : L->blocks()) {
+            for (Instruction &I : *BB) {
+                if (&I == si)
+                    continue;
+                ModRefInfo MRI = AA.getModRefInfo(&I, loc);
+                if (MRI & MRI_Mod)
+                    ok = false;
+                if (isa<LoadInst>(I) && !plannedUses.count(cast<LoadInst>(&I)))
+                    continue;
+                if (MRI & MRI_Ref)
+                    ok = false;
+            }
+        }
+        if (ok)
+            sinkTo.push_back(std::make_pair(si, L));
+    }
+
+    // all decisions are made, now change the IR
+    for (auto &ht : hoistTo) {
+        LoadInst *li = ht.first;
+        BasicBlock *preheader = ht.second;
+        auto key = std::make_tuple(preheader, li->getPointerOperand(), li->getType());
+
+        plannedUses.remove(li);
+        if (hoisted.count(key)) {
+            eliminated_use_event_count++;
+            continue;
+        }
+
+        LoadInst *hl = cast<LoadInst>(li->clone());
+        hl->setName(li->getName() + ".hoist");
+        hl->insertBefore(preheader->getTerminator());
+        hoisted.insert(key);
+        plannedUseBatches[preheader->getTerminator()].push_back(hl);
+    }
+
+    for (auto &st : sinkTo) {
+        StoreInst *si = st.first;
+        Loop *L = st.second;
+        Value *val = si->getValueOperand();
+
+        plannedDefs.remove(si);
+
+        // si dominates every exiting block, so val is available there
+        SmallVector<BasicBlock *, 8> exits;
+        L->getUniqueExitBlocks(exits);
+        for (BasicBlock *exit : exits) {
+            PHINode *phi = PHINode::Create(val->getType(), 2, "exitdef", &exit->front());
+            for (BasicBlock *pred : predecessors(exit))
+                phi->addIncoming(val, pred);
+            plannedExitDefs[phi] = si->getPointerOperand();
+        }
+    }
+}
+
+void Nova::InstrumentPlannedEvents() {
+    Instruction *fakeInst;
+
+    for (StoreInst *si : plannedDefs)
+        InstrumentStoreInst(si, si->getPointerOperand(), si->getValueOperand());
+
+    // def of the value a loop stored last
+    for (auto &ed : plannedExitDefs)
+        InstrumentStoreInst(&*ed.first->getParent()->getFirstInsertionPt(),
+                            ed.second, ed.first);
+
+    for (LoadInst *li : plannedUses) {
+        Value *op = li->getPointerOperand();
+        fakeInst = CastInst::Create(Instruction::PtrToInt, op,
+                                    Type::getInt64Ty(li->getContext()), "fptrtoint");
+        fakeInst->insertAfter(li);
+        InstrumentLoadInst(fakeInst, op, li);
+    }
+
+    for (auto &batch : plannedUseBatches)
+        InstrumentUseBatch(batch.first, batch.second);
+
+    plannedDefs.clear();
+    plannedUses.clear();
+    plannedExitDefs.clear();
+    plannedUseBatches.clear();
+}
+
+// Check the loads of one program point with a single world switch:
+//  __check_useevt_multi(n, addrs, vals)
+void Nova::InstrumentUseBatch(Instruction *insertAt, ArrayRef<LoadInst *> loads) {
+    if (loads.size() == 1) {
+        Instruction *fakeInst = CastInst::Create(Instruction::PtrToInt, loads[0]->getPointerOperand(),
+                                                 Type::getInt64Ty(insertAt->getContext()), "fptrtoint");
+        fakeInst->insertAfter(loads[0]);
+        InstrumentLoadInst(fakeInst, loads[0]->getPointerOperand(), loads[0]);
+        return;
+    }
+
+    IRBuilder<> B(insertAt);
+    Module *M = B.GetInsertBlock()->getModule();
+    Type *VoidTy = B.getVoidTy();
+    Type *I64Ty = B.getInt64Ty();
+    Type *I64PtrTy = I64Ty->getPointerTo();
+    Function *F = insertAt->getFunction();
+
+    // the arrays live in the frame of F, allocated once in its entry block
+    IRBuilder<> EB(&*F->getEntryBlock().getFirstInsertionPt());
+    ArrayType *arrTy = ArrayType::get(I64Ty, loads.size());
+    AllocaInst *addrs = EB.CreateAlloca(arrTy, nullptr, "chkaddrs");
+    AllocaInst *vals = EB.CreateAlloca(arrTy, nullptr, "chkvals");
+
+    for (unsigned i = 0; i < loads.size(); i++) {
+        LoadInst *li = loads[i];
+        Value *castAddr = GetSensitiveKey(li->getPointerOperand(), insertAt, "chkptrtoint");
+        Value *castVal = GetWideSensitiveValue(li->getPointerOperand(), li, insertAt, false);
+
+        if (castVal == NULL && li->getType()->isPointerTy())
+            castVal = B.CreatePtrToInt(li, I64Ty, "chkptrtoint");
+        else if (castVal == NULL)
+            castVal = B.CreateZExtOrBitCast(li, I64Ty, "chkzexttoi64");
+
+        B.CreateStore(castAddr, B.CreateConstInBoundsGEP2_64(addrs, 0, i));
+        B.CreateStore(castVal, B.CreateConstInBoundsGEP2_64(vals, 0, i));
+        use_event_count++;
+    }
+
+    Function *CheckUseEvtMultiFunc = oat::getOrInsertHook(*M, "__check_useevt_multi",
+                                        FunctionType::get(VoidTy, {I64Ty, I64PtrTy, I64PtrTy}, false));
+    oat::createHookCall(B, CheckUseEvtMultiFunc,
+                        {B.getInt64(loads.size()),
+                         B.CreateConstInBoundsGEP2_64(addrs, 0, 0),
+                         B.CreateConstInBoundsGEP2_64(vals, 0, 0)});
+}
+
+// Uses of v by llvm.global.annotations do not access it at runtime.
+bool Nova::IsAnnotationUse(User *U) {
+    if (GlobalVariable *gv = dyn_cast<GlobalVariable>(U))
+        return gv->getName() == "llvm.global.annotations";
+
+    if (!isa<Constant>(U))
+        return false;
+
+    for (User *UoU : U->users())
+        if (!IsAnnotationUse(UoU))
+            return false;
+
+    return true;
+}
+
+// A global whose address never escapes can only be accessed through
+// loads/stores of itself or of a constant offset into it, so every def/use
+// of it is resolved at compile time and no runtime address is needed.
+bool Nova::IsDirectAccessOnly(Value *v) {
+    for (User *UoV : v->users()) {
+        if (LoadInst *li = dyn_cast<LoadInst>(UoV)) {
+            if (li->isVolatile())
+                return false;
+        } else if (StoreInst *si = dyn_cast<StoreInst>(UoV)) {
+            if (si->getValueOperand() == v || si->isVolatile())
+                return false;
+        } else if (GEPOperator *gop = dyn_cast<GEPOperator>(UoV)) {
+            if (!gop->hasAllConstantIndices() || !IsDirectAccessOnly(gop))
+                return false;
+        } else if (BitCastOperator *bop = dyn_cast<BitCastOperator>(UoV)) {
+            if (!IsDirectAccessOnly(bop))
+                return false;
+        } else if (!IsAnnotationUse(UoV)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Collect the sensitive globals that get dense IDs and lay them out
+// contiguously in the .oat_sensitive section.
+void Nova::CollectSensitiveGlobals(Module &M, ValueSet &senVarSet) {
+    const DataLayout &DL = M.getDataLayout();
+    GlobalVariable *gv;
+    int64_t offset;
+
+    for (ValueSet::iterator it = senVarSet.begin(), ie = senVarSet.end();
+                                    it != ie; ++it) {
+        offset = 0;
+        gv = dyn_cast<GlobalVariable>(GetPointerBaseWithConstantOffset(*it, offset, DL));
+        if (gv == NULL || senGlobals.count(gv) != 0)
+            continue;
+
+        if (gv->isDeclaration() || gv->isConstant() || gv->isThreadLocal())
+            continue;
+
+        if (!IsDirectAccessOnly(gv) || !CollectSensitiveRanges(gv, DL))
+            continue;
+
+        // common symbols can't be placed in a section
+        if (gv->hasCommonLinkage())
+            gv->setLinkage(GlobalValue::ExternalLinkage);
+        if (!gv->hasSection())
+            gv->setSection(oat::SensitiveSectionName);
+
+        errs() << "sensitive global with ID: " << gv->getName() << "\n";
+        senGlobals.insert(gv);
+    }
+}
+
+// Merge the byte ranges accessed in gv that overlap, e.g. an i64 store and an
+// i32 load of its upper half, into one range with one ID. Return false if a
+// range accessed in parts does not fit the 64-bit value of an event, gv then
+// keeps address keys.
+bool Nova::CollectSensitiveRanges(GlobalVariable *gv, const DataLayout &DL) {
+    std::vector<std::pair<int64_t, int64_t>> accesses;
+    SmallVector<Value *, 16> worklist(1, gv);
+
+    while (!worklist.empty()) {
+        Value *v = worklist.pop_back_val();
+        for (User *UoV : v->users()) {
+            Value *ptr;
+            Type *ty;
+            if (LoadInst *li = dyn_cast<LoadInst>(UoV)) {
+                ptr = li->getPointerOperand();
+                ty = li->getType();
+            } else if (StoreInst *si = dyn_cast<StoreInst>(UoV)) {
+                ptr = si->getPointerOperand();
+                ty = si->getValueOperand()->getType();
+            } else {
+                if (isa<GEPOperator>(UoV) || isa<BitCastOperator>(UoV))
+                    worklist.push_back(UoV);
+                continue;
+            }
+
+            int64_t offset = 0;
+            GetPointerBaseWithConstantOffset(ptr, offset, DL);
+            accesses.push_back(std::make_pair(offset, offset + (int64_t)DL.getTypeStoreSize(ty)));
+        }
+    }
+
+    std::sort(accesses.begin(), accesses.end());
+    SensitiveRangeMap &ranges = senRanges[gv];
+    SensitiveRange *cur = NULL;
+    for (auto &a : accesses) {
+        if (cur == NULL || a.first >= cur->end) {
+            cur = &ranges[a.first];
+            cur->start = a.first;
+            cur->end = a.second;
+            cur->wide = false;
+            continue;
+        }
+        if (a.first != cur->start || a.second != cur->end)
+            cur->wide = true;
+        cur->end = std::max(cur->end, a.second);
+    }
+
+    for (auto &r : ranges) {
+        if (r.second.wide && r.second.end - r.second.start > 8) {
+            errs() << "sensitive global with overlapping accesses: " << gv->getName() << "\n";
+            senRanges.erase(gv);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Return the range of a sensitive global with IDs that addr points into,
+// NULL if addr is keyed by its runtime address.
+SensitiveRange *Nova::LookupSensitiveRange(Value *addr, const DataLayout &DL,
+                                           GlobalVariable *&gv, int64_t &offset) {
+    offset = 0;
+    gv = dyn_cast<GlobalVariable>(GetPointerBaseWithConstantOffset(addr, offset, DL));
+    if (gv == NULL || senGlobals.count(gv) == 0)
+        return NULL;
+
+    SensitiveRangeMap &ranges = senRanges[gv];
+    SensitiveRangeMap::iterator it = ranges.upper_bound(offset);
+    if (it == ranges.begin())
+        return NULL;
+    --it;
+    if (offset >= it->second.end)
+        return NULL;
+
+    return &it->second;
+}
+
+// Return the key identifying addr in a def/use event: the tagged dense ID of
+// the accessed range for sensitive globals, the runtime address otherwise.
+Value *Nova::GetSensitiveKey(Value *addr, Instruction *insertAt, const char *name) {
+    const DataLayout &DL = insertAt->getModule()->getDataLayout();
+    Type *I64Ty = Type::getInt64Ty(insertAt->getContext());
+    int64_t offset;
+    GlobalVariable *gv;
+
+    SensitiveRange *range = LookupSensitiveRange(addr, DL, gv, offset);
+    if (range == NULL)
+        return CastInst::Create(Instruction::PtrToInt, addr, I64Ty, name, insertAt);
+
+    std::pair<GlobalVariable *, int64_t> field = std::make_pair(gv, range->start);
+    if (senIDMap.find(field) == senIDMap.end()) {
+        uint64_t id = senIDMap.size();
+        senIDMap[field] = id;
+    }
+
+    return ConstantInt::get(I64Ty, oat::SensitiveIDFlag | senIDMap[field]);
+}
+
+// An access to part of a wide range reports the value of the whole range, so
+// that all events of its ID compare the same bytes. For a def, inserted before
+// the store, that is the range with the stored bytes replaced by val; for a
+// use, inserted after the load, it is the range as the load saw it. Return
+// NULL if addr is not in a wide range, or if a stored val has no scalar bits
+// to splice in.
+Value *Nova::GetWideSensitiveValue(Value *addr, Value *val, Instruction *insertAt,
+                                   bool isDef) {
+    const DataLayout &DL = insertAt->getModule()->getDataLayout();
+    Type *ValTy = val->getType();
+    int64_t offset;
+    GlobalVariable *gv;
+
+    SensitiveRange *range = LookupSensitiveRange(addr, DL, gv, offset);
+    if (range == NULL || !range->wide)
+        return NULL;
+    if (isDef && !ValTy->isIntegerTy() && !ValTy->isPointerTy() &&
+            !ValTy->isFloatingPointTy())
+        return NULL;
+
+    IRBuilder<> B(insertAt);
+    unsigned bits = (range->end - range->start) * 8;
+    IntegerType *WideTy = B.getIntNTy(bits);
+    Constant *base = ConstantExpr::getBitCast(gv, B.getInt8PtrTy(gv->getType()->getAddressSpace()));
+    base = ConstantExpr::getInBoundsGetElementPtr(B.getInt8Ty(), base, B.getInt64(range->start));
+    base = ConstantExpr::getBitCast(base, WideTy->getPointerTo(gv->getType()->getAddressSpace()));
+    LoadInst *wide = B.CreateLoad(base, "senwide");
+    wide->setAlignment(1);
+
+    Value *result = wide;
+    if (isDef) {
+        unsigned size = DL.getTypeStoreSize(ValTy);
+        unsigned shift = DL.isLittleEndian() ? (offset - range->start) * 8
+                                             : (range->end - offset - size) * 8;
+        // the stored bits as an integer
+        if (ValTy->isPointerTy())
+            val = B.CreatePtrToInt(val, B.getIntNTy(size * 8));
+        else if (ValTy->isFloatingPointTy())
+            val = B.CreateBitCast(val, B.getIntNTy(ValTy->getPrimitiveSizeInBits()));
+
+        APInt mask = APInt::getBitsSet(bits, shift, shift + size * 8);
+        Value *part = B.CreateShl(B.CreateZExt(val, WideTy), shift);
+        result = B.CreateOr(B.CreateAnd(wide, ConstantInt::get(WideTy, ~mask)), part, "senwidedef");
+    }
+
+    return B.CreateZExtOrBitCast(result, B.getInt64Ty(), "senwidetoi64");
+}
+
+// Tell the runtime how large the TA's table of sensitive values must be.
+void Nova::EmitSensitiveCount(Module &M) {
+    Type *I64Ty = Type::getInt64Ty(M.getContext());
+    Constant *count = ConstantInt::get(I64Ty, senIDMap.size());
+    GlobalVariable *gv = M.getNamedGlobal(oat::SensitiveCountName);
+
+    if (gv == NULL)
+        gv = new GlobalVariable(M, I64Ty, true, GlobalValue::ExternalLinkage,
+                                count, oat::SensitiveCountName);
+    else
+        gv->setInitializer(count);
+
+    errs() << "\nsensitive_id_count: " << senIDMap.size() << "\n";
 }
 
 //void Nova::extendSenVarSet(Module &M, SenObjSet &exSenVarSet) {
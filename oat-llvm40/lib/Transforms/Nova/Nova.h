@@ -1,9 +1,18 @@
 #ifndef NOVA_H
 #define NOVA_H
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SparseBitVector.h"
+#include "llvm/Support/Allocator.h"
+#include <unordered_map>
 
-#define MAX_RUNS    1
+#define MAX_LOOP_VISITS    64
+// bump with every change to the sensitive variables Nova computes, the cache
+// would return the result of the old analysis otherwise
+#define NOVA_CACHE_VERSION  6
 
 namespace llvm{
     class Module;
@@ -14,32 +23,50 @@ namespace llvm{
     struct CallInst;
     struct GEPOperator;
     struct GlobalValue;
+    class GlobalVariable;
+    class DominatorTree;
+    class LoopInfo;
+    class AAResults;
+    class MemorySSA;
+    class ModuleSlotTracker;
+    class BlockFrequencyInfo;
 
     typedef SetVector<Value *> ValueSet;
-    typedef SetVector<Instruction *> InstSet;
+    typedef SparseBitVector<> InstSet;  // IDs of instructions, see GetInstID
 
     // AliasTuple
     typedef struct AliasObjectTuple *AliasObjectTupleRef;
-    typedef SetVector<AliasObjectTupleRef> TupleSet;
+    typedef SmallSetVector<AliasObjectTupleRef, 4> TupleSet;
 
     // AliasObject members
     typedef struct AliasObject *AliasObjectRef;
-    typedef SetVector<AliasObjectRef> AliasObjectSet;
-    typedef std::map<int, AliasObjectSet *> AliasMap;
+    typedef SmallSetVector<AliasObjectRef, 4> AliasObjectSet;
+    typedef SmallDenseMap<int, AliasObjectSet *, 4> AliasMap;
     typedef AliasMap *AliasMapRef;
-    typedef std::map<int, InstSet *> LocalTaintMap;
+    typedef SmallDenseMap<int, InstSet *, 4> LocalTaintMap;
     typedef LocalTaintMap *LocalTaintMapRef;
 
     // GlobalState members
-    typedef std::map<Value*, InstSet *> TaintMap;
-    typedef std::map<Value*, TupleSet *> PointsToMap;
-    typedef std::map<Value*, bool> VisitMap;
+    typedef DenseMap<Value*, InstSet *> TaintMap;
+    typedef MapVector<Value*, TupleSet *> PointsToMap;
+    typedef DenseMap<Value*, bool> VisitMap;
     typedef TaintMap *TaintMapRef;
     typedef PointsToMap *PointsToMapRef;
     typedef VisitMap *VisitMapRef;
 
     typedef struct GlobalState *GlobalStateRef; 
 
+    // (sensitive global, start of the accessed range) -> dense ID
+    typedef std::map<std::pair<GlobalVariable *, int64_t>, uint64_t> SensitiveIDMap;
+
+    // overlapping accesses of a sensitive global share the ID of the byte
+    // range [start, end) they cover, wide if some access covers only part
+    struct SensitiveRange {
+        int64_t start, end;
+        bool wide;
+    };
+    typedef std::map<int64_t, SensitiveRange> SensitiveRangeMap;
+
     // SCC
     typedef std::vector<BasicBlock *> SCC;
     typedef std::vector<BasicBlock *> *SCCRef;
@@ -47,14 +74,18 @@ namespace llvm{
 // all local/global variables and dynamically allocated objects should have an alias object
 // for locations, .aliasMap = null, .taintMap = null, .val = Instruction
 // for dynamic allocated object, size is used for record allocation size.
+// for the object a formal parameter points to in a function summary, and the
+// objects nested in it, .isParam = true, .val = Argument
 struct AliasObject {
     Value *val;
     bool isStruct;
     bool isLocation;
+    bool isParam;
     Type *type;
     uint32_t size;
     AliasMapRef aliasMap;
     LocalTaintMapRef taintMap;
+    uint32_t changes;   // bumped whenever its alias or taint sets grow
 }; // struct AliasObject
 
 struct AliasObjectTuple {
@@ -62,27 +93,123 @@ struct AliasObjectTuple {
     struct AliasObject *ao;
 }; // struct AliasObjectTuple
 
+// Points-to and taint effect of a function on its callers, computed bottom-up
+// over the call graph and instantiated at each call site.
+// Globals are shared by all functions: the summary lists the global objects
+// the function reads, to compute it again when they change, and the ones it
+// or its callees store to, to bind the placeholders stored there at a call.
+struct FunctionSummary {
+    SmallVector<AliasObjectRef, 4> params;  // per formal, NULL if not a pointer
+    TupleSet *ret;                          // points-to set of the returned value
+    InstSet *retTaint;                      // taint of the returned value
+    DenseMap<AliasObjectRef, uint32_t> globalUses;  // global object -> its changes when read
+    SmallSetVector<std::pair<AliasObjectRef, int>, 4> globalDefs;  // (global object, offset)
+    DenseMap<Function *, uint64_t> callees; // callee -> version of its summary when applied
+    DenseMap<AliasObjectRef, AliasObjectSet> bindings;  // callee placeholder -> what the calls bound it to
+}; // struct FunctionSummary
+
+// Storage of everything the points-to and taint analysis allocates, released
+// as a whole at the end of runOnModule. Tuples and tuple sets are interned,
+// an interned tuple set is shared by all values pointing to the same tuples
+// and is never modified.
+struct NovaArena {
+    SpecificBumpPtrAllocator<AliasObject> aliasObjects;
+    SpecificBumpPtrAllocator<AliasObjectTuple> tuples;
+    SpecificBumpPtrAllocator<TupleSet> tupleSets;
+    SpecificBumpPtrAllocator<AliasObjectSet> aliasObjectSets;
+    SpecificBumpPtrAllocator<AliasMap> aliasMaps;
+    SpecificBumpPtrAllocator<LocalTaintMap> taintMaps;
+    SpecificBumpPtrAllocator<InstSet> instSets;
+    SpecificBumpPtrAllocator<FunctionSummary> summaries;
+
+    DenseMap<std::pair<AliasObjectRef, int>, AliasObjectTupleRef> tupleMap;
+    std::unordered_map<size_t, SmallVector<TupleSet *, 1>> tupleSetMap;
+
+    // dense IDs of the instructions in taint sets
+    DenseMap<Instruction *, unsigned> instIDs;
+    std::vector<Instruction *> insts;
+
+    // top-level object of each global, alloca and param placeholder, every
+    // other object is nested in one of them
+    DenseMap<Value *, AliasObjectRef> roots;
+
+    void Reset();
+}; // struct NovaArena
+
 struct GlobalState {
     TaintMapRef tMap;
     PointsToMapRef pMap;
     VisitMapRef vMap;
     CallInst *ci;   // current callInst
     ValueSet *senVarSet;
+    FunctionSummary *summary;   // summary being computed, NULL when traversing call paths
+    uint64_t memChanges;        // bumped whenever an object's alias or taint set grows
 }; // GlobalState
 
 struct Nova : public ModulePass {
     static char ID;
     Nova() : ModulePass(ID) {}
     bool runOnModule(Module &M);
+    void getAnalysisUsage(AnalysisUsage &AU) const;
 
     // def-use check
     void GetAnnotatedVariables(Module &M, GlobalStateRef gs);
-    void DefUseCheck(Module &M, GlobalStateRef gs);
+    void CollectSensitiveVars(GlobalStateRef gs, ValueSet &senVarSet);
+    void DefUseCheck(Module &M, GlobalStateRef gs, ValueSet &senVarSet);
+
+    // cache of the sensitive variables, keyed by the functions they depend on
+    std::string cacheHeader;    // digest of what every key depends on
+    DenseMap<Function *, std::string> funcHashes;
+    std::vector<Function *> hashedAddrTaken;
+    void ComputeCacheKeys(Module &M);
+    std::string GetCacheFile(Module &M);
+    std::string GetFunctionHash(Function &F, ModuleSlotTracker &MST);
+    std::string GetFunctionKey(Function *f, DenseMap<Function *, std::string> &hashes,
+                               std::vector<Function *> &addrTaken);
+    bool LoadSensitiveVars(Module &M, StringRef file, ValueSet &senVarSet);
+    void StoreSensitiveVars(Module &M, StringRef file, ValueSet &senVarSet);
+
+    // cache of the function summaries, one entry per function
+    std::string summaryKey;     // digest of cacheHeader and the demanded functions
+    SmallPtrSet<Function *, 32> cachedSummaries;  // loaded and not computed again
+    std::string GetSummaryCacheFile(Function *f);
+    void LoadSummaries(Module &M, GlobalStateRef gs);
+    void StoreSummaries(Module &M, GlobalStateRef gs);
     void RecordDefineEvent(Module &M, Value *var);
     void CheckUseEvent(Module &M, Value *var);
     void InstrumentStoreInst(Instruction *inst, Value *addr, Value *val);
     void InstrumentLoadInst(Instruction *inst, Value *addr, Value *val);
 
+    // def/use events are planned first, redundant ones are dropped before
+    // instrumentation
+    SetVector<StoreInst *> plannedDefs;
+    SetVector<LoadInst *> plannedUses;
+    MapVector<PHINode *, Value *> plannedExitDefs;
+    MapVector<Instruction *, SmallVector<LoadInst *, 4>> plannedUseBatches;
+    void OptimizePlannedEvents(Module &M);
+    void EliminateRedundantEvents(Function &F, DominatorTree &DT, AAResults &AA,
+                                  MemorySSA &MSSA);
+    void HoistLoopInvariantEvents(Function &F, DominatorTree &DT, LoopInfo &LI,
+                                  AAResults &AA, MemorySSA &MSSA,
+                                  BlockFrequencyInfo *BFI);
+    void InstrumentPlannedEvents();
+    void InstrumentUseBatch(Instruction *insertAt, ArrayRef<LoadInst *> loads);
+
+    // dense IDs for sensitive globals
+    SetVector<GlobalVariable *> senGlobals;
+    SensitiveIDMap senIDMap;
+    std::map<GlobalVariable *, SensitiveRangeMap> senRanges;
+    void CollectSensitiveGlobals(Module &M, ValueSet &senVarSet);
+    bool CollectSensitiveRanges(GlobalVariable *gv, const DataLayout &DL);
+    bool IsDirectAccessOnly(Value *v);
+    bool IsAnnotationUse(User *U);
+    SensitiveRange *LookupSensitiveRange(Value *addr, const DataLayout &DL,
+                                         GlobalVariable *&gv, int64_t &offset);
+    Value *GetSensitiveKey(Value *addr, Instruction *insertAt, const char *name);
+    Value *GetWideSensitiveValue(Value *addr, Value *val, Instruction *insertAt,
+                                 bool isDef);
+    void EmitSensitiveCount(Module &M);
+
     // pointer boundary check
     void ConstructCheckHandlers(Module &M);
     void PointerBoundaryCheck(Module &M, ValueSet &vs);
@@ -148,13 +275,44 @@ struct Nova : public ModulePass {
     Instruction* GetNextInstruction(Instruction* I);
     void IterateCallSiteIntroduceShadowStackStores(CallInst* call_inst);
 
+    // analysis state
+    NovaArena Arena;
+
+    // bottom-up function summaries
+    DenseMap<Function *, FunctionSummary *> summaries;
+    DenseMap<AliasObjectRef, AliasObjectSet *> paramBindings;
+    void ComputeSummaries(GlobalStateRef gs, Module &M);
+    SmallPtrSet<Function *, 32> demandedFuncs;
+    void ComputeDemandedFunctions(Module &M);
+    void HavocCall(GlobalStateRef gs, Function *f, CallInst &I);
+
+    // address-taken functions by type, the targets of indirect calls
+    DenseMap<FunctionType *, SmallVector<Function *, 4>> addrTakenFuncs;
+    std::vector<Function *> allAddrTakenFuncs;
+    DenseMap<Function *, std::vector<GlobalVariable *>> usedGlobals;
+    void CollectAddressTaken(Module &M);
+    void GetCallTargets(Instruction *call, SmallVectorImpl<Function *> &targets);
+    std::vector<GlobalVariable *> &GetUsedGlobals(Function *f);
+    void ComputeSummary(GlobalStateRef gs, Function *f);
+    void ApplySummary(GlobalStateRef gs, Function *f, CallInst &I);
+    uint64_t GetSummaryVersion(FunctionSummary *summary);
+    bool IsSummaryStale(FunctionSummary *summary);
+    void NoteGlobalAccess(GlobalStateRef gs, AliasObjectRef ao, int offset, bool isDef);
+    void MarkParamObject(AliasObjectRef ao);
+    void BindParamObject(AliasObjectRef param, AliasObjectRef actual,
+                         DenseMap<AliasObjectRef, AliasObjectSet> &subst);
+    void ResolveAliasObject(AliasObjectRef ao, SmallPtrSetImpl<AliasObjectRef> &visited,
+                            SmallVectorImpl<AliasObjectRef> &objs);
+    void InsertObjectValues(AliasObjectRef ao, ValueSet &senVarSet);
+
     // SCC traversal
     void Traversal(GlobalStateRef gs, Function *f);
     void ReverseSCC(std::vector<SCCRef> &, Function *f);
     void VisitSCC(GlobalStateRef gs, SCC &scc);  
-    void HandleLoop(GlobalStateRef gs, SCC &scc);  
+    void HandleLoop(GlobalStateRef gs, SCC &scc);
+    void HandleUnsettledLoop(GlobalStateRef gs, SCC &scc);  
     void HandleCall(GlobalStateRef gs, CallInst &I);  
-    uint32_t LongestUseDefChain(SCC &scc);
+    void VisitInstruction(GlobalStateRef gs, Instruction &I);
     void DispatchClients(GlobalStateRef gs, Instruction &I);
     Function *ResolveCall(GlobalStateRef gs, CallInst &I);
 
@@ -174,10 +332,17 @@ struct Nova : public ModulePass {
     void UpdatePtoGEP(GlobalStateRef gs, Instruction &I);
     void UpdatePtoRet(GlobalStateRef gs, Instruction &I);
     void UpdatePtoBitCast(GlobalStateRef gs, Instruction &I);
+    void UpdatePtoMerge(GlobalStateRef gs, Instruction &I, ArrayRef<Value *> ops);
 
     // points to analysis helper functions 
     void HandlePtoGEPOperator(GlobalStateRef gs, GEPOperator *op);
     AliasObject *CreateAliasObject(Type *type, Value *v);
+    AliasObjectTupleRef GetAliasObjectTuple(AliasObjectRef ao, int offset);
+    TupleSet *InternTupleSet(const TupleSet &ts);
+    AliasObjectSet *NewAliasObjectSet();
+    InstSet *NewInstSet();
+    unsigned GetInstID(Instruction *I);
+    void ReleaseGlobalState(GlobalStateRef gs);
     void PrintAliasObject(AliasObjectRef ao);
     bool SkipStructType(Type *type);
 
@@ -189,6 +354,7 @@ struct Nova : public ModulePass {
     void UpdateTaintGEP(GlobalStateRef gs, Instruction &I);
     void UpdateTaintRet(GlobalStateRef gs, Instruction &I);
     void UpdateTaintBitCast(GlobalStateRef gs, Instruction &I);
+    void UpdateTaintMerge(GlobalStateRef gs, Instruction &I, ArrayRef<Value *> ops);
 }; // struct Nova
 } // namespace
 
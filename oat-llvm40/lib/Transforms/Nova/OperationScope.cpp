@@ -0,0 +1,283 @@
+//===- OperationScope.cpp - Find the functions of the attested operation --===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+// Only the code that runs between cfv_init() and cfv_quote() is attested, the
+// rest of the program does not need any instrumentation.
+//
+// Run this pass on the llvm-link'ed module of the whole program, before Nova
+// and the hint passes. The operation runs the code reachable from each
+// cfv_init call without passing a cfv_quote call; where that code returns, it
+// goes on after the calls of its function, up to their cfv_quote calls. The
+// pass marks every function that may run during the operation with the
+// "oat-in-scope" attribute:
+//   - the functions running that code, as a whole,
+//   - direct callees,
+//   - address-taken functions whose type matches an indirect call, all of
+//     them if none matches, and the ones taken through a cast for any
+//     indirect call,
+//   - address-taken functions that escape anywhere in the module, since
+//     external code may call them back at any time.
+// It also sets the oat.scoped module flag. Nova, the hint passes and the
+// AArch64 control-flow verification pass then skip the functions without the
+// attribute (see oat::isInScope). Modules without a cfv_init call are left
+// alone and instrumented completely.
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Pass.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/OAT/OATCommon.h"
+
+#define DEBUG_TYPE "oat-scope"
+
+STATISTIC(NumInScope, "Number of functions in the operation scope");
+STATISTIC(NumOutOfScope, "Number of functions left uninstrumented");
+
+using namespace llvm;
+
+namespace {
+struct OperationScope : public ModulePass {
+  static char ID;
+
+  DenseMap<FunctionType *, SmallVector<Function *, 4>> AddressTaken;
+  // address-taken functions that may be called through another type
+  SmallVector<Function *, 8> CastAddressTaken;
+  SmallVector<Function *, 16> AllAddressTaken;
+  // address-taken functions external code may get hold of
+  SmallVector<Function *, 16> Escaping;
+  DenseMap<Function *, SmallVector<Instruction *, 4>> Callers;
+  SmallPtrSet<Function *, 32> Scope;
+  SmallVector<Function *, 32> Worklist;
+
+  OperationScope() : ModulePass(ID) {}
+  bool runOnModule(Module &M) override;
+
+  void collectAddressTaken(Module &M);
+  void getCallees(CallSite CS, SmallVectorImpl<Function *> &Callees);
+  void addToScope(Function *F);
+  void addCallees(Instruction &I);
+  bool collectOperationCode(Instruction *Start, Function *Quote,
+                            SmallVectorImpl<Instruction *> &Insts);
+};
+} // end of namespace
+
+// Find the address-taken functions, i.e. those with a use other than a direct
+// call. A function escapes if its address goes anywhere but to a comparison
+// or to a call of a defined function: stored, in a global initializer, passed
+// to external code or through an indirect call, returned, ...
+void OperationScope::collectAddressTaken(Module &M) {
+  for (Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+
+    SmallVector<std::pair<const Use *, bool>, 8> Uses;
+    bool Taken = false, Casted = false, Escapes = false;
+
+    for (const Use &U : F.uses())
+      Uses.push_back(std::make_pair(&U, false));
+    while (!Uses.empty()) {
+      const Use *U = Uses.back().first;
+      bool ThroughCast = Uses.back().second;
+      const User *Usr = U->getUser();
+      Uses.pop_back();
+
+      if (auto *CE = dyn_cast<ConstantExpr>(Usr))
+        if (CE->isCast()) {
+          for (const Use &CU : CE->uses())
+            Uses.push_back(std::make_pair(&CU, true));
+          continue;
+        }
+
+      ImmutableCallSite CS(Usr);
+      if (CS && CS.isCallee(U))
+        continue;
+
+      Taken = true;
+      Casted |= ThroughCast;
+      if (CS) {
+        auto *Callee = dyn_cast<Function>(CS.getCalledValue()->stripPointerCasts());
+        if (Callee == nullptr || Callee->isDeclaration())
+          Escapes = true;
+      } else if (!isa<ICmpInst>(Usr))
+        Escapes = true;
+    }
+
+    if (!Taken)
+      continue;
+    AddressTaken[F.getFunctionType()].push_back(&F);
+    AllAddressTaken.push_back(&F);
+    if (Casted)
+      CastAddressTaken.push_back(&F);
+    if (Escapes)
+      Escaping.push_back(&F);
+  }
+}
+
+// the functions the call CS may run, an indirect call may run any
+// address-taken function of its type or taken through a cast, or any
+// address-taken function at all if none has its type
+void OperationScope::getCallees(CallSite CS, SmallVectorImpl<Function *> &Callees) {
+  Value *Callee = CS.getCalledValue()->stripPointerCasts();
+  if (auto *F = dyn_cast<Function>(Callee)) {
+    if (!F->isIntrinsic())
+      Callees.push_back(F);
+    return;
+  }
+
+  auto It = AddressTaken.find(CS.getFunctionType());
+  if (It == AddressTaken.end()) {
+    Callees.append(AllAddressTaken.begin(), AllAddressTaken.end());
+    return;
+  }
+  Callees.append(It->second.begin(), It->second.end());
+  Callees.append(CastAddressTaken.begin(), CastAddressTaken.end());
+}
+
+void OperationScope::addToScope(Function *F) {
+  if (F->isDeclaration() || !Scope.insert(F).second)
+    return;
+
+  DEBUG(dbgs() << "in scope: " << F->getName() << "\n");
+  Worklist.push_back(F);
+}
+
+// add everything the call I may run
+void OperationScope::addCallees(Instruction &I) {
+  CallSite CS(&I);
+  if (!CS || CS.isInlineAsm())
+    return;
+
+  SmallVector<Function *, 8> Callees;
+  getCallees(CS, Callees);
+  for (Function *F : Callees)
+    addToScope(F);
+}
+
+// Collect the instructions of Start's function that run after Start without
+// passing a cfv_quote call. Returns true if the operation may return from the
+// function, i.e. go on in its callers.
+bool OperationScope::collectOperationCode(Instruction *Start, Function *Quote,
+                                          SmallVectorImpl<Instruction *> &Insts) {
+  SmallPtrSet<BasicBlock *, 32> Visited;
+  SmallVector<BasicBlock *, 32> Stack;
+  bool Returns = false;
+
+  // the instructions from I to the end of the block, false at a cfv_quote call
+  auto collect = [&](BasicBlock::iterator I, BasicBlock *BB) {
+    for (auto E = BB->end(); I != E; ++I) {
+      CallSite CS(&*I);
+      if (CS && Quote && CS.getCalledValue()->stripPointerCasts() == Quote)
+        return false;
+      Insts.push_back(&*I);
+    }
+    return true;
+  };
+
+  BasicBlock *BB = Start->getParent();
+  if (collect(std::next(Start->getIterator()), BB)) {
+    Returns |= isa<ReturnInst>(BB->getTerminator());
+    Stack.append(succ_begin(BB), succ_end(BB));
+  }
+  while (!Stack.empty()) {
+    BB = Stack.pop_back_val();
+    if (!Visited.insert(BB).second || !collect(BB->begin(), BB))
+      continue;
+    Returns |= isa<ReturnInst>(BB->getTerminator());
+    Stack.append(succ_begin(BB), succ_end(BB));
+  }
+
+  return Returns;
+}
+
+bool OperationScope::runOnModule(Module &M) {
+  Function *Init = M.getFunction("cfv_init");
+  Function *Quote = M.getFunction("cfv_quote");
+  LLVMContext &Ctx = M.getContext();
+  SmallVector<Instruction *, 4> Starts;
+  SmallPtrSet<Instruction *, 16> Started;
+
+  if (Init == nullptr)
+    return false;
+
+  for (User *U : Init->users()) {
+    CallSite CS(U);
+    if (CS && CS.getCalledValue()->stripPointerCasts() == Init)
+      Starts.push_back(CS.getInstruction());
+  }
+  if (Starts.empty())
+    return false;
+
+  collectAddressTaken(M);
+  for (Function &F : M)
+    for (Instruction &I : instructions(F)) {
+      CallSite CS(&I);
+      if (!CS || CS.isInlineAsm())
+        continue;
+      SmallVector<Function *, 8> Callees;
+      getCallees(CS, Callees);
+      for (Function *Callee : Callees)
+        Callers[Callee].push_back(&I);
+    }
+
+  for (Function *F : Escaping)
+    addToScope(F);
+
+  // the operation goes on after each call of a function it returns from
+  Started.insert(Starts.begin(), Starts.end());
+  while (!Starts.empty()) {
+    Instruction *Start = Starts.pop_back_val();
+    SmallVector<Instruction *, 64> Insts;
+
+    // the function running the operation is instrumented as a whole
+    Scope.insert(Start->getFunction());
+    if (collectOperationCode(Start, Quote, Insts))
+      for (Instruction *Call : Callers.lookup(Start->getFunction()))
+        if (Started.insert(Call).second)
+          Starts.push_back(Call);
+    for (Instruction *I : Insts)
+      addCallees(*I);
+  }
+
+  while (!Worklist.empty()) {
+    Function *F = Worklist.pop_back_val();
+    for (Instruction &I : instructions(F))
+      addCallees(I);
+  }
+
+  for (Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    if (Scope.count(&F)) {
+      F.addFnAttr(oat::InScopeAttrName);
+      NumInScope++;
+    } else
+      NumOutOfScope++;
+  }
+  M.addModuleFlag(Module::Warning, oat::ScopeFlagName,
+                  ConstantInt::get(Type::getInt32Ty(Ctx), 1));
+
+  AddressTaken.clear();
+  CastAddressTaken.clear();
+  AllAddressTaken.clear();
+  Escaping.clear();
+  Callers.clear();
+  Scope.clear();
+  return true;
+}
+
+char OperationScope::ID = 0;
+static RegisterPass<OperationScope> X("oat-scope", "Mark The Functions Of The Attested Operation", false, false);
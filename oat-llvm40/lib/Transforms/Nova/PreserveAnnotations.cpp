@@ -0,0 +1,86 @@
+//===- PreserveAnnotations.cpp - Keep sensitive annotations across SROA ---===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+// Nova finds the sensitive local variables through their llvm.var.annotation
+// calls. The call takes the address of the alloca, so SROA and mem2reg never
+// promote an annotated variable, and in optimized builds the annotation is
+// what keeps a sensitive variable in memory.
+//
+// Run this pass on the unoptimized module before the -O2 pipeline. It moves
+// each annotation of an alloca onto the alloca as !oat.sensitive metadata and
+// removes the call. A variable that is promoted afterwards lives in registers
+// and needs no def/use events. Nova picks up the ones still in memory from
+// the metadata.
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Pass.h"
+
+#include "llvm/ADT/Statistic.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/OAT/OATCommon.h"
+
+#define DEBUG_TYPE "oat-preserve-annotations"
+
+STATISTIC(NumPreserved, "Number of annotations moved to metadata");
+
+using namespace llvm;
+
+namespace {
+struct PreserveAnnotations : public ModulePass {
+  static char ID;
+
+  PreserveAnnotations() : ModulePass(ID) {}
+  bool runOnModule(Module &M) override;
+};
+} // end of namespace
+
+bool PreserveAnnotations::runOnModule(Module &M) {
+  Function *F = M.getFunction("llvm.var.annotation");
+  SmallVector<IntrinsicInst *, 16> Calls;
+  LLVMContext &Ctx = M.getContext();
+  bool modified = false;
+
+  if (F == nullptr)
+    return false;
+
+  for (User *U : F->users())
+    if (auto *II = dyn_cast<IntrinsicInst>(U))
+      Calls.push_back(II);
+
+  for (IntrinsicInst *II : Calls) {
+    Value *Addr = II->getArgOperand(0);
+    auto *AI = dyn_cast<AllocaInst>(Addr->stripPointerCasts());
+
+    // annotations of anything else stay, Nova still reads the calls
+    if (AI == nullptr)
+      continue;
+
+    DEBUG(dbgs() << "sensitive alloca: " << *AI << "\n");
+
+    AI->setMetadata(oat::SensitiveMDName, MDNode::get(Ctx, None));
+    II->eraseFromParent();
+
+    // only the bitcast feeding the call, an alloca nothing else uses would
+    // be trivially dead as well and lose its metadata with it
+    if (auto *BC = dyn_cast<BitCastInst>(Addr))
+      if (BC->use_empty())
+        BC->eraseFromParent();
+    NumPreserved++;
+    modified = true;
+  }
+
+  return modified;
+}
+
+char PreserveAnnotations::ID = 0;
+static RegisterPass<PreserveAnnotations> X("oat-preserve-annotations", "Move Sensitive Variable Annotations To Metadata", false, false);
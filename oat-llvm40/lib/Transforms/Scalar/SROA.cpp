@@ -51,6 +51,7 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/OAT/OATCommon.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Utils/Local.h"
 #include "llvm/Transforms/Utils/PromoteMemToReg.h"
@@ -3859,6 +3860,10 @@ AllocaInst *SROA::rewritePartition(AllocaInst &AI, AllocaSlices &AS,
     NewAI = new AllocaInst(
         SliceTy, nullptr, Alignment,
         AI.getName() + ".sroa." + Twine(P.begin() - AS.begin()), &AI);
+    // Every partition of an annotated alloca holds part of the sensitive
+    // variable, keep the tag -oat-preserve-annotations left on it.
+    if (MDNode *Sensitive = AI.getMetadata(oat::SensitiveMDName))
+      NewAI->setMetadata(oat::SensitiveMDName, Sensitive);
     ++NumNewAllocas;
   }
 
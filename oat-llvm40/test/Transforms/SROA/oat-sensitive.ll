@@ -0,0 +1,29 @@
+; RUN: opt < %s -sroa -S | FileCheck %s
+target datalayout = "e-m:e-i8:8:32-i16:16:32-i64:64-i128:128-n32:64-S128"
+
+; The partitions of an alloca tagged by -oat-preserve-annotations keep the
+; !oat.sensitive tag. Only the volatile second field stays in memory.
+
+define i32 @test1(i32 %a, i32 %b) {
+; CHECK-LABEL: @test1(
+; CHECK: %[[slot:.*]] = alloca i32, !oat.sensitive ![[md:[0-9]+]]
+; CHECK-NOT: alloca
+; CHECK: store volatile i32 %b, i32* %[[slot]]
+; CHECK: %[[b:.*]] = load volatile i32, i32* %[[slot]]
+; CHECK: %[[sum:.*]] = add i32 %a, %[[b]]
+; CHECK: ret i32 %[[sum]]
+
+entry:
+  %key = alloca { i32, i32 }, align 4, !oat.sensitive !0
+  %f0 = getelementptr inbounds { i32, i32 }, { i32, i32 }* %key, i64 0, i32 0
+  %f1 = getelementptr inbounds { i32, i32 }, { i32, i32 }* %key, i64 0, i32 1
+  store i32 %a, i32* %f0
+  store volatile i32 %b, i32* %f1
+  %x = load i32, i32* %f0
+  %y = load volatile i32, i32* %f1
+  %sum = add i32 %x, %y
+  ret i32 %sum
+}
+
+; CHECK: ![[md]] = !{}
+!0 = !{}
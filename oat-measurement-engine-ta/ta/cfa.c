@@ -4,7 +4,7 @@
 #include <include/cfa.h>
 #include <include/blake2.h>
 
-uint32_t cfa_init(cfa_ctx_t *ctx) {
+uint32_t cfa_init(cfa_ctx_t *ctx, uint32_t sen_count) {
     int i;
 
     ctx->p = 10000001; /* some prime number near 2^64 */
@@ -23,14 +23,35 @@ uint32_t cfa_init(cfa_ctx_t *ctx) {
     for (i = 0; i < HASHMAP_SIZE; i++)
        ctx->sec_data_hashmap.bucket[i] = NULL;
 
+    /* initialize sensitive variable table, indexed by dense ID */
+    ctx->sen_count = sen_count;
+    ctx->sen_vals = TEE_Malloc(sen_count*sizeof(uint64_t), TEE_MALLOC_FILL_ZERO);
+    ctx->sen_defined = TEE_Malloc(sen_count*sizeof(uint8_t), TEE_MALLOC_FILL_ZERO);
+
     /* initialize conditional branch condition buffer */
-    ctx->cond_buf = TEE_Malloc(MAX_COND_EVENTS*sizeof(char), TEE_MALLOC_FILL_ZERO);
+    ctx->cond_buf = TEE_Malloc(MAX_COND_BITS/8, TEE_MALLOC_FILL_ZERO);
     ctx->cond_buf_idx = 0;
 
     /* initialize indirect branch address buffer */
     ctx->iaddr_buf = TEE_Malloc(MAX_IBRANCH_EVENTS*sizeof(uint64_t), TEE_MALLOC_FILL_ZERO);
     ctx->iaddr_buf_idx = 0;
 
+    /* initialize jump table case index buffer */
+    ctx->jt_buf = TEE_Malloc(MAX_JT_EVENTS*sizeof(uint8_t), TEE_MALLOC_FILL_ZERO);
+    ctx->jt_buf_idx = 0;
+
+    /* initialize indirect call target index buffer */
+    ctx->icall_buf = TEE_Malloc(MAX_ICALL_EVENTS*sizeof(uint8_t), TEE_MALLOC_FILL_ZERO);
+    ctx->icall_buf_idx = 0;
+
+    /* initialize path ID buffer */
+    ctx->path_buf = TEE_Malloc(MAX_PATH_EVENTS*2*sizeof(uint64_t), TEE_MALLOC_FILL_ZERO);
+    ctx->path_buf_idx = 0;
+
+    /* initialize loop iteration count buffer */
+    ctx->loop_buf = TEE_Malloc(MAX_LOOP_EVENTS*2*sizeof(uint64_t), TEE_MALLOC_FILL_ZERO);
+    ctx->loop_buf_idx = 0;
+
     ctx->initialized = true;
 
     return 0;
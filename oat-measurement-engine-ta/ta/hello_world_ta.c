@@ -38,6 +38,10 @@
 /* store buffer in encrypted file */
 const char blob_cond_fname[] = "blob.cond.teedata.date";
 const char blob_iaddr_fname[] = "blob.iaddr.teedata.date";
+const char blob_jt_fname[] = "blob.jt.teedata.date";
+const char blob_icall_fname[] = "blob.icall.teedata.date";
+const char blob_path_fname[] = "blob.path.teedata.date";
+const char blob_loop_fname[] = "blob.loop.teedata.date";
 const char blob_rethash_fname[] = "blob.rethash.teedata.date";
 
 /*
@@ -129,14 +133,42 @@ static TEE_Result cfa_init_wrapper(uint32_t param_types,
 	if (param_types != exp_param_types)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	cfa_init(&cfa_ctx);
+	cfa_init(&cfa_ctx, params[0].value.a);
 
 	return TEE_SUCCESS;
 }
 
+static void sensitive_id_event(cfa_ctx_t *ctx, cfa_event_t *evt) {
+    uint64_t id = evt->a & ~OAT_SENSITIVE_ID_FLAG;
+
+    if (id >= ctx->sen_count) {
+        DMSG("def-use check fail, bad sensitive id: 0x%llx\n", id);
+        return;
+    }
+
+    if (evt->etype == CFV_EVENT_DATA_DEF) {
+        ctx->sen_vals[id] = evt->b;
+        ctx->sen_defined[id] = 1;
+    } else if (evt->etype == CFV_EVENT_DATA_USE) {
+        if (!ctx->sen_defined[id] || ctx->sen_vals[id] != evt->b) {
+            /* use check fail! */
+            if (!ctx->sen_defined[id])
+	            DMSG("def-use check fail at id: 0x%llx, value: 0x%llx no define record\n", id, evt->b);
+            else
+	            DMSG("def-use check fail at id: 0x%llx, value: 0x%llx value not match with recorded 0x%llx\n", id, evt->b, ctx->sen_vals[id]);
+
+            // record and update
+            ctx->sen_vals[id] = evt->b;
+            ctx->sen_defined[id] = 1;
+        }
+    }
+}
+
 static void data_event(cfa_ctx_t *ctx, cfa_event_t *evt) {
     node_t *ptr;
-    if (evt->etype == CFV_EVENT_DATA_DEF) {
+    if (evt->a & OAT_SENSITIVE_ID_FLAG) {
+        sensitive_id_event(ctx, evt);
+    } else if (evt->etype == CFV_EVENT_DATA_DEF) {
         hashmap_update(&(ctx->sec_data_hashmap), evt->a, evt->b);
     } else if (evt->etype == CFV_EVENT_DATA_USE) {
         ptr = hashmap_lookup(&(ctx->sec_data_hashmap), evt->a);
@@ -286,24 +318,104 @@ static void trace_addr_event(cfa_ctx_t *ctx, cfa_event_t *evt) {
     ctx->iaddr_buf[ctx->iaddr_buf_idx++] = evt->b;//record return inst target address
 }
 
-static void trace_cond_event(cfa_ctx_t *ctx, cfa_event_t *evt) {
-    if (ctx->cond_buf_idx == MAX_COND_EVENTS) {
+static void trace_jt_event(cfa_ctx_t *ctx, cfa_event_t *evt) {
+    if (ctx->jt_buf_idx == MAX_JT_EVENTS) {
+        // buffer full, store it.
+        save_data(blob_jt_fname, ctx->jt_buf, MAX_JT_EVENTS*sizeof(uint8_t));
+        ctx->jt_buf_idx = 0;
+    }
+
+    // the verifier knows which jump table is dispatched from its .oat_jt
+    // record, the case index (< 256) is all it needs to pick the target.
+    ctx->jt_buf[ctx->jt_buf_idx++] = evt->b & 0xff;
+}
+
+static void trace_icall_event(cfa_ctx_t *ctx, cfa_event_t *evt) {
+    if (ctx->icall_buf_idx == MAX_ICALL_EVENTS) {
+        // buffer full, store it.
+        save_data(blob_icall_fname, ctx->icall_buf, MAX_ICALL_EVENTS*sizeof(uint8_t));
+        ctx->icall_buf_idx = 0;
+    }
+
+    // the verifier looks the index up in the .oat_icall table of the call
+    // site, a target missing from the table is recorded by address.
+    ctx->icall_buf[ctx->icall_buf_idx++] = evt->a & 0xff;
+    if (evt->a == 0)
+        trace_addr_event(ctx, evt);
+}
+
+static void trace_path_event(cfa_ctx_t *ctx, cfa_event_t *evt) {
+    if (ctx->path_buf_idx == MAX_PATH_EVENTS*2) {
+        // buffer full, store it.
+        save_data(blob_path_fname, ctx->path_buf, MAX_PATH_EVENTS*2*sizeof(uint64_t));
+        ctx->path_buf_idx = 0;
+    }
+
+    // (function ID, path ID), the path ID decodes into the branches taken
+    // with the .oat_paths record of the function.
+    ctx->path_buf[ctx->path_buf_idx++] = evt->b;
+    ctx->path_buf[ctx->path_buf_idx++] = evt->a;
+}
+
+// Append the nbits low bits of bits to the cond bitstream, least significant
+// bit first. The bytes are filled from their least significant bit as well.
+static void trace_bits(cfa_ctx_t *ctx, uint64_t bits, uint32_t nbits) {
+    uint32_t i;
+
+    for (i = 0; i < nbits; i++) {
+        if (ctx->cond_buf_idx == MAX_COND_BITS) {
+            // buffer full, store it.
+            save_data(blob_cond_fname, ctx->cond_buf, MAX_COND_BITS/8);
+            TEE_MemFill(ctx->cond_buf, 0, MAX_COND_BITS/8);
+            ctx->cond_buf_idx = 0;
+        }
+        if ((bits >> i) & 1)
+            ctx->cond_buf[ctx->cond_buf_idx / 8] |= 1 << (ctx->cond_buf_idx % 8);
+        ctx->cond_buf_idx++;
+    }
+}
+
+static void trace_loop_event(cfa_ctx_t *ctx, cfa_event_t *evt) {
+    if (ctx->loop_buf_idx == MAX_LOOP_EVENTS*2) {
         // buffer full, store it.
-        save_data(blob_cond_fname, ctx->cond_buf, MAX_COND_EVENTS*sizeof(char));
-        ctx->cond_buf_idx = 0;
+        save_data(blob_loop_fname, ctx->loop_buf, MAX_LOOP_EVENTS*2*sizeof(uint64_t));
+        ctx->loop_buf_idx = 0;
     }
-    //record condition taken / not takeninfo, we use 'y' or 'n', which takes one-byte
-    // it should be further optimized to use only one bit.
-    ctx->cond_buf[ctx->cond_buf_idx++] = 'y' ? evt->a == 1 : 'n';
+
+    // (function ID << 32 | site, depth << 48 | header executions) of one
+    // entry of the loop, the verifier replays the loop exit from them.
+    ctx->loop_buf[ctx->loop_buf_idx++] = evt->a;
+    ctx->loop_buf[ctx->loop_buf_idx++] = evt->b;
+}
+
+static void trace_cond_event(cfa_ctx_t *ctx, cfa_event_t *evt) {
+    // one bit, set if the branch is taken
+    trace_bits(ctx, evt->a == 1, 1);
+}
+
+static void trace_switch_event(cfa_ctx_t *ctx, cfa_event_t *evt) {
+    // the case index in the fewest bits for the case count of the switch,
+    // which the verifier knows from the .oat_sites entry it is replaying.
+    trace_bits(ctx, evt->a, evt->b);
 }
 
 static void handle_event(cfa_ctx_t *ctx, cfa_event_t *evt) {
     if (evt->etype == CFV_EVENT_CTRL)
         control_event(ctx, evt);
-    else (evt->etype == CFV_EVENT_HINT_ICALL || evt-etype == CFV_EVENT_HINT_IBR)
+    else if (evt->etype == CFV_EVENT_HINT_ICALL || evt->etype == CFV_EVENT_HINT_IBR)
         trace_addr_event(ctx, evt);
-    else (evt->etype == CFV_EVENT_CONDBR)
+    else if (evt->etype == CFV_EVENT_HINT_IBR_JT)
+        trace_jt_event(ctx, evt);
+    else if (evt->etype == CFV_EVENT_HINT_ICALL_IDX)
+        trace_icall_event(ctx, evt);
+    else if (evt->etype == CFV_EVENT_HINT_CONDBR)
         trace_cond_event(ctx, evt);
+    else if (evt->etype == CFV_EVENT_HINT_SWITCH)
+        trace_switch_event(ctx, evt);
+    else if (evt->etype == CFV_EVENT_HINT_PATH)
+        trace_path_event(ctx, evt);
+    else if (evt->etype == CFV_EVENT_HINT_LOOP)
+        trace_loop_event(ctx, evt);
     else
         data_event(ctx, evt);
 }
@@ -334,6 +446,39 @@ static TEE_Result verify(uint32_t param_types,
 	return TEE_SUCCESS;
 }
 
+static TEE_Result verify_multi(uint32_t param_types,
+	TEE_Param params[4])
+{
+	uint32_t exp_param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_MEMREF_INPUT,
+						   TEE_PARAM_TYPE_MEMREF_INPUT,
+						   TEE_PARAM_TYPE_NONE);
+
+	cfa_event_t evt;
+	uint64_t *a, *b;
+	uint32_t i, n;
+
+	DMSG("has been called");
+	if (param_types != exp_param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	n = params[0].value.b;
+	if (params[1].memref.size < n*sizeof(uint64_t) ||
+	    params[2].memref.size < n*sizeof(uint64_t))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	a = params[1].memref.buffer;
+	b = params[2].memref.buffer;
+	evt.etype = params[0].value.a;
+	for (i = 0; i < n; i++) {
+		evt.a = a[i];
+		evt.b = b[i];
+		handle_event(&cfa_ctx, &evt);
+	}
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result cfa_quote_wrapper(uint32_t param_types,
 	TEE_Param params[4])
 {
@@ -356,7 +501,11 @@ static TEE_Result cfa_quote_wrapper(uint32_t param_types,
     // in real system, we should sign them and send the blob and the signature out to verifier
     // for our prototype, we just save them as secure objects.
     save_data(blob_iaddr_fname, cfa_ctx.iaddr_buf, cfa_ctx.iaddr_buf_idx*sizeof(uint64_t));
-    save_data(blob_cond_fname, cfa_ctx.cond_buf, cfa_ctx.cond_buf_idx*sizeof(char));
+    save_data(blob_jt_fname, cfa_ctx.jt_buf, cfa_ctx.jt_buf_idx*sizeof(uint8_t));
+    save_data(blob_icall_fname, cfa_ctx.icall_buf, cfa_ctx.icall_buf_idx*sizeof(uint8_t));
+    save_data(blob_path_fname, cfa_ctx.path_buf, cfa_ctx.path_buf_idx*sizeof(uint64_t));
+    save_data(blob_loop_fname, cfa_ctx.loop_buf, cfa_ctx.loop_buf_idx*sizeof(uint64_t));
+    save_data(blob_cond_fname, cfa_ctx.cond_buf, (cfa_ctx.cond_buf_idx + 7)/8);
     save_data(blob_rethash_fname, cfa_ctx.digest, BLAKE2S_OUTBYTES);
 
 	return TEE_SUCCESS;
@@ -401,6 +550,8 @@ TEE_Result TA_InvokeCommandEntryPoint(void __maybe_unused *sess_ctx,
 		return cfa_init_wrapper(param_types, params);
 	case TA_CMD_CFA_QUOTE:
 		return cfa_quote_wrapper(param_types, params);
+	case TA_CMD_CFA_VERIFY_EVENTS_MULTI:
+		return verify_multi(param_types, params);
 	default:
 		return TEE_ERROR_BAD_PARAMETERS;
 	}
@@ -12,10 +12,22 @@
 #define CFV_EVENT_HINT_CONDBR	0x00000080
 #define CFV_EVENT_HINT_ICALL	0x00000100
 #define CFV_EVENT_HINT_IBR  	0x00000200
+#define CFV_EVENT_HINT_IBR_JT	0x00000400
+#define CFV_EVENT_HINT_PATH	0x00000800
+#define CFV_EVENT_HINT_SWITCH	0x00001000
+#define CFV_EVENT_HINT_LOOP	0x00002000
+#define CFV_EVENT_HINT_ICALL_IDX	0x00004000
+
+/* data event key is a dense sensitive variable ID, not an address */
+#define OAT_SENSITIVE_ID_FLAG	0x8000000000000000ULL
 
 /* max trace events */
-#define MAX_COND_EVENTS 10*1000 // it depends on how much memory is available for recording trace
+#define MAX_COND_BITS 80*1000 // branch outcomes and switch case indexes, same memory as 10*1000 bytes
 #define MAX_IBRANCH_EVENTS 1000 // it depends on how much memory is available for recording trace
+#define MAX_JT_EVENTS 8*1000 // one byte per event, same memory as MAX_IBRANCH_EVENTS
+#define MAX_ICALL_EVENTS 8*1000 // one byte per event, the target index in its .oat_icall table
+#define MAX_PATH_EVENTS 1000 // one Ball-Larus path ID per loop iteration, call or function return
+#define MAX_LOOP_EVENTS 500 // one (loop ID, iterations) pair per loop entry
 
 typedef struct cfa_event {
 	uint64_t etype;
@@ -49,20 +61,41 @@ typedef struct cfa_ctx {
     blake2s_state S;
     uint8_t digest[BLAKE2S_BLOCKBYTES];
 
-    /* trace cond buffer */
-    char *cond_buf;
+    /* trace cond bitstream, cond_buf_idx counts bits */
+    uint8_t *cond_buf;
     uint32_t cond_buf_idx;
 
     /* trace indirect branch address buffer */
     uint64_t *iaddr_buf;
     uint32_t iaddr_buf_idx;
 
+    /* trace jump table case index buffer */
+    uint8_t *jt_buf;
+    uint32_t jt_buf_idx;
+
+    /* trace indirect call target index buffer */
+    uint8_t *icall_buf;
+    uint32_t icall_buf_idx;
+
+    /* trace Ball-Larus path ID buffer */
+    uint64_t *path_buf;
+    uint32_t path_buf_idx;
+
+    /* trace loop iteration count buffer, (loop ID, iterations) pairs */
+    uint64_t *loop_buf;
+    uint32_t loop_buf_idx;
 
     hashmap_t sec_data_hashmap;
+
+    /* last defined value of sensitive variables with dense ID */
+    uint64_t *sen_vals;
+    uint8_t *sen_defined;
+    uint32_t sen_count;
+
 	bool initialized;
 } cfa_ctx_t;
 
-uint32_t cfa_init(cfa_ctx_t *ctx);
+uint32_t cfa_init(cfa_ctx_t *ctx, uint32_t sen_count);
 uint32_t cfa_quote(cfa_ctx_t *ctx);
 
 /*!
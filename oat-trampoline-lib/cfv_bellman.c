@@ -27,12 +27,15 @@ bool cfv_start = false;
 char hints_file[64] = "hints.txt";
 FILE *hfp = NULL;
 
+/* number of dense sensitive variable IDs, emitted by Nova */
+extern const uint64_t __oat_sensitive_count __attribute__((weak));
+
 /**
  * for control event:(noly return event)
  *    a = src
  *    b = dest
  * for data event
- *    a = addr
+ *    a = addr, or (1 << 63) | id for sensitive globals with dense ID
  *    b = value 
  * for icall hint
  *    a = src
@@ -40,6 +43,9 @@ FILE *hfp = NULL;
  * for ijmp hint
  *    a = src
  *    b = target
+ * for jump table ijmp hint
+ *    a = src
+ *    b = (jump table index << 32) | case index
  * for cond branch hint
  *    a = true/false
  *
@@ -110,11 +116,14 @@ uint32_t cfv_init()
 	printf("open_ta time: %lu\n", end - start);
 
 	memset(&op, 0, sizeof(op));
-	op.paramTypes = TEEC_PARAM_TYPES(TEEC_NONE,
+	op.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_INOUT,
 					 TEEC_NONE,
 					 TEEC_NONE,
 					 TEEC_NONE);
 
+	/* the TA sizes its table of sensitive values by this count */
+	op.params[0].value.a = &__oat_sensitive_count ? __oat_sensitive_count : 0;
+
 	start = usecs();
 	printf("memset op time: %lu\n", start - end);
 
@@ -201,6 +210,36 @@ uint32_t handle_event(uint64_t etype, uint64_t a, uint64_t b) {
 	return 0;
 }
 
+/**
+ * n events of the same type in one world switch,
+ * event i is (event_type, a[i], b[i])
+ */
+uint32_t handle_events(uint64_t etype, uint64_t n, uint64_t *a, uint64_t *b) {
+	TEEC_Result res;
+	uint32_t ret_origin;
+
+	if (cfv_start == false)
+		return 0;
+	memset(&op, 0, sizeof(op));
+
+	op.paramTypes = TEEC_PARAM_TYPES(TEEC_VALUE_INPUT,
+					 TEEC_MEMREF_TEMP_INPUT,
+					 TEEC_MEMREF_TEMP_INPUT,
+					 TEEC_NONE);
+	op.params[0].value.a = etype;
+	op.params[0].value.b = n;
+	op.params[1].tmpref.buffer = a;
+	op.params[1].tmpref.size = n * sizeof(uint64_t);
+	op.params[2].tmpref.buffer = b;
+	op.params[2].tmpref.size = n * sizeof(uint64_t);
+
+	res = TEEC_InvokeCommand(&sess, TA_CMD_CFA_VERIFY_EVENTS_MULTI, &op,
+				 &ret_origin);
+	check_res(res, "TEEC_InvokeCommand");
+
+	return 0;
+}
+
 void enable_pmc() {
 	// program the performance-counter control-register:
 	asm volatile("msr pmcr_el0, %0" : : "r" (17));
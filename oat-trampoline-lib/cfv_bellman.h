@@ -11,12 +11,18 @@
 #define CFV_EVENT_HINT_CONDBR	0x00000080
 #define CFV_EVENT_HINT_ICALL	0x00000100
 #define CFV_EVENT_HINT_IBR  	0x00000200
+#define CFV_EVENT_HINT_IBR_JT	0x00000400
+#define CFV_EVENT_HINT_PATH	0x00000800
+#define CFV_EVENT_HINT_SWITCH	0x00001000
+#define CFV_EVENT_HINT_LOOP	0x00002000
+#define CFV_EVENT_HINT_ICALL_IDX	0x00004000
 
 /* Normal world API */
 
 uint32_t cfv_init(void);
 uint32_t cfv_quote(void);
 uint32_t handle_event(uint64_t event_type, uint64_t a, uint64_t b);
+uint32_t handle_events(uint64_t event_type, uint64_t n, uint64_t *a, uint64_t *b);
 
 
 #endif /* CFV_BELLMAN_H*/
@@ -38,5 +38,6 @@
 #define TA_CMD_CFA_INIT			2
 #define TA_CMD_CFA_QUOTE		3
 #define TA_CMD_CFA_SETUP		4
+#define TA_CMD_CFA_VERIFY_EVENTS_MULTI	5
 
 #endif /*TA_HELLO_WORLD_H*/
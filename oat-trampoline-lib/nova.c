@@ -22,18 +22,36 @@ extern bool cfv_start;
 void cfv_icall(uint64_t target, uint64_t pc);
 void cfv_ijmp(uint64_t target, uint64_t pc);
 void cfv_ret(uint64_t target, uint64_t pc);
+void cfv_ijmp_jt(uint64_t jt_index, uint64_t pc);
 
-void __record_defevt(uint64_t addr, uint64_t val) {
+/* handlers of the preserve_most hook stubs in trampoline.S */
+void record_defevt(uint64_t addr, uint64_t val);
+void check_useevt(uint64_t addr, uint64_t val);
+void check_useevt_multi(uint64_t n, uint64_t *addrs, uint64_t *vals);
+void collect_cond_branch_hints(bool cond);
+void collect_switch_hints(uint32_t index, uint32_t width);
+void collect_path_hints(uint32_t fid, uint64_t path);
+void collect_icall_hints(uint32_t index, uint64_t target);
+void collect_ibranch_hints(uint64_t fid, uint64_t site, uint64_t target);
+void collect_loop_hints(uint32_t fid, uint32_t site, uint32_t depth, uint64_t iterations);
+
+void record_defevt(uint64_t addr, uint64_t val) {
     debug_info("%s addr: %lx val: %lx\n", __func__, addr, val);
     handle_event(CFV_EVENT_DATA_DEF, addr, val);
 }
 
-void __check_useevt(uint64_t addr, uint64_t val) {
+void check_useevt(uint64_t addr, uint64_t val) {
     debug_info("%s addr: %lx val: %lx\n", __func__, addr, val);
     handle_event(CFV_EVENT_DATA_USE, addr, val);
 }
 
-void __collect_cond_branch_hints(bool cond) {
+/* use checks hoisted to the same program point, e.g. a loop preheader */
+void check_useevt_multi(uint64_t n, uint64_t *addrs, uint64_t *vals) {
+    debug_info("%s n: %lu\n", __func__, n);
+    handle_events(CFV_EVENT_DATA_USE, n, addrs, vals);
+}
+
+void collect_cond_branch_hints(bool cond) {
     if (cond)
         handle_event(CFV_EVENT_HINT_CONDBR, 1, 0);
     else
@@ -47,12 +65,53 @@ void __collect_cond_branch_hints(bool cond) {
         fprintf(hfp, "n");
 }
 
-void __collect_icall_hints(uint64_t fid, uint64_t count, uint64_t func) {
-    debug_info("%s fid: 0x%lx count: 0x%lx funcaddr: 0x%lx\n", __func__, fid, count, func);
+/* case index of a switch, 0 for the default, packed in width bits */
+void collect_switch_hints(uint32_t index, uint32_t width) {
+    debug_info("%s index: %u width: %u\n", __func__, index, width);
+    handle_event(CFV_EVENT_HINT_SWITCH, index, width);
+
+    if (hfp == NULL || cfv_start == false)
+	return;
+    fprintf(hfp, "s%u\n", index);
+}
+
+/* Ball-Larus path ID of function fid, emitted at loop back edges, returns
+ * and before calls */
+void collect_path_hints(uint32_t fid, uint64_t path) {
+    debug_info("%s fid: %u path: %lu\n", __func__, fid, path);
+    handle_event(CFV_EVENT_HINT_PATH, path, fid);
+
+    if (hfp == NULL || cfv_start == false)
+	return;
+    fprintf(hfp, "p%u:%lu\n", fid, path);
+}
+
+/* index from 1 of the target in the .oat_icall table of the call site, 0 if
+ * it is not listed there and the TA has to record the target address */
+void collect_icall_hints(uint32_t index, uint64_t target) {
+    debug_info("%s index: %u funcaddr: 0x%lx\n", __func__, index, target);
+    handle_event(CFV_EVENT_HINT_ICALL_IDX, index, target);
+
+    if (hfp == NULL || cfv_start == false)
+	return;
+    fprintf(hfp, "i%u:%lx\n", index, target);
+}
+
+void collect_ibranch_hints(uint64_t fid, uint64_t site, uint64_t target) {
+    debug_info("%s fid: 0x%lx site: 0x%lx funcaddr: 0x%lx\n", __func__, fid, site, target);
 }
 
-void __collect_ibranch_hints(uint64_t fid, uint64_t count, uint64_t target) {
-    debug_info("%s fid: 0x%lx count: 0x%lx funcaddr: 0x%lx\n", __func__, fid, count, target);
+/* header executions of one entry of a loop, reported when it is left, with
+ * the number of activations of its function below the one that ran it; the
+ * depth goes to the top 16 bits */
+void collect_loop_hints(uint32_t fid, uint32_t site, uint32_t depth, uint64_t iterations) {
+    debug_info("%s fid: %u site: %u depth: %u iterations: %lu\n", __func__, fid, site, depth, iterations);
+    handle_event(CFV_EVENT_HINT_LOOP, ((uint64_t)fid << 32) | site,
+                 ((uint64_t)(depth & 0xffff) << 48) | (iterations & 0xffffffffffffULL));
+
+    if (hfp == NULL || cfv_start == false)
+	return;
+    fprintf(hfp, "l%u:%u:%u:%lu\n", fid, site, depth, iterations);
 }
 
 void cfv_icall(uint64_t target, uint64_t pc) {
@@ -76,3 +135,11 @@ void cfv_ijmp(uint64_t target, uint64_t pc) {
     fprintf(hfp,"%s dest: %lx src: %lx\n", __func__, target, pc);
 }
 
+/* jump table dispatch, the target is resolved by the verifier from .oat_jt */
+void cfv_ijmp_jt(uint64_t jt_index, uint64_t pc) {
+    debug_info("%s jt: %lu idx: %lu src: %lx\n", __func__, jt_index >> 32, jt_index & 0xffffffff, pc);
+    handle_event(CFV_EVENT_HINT_IBR_JT, pc, jt_index);
+    if (hfp == NULL||cfv_start == false)
+	return;
+    fprintf(hfp,"%s jt: %lu idx: %lu src: %lx\n", __func__, jt_index >> 32, jt_index & 0xffffffff, pc);
+}
@@ -5,13 +5,17 @@
 
 void __record_defevt(uint64_t addr, uint64_t val);
 void __check_useevt(uint64_t addr, uint64_t val);
-void __collect_loop_hints(int fid, int level, int count);
+void __check_useevt_multi(uint64_t n, uint64_t *addrs, uint64_t *vals);
+void __collect_loop_hints(uint32_t fid, uint32_t site, uint32_t depth, uint64_t iterations);
 void __collect_cond_branch_hints(bool cond);
-void __collect_icall_hints(uint64_t fid, uint64_t count, uint64_t func);
-void __collect_ibranch_hints(uint64_t fid, uint64_t count, uint64_t target);
+void __collect_switch_hints(uint32_t index, uint32_t width);
+void __collect_path_hints(uint32_t fid, uint64_t path);
+void __collect_icall_hints(uint32_t index, uint64_t target);
+void __collect_ibranch_hints(uint64_t fid, uint64_t site, uint64_t target);
 
 void __cfv_icall(uint64_t target);
 void __cfv_ijmp(uint64_t target);
 void __cfv_ret(uint64_t target);
+void __cfv_ijmp_jt(uint64_t jt_index);
 
 #endif
@@ -0,0 +1,425 @@
+#!/usr/bin/env python
+#
+# Reader for the .oat_* sections emitted by the OAT compiler
+#
+# Copyright (c) 2018 Northeastern University
+#
+import struct
+
+ELF64_EHDR = '<16sHHIQQQIHHHHHH'
+ELF64_SHDR = '<IIQQQQIIQQ'
+
+def read_sections(binfile):
+    """Return a dict mapping section name to (address, data) of an ELF64 file."""
+    sections = {}
+
+    with open(binfile, 'rb') as f:
+        elf = f.read()
+
+    if elf[:4] != '\x7fELF':
+        return sections
+
+    ehdr = struct.unpack_from(ELF64_EHDR, elf, 0)
+    shoff, shentsize, shnum, shstrndx = ehdr[6], ehdr[10], ehdr[11], ehdr[12]
+
+    shdrs = [struct.unpack_from(ELF64_SHDR, elf, shoff + i * shentsize)
+            for i in range(shnum)]
+    strtab = shdrs[shstrndx]
+    names = elf[strtab[4]:strtab[4] + strtab[5]]
+
+    for shdr in shdrs:
+        name = names[shdr[0]:names.index('\0', shdr[0])]
+        sections[name] = (shdr[3], elf[shdr[4]:shdr[4] + shdr[5]])
+
+    return sections
+
+def read_jump_tables(sections):
+    """Parse .oat_jt, return a dict mapping br address to its target list.
+
+    Each record is:
+        .xword <address of br>
+        .word  <jump table index>, <number of entries>
+        .xword <target block address> * number of entries
+    """
+    tables = {}
+
+    if '.oat_jt' not in sections:
+        return tables
+
+    data = sections['.oat_jt'][1]
+    offset = 0
+    while offset < len(data):
+        br, jti, count = struct.unpack_from('<QII', data, offset)
+        offset += 16
+        tables[br] = list(struct.unpack_from('<%dQ' % count, data, offset))
+        offset += 8 * count
+
+    return tables
+
+def read_implicit_rets(sections):
+    """Parse .oat_implicit_ret, return the set of ret addresses not reported."""
+    rets = set()
+
+    if '.oat_implicit_ret' not in sections:
+        return rets
+
+    data = sections['.oat_implicit_ret'][1]
+    rets.update(struct.unpack_from('<%dQ' % (len(data) / 8), data, 0))
+
+    return rets
+
+def read_icall_tables(sections):
+    """Parse .oat_icall, return a dict mapping (fid, site) to the target
+    list of an indirect call site, see read_sites().
+
+    Each record is:
+        .word  <function ID>, <site>, <number of targets>, <slot>
+        .xword <target address> * number of targets
+
+    <slot> is 0 for an indirect call. For a virtual call it is the vtable
+    slot + 1, the list holds the function in that slot of each vtable of the
+    static type of the object, and the index is the class ID of the object.
+    The icall blob of the TA holds one byte per indirect call, the index of
+    the target in this list counted from 1. Index 0 means the target is not
+    in the list, its address is the next entry of the iaddr blob.
+    """
+    tables = {}
+
+    if '.oat_icall' not in sections:
+        return tables
+
+    data = sections['.oat_icall'][1]
+    offset = 0
+    while offset < len(data):
+        fid, site, count = struct.unpack_from('<III', data, offset)
+        offset += 16
+        tables[(fid, site)] = list(struct.unpack_from('<%dQ' % count, data, offset))
+        offset += 8 * count
+
+    return tables
+
+# flags of a .oat_paths edge record
+PATH_BRANCH = 1
+PATH_RESET = 2
+PATH_EXIT = 4
+PATH_EXIT_BLOCK = 0xffffffff
+
+def read_paths(sections):
+    """Parse .oat_paths, return a dict mapping a function ID to its
+    (name, path DAG).
+
+    Each record is:
+        .word  <function ID>, <length of the name>, <number of edges>, 0
+        .ascii <function name>, zero padded to 8 bytes
+        .word  <src>, <dst>, <successor number>, <flags>
+        .xword <value>                            * number of edges
+
+    The DAG maps a block index to its (dst, successor number, flags, value)
+    edges, listed by increasing value. Each back edge has its own edge to
+    EXIT, with the successor number of the back edge. So has each block
+    ending with a call, a path ends right before the call.
+    The branch of block b is the SITE_PATHBR site b | PATH_SITE_FLAG of the
+    function in .oat_cfg, see read_cfg().
+    """
+    paths = {}
+
+    if '.oat_paths' not in sections:
+        return paths
+
+    data = sections['.oat_paths'][1]
+    offset = 0
+    while offset < len(data):
+        fid, namelen, count = struct.unpack_from('<III', data, offset)
+        offset += 16
+        name = data[offset:offset + namelen]
+        offset += (namelen + 7) & ~7
+        dag = {}
+        for i in range(count):
+            src, dst, succ, flags, val = struct.unpack_from('<IIIIQ', data, offset)
+            offset += 24
+            dag.setdefault(src, []).append((dst, succ, flags, val))
+        paths[fid] = (name, dag)
+
+    return paths
+
+def decode_path(dag, path):
+    """Decode a path ID into the list of (block, successor number) branches.
+
+    The path starts at the entry block, or at the loop header or the block
+    after a call of the reset edge it begins with, and ends at EXIT. An edge
+    to EXIT from a branch is the back edge taken at the end of a loop
+    iteration. The successor number of a switch is its case index.
+    """
+    branches = []
+    block = 0
+
+    while block != PATH_EXIT_BLOCK:
+        # the edge with the largest value not above the remaining path ID
+        dst, succ, flags, val = [e for e in dag[block] if e[3] <= path][-1]
+        path -= val
+        if flags & PATH_BRANCH:
+            branches.append((block, succ))
+        block = dst
+
+    return branches
+
+def read_path_trace(blob):
+    """Parse the path blob of the TA, return the list of (fid, path ID) in
+    trace order.
+
+    Each record is two little endian u64, the function ID and the path ID.
+    Paths are reported when they end, at a back edge, a return or right
+    before a call, so the records are in the order the paths ran.
+    """
+    paths = []
+
+    for offset in range(0, len(blob) - 15, 16):
+        paths.append(struct.unpack_from('<QQ', blob, offset))
+
+    return paths
+
+# derivation of a .oat_static_br site
+SBR_CONST = 1
+SBR_LVI = 2
+SBR_IMPLIED = 3
+SBR_TRIP = 4
+SBR_COUNT = 5
+
+def read_static_branches(sections):
+    """Parse .oat_static_br, return a dict mapping (fid, site) to
+    (kind, successor, argument) for the uninstrumented branch sites.
+
+    Each record is:
+        .word  <function ID>, <length of the name>, <number of sites>, 0
+        .ascii <function name>, zero padded to 8 bytes
+        .word  <site>, <kind>, <successor>, <argument>   * number of sites
+
+    Sites are numbered as in .oat_sites, see read_sites(). Successor 0 is
+    taken when the IR condition is true, as a set hint bit. The
+    site takes <successor> every time, except SBR_TRIP sites, which take the
+    other successor <argument> - 1 times per loop entry before <successor>,
+    counted per activation of the function, and SBR_COUNT sites, the exit of
+    the loop of SITE_LOOP site <argument>, which take <successor> once the
+    header executions of the loop entry reach its count, see
+    read_loop_counts().
+    For SBR_IMPLIED <argument> is the dominating site the outcome follows
+    from.
+    """
+    branches = {}
+
+    if '.oat_static_br' not in sections:
+        return branches
+
+    data = sections['.oat_static_br'][1]
+    offset = 0
+    while offset < len(data):
+        fid, namelen, count = struct.unpack_from('<III', data, offset)
+        offset += 16
+        offset += (namelen + 7) & ~7
+        for i in range(count):
+            site, kind, succ, arg = struct.unpack_from('<IIII', data, offset)
+            offset += 16
+            branches[(fid, site)] = (kind, succ, arg)
+
+    return branches
+
+# kinds of a .oat_sites entry
+SITE_CONDBR = 1
+SITE_ICALL = 2
+SITE_IBRANCH = 3
+SITE_LOOP = 4
+SITE_SWITCH = 5
+SITE_PATHBR = 6
+
+# site numbers of the SITE_PATHBR sites are block indexes with this flag
+PATH_SITE_FLAG = 1 << 31
+
+def read_sites(sections):
+    """Parse .oat_sites, return a dict mapping (fid, site) to
+    (kind, address, line, column, argument).
+
+    Each entry is:
+        .xword <address after the hook call>
+        .xword <site ID>
+        .word  <source line>
+        .hword <source column>, <argument>
+
+    The site ID has bit 63 set, the kind in bits 56-62, the function ID in
+    bits 32-55 and the site number in bits 0-31. Function IDs count the
+    defined functions of the linked module from 1, sites count the hint
+    sites of a function in instruction order. The address of a static
+    branch site (see read_static_branches()) is the one of its branch, the
+    address of a SITE_LOOP site is in its loop header.
+    The argument of a SITE_SWITCH site is the width of its hint in the
+    cond bitstream, see read_bits(). The argument of a SITE_CONDBR site is 1
+    for a static branch, which has no hint bit.
+    """
+    sites = {}
+
+    if '.oat_sites' not in sections:
+        return sites
+
+    data = sections['.oat_sites'][1]
+    for offset in range(0, len(data), 24):
+        addr, sid, line, col, arg = struct.unpack_from('<QQIHH', data, offset)
+        kind = (sid >> 56) & 0x7f
+        fid = (sid >> 32) & 0xffffff
+        sites[(fid, sid & 0xffffffff)] = (kind, addr, line, col, arg)
+
+    return sites
+
+# terminator kinds of a .oat_cfg block
+CFG_FALLTHROUGH = 0
+CFG_JUMP = 1
+CFG_COND = 2
+CFG_INDIRECT = 3
+CFG_RET = 4
+CFG_TAILCALL = 5
+CFG_NOSUCC = 6
+
+# polarity of the branch of a .oat_cfg hint site
+CFG_POL_UNKNOWN = 0
+CFG_POL_TAKEN_IF_SET = 1
+CFG_POL_TAKEN_IF_CLEAR = 2
+
+# operation calls of a .oat_cfg record
+CFG_OP_INIT = 1
+CFG_OP_QUOTE = 2
+
+def read_cfg(sections):
+    """Parse .oat_cfg, return a list of functions, each a dict with
+        'range':  (start, end) addresses
+        'blocks': list of (start, terminator address, kind, target list)
+        'sites':  dict mapping (fid, site) to (branch address, polarity,
+                  block index, destination list)
+        'calls':  list of (bl address, CFG_OP_INIT or CFG_OP_QUOTE)
+
+    Each record is:
+        .xword <function start>, <function end>
+        .word  <number of blocks>, <number of hint sites>
+        .word  <number of operation calls>, 0
+        .xword <block start>, <terminator address, 0 if none>
+        .word  <terminator kind>, <number of targets>
+        .xword <target block start> * number of targets    * number of blocks
+        .xword <site ID>, <branch address, 0 if unknown>
+        .word  <polarity>, <block index>
+        .word  <number of destinations>, 0
+        .xword <destination block start> * number of destinations
+                                                           * number of sites
+        .xword <bl address>
+        .word  <kind>, 0                                   * number of calls
+
+    A CFG_COND block lists the taken target first. The sites are the
+    SITE_CONDBR, SITE_SWITCH and SITE_PATHBR sites of .oat_sites, a
+    CFG_POL_TAKEN_IF_SET branch is taken when the hint bit of its site is
+    set, or its path takes successor 0. The branch of a SITE_SWITCH site,
+    or of a SITE_PATHBR site of a switch, is the first one of its dispatch,
+    and its destination list gives the block each case index goes to, 0 if
+    unknown.
+    """
+    functions = []
+
+    if '.oat_cfg' not in sections:
+        return functions
+
+    data = sections['.oat_cfg'][1]
+    offset = 0
+    while offset < len(data):
+        start, end, nblocks, nsites, ncalls = struct.unpack_from('<QQIII', data, offset)
+        offset += 32
+        blocks = []
+        for i in range(nblocks):
+            bb, term, kind, ntargets = struct.unpack_from('<QQII', data, offset)
+            offset += 24
+            targets = list(struct.unpack_from('<%dQ' % ntargets, data, offset))
+            offset += 8 * ntargets
+            blocks.append((bb, term, kind, targets))
+        sites = {}
+        for i in range(nsites):
+            sid, br, polarity, block, ndests = struct.unpack_from('<QQIII', data, offset)
+            offset += 32
+            dests = list(struct.unpack_from('<%dQ' % ndests, data, offset))
+            offset += 8 * ndests
+            sites[((sid >> 32) & 0xffffff, sid & 0xffffffff)] = (br, polarity, block, dests)
+        calls = []
+        for i in range(ncalls):
+            bl, kind = struct.unpack_from('<QI', data, offset)
+            offset += 16
+            calls.append((bl, kind))
+        functions.append({'range': (start, end), 'blocks': blocks,
+                          'sites': sites, 'calls': calls})
+
+    return functions
+
+def read_bits(blob, pos, nbits):
+    """Read nbits from the cond bitstream blob at bit pos, return
+    (value, next pos).
+
+    A conditional branch hint is 1 bit, set if the branch is taken. A switch
+    hint is its case index in the width given by its .oat_sites entry, 0 for
+    the default destination and i for the i-th case. Bits are stored least
+    significant first, starting from the least significant bit of each byte.
+    """
+    value = 0
+    for i in range(nbits):
+        byte = ord(blob[(pos + i) / 8])
+        value |= ((byte >> ((pos + i) % 8)) & 1) << i
+
+    return value, pos + nbits
+
+def read_loop_counts(blob):
+    """Parse the loop blob of the TA, return the list of
+    ((fid, site), depth, iterations) in trace order.
+
+    Each record is two little endian u64, the loop ID (fid << 32 | site)
+    and depth << 48 | the number of times its header was entered. The
+    counter of a loop is cleared when the loop is entered and reported when
+    it is left, one record per entry. An inner loop reports once per
+    iteration of the outer one, before the outer loop reports. The depth is
+    the number of activations of the function of the loop below the one
+    that entered it, a loop entered again by a recursive call from its body
+    reports before the entry of the caller.
+
+    The records of one loop at one depth are in the order of its entries.
+    The replay takes the next count of a loop at the depth of the current
+    activation when it enters the loop, runs its header only while that count
+    is not used up, and must have used up all counts when the operation ends.
+    """
+    counts = []
+
+    for offset in range(0, len(blob) - 15, 16):
+        lid, iterations = struct.unpack_from('<QQ', blob, offset)
+        counts.append(((lid >> 32, lid & 0xffffffff), iterations >> 48,
+                       iterations & 0xffffffffffff))
+
+    return counts
+
+def decode_branch(word, address):
+    """Decode the A64 instruction word at address, return (mnemonic, target)
+    if it is a branch or a call, None otherwise.
+
+    The mnemonic is one of 'b', 'bl', 'b.cond', 'cbz', 'cbnz', 'tbz',
+    'tbnz', 'br', 'blr' and 'ret'. The target of a register branch is 0.
+    This is all the .oat_cfg walk of the verifier decodes, the terminators
+    and their targets come from read_cfg().
+    """
+    def offset(imm, bits):
+        return (imm - (1 << bits) if imm & (1 << (bits - 1)) else imm) * 4
+
+    if word & 0x7c000000 == 0x14000000:
+        return ('bl' if word & 0x80000000 else 'b',
+                address + offset(word & 0x3ffffff, 26))
+    if word & 0xff000010 == 0x54000000:
+        return ('b.cond', address + offset((word >> 5) & 0x7ffff, 19))
+    if word & 0x7e000000 == 0x34000000:
+        return ('cbnz' if word & 0x01000000 else 'cbz',
+                address + offset((word >> 5) & 0x7ffff, 19))
+    if word & 0x7e000000 == 0x36000000:
+        return ('tbnz' if word & 0x01000000 else 'tbz',
+                address + offset((word >> 5) & 0x3fff, 14))
+    for mnemonic, opcode in (('br', 0xd61f0000), ('blr', 0xd63f0000),
+                             ('ret', 0xd65f0000)):
+        if word & 0xfffffc1f == opcode:
+            return (mnemonic, 0)
+
+    return None